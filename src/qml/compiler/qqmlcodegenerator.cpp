@@ -1099,6 +1099,7 @@ QV4::CompiledData::QmlUnit *QmlUnitGenerator::generate(ParsedQML &output, const
 
     QV4::CompiledData::QmlUnit *qmlUnit = reinterpret_cast<QV4::CompiledData::QmlUnit *>(data);
     qmlUnit->header.flags |= QV4::CompiledData::Unit::IsQml;
+    qmlUnit->header.unitSize = totalSize;
     qmlUnit->offsetToImports = unitSize;
     qmlUnit->nImports = output.imports.count();
     qmlUnit->offsetToObjects = unitSize + importSize;
@@ -1159,8 +1160,11 @@ QV4::CompiledData::QmlUnit *QmlUnitGenerator::generate(ParsedQML &output, const
         for (Binding *b = o->bindings->first; b; b = b->next) {
             QV4::CompiledData::Binding *bindingToWrite = reinterpret_cast<QV4::CompiledData::Binding*>(bindingPtr);
             *bindingToWrite = *b;
-            if (b->type == QV4::CompiledData::Binding::Type_Script)
+            if (b->type == QV4::CompiledData::Binding::Type_Script) {
                 bindingToWrite->value.compiledScriptIndex = runtimeFunctionIndices[b->value.compiledScriptIndex];
+                if (output.jsModule.functions.at(bindingToWrite->value.compiledScriptIndex)->hasStaticQmlDependencies)
+                    bindingToWrite->flags |= QV4::CompiledData::Binding::HasStaticDependencies;
+            }
             bindingPtr += sizeof(QV4::CompiledData::Binding);
         }
 
@@ -1235,6 +1239,152 @@ void JSCodeGen::beginObjectScope(QQmlPropertyCache *scopeObject)
     _scopeObject = scopeObject;
 }
 
+// What a virtual register of a binding function may hold, see hasStaticQmlDependencies()
+enum StaticTempKind {
+    StaticObject = 0x1, // the scope object, the context object or an object by id
+    StaticIdArray = 0x2,
+    StaticTypeName = 0x4, // a type or import namespace
+    StaticConstant = 0x8,
+    StaticPrimitive = 0x10, // a number, boolean or string, never an object
+    AnyStaticTempKind = 0x1f
+};
+
+static bool isPrimitiveMember(V4IR::Member *member);
+
+static int staticTempKind(const QVector<int> &tempKinds, V4IR::Expr *e)
+{
+    V4IR::Temp *t = e->asTemp();
+    if (!t || t->kind != V4IR::Temp::VirtualRegister || int(t->index) >= tempKinds.size())
+        return 0;
+    return tempKinds.at(t->index);
+}
+
+static bool isPrimitiveOperand(const QVector<int> &tempKinds, V4IR::Expr *e)
+{
+    if (e->asConst() || e->asString())
+        return true;
+    return staticTempKind(tempKinds, e) & StaticPrimitive;
+}
+
+static int staticSourceKind(const QVector<int> &tempKinds, V4IR::Expr *source)
+{
+    if (source->asConst() || source->asString())
+        return StaticConstant | StaticPrimitive;
+    if (V4IR::Name *n = source->asName()) {
+        if (n->builtin == V4IR::Name::builtin_qml_context_object
+            || n->builtin == V4IR::Name::builtin_qml_scope_object)
+            return StaticObject;
+        if (n->builtin == V4IR::Name::builtin_qml_id_array)
+            return StaticIdArray;
+        if (n->builtin == V4IR::Name::builtin_invalid && n->freeOfSideEffects)
+            return StaticTypeName;
+        return 0;
+    }
+    if (V4IR::Subscript *ss = source->asSubscript()) {
+        if ((staticTempKind(tempKinds, ss->base) & StaticIdArray)
+            && (staticTempKind(tempKinds, ss->index) & StaticConstant))
+            return StaticObject;
+        return 0;
+    }
+    if (source->asTemp())
+        return staticTempKind(tempKinds, source);
+    if (V4IR::Member *m = source->asMember())
+        return isPrimitiveMember(m) ? StaticPrimitive : 0;
+    // Operators on primitive values always produce primitive values
+    if (V4IR::Convert *c = source->asConvert())
+        return isPrimitiveOperand(tempKinds, c->expr) ? StaticPrimitive : 0;
+    if (V4IR::Unop *u = source->asUnop())
+        return isPrimitiveOperand(tempKinds, u->expr) ? StaticPrimitive : 0;
+    if (V4IR::Binop *b = source->asBinop())
+        return isPrimitiveOperand(tempKinds, b->left) && isPrimitiveOperand(tempKinds, b->right) ? StaticPrimitive : 0;
+    return 0;
+}
+
+static bool isStaticExpression(const QVector<int> &tempKinds, V4IR::Expr *e)
+{
+    if (e->asConst() || e->asString() || e->asRegExp() || e->asTemp())
+        return true;
+    if (V4IR::Name *n = e->asName()) {
+        return n->builtin == V4IR::Name::builtin_qml_context_object
+            || n->builtin == V4IR::Name::builtin_qml_scope_object
+            || n->builtin == V4IR::Name::builtin_qml_id_array
+            || n->builtin == V4IR::Name::builtin_qml_imported_scripts_object
+            || (n->builtin == V4IR::Name::builtin_invalid && n->freeOfSideEffects);
+    }
+    // Operators convert objects through valueOf() and toString(), which can read
+    // any property, so only accept operands that are never objects
+    if (V4IR::Convert *c = e->asConvert())
+        return isPrimitiveOperand(tempKinds, c->expr);
+    if (V4IR::Unop *u = e->asUnop())
+        return isPrimitiveOperand(tempKinds, u->expr);
+    if (V4IR::Binop *b = e->asBinop())
+        return isPrimitiveOperand(tempKinds, b->left) && isPrimitiveOperand(tempKinds, b->right);
+    if (V4IR::Member *m = e->asMember()) {
+        if (m->kind == V4IR::Member::MemberOfEnum)
+            return true;
+        if (m->attachedPropertiesIdOrEnumValue != 0)
+            return false;
+        if (m->kind == V4IR::Member::MemberOfQmlScopeObject || m->kind == V4IR::Member::MemberOfQmlContextObject)
+            return true;
+        // Properties of objects that can not be exchanged behind the binding's back
+        return staticTempKind(tempKinds, m->base) & (StaticObject | StaticTypeName);
+    }
+    if (V4IR::Subscript *ss = e->asSubscript())
+        return staticSourceKind(tempKinds, ss) == StaticObject;
+    // Calls can read anything
+    return false;
+}
+
+// Returns true if the binding function captures the same set of dependencies
+// on every evaluation. That is the case if it consists of a single path without
+// calls and only reads properties of objects that are fixed for the lifetime of
+// the binding: the scope object, the context object and objects referenced by id.
+// The run-time then only needs to capture the dependencies once.
+static bool hasStaticQmlDependencies(V4IR::Function *function)
+{
+    if (function->hasDirectEval || function->usesArgumentsObject || function->hasTry
+        || function->hasWith || !function->nestedFunctions.isEmpty())
+        return false;
+
+    // Find out which virtual registers always hold the same object. Registers may
+    // be assigned more than once before SSA, so only keep the kinds that all
+    // assignments agree on.
+    QVector<int> tempKinds(function->tempCount, AnyStaticTempKind);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        foreach (V4IR::BasicBlock *bb, function->basicBlocks) {
+            foreach (V4IR::Stmt *s, bb->statements) {
+                V4IR::Move *move = s->asMove();
+                if (!move)
+                    continue;
+                V4IR::Temp *target = move->target->asTemp();
+                if (!target || target->kind != V4IR::Temp::VirtualRegister || int(target->index) >= tempKinds.size())
+                    continue;
+                const int kind = tempKinds.at(target->index) & staticSourceKind(tempKinds, move->source);
+                if (kind != tempKinds.at(target->index)) {
+                    tempKinds[target->index] = kind;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    foreach (V4IR::BasicBlock *bb, function->basicBlocks) {
+        foreach (V4IR::Stmt *s, bb->statements) {
+            if (s->asJump() || s->asRet())
+                continue;
+            V4IR::Move *move = s->asMove();
+            // Conditional jumps make the captured dependencies depend on the path taken
+            if (!move || !move->target->asTemp())
+                return false;
+            if (!isStaticExpression(tempKinds, move->source))
+                return false;
+        }
+    }
+    return true;
+}
+
 QVector<int> JSCodeGen::generateJSCodeForFunctionsAndBindings(const QList<CompiledFunctionOrExpression> &functions)
 {
     QVector<int> runtimeFunctionIndices(functions.size());
@@ -1298,6 +1448,11 @@ QVector<int> JSCodeGen::generateJSCodeForFunctionsAndBindings(const QList<Compil
                                  function ? function->formals : 0,
                                  body);
         runtimeFunctionIndices[i] = idx;
+
+        if (!function) {
+            V4IR::Function *irFunction = _module->functions.at(idx);
+            irFunction->hasStaticQmlDependencies = hasStaticQmlDependencies(irFunction);
+        }
     }
 
     qDeleteAll(_envMap);
@@ -1505,6 +1660,45 @@ static void initMetaObjectResolver(V4IR::MemberExpressionResolver *resolver, QQm
     resolver->isQObjectResolver = true;
 }
 
+// Returns true if reading the member always yields a number, boolean or string. That
+// is only known for enums and for properties resolved at compile time, either by the
+// QML name lookup or through an object referenced by id.
+static bool isPrimitiveMember(V4IR::Member *member)
+{
+    if (member->kind == V4IR::Member::MemberOfEnum || member->memberIsEnum)
+        return true;
+    if (member->attachedPropertiesIdOrEnumValue != 0)
+        return false;
+
+    QQmlPropertyData *property = member->property;
+    if (!property) {
+        V4IR::Temp *base = member->base->asTemp();
+        if (!base || base->memberResolver.resolveMember != &resolveMetaObjectProperty
+            || !(base->memberResolver.flags & AllPropertiesAreFinal))
+            return false;
+        QQmlPropertyCache *metaObject = static_cast<QQmlPropertyCache*>(base->memberResolver.data);
+        if (!metaObject)
+            return false;
+        property = metaObject->property(*member->name, /*object*/0, /*context*/0);
+        if (!property || property->isFunction() || !metaObject->isAllowedInRevision(property))
+            return false;
+    }
+
+    if (property->isEnum())
+        return true;
+    switch (property->propType) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::QString:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void JSCodeGen::beginFunctionBodyHook()
 {
     _contextObjectTemp = _block->newTemp();
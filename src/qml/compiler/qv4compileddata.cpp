@@ -47,6 +47,8 @@
 #include <private/qv4lookup_p.h>
 #include <private/qv4regexpobject_p.h>
 
+#include <QFile>
+
 #include <algorithm>
 
 QT_BEGIN_NAMESPACE
@@ -140,12 +142,18 @@ QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
 
 void CompilationUnit::unlink()
 {
+    if (runtimeLookups) {
+        for (uint i = 0; i < data->lookupTableSize; ++i)
+            delete runtimeLookups[i].polymorphic;
+    }
     if (engine)
         engine->compilationUnits.erase(engine->compilationUnits.find(this));
     engine = 0;
     if (ownsData)
         free(data);
     data = 0;
+    delete mappedFile;
+    mappedFile = 0;
     free(runtimeStrings);
     runtimeStrings = 0;
     delete [] runtimeLookups;
@@ -50,6 +50,8 @@
 
 QT_BEGIN_NAMESPACE
 
+class QFile;
+
 namespace QQmlJS {
 namespace V4IR {
 struct Function;
@@ -139,6 +141,10 @@ struct String
 
 static const char magic_str[] = "qv4cdata";
 
+// Bump whenever the layout of the structures below changes, cached units
+// with a different version are rejected.
+#define QV4_DATA_STRUCTURE_VERSION 0x02
+
 struct Unit
 {
     char magic[8];
@@ -152,6 +158,7 @@ struct Unit
         IsSingleton = 0x8
     };
     quint32 flags;
+    quint32 unitSize; // including the QML data that follows a QML unit
     uint stringTableSize;
     uint offsetToStringTable;
     uint functionTableSize;
@@ -218,7 +225,8 @@ struct Function
         UsesArgumentsObject = 0x2,
         IsStrict            = 0x4,
         IsNamedExpression   = 0x8,
-        HasCatchOrWith      = 0x10
+        HasCatchOrWith      = 0x10,
+        HasStaticQmlDependencies = 0x20
     };
 
     quint32 index; // in CompilationUnit's function table
@@ -280,7 +288,9 @@ struct Binding
     };
 
     enum Flags {
-        IsSignalHandlerExpression = 0x1
+        IsSignalHandlerExpression = 0x1,
+        // The binding captures the same dependencies on every evaluation
+        HasStaticDependencies = 0x2
     };
 
     quint32 flags : 16;
@@ -478,6 +488,7 @@ struct Q_QML_EXPORT CompilationUnit
         , runtimeLookups(0)
         , runtimeRegularExpressions(0)
         , runtimeClasses(0)
+        , mappedFile(0)
     {}
     virtual ~CompilationUnit();
 
@@ -503,6 +514,14 @@ struct Q_QML_EXPORT CompilationUnit
 
     virtual QV4::ExecutableAllocator::ChunkOfPages *chunkForFunction(int /*functionIndex*/) { return 0; }
 
+    // Backends with position independent code can persist it next to the unit data,
+    // see QV4::DiskCache.
+    virtual bool saveCode(QByteArray * /*code*/) const { return false; }
+    virtual bool loadCode(const QByteArray & /*code*/) { return false; }
+
+    // Set when data points into a cache file mapped into memory.
+    QFile *mappedFile;
+
     // ### runtime data
     // pointer to qml data for QML unit
 
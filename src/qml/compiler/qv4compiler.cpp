@@ -200,7 +200,8 @@ QV4::CompiledData::Unit *QV4::Compiler::JSUnitGenerator::generateUnit(int *total
     memcpy(unit->magic, QV4::CompiledData::magic_str, sizeof(unit->magic));
     unit->architecture = 0; // ###
     unit->flags = QV4::CompiledData::Unit::IsJavascript;
-    unit->version = 1;
+    unit->version = QV4_DATA_STRUCTURE_VERSION;
+    unit->unitSize = totalSize;
     unit->stringTableSize = strings.size();
     unit->offsetToStringTable = headerSize;
     unit->functionTableSize = irModule->functions.size();
@@ -300,6 +301,8 @@ int QV4::Compiler::JSUnitGenerator::writeFunction(char *f, int index, QQmlJS::V4
         function->flags |= CompiledData::Function::IsNamedExpression;
     if (irFunction->hasTry || irFunction->hasWith)
         function->flags |= CompiledData::Function::HasCatchOrWith;
+    if (irFunction->hasStaticQmlDependencies)
+        function->flags |= CompiledData::Function::HasStaticQmlDependencies;
     function->nFormals = irFunction->formals.size();
     function->formalsOffset = currentOffset;
     currentOffset += function->nFormals * sizeof(quint32);
@@ -0,0 +1,392 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4diskcache_p.h"
+#include "qv4isel_p.h"
+// the instruction set is part of the engine stamp below
+#include "qv4instr_moth_p.h"
+#include <private/qv4engine_p.h>
+#include <QtQml/qqmlfile.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QUrl>
+
+QT_BEGIN_NAMESPACE
+
+using namespace QV4;
+
+namespace {
+
+static const char cache_magic_str[] = "qv4cache";
+
+// Bump this whenever the layout of cache files or of the code stored in them
+// changes in a way that the engine stamp doesn't capture.
+static const quint32 cacheFormatVersion = 1;
+
+struct CacheFileHeader
+{
+    char magic[8];
+    char engineStamp[20];
+    char sourceHash[20];
+    quint32 unitOffset;
+    quint32 unitSize;
+    quint32 codeOffset;
+    quint32 codeSize;
+};
+
+inline quint32 alignedSize(quint32 size)
+{
+    return (size + 7) & ~7;
+}
+
+// Identifies the engines that can use a cache file. This only depends on the
+// source code of the engine, so that reproducible builds produce identical
+// cache files, and files generated by qmlcachegen work with any build of the
+// same Qt version.
+QByteArray engineStamp()
+{
+    QByteArray build(QT_VERSION_STR);
+    build += ' ' + QByteArray::number(cacheFormatVersion);
+    build += ' ' + QByteArray::number(QV4_DATA_STRUCTURE_VERSION);
+#define MOTH_INSTR_STAMP(I, FMT) \
+    build += " " #I " " + QByteArray::number(int(MOTH_INSTR_SIZE(I, FMT)));
+    FOR_EACH_MOTH_INSTR(MOTH_INSTR_STAMP)
+#undef MOTH_INSTR_STAMP
+    build += ' ' + QByteArray::number(QSysInfo::WordSize);
+    build += ' ' + QByteArray::number(QSysInfo::ByteOrder);
+    return QCryptographicHash::hash(build, QCryptographicHash::Sha1);
+}
+
+QByteArray sourceHash(const QString &source)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char *>(source.constData()),
+                                                            source.size() * sizeof(QChar)),
+                                    QCryptographicHash::Sha1);
+}
+
+// A cache file is untrusted input, check that every table of the unit and everything
+// the tables point to lies within the unit before CompiledData::Unit dereferences it.
+class UnitValidator
+{
+public:
+    UnitValidator(const CompiledData::Unit *unit)
+        : base(reinterpret_cast<const char *>(unit))
+        , unit(unit)
+    {}
+
+    bool isValid() const;
+
+private:
+    bool inRange(quint64 offset, quint64 size, quint64 alignment = sizeof(quint32)) const
+    { return offset % alignment == 0 && offset + size <= unit->unitSize; }
+    bool tableInRange(quint64 offset, quint32 count, quint32 entrySize, quint64 alignment = sizeof(quint32)) const
+    { return inRange(offset, quint64(count) * entrySize, alignment); }
+    bool isString(quint32 index) const { return index < unit->stringTableSize; }
+    bool stringIndexesValid(const quint32 *indexes, quint32 count) const;
+
+    bool stringValid(quint32 offset) const;
+    bool functionValid(quint32 offset) const;
+    bool jsClassValid(quint32 offset) const;
+
+    const char *base;
+    const CompiledData::Unit *unit;
+};
+
+bool UnitValidator::isValid() const
+{
+    if (!tableInRange(unit->offsetToStringTable, unit->stringTableSize, sizeof(quint32))
+        || !tableInRange(unit->offsetToFunctionTable, unit->functionTableSize, sizeof(quint32))
+        || !tableInRange(unit->offsetToLookupTable, unit->lookupTableSize, sizeof(CompiledData::Lookup))
+        || !tableInRange(unit->offsetToRegexpTable, unit->regexpTableSize, sizeof(CompiledData::RegExp))
+        || !tableInRange(unit->offsetToConstantTable, unit->constantTableSize, sizeof(QV4::SafeValue), sizeof(QV4::SafeValue))
+        || !tableInRange(unit->offsetToJSClassTable, unit->jsClassTableSize, sizeof(quint32)))
+        return false;
+
+    if (!isString(unit->sourceFileIndex))
+        return false;
+    if (unit->indexOfRootFunction != -1
+        && (unit->indexOfRootFunction < 0 || quint32(unit->indexOfRootFunction) >= unit->functionTableSize))
+        return false;
+
+    const quint32 *strings = reinterpret_cast<const quint32 *>(base + unit->offsetToStringTable);
+    for (quint32 i = 0; i < unit->stringTableSize; ++i) {
+        if (!stringValid(strings[i]))
+            return false;
+    }
+
+    const quint32 *functions = reinterpret_cast<const quint32 *>(base + unit->offsetToFunctionTable);
+    for (quint32 i = 0; i < unit->functionTableSize; ++i) {
+        if (!functionValid(functions[i]))
+            return false;
+    }
+
+    const CompiledData::Lookup *lookups = unit->lookupTable();
+    for (quint32 i = 0; i < unit->lookupTableSize; ++i) {
+        if (!isString(lookups[i].nameIndex))
+            return false;
+    }
+
+    for (quint32 i = 0; i < unit->regexpTableSize; ++i) {
+        if (!isString(unit->regexpAt(i)->stringIndex))
+            return false;
+    }
+
+    const quint32 *classes = reinterpret_cast<const quint32 *>(base + unit->offsetToJSClassTable);
+    for (quint32 i = 0; i < unit->jsClassTableSize; ++i) {
+        if (!jsClassValid(classes[i]))
+            return false;
+    }
+
+    return true;
+}
+
+bool UnitValidator::stringIndexesValid(const quint32 *indexes, quint32 count) const
+{
+    for (quint32 i = 0; i < count; ++i) {
+        if (!isString(indexes[i]))
+            return false;
+    }
+    return true;
+}
+
+bool UnitValidator::stringValid(quint32 offset) const
+{
+    if (!inRange(offset, sizeof(CompiledData::String), sizeof(quint64)))
+        return false;
+    const CompiledData::String *str = reinterpret_cast<const CompiledData::String *>(base + offset);
+    // stringAt() wraps the mapped data without copying it, so it has to be a static
+    // QArrayData whose characters directly follow the header.
+    return str->str.ref.isStatic()
+        && str->str.offset == sizeof(QArrayData)
+        && str->str.size >= 0
+        && inRange(offset + sizeof(CompiledData::String), (quint64(str->str.size) + 1) * sizeof(quint16), sizeof(quint16));
+}
+
+bool UnitValidator::functionValid(quint32 offset) const
+{
+    if (!inRange(offset, sizeof(CompiledData::Function), sizeof(quint64)))
+        return false;
+    const CompiledData::Function *function = reinterpret_cast<const CompiledData::Function *>(base + offset);
+    if (!isString(function->nameIndex))
+        return false;
+
+    const quint64 start = offset;
+    if (!tableInRange(start + function->formalsOffset, function->nFormals, sizeof(quint32))
+        || !tableInRange(start + function->localsOffset, function->nLocals, sizeof(quint32))
+        || !tableInRange(start + function->lineNumberMappingOffset, function->nLineNumberMappingEntries, 2 * sizeof(quint32))
+        || !tableInRange(start + function->innerFunctionsOffset, function->nInnerFunctions, sizeof(quint32))
+        || !tableInRange(start + function->dependingIdObjectsOffset, function->nDependingIdObjects, sizeof(quint32))
+        || !tableInRange(start + function->dependingContextPropertiesOffset, function->nDependingContextProperties, 2 * sizeof(quint32))
+        || !tableInRange(start + function->dependingScopePropertiesOffset, function->nDependingScopeProperties, 2 * sizeof(quint32)))
+        return false;
+
+    return stringIndexesValid(function->formalsTable(), function->nFormals)
+        && stringIndexesValid(function->localsTable(), function->nLocals);
+}
+
+bool UnitValidator::jsClassValid(quint32 offset) const
+{
+    if (!inRange(offset, sizeof(CompiledData::JSClass)))
+        return false;
+    const CompiledData::JSClass *klass = reinterpret_cast<const CompiledData::JSClass *>(base + offset);
+    if (!tableInRange(offset + sizeof(CompiledData::JSClass), klass->nMembers, sizeof(CompiledData::JSClassMember)))
+        return false;
+    const CompiledData::JSClassMember *members = reinterpret_cast<const CompiledData::JSClassMember *>(klass + 1);
+    for (quint32 i = 0; i < klass->nMembers; ++i) {
+        if (!isString(members[i].nameOffset))
+            return false;
+    }
+    return true;
+}
+
+}
+
+bool DiskCache::isEnabled()
+{
+    return !qgetenv("QML_DISK_CACHE").isEmpty() || !qgetenv("QML_DISK_CACHE_PATH").isEmpty();
+}
+
+bool DiskCache::isSupported(ExecutionEngine *engine)
+{
+    if (engine->debugger)
+        return false;
+    QScopedPointer<CompiledData::CompilationUnit> unit(engine->iselFactory->createUnitForLoading());
+    return !unit.isNull();
+}
+
+QString DiskCache::cacheDirectory()
+{
+    QString path = QString::fromLocal8Bit(qgetenv("QML_DISK_CACHE_PATH"));
+    if (path.isEmpty())
+        path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/qmlcache");
+    return path;
+}
+
+QString DiskCache::cacheFilePath(const QUrl &url)
+{
+    const QByteArray key = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cacheDirectory() + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1String(".qmlc");
+}
+
+QString DiskCache::precompiledFilePath(const QUrl &url)
+{
+    const QString path = QQmlFile::urlToLocalFileOrQrc(url);
+    if (path.isEmpty())
+        return path;
+    return path + QLatin1Char('c');
+}
+
+CompiledData::CompilationUnit *DiskCache::load(ExecutionEngine *engine, const QUrl &url, const QString &source)
+{
+    // Only backends that can load a unit's code, i.e. the interpreter, use cache files.
+    if (!isSupported(engine))
+        return 0;
+
+    // Units generated ahead of time by qmlcachegen take precedence over the cache directory.
+    const QString precompiled = precompiledFilePath(url);
+    if (!precompiled.isEmpty()) {
+        if (CompiledData::CompilationUnit *unit = loadUnit(engine, precompiled, url, source))
+            return unit;
+    }
+
+    if (!isEnabled())
+        return 0;
+    return loadUnit(engine, cacheFilePath(url), url, source);
+}
+
+bool DiskCache::save(ExecutionEngine *engine, const QUrl &url, const QString &source, CompiledData::CompilationUnit *unit)
+{
+    if (!isEnabled() || !isSupported(engine))
+        return false;
+
+    if (!QDir().mkpath(cacheDirectory()))
+        return false;
+    return saveUnit(cacheFilePath(url), source, unit);
+}
+
+CompiledData::CompilationUnit *DiskCache::loadUnit(ExecutionEngine *engine, const QString &fileName, const QUrl &url, const QString &source)
+{
+    QScopedPointer<QFile> file(new QFile(fileName));
+    if (!file->open(QIODevice::ReadOnly))
+        return 0;
+
+    const qint64 fileSize = file->size();
+    if (fileSize < qint64(sizeof(CacheFileHeader)))
+        return 0;
+    uchar *map = file->map(0, fileSize);
+    if (!map)
+        return 0;
+
+    const CacheFileHeader *header = reinterpret_cast<const CacheFileHeader *>(map);
+    if (memcmp(header->magic, cache_magic_str, sizeof(header->magic))
+        || memcmp(header->engineStamp, engineStamp().constData(), sizeof(header->engineStamp))
+        || memcmp(header->sourceHash, sourceHash(source).constData(), sizeof(header->sourceHash)))
+        return 0;
+
+    if (header->unitSize < sizeof(CompiledData::Unit)
+        || header->unitOffset % sizeof(quint64)
+        || qint64(header->unitOffset) + header->unitSize > fileSize
+        || qint64(header->codeOffset) + header->codeSize > fileSize)
+        return 0;
+
+    CompiledData::Unit *data = reinterpret_cast<CompiledData::Unit *>(map + header->unitOffset);
+    if (memcmp(data->magic, CompiledData::magic_str, sizeof(data->magic))
+        || data->version != QV4_DATA_STRUCTURE_VERSION
+        || data->unitSize != header->unitSize
+        || (data->flags & CompiledData::Unit::IsQml)
+        || !UnitValidator(data).isValid())
+        return 0;
+
+    // The source file name ends up in error messages and stack traces, a unit compiled
+    // for a different location is not reused.
+    if (data->stringAt(data->sourceFileIndex) != url.toString())
+        return 0;
+
+    QScopedPointer<CompiledData::CompilationUnit> unit(engine->iselFactory->createUnitForLoading());
+    if (!unit)
+        return 0;
+    unit->data = data;
+    unit->ownsData = false;
+    const QByteArray code = QByteArray::fromRawData(reinterpret_cast<const char *>(map + header->codeOffset), header->codeSize);
+    if (!unit->loadCode(code))
+        return 0;
+
+    unit->mappedFile = file.take();
+    return unit.take();
+}
+
+bool DiskCache::saveUnit(const QString &fileName, const QString &source, CompiledData::CompilationUnit *unit)
+{
+    if (!unit->data)
+        return false;
+
+    QByteArray code;
+    if (!unit->saveCode(&code))
+        return false;
+
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic_str, sizeof(header.magic));
+    memcpy(header.engineStamp, engineStamp().constData(), sizeof(header.engineStamp));
+    memcpy(header.sourceHash, sourceHash(source).constData(), sizeof(header.sourceHash));
+    header.unitOffset = alignedSize(sizeof(CacheFileHeader));
+    header.unitSize = unit->data->unitSize;
+    header.codeOffset = header.unitOffset + alignedSize(header.unitSize);
+    header.codeSize = code.size();
+
+    // Written to a temporary file first, so that concurrent readers never see a partial unit.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(QByteArray(header.unitOffset - sizeof(header), '\0'));
+    file.write(reinterpret_cast<const char *>(unit->data), header.unitSize);
+    file.write(QByteArray(header.codeOffset - header.unitOffset - header.unitSize, '\0'));
+    file.write(code);
+    return file.commit();
+}
+
+QT_END_NAMESPACE
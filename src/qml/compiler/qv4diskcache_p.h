@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QV4DISKCACHE_P_H
+#define QV4DISKCACHE_P_H
+
+#include <private/qv4compileddata_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QUrl;
+
+namespace QV4 {
+
+struct ExecutionEngine;
+
+// Persists compiled units of JavaScript files between runs. Cache files are named after the
+// source URL and carry a hash of the source as well as a stamp of the engine build that
+// produced them, so changing either invalidates the cached unit. The unit data is stored
+// unmodified and used in place from the mapped cache file.
+//
+// Units generated ahead of time by qmlcachegen are stored next to their source, as "file.jsc"
+// for "file.js", and are always looked up first. The cache directory is only used when
+// enabled with QML_DISK_CACHE, QML_DISK_CACHE_PATH overrides its location.
+class Q_QML_EXPORT DiskCache
+{
+public:
+    static bool isEnabled();
+    static bool isSupported(ExecutionEngine *engine);
+    static QString cacheDirectory();
+    static QString cacheFilePath(const QUrl &url);
+    static QString precompiledFilePath(const QUrl &url);
+
+    static CompiledData::CompilationUnit *load(ExecutionEngine *engine, const QUrl &url, const QString &source);
+    static bool save(ExecutionEngine *engine, const QUrl &url, const QString &source, CompiledData::CompilationUnit *unit);
+
+    static CompiledData::CompilationUnit *loadUnit(ExecutionEngine *engine, const QString &fileName, const QUrl &url, const QString &source);
+    static bool saveUnit(const QString &fileName, const QString &source, CompiledData::CompilationUnit *unit);
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QV4DISKCACHE_P_H
@@ -63,10 +63,12 @@ QT_BEGIN_NAMESPACE
     F(StoreElement, storeElement) \
     F(LoadProperty, loadProperty) \
     F(GetLookup, getLookup) \
+    F(GetLookupMove, getLookupMove) \
     F(StoreProperty, storeProperty) \
     F(SetLookup, setLookup) \
     F(StoreQObjectProperty, storeQObjectProperty) \
     F(LoadQObjectProperty, loadQObjectProperty) \
+    F(LoadQObjectPropertyCJump, loadQObjectPropertyCJump) \
     F(LoadAttachedQObjectProperty, loadAttachedQObjectProperty) \
     F(Push, push) \
     F(CallValue, callValue) \
@@ -104,6 +106,7 @@ QT_BEGIN_NAMESPACE
     F(ConstructGlobalLookup, constructGlobalLookup) \
     F(Jump, jump) \
     F(CJump, cjump) \
+    F(CmpJump, cmpJump) \
     F(UNot, unot) \
     F(UNotBool, unotBool) \
     F(UPlus, uplus) \
@@ -154,6 +157,23 @@ QT_BEGIN_NAMESPACE
 namespace QQmlJS {
 namespace Moth {
 
+// Superinstructions fuse sequences that are common in the instruction-pair histogram
+// (build qv4vme_moth.cpp with WITH_STATS to get one):
+// - GetLookupMove: GetLookup followed by a Move of its result
+// - LoadQObjectPropertyCJump: LoadQObjectProperty followed by a CJump on its result
+// - CmpJump: a comparison Binop followed by a CJump on its result
+
+enum CompareOp {
+    CompareGt,
+    CompareLt,
+    CompareGe,
+    CompareLe,
+    CompareEqual,
+    CompareNotEqual,
+    CompareStrictEqual,
+    CompareStrictNotEqual
+};
+
 struct Param {
     // Params are looked up as follows:
     // Constant: 0
@@ -284,6 +304,13 @@ union Instr
         Param base;
         Param result;
     };
+    struct instr_getLookupMove {
+        MOTH_INSTR_HEADER
+        int index;
+        Param base;
+        Param result;
+        Param moveResult;
+    };
     struct instr_loadQObjectProperty {
         MOTH_INSTR_HEADER
         int propertyIndex;
@@ -292,6 +319,15 @@ union Instr
         int attachedPropertiesId;
         bool captureRequired;
     };
+    struct instr_loadQObjectPropertyCJump {
+        MOTH_INSTR_HEADER
+        int propertyIndex;
+        Param base;
+        Param result;
+        bool captureRequired;
+        bool invert;
+        ptrdiff_t offset;
+    };
     struct instr_loadAttachedQObjectProperty {
         MOTH_INSTR_HEADER
         int propertyIndex;
@@ -533,6 +569,14 @@ union Instr
         Param condition;
         bool invert;
     };
+    struct instr_cmpJump {
+        MOTH_INSTR_HEADER
+        ptrdiff_t offset;
+        Param lhs;
+        Param rhs;
+        quint8 op;
+        bool invert;
+    };
     struct instr_unot {
         MOTH_INSTR_HEADER
         Param source;
@@ -699,7 +743,9 @@ union Instr
     instr_storeElement storeElement;
     instr_loadProperty loadProperty;
     instr_getLookup getLookup;
+    instr_getLookupMove getLookupMove;
     instr_loadQObjectProperty loadQObjectProperty;
+    instr_loadQObjectPropertyCJump loadQObjectPropertyCJump;
     instr_loadAttachedQObjectProperty loadAttachedQObjectProperty;
     instr_storeProperty storeProperty;
     instr_setLookup setLookup;
@@ -740,6 +786,7 @@ union Instr
     instr_constructGlobalLookup constructGlobalLookup;
     instr_jump jump;
     instr_cjump cjump;
+    instr_cmpJump cmpJump;
     instr_unot unot;
     instr_unotBool unotBool;
     instr_uplus uplus;
@@ -349,6 +349,37 @@ void Assembler::enterStandardStackFrame()
 
 }
 
+// The garbage collector scans the whole JS stack, so the temporaries of a new
+// frame must not contain stale values left behind by earlier calls.
+void Assembler::clearJSStackFrame(int frameSize)
+{
+    const int slots = frameSize / sizeof(QV4::SafeValue);
+    if (slots <= 8) {
+        for (int i = 1; i <= slots; ++i)
+            clearValue(Address(LocalsRegister, -i * int(sizeof(QV4::SafeValue))));
+        return;
+    }
+
+    // nothing is live in the return value register at this point
+    move(LocalsRegister, ReturnValueRegister);
+    subPtr(TrustedImm32(frameSize), ReturnValueRegister);
+    Label loop = label();
+    clearValue(Address(ReturnValueRegister, 0));
+    addPtr(TrustedImm32(sizeof(QV4::SafeValue)), ReturnValueRegister);
+    branchPtr(Below, ReturnValueRegister, LocalsRegister).linkTo(loop, this);
+}
+
+void Assembler::clearValue(Address addr)
+{
+#if QT_POINTER_SIZE == 8
+    store64(TrustedImm64(0), addr);
+#else
+    store32(TrustedImm32(0), addr);
+    addr.offset += 4;
+    store32(TrustedImm32(0), addr);
+#endif
+}
+
 void Assembler::leaveStandardStackFrame()
 {
     // restore the callee saved registers
@@ -612,11 +643,12 @@ void InstructionSelection::run(int functionIndex)
     _as->loadPtr(addressForArgument(0), Assembler::ContextRegister);
 #endif
 
-    const int locals = _as->stackLayout().calculateJSStackFrameSize();
+    const int frameSize = _as->stackLayout().calculateJSStackFrameSize();
     _as->loadPtr(Address(Assembler::ContextRegister, qOffsetOf(ExecutionContext, engine)), Assembler::ScratchRegister);
     _as->loadPtr(Address(Assembler::ScratchRegister, qOffsetOf(ExecutionEngine, jsStackTop)), Assembler::LocalsRegister);
-    _as->addPtr(Assembler::TrustedImm32(sizeof(QV4::SafeValue)*locals), Assembler::LocalsRegister);
+    _as->addPtr(Assembler::TrustedImm32(frameSize), Assembler::LocalsRegister);
     _as->storePtr(Assembler::LocalsRegister, Address(Assembler::ScratchRegister, qOffsetOf(ExecutionEngine, jsStackTop)));
+    _as->clearJSStackFrame(frameSize);
 
     int lastLine = -1;
     for (int i = 0, ei = _function->basicBlocks.size(); i != ei; ++i) {
@@ -2009,8 +2041,8 @@ void InstructionSelection::visitRet(V4IR::Ret *s)
 
     _as->exceptionReturnLabel = _as->label();
 
-    const int locals = _as->stackLayout().calculateJSStackFrameSize();
-    _as->subPtr(Assembler::TrustedImm32(sizeof(QV4::SafeValue)*locals), Assembler::LocalsRegister);
+    const int frameSize = _as->stackLayout().calculateJSStackFrameSize();
+    _as->subPtr(Assembler::TrustedImm32(frameSize), Assembler::LocalsRegister);
     _as->loadPtr(Address(Assembler::ContextRegister, qOffsetOf(ExecutionContext, engine)), Assembler::ScratchRegister);
     _as->storePtr(Assembler::LocalsRegister, Address(Assembler::ScratchRegister, qOffsetOf(ExecutionEngine, jsStackTop)));
 
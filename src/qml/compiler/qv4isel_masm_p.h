@@ -886,6 +886,8 @@ public:
 
     void enterStandardStackFrame();
     void leaveStandardStackFrame();
+    void clearJSStackFrame(int frameSize);
+    void clearValue(Address addr);
 
     void checkException() {
         loadPtr(Address(ContextRegister, qOffsetOf(QV4::ExecutionContext, engine)), ScratchRegister);
@@ -48,6 +48,8 @@
 #include <private/qv4regexpobject_p.h>
 #include <private/qv4compileddata_p.h>
 
+#include <QDataStream>
+
 #undef USE_TYPE_INFO
 
 using namespace QQmlJS;
@@ -150,6 +152,21 @@ inline bool isBoolType(V4IR::Expr *e)
     return (e->type == V4IR::BoolType);
 }
 
+inline bool compareOp(V4IR::AluOp op, CompareOp *compare)
+{
+    switch (op) {
+    case V4IR::OpGt: *compare = CompareGt; return true;
+    case V4IR::OpLt: *compare = CompareLt; return true;
+    case V4IR::OpGe: *compare = CompareGe; return true;
+    case V4IR::OpLe: *compare = CompareLe; return true;
+    case V4IR::OpEqual: *compare = CompareEqual; return true;
+    case V4IR::OpNotEqual: *compare = CompareNotEqual; return true;
+    case V4IR::OpStrictEqual: *compare = CompareStrictEqual; return true;
+    case V4IR::OpStrictNotEqual: *compare = CompareStrictNotEqual; return true;
+    default: return false;
+    }
+}
+
 } // anonymous namespace
 
 InstructionSelection::InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, V4IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator)
@@ -159,6 +176,9 @@ InstructionSelection::InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::Ex
     , _codeStart(0)
     , _codeNext(0)
     , _codeEnd(0)
+    , _lastInstruction(-1)
+    , _lastInstructionType(Instr::Ret)
+    , _fusionBarrier(-1)
     , _currentStatement(0)
 {
     compilationUnit = new CompilationUnit;
@@ -181,6 +201,8 @@ void InstructionSelection::run(int functionIndex)
     memset(codeStart, 0, codeSize);
     uchar *codeNext = codeStart;
     uchar *codeEnd = codeStart + codeSize;
+    ptrdiff_t lastInstruction = -1;
+    ptrdiff_t fusionBarrier = -1;
 
     qSwap(_function, function);
     qSwap(block, _block);
@@ -190,6 +212,8 @@ void InstructionSelection::run(int functionIndex)
     qSwap(codeStart, _codeStart);
     qSwap(codeNext, _codeNext);
     qSwap(codeEnd, _codeEnd);
+    qSwap(lastInstruction, _lastInstruction);
+    qSwap(fusionBarrier, _fusionBarrier);
 
     V4IR::Optimizer opt(_function);
     opt.run(qmlEngine);
@@ -221,6 +245,7 @@ void InstructionSelection::run(int functionIndex)
         _block = _function->basicBlocks[i];
         _nextBlock = (i < ei - 1) ? _function->basicBlocks[i + 1] : 0;
         _addrs.insert(_block, _codeNext - _codeStart);
+        _fusionBarrier = _codeNext - _codeStart;
 
         if (_block->catchBlock != exceptionHandler) {
             Instruction::SetExceptionHandler set;
@@ -237,8 +262,10 @@ void InstructionSelection::run(int functionIndex)
         foreach (V4IR::Stmt *s, _block->statements) {
             _currentStatement = s;
 
-            if (s->location.isValid())
+            if (s->location.isValid()) {
                 lineNumberMappings << _codeNext - _codeStart << s->location.startLine;
+                _fusionBarrier = _codeNext - _codeStart;
+            }
 
             s->accept(this);
         }
@@ -261,6 +288,8 @@ void InstructionSelection::run(int functionIndex)
     qSwap(codeStart, _codeStart);
     qSwap(codeNext, _codeNext);
     qSwap(codeEnd, _codeEnd);
+    qSwap(lastInstruction, _lastInstruction);
+    qSwap(fusionBarrier, _fusionBarrier);
 
     delete[] codeStart;
 }
@@ -565,11 +594,10 @@ void InstructionSelection::setElement(V4IR::Expr *source, V4IR::Expr *targetBase
 
 void InstructionSelection::copyValue(V4IR::Temp *sourceTemp, V4IR::Temp *targetTemp)
 {
-    Instruction::Move move;
-    move.source = getParam(sourceTemp);
-    move.result = getResultParam(targetTemp);
-    if (move.source != move.result)
-        addInstruction(move);
+    Param source = getParam(sourceTemp);
+    Param result = getResultParam(targetTemp);
+    if (source != result)
+        addMove(source, result);
 }
 
 void InstructionSelection::swapValues(V4IR::Temp *sourceTemp, V4IR::Temp *targetTemp)
@@ -810,10 +838,7 @@ void InstructionSelection::prepareCallArgs(V4IR::ExprList *e, quint32 &argc, qui
         // We need to move all the temps into the function arg array
         assert(argLocation >= 0);
         while (e) {
-            Instruction::Move move;
-            move.source = getParam(e->expr);
-            move.result = Param::createTemp(argLocation);
-            addInstruction(move);
+            addMove(getParam(e->expr), Param::createTemp(argLocation));
             ++argLocation;
             ++argc;
             e = e->next;
@@ -835,28 +860,78 @@ void InstructionSelection::visitJump(V4IR::Jump *s)
     _patches[s->target].append(loc);
 }
 
-void InstructionSelection::visitCJump(V4IR::CJump *s)
+void InstructionSelection::addMove(const Param &source, const Param &result)
+{
+    if (const Instr::instr_getLookup *lookup = fusableInstruction<Instr::GetLookup>()) {
+        if (lookup->result == source) {
+            Instruction::GetLookupMove fused;
+            fused.index = lookup->index;
+            fused.base = lookup->base;
+            fused.result = lookup->result;
+            fused.moveResult = result;
+            removeLastInstruction();
+            addInstruction(fused);
+            return;
+        }
+    }
+
+    Instruction::Move move;
+    move.source = source;
+    move.result = result;
+    addInstruction(move);
+}
+
+// Returns the location of the jump offset to patch
+ptrdiff_t InstructionSelection::addConditionalJump(V4IR::Expr *condition, bool invert)
 {
-    Param condition;
-    if (V4IR::Temp *t = s->cond->asTemp()) {
-        condition = getResultParam(t);
-    } else if (V4IR::Binop *b = s->cond->asBinop()) {
-        condition = binopHelper(b->op, b->left, b->right, /*target*/0);
+    V4IR::Binop *b = condition->asBinop();
+    CompareOp op;
+    if (b && compareOp(b->op, &op)) {
+        Instruction::CmpJump jump;
+        jump.offset = 0;
+        jump.lhs = getParam(b->left);
+        jump.rhs = getParam(b->right);
+        jump.op = op;
+        jump.invert = invert;
+        return addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+    }
+
+    Param conditionParam;
+    if (V4IR::Temp *t = condition->asTemp()) {
+        conditionParam = getResultParam(t);
+
+        const Instr::instr_loadQObjectProperty *load = fusableInstruction<Instr::LoadQObjectProperty>();
+        if (load && load->result == conditionParam) {
+            Instruction::LoadQObjectPropertyCJump fused;
+            fused.propertyIndex = load->propertyIndex;
+            fused.base = load->base;
+            fused.result = load->result;
+            fused.captureRequired = load->captureRequired;
+            fused.invert = invert;
+            fused.offset = 0;
+            removeLastInstruction();
+            return addInstruction(fused) + (((const char *)&fused.offset) - ((const char *)&fused));
+        }
+    } else if (b) {
+        conditionParam = binopHelper(b->op, b->left, b->right, /*target*/0);
     } else {
         Q_UNIMPLEMENTED();
     }
 
     Instruction::CJump jump;
     jump.offset = 0;
-    jump.condition = condition;
+    jump.condition = conditionParam;
+    jump.invert = invert;
+    return addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+}
 
+void InstructionSelection::visitCJump(V4IR::CJump *s)
+{
     if (s->iftrue == _nextBlock) {
-        jump.invert = true;
-        ptrdiff_t falseLoc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+        ptrdiff_t falseLoc = addConditionalJump(s->cond, /*invert*/true);
         _patches[s->iffalse].append(falseLoc);
     } else {
-        jump.invert = false;
-        ptrdiff_t trueLoc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+        ptrdiff_t trueLoc = addConditionalJump(s->cond, /*invert*/false);
         _patches[s->iftrue].append(trueLoc);
 
         if (s->iffalse != _nextBlock) {
@@ -1147,9 +1222,20 @@ ptrdiff_t InstructionSelection::addInstructionHelper(Instr::Type type, Instr &in
     ptrdiff_t ptrOffset = _codeNext - _codeStart;
     _codeNext += instructionSize;
 
+    _lastInstruction = ptrOffset;
+    _lastInstructionType = type;
+
     return ptrOffset;
 }
 
+// Only used to replace the last instruction with a superinstruction, see fusableInstruction()
+void InstructionSelection::removeLastInstruction()
+{
+    Q_ASSERT(_lastInstruction >= 0);
+    _codeNext = _codeStart + _lastInstruction;
+    _lastInstruction = -1;
+}
+
 void InstructionSelection::patchJumpAddresses()
 {
     typedef QHash<V4IR::BasicBlock *, QVector<ptrdiff_t> >::ConstIterator PatchIt;
@@ -1228,3 +1314,115 @@ void CompilationUnit::linkBackendToEngine(QV4::ExecutionEngine *engine)
     foreach (QV4::Function *f, runtimeFunctions)
         engine->allFunctions.insert(reinterpret_cast<quintptr>(f->codeData), f);
 }
+
+#define MOTH_COUNT_INSTR(I, FMT) + 1
+static const int instructionCount = 0 FOR_EACH_MOTH_INSTR(MOTH_COUNT_INSTR);
+#undef MOTH_COUNT_INSTR
+
+// Bump whenever instructions are added or change layout, cached code with a different
+// format is rejected.
+static const quint32 codeFormatVersion = 2;
+
+// The runtime functions referenced by Binop and BinopContext instructions
+static const QV4::BinOp binopFunctions[] = {
+    QV4::__qmljs_bit_and, QV4::__qmljs_bit_or, QV4::__qmljs_bit_xor, QV4::__qmljs_sub,
+    QV4::__qmljs_mul, QV4::__qmljs_div, QV4::__qmljs_mod, QV4::__qmljs_shl, QV4::__qmljs_shr,
+    QV4::__qmljs_ushr, QV4::__qmljs_gt, QV4::__qmljs_lt, QV4::__qmljs_ge, QV4::__qmljs_le,
+    QV4::__qmljs_eq, QV4::__qmljs_ne, QV4::__qmljs_se, QV4::__qmljs_sne
+};
+static const QV4::BinOpContext binopContextFunctions[] = {
+    QV4::__qmljs_instanceof, QV4::__qmljs_in, QV4::__qmljs_add
+};
+
+template <typename Function, int N>
+static bool relocateFunction(Function *function, const Function (&functions)[N], bool toIndex)
+{
+    if (toIndex) {
+        for (int i = 0; i < N; ++i) {
+            if (functions[i] == *function) {
+                *function = reinterpret_cast<Function>(quintptr(i));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    quintptr i = reinterpret_cast<quintptr>(*function);
+    if (i >= quintptr(N))
+        return false;
+    *function = functions[i];
+    return true;
+}
+
+// Threaded code refers to the instruction handlers by address, and Binop instructions refer
+// to runtime functions, which are only valid within the current process. Cached code stores
+// indices in their place instead.
+static bool relocateCode(QByteArray *code, bool toInstructionTypes)
+{
+#ifdef MOTH_THREADED_INTERPRETER
+    void **jumpTable = VME::instructionJumpTable();
+    QHash<void *, int> instructionTypes;
+    if (toInstructionTypes) {
+        for (int i = 0; i < instructionCount; ++i)
+            instructionTypes.insert(jumpTable[i], i);
+    }
+#endif
+
+    char *ptr = code->data();
+    char *end = ptr + code->size();
+    while (ptr < end) {
+        Instr *instr = reinterpret_cast<Instr *>(ptr);
+        int type;
+#ifdef MOTH_THREADED_INTERPRETER
+        if (toInstructionTypes) {
+            type = instructionTypes.value(instr->common.code, -1);
+            instr->common.code = reinterpret_cast<void *>(quintptr(type));
+        } else {
+            type = int(reinterpret_cast<quintptr>(instr->common.code));
+            if (type >= 0 && type < instructionCount)
+                instr->common.code = jumpTable[type];
+        }
+#else
+        type = instr->common.instructionType;
+#endif
+        if (type < 0 || type >= instructionCount)
+            return false;
+        if (type == Instr::Binop && !relocateFunction(&instr->binop.alu, binopFunctions, toInstructionTypes))
+            return false;
+        if (type == Instr::BinopContext && !relocateFunction(&instr->binopContext.alu, binopContextFunctions, toInstructionTypes))
+            return false;
+        ptr += Instr::size(static_cast<Instr::Type>(type));
+    }
+    return ptr == end;
+}
+
+bool CompilationUnit::saveCode(QByteArray *code) const
+{
+    QVector<QByteArray> relocated = codeRefs;
+    for (int i = 0; i < relocated.size(); ++i) {
+        if (!relocateCode(&relocated[i], /*toInstructionTypes*/true))
+            return false;
+    }
+
+    QDataStream stream(code, QIODevice::WriteOnly);
+    stream << codeFormatVersion << relocated;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool CompilationUnit::loadCode(const QByteArray &code)
+{
+    QDataStream stream(code);
+    quint32 format = 0;
+    stream >> format;
+    if (stream.status() != QDataStream::Ok || format != codeFormatVersion)
+        return false;
+    stream >> codeRefs;
+    if (stream.status() != QDataStream::Ok || codeRefs.size() != int(data->functionTableSize))
+        return false;
+
+    for (int i = 0; i < codeRefs.size(); ++i) {
+        if (!relocateCode(&codeRefs[i], /*toInstructionTypes*/false))
+            return false;
+    }
+    return true;
+}
@@ -58,6 +58,8 @@ struct CompilationUnit : public QV4::CompiledData::CompilationUnit
 {
     virtual ~CompilationUnit();
     virtual void linkBackendToEngine(QV4::ExecutionEngine *engine);
+    virtual bool saveCode(QByteArray *code) const;
+    virtual bool loadCode(const QByteArray &code);
 
     QVector<QByteArray> codeRefs;
 
@@ -157,6 +159,8 @@ private:
 
     void simpleMove(V4IR::Move *);
     void prepareCallArgs(V4IR::ExprList *, quint32 &, quint32 * = 0);
+    void addMove(const Param &source, const Param &result);
+    ptrdiff_t addConditionalJump(V4IR::Expr *condition, bool invert);
 
     int scratchTempIndex() const { return _function->tempCount; }
     int callDataStart() const { return scratchTempIndex() + 1; }
@@ -166,6 +170,9 @@ private:
     template <int Instr>
     inline ptrdiff_t addInstruction(const InstrData<Instr> &data);
     ptrdiff_t addInstructionHelper(Instr::Type type, Instr &instr);
+    template <int InstrT>
+    inline const typename InstrMeta<InstrT>::DataType *fusableInstruction() const;
+    void removeLastInstruction();
     void patchJumpAddresses();
     QByteArray squeezeCode() const;
 
@@ -181,6 +188,12 @@ private:
     uchar *_codeNext;
     uchar *_codeEnd;
 
+    // The last instruction can be fused with the next one unless that one has to start at
+    // _fusionBarrier, e.g. because it's the start of a block or of a line.
+    ptrdiff_t _lastInstruction;
+    Instr::Type _lastInstructionType;
+    ptrdiff_t _fusionBarrier;
+
     QSet<V4IR::Jump *> _removableJumps;
     V4IR::Stmt *_currentStatement;
 
@@ -196,6 +209,8 @@ public:
     { return new InstructionSelection(qmlEngine, execAllocator, module, jsGenerator); }
     virtual bool jitCompileRegexps() const
     { return false; }
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading()
+    { return new CompilationUnit; }
 };
 
 template<int InstrT>
@@ -206,6 +221,15 @@ ptrdiff_t InstructionSelection::addInstruction(const InstrData<InstrT> &data)
     return addInstructionHelper(static_cast<Instr::Type>(InstrT), genericInstr);
 }
 
+template<int InstrT>
+const typename InstrMeta<InstrT>::DataType *InstructionSelection::fusableInstruction() const
+{
+    if (_lastInstruction < 0 || _lastInstructionType != InstrT
+            || _codeNext - _codeStart == _fusionBarrier || irModule->debugMode)
+        return 0;
+    return &InstrMeta<InstrT>::data(*reinterpret_cast<const Instr *>(_codeStart + _lastInstruction));
+}
+
 } // namespace Moth
 } // namespace QQmlJS
 
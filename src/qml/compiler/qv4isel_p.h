@@ -96,6 +96,9 @@ public:
     virtual ~EvalISelFactory() = 0;
     virtual EvalInstructionSelection *create(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, V4IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator) = 0;
     virtual bool jitCompileRegexps() const = 0;
+    // Returns an empty unit to be filled with CompilationUnit::loadCode(), or 0 if the code
+    // generated by this backend can't be cached.
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading() { return 0; }
 };
 
 namespace V4IR {
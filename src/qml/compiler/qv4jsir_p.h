@@ -784,7 +784,8 @@ struct Function {
     uint isNamedExpression : 1;
     uint hasTry: 1;
     uint hasWith: 1;
-    uint unused : 25;
+    uint hasStaticQmlDependencies: 1; // QML binding that captures the same dependencies on every evaluation
+    uint unused : 24;
 
     // Location of declaration in source code (-1 if not specified)
     int line;
@@ -810,6 +811,7 @@ struct Function {
         , isNamedExpression(false)
         , hasTry(false)
         , hasWith(false)
+        , hasStaticQmlDependencies(false)
         , unused(0)
         , line(-1)
         , column(-1)
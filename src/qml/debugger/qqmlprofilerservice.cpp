@@ -115,7 +115,7 @@ QByteArray QQmlProfilerData::toByteArray() const
 }
 
 QQmlProfilerService::QQmlProfilerService()
-    : QQmlDebugService(QStringLiteral("CanvasFrameRate"), 1)
+    : QQmlDebugService(QStringLiteral("CanvasFrameRate"), 2)
 {
     m_timer.start();
 
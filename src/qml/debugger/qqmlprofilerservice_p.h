@@ -129,6 +129,7 @@ public:
         Creating,
         Binding,            //running a binding
         HandlingSignal,     //running a signal handler
+        Incubating,         //an incubation slice, since version 2 of the service
 
         MaximumRangeType
     };
@@ -228,6 +229,7 @@ private:
     friend struct QQmlHandlingSignalProfiler;
     friend struct QQmlVmeProfiler;
     friend struct QQmlCompilingProfiler;
+    friend struct QQmlIncubatingProfiler;
     friend struct QQmlPixmapProfiler;
 };
 
@@ -296,6 +298,25 @@ struct QQmlCompilingProfiler {
     }
 };
 
+struct QQmlIncubatingProfiler {
+    QQmlIncubatingProfiler(int msecs)
+    {
+        if (QQmlProfilerService::enabled) {
+            QQmlProfilerService::instance->startRange(QQmlProfilerService::Incubating);
+            if (msecs > 0) {
+                QQmlProfilerService::instance->rangeData(QQmlProfilerService::Incubating,
+                        QString::fromLatin1("%1 ms").arg(msecs));
+            }
+        }
+    }
+
+    ~QQmlIncubatingProfiler()
+    {
+        if (QQmlProfilerService::enabled)
+            QQmlProfilerService::instance->endRange(QQmlProfilerService::Incubating);
+    }
+};
+
 struct QQmlVmeProfiler {
 public:
 
@@ -230,6 +230,26 @@ void QJSEngine::collectGarbage()
     d->m_v4Engine->memoryManager->runGC();
 }
 
+/*!
+    \since 5.3
+
+    Runs the garbage collector and returns all memory of the JavaScript heap
+    that is not in use anymore to the operating system.
+
+    The JavaScript heap keeps free memory around after a garbage collection, so
+    that it can be reused by later allocations. Call this function when the
+    application is running low on memory, e.g. after a memory warning from the
+    platform, or before it is sent to the background.
+
+    \sa collectGarbage(), QQmlEngine::trimComponentCache()
+*/
+void QJSEngine::trimMemory()
+{
+    QV4::MemoryManager *mm = d->m_v4Engine->memoryManager;
+    mm->runGC();
+    mm->trimHeap();
+}
+
 /*!
     Evaluates \a program, using \a lineNumber as the base line number,
     and returns the result of the evaluation.
@@ -88,6 +88,7 @@ public:
     }
 
     void collectGarbage();
+    void trimMemory();
 
     QV8Engine *handle() const { return d; }
 
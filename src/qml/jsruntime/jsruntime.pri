@@ -30,6 +30,9 @@ SOURCES += \
     $$PWD/qv4regexpobject.cpp \
     $$PWD/qv4stringobject.cpp \
     $$PWD/qv4variantobject.cpp \
+    $$PWD/qv4arraybuffer.cpp \
+    $$PWD/qv4typedarray.cpp \
+    $$PWD/qv4dataview.cpp \
     $$PWD/qv4string.cpp \
     $$PWD/qv4objectiterator.cpp \
     $$PWD/qv4regexp.cpp \
@@ -74,6 +77,9 @@ HEADERS += \
     $$PWD/qv4regexpobject_p.h \
     $$PWD/qv4stringobject_p.h \
     $$PWD/qv4variantobject_p.h \
+    $$PWD/qv4arraybuffer_p.h \
+    $$PWD/qv4typedarray_p.h \
+    $$PWD/qv4dataview_p.h \
     $$PWD/qv4string_p.h \
     $$PWD/qv4property_p.h \
     $$PWD/qv4objectiterator_p.h \
@@ -128,6 +128,7 @@ bool ArgumentsObject::defineOwnProperty(ExecutionContext *ctx, uint index, const
         map = *pd;
         mapAttrs = arrayAttributes[pidx];
         arrayAttributes[pidx] = Attr_Data;
+        writeBarrier();
         pd->value = mappedArguments.at(index);
     }
 
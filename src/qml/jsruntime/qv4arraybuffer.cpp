@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4arraybuffer_p.h"
+#include "qv4typedarray_p.h"
+#include "qv4dataview_p.h"
+#include "qv4mm_p.h"
+#include "qv4variantobject_p.h"
+
+using namespace QV4;
+
+DEFINE_MANAGED_VTABLE(ArrayBufferCtor);
+DEFINE_MANAGED_VTABLE(ArrayBuffer);
+
+ArrayBufferCtor::ArrayBufferCtor(ExecutionContext *scope)
+    : FunctionObject(scope, QStringLiteral("ArrayBuffer"))
+{
+    setVTable(&static_vtbl);
+}
+
+ReturnedValue ArrayBufferCtor::construct(Managed *m, CallData *callData)
+{
+    ExecutionEngine *v4 = m->engine();
+    Scope scope(v4);
+
+    ScopedValue l(scope, callData->argument(0));
+    // QByteArray values from C++ arrive as variants, and share their contents with
+    // the buffer created from them
+    if (VariantObject *v = l->as<VariantObject>()) {
+        if (v->data.userType() == QMetaType::QByteArray)
+            return Encode(v4->newArrayBuffer(v->data.toByteArray()));
+    }
+
+    double dl = l->toInteger();
+    if (v4->hasException)
+        return Encode::undefined();
+    if (dl < 0 || dl > INT_MAX)
+        return v4->currentContext()->throwRangeError(QStringLiteral("ArrayBuffer: invalid length"));
+
+    return Encode(v4->newArrayBuffer(uint(dl)));
+}
+
+ReturnedValue ArrayBufferCtor::call(Managed *that, CallData *)
+{
+    return that->engine()->currentContext()->throwTypeError(QStringLiteral("ArrayBuffer must be called with new"));
+}
+
+ArrayBuffer::ArrayBuffer(ExecutionEngine *engine, uint length)
+    : Object(engine->arrayBufferClass)
+    , data(int(length), '\0')
+    , ownsData(true)
+{
+    type = Type_ArrayBuffer;
+    engine->memoryManager->changeUnmanagedHeapSizeUsage(data.size());
+}
+
+ArrayBuffer::ArrayBuffer(ExecutionEngine *engine, const QByteArray &array)
+    : Object(engine->arrayBufferClass)
+    , data(array)
+    , ownsData(false)
+{
+    type = Type_ArrayBuffer;
+}
+
+void ArrayBuffer::detach()
+{
+    if (ownsData)
+        return;
+
+    // Copies the contents, unless nothing else references them any more
+    data.detach();
+    ownsData = true;
+    engine()->memoryManager->changeUnmanagedHeapSizeUsage(data.size());
+}
+
+void ArrayBuffer::clear()
+{
+    if (ownsData)
+        engine()->memoryManager->changeUnmanagedHeapSizeUsage(-qptrdiff(data.size()));
+    data = QByteArray();
+    ownsData = true;
+}
+
+void ArrayBuffer::destroy(Managed *m)
+{
+    ArrayBuffer *buffer = static_cast<ArrayBuffer *>(m);
+    if (buffer->ownsData)
+        buffer->engine()->memoryManager->changeUnmanagedHeapSizeUsage(-qptrdiff(buffer->data.size()));
+    buffer->~ArrayBuffer();
+}
+
+void ArrayBufferPrototype::init(ExecutionEngine *engine, ObjectRef ctor)
+{
+    Scope scope(engine);
+    ScopedObject o(scope);
+    ctor->defineReadonlyProperty(engine->id_length, Primitive::fromInt32(1));
+    ctor->defineReadonlyProperty(engine->id_prototype, (o = this));
+    ctor->defineDefaultProperty(QStringLiteral("isView"), method_isView, 1);
+    defineDefaultProperty(QStringLiteral("constructor"), (o = ctor));
+    defineAccessorProperty(QStringLiteral("byteLength"), method_get_byteLength, 0);
+    defineDefaultProperty(QStringLiteral("slice"), method_slice, 2);
+}
+
+ReturnedValue ArrayBufferPrototype::method_get_byteLength(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<ArrayBuffer> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteLength());
+}
+
+ReturnedValue ArrayBufferPrototype::method_slice(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<ArrayBuffer> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    uint length = a->byteLength();
+    ScopedValue begin(scope, ctx->argument(0));
+    ScopedValue end(scope, ctx->argument(1));
+    uint first = relativeIndex(begin, length, 0);
+    uint last = relativeIndex(end, length, length);
+    if (scope.engine->hasException)
+        return Encode::undefined();
+
+    uint newLength = last > first ? last - first : 0;
+    Scoped<ArrayBuffer> newBuffer(scope, ctx->engine->newArrayBuffer(newLength));
+    memcpy(newBuffer->writableData(), a->constData() + first, newLength);
+    return newBuffer.asReturnedValue();
+}
+
+ReturnedValue ArrayBufferPrototype::method_isView(CallContext *ctx)
+{
+    Scope scope(ctx);
+    ScopedObject o(scope, ctx->argument(0));
+    bool isView = o && (o->asTypedArray() || o->as<DataView>());
+    return Encode(isView);
+}
+
+uint QV4::relativeIndex(const ValueRef value, uint length, uint defaultValue)
+{
+    if (value->isUndefined())
+        return defaultValue;
+    double d = value->toInteger();
+    if (d < 0)
+        d = qMax(0., d + length);
+    return uint(qMin(d, double(length)));
+}
@@ -222,7 +222,7 @@ ReturnedValue ArrayPrototype::method_join(CallContext *ctx)
             if (i)
                 R += r4;
 
-            e = a->getIndexed(i);
+            e = a->getArrayElement(i);
             if (scope.hasException())
                 return Encode::undefined();
             if (!e->isNullOrUndefined())
@@ -309,6 +309,7 @@ ReturnedValue ArrayPrototype::method_push(CallContext *ctx)
     }
 
     if (!instance->protoHasArray() && instance->arrayDataLen <= len && (instance->flags & SimpleArray)) {
+        instance->writeBarrier();
         for (int i = 0; i < ctx->callData->argc; ++i) {
             if (!instance->sparseArray) {
                 if (len >= instance->arrayAlloc)
@@ -401,7 +402,8 @@ ReturnedValue ArrayPrototype::method_shift(CallContext *ctx)
             }
         } else {
             uint idx = instance->sparseArray->pop_front();
-            instance->freeArrayValue(idx);
+            if (idx != UINT_MAX)
+                instance->freeArrayValue(idx);
         }
     } else {
         ScopedValue v(scope);
@@ -460,7 +462,7 @@ ReturnedValue ArrayPrototype::method_slice(CallContext *ctx)
     uint n = 0;
     for (uint i = start; i < end; ++i) {
         bool exists;
-        v = o->getIndexed(i, &exists);
+        v = o->getArrayElement(i, &exists);
         if (scope.hasException())
             return Encode::undefined();
         if (exists)
@@ -504,17 +506,20 @@ ReturnedValue ArrayPrototype::method_splice(CallContext *ctx)
     uint deleteCount = (uint)qMin(qMax(ScopedValue(scope, ctx->argument(1))->toInteger(), 0.), (double)(len - start));
 
     newArray->arrayReserve(deleteCount);
+    ScopedValue v(scope);
     for (uint i = 0; i < deleteCount; ++i) {
-        newArray->arrayData[i].value = instance->getIndexed(start + i);
+        // getters can allocate, and thus promote the new array
+        v = instance->getIndexed(start + i);
         if (scope.hasException())
             return Encode::undefined();
+        newArray->writeBarrier();
+        newArray->arrayData[i].value = v.asReturnedValue();
         newArray->arrayDataLen = i + 1;
     }
     newArray->setArrayLengthUnchecked(deleteCount);
 
     uint itemCount = ctx->callData->argc < 2 ? 0 : ctx->callData->argc - 2;
 
-    ScopedValue v(scope);
     if (itemCount < deleteCount) {
         for (uint k = start; k < len - deleteCount; ++k) {
             bool exists;
@@ -572,6 +577,7 @@ ReturnedValue ArrayPrototype::method_unshift(CallContext *ctx)
 
     ScopedValue v(scope);
     if (!instance->protoHasArray() && instance->arrayDataLen <= len) {
+        instance->writeBarrier();
         for (int i = ctx->callData->argc - 1; i >= 0; --i) {
             v = ctx->argument(i);
 
@@ -691,7 +697,7 @@ ReturnedValue ArrayPrototype::method_lastIndexOf(CallContext *ctx)
     for (uint k = fromIndex; k > 0;) {
         --k;
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (scope.hasException())
             return Encode::undefined();
         if (exists && __qmljs_strict_equal(v, searchValue))
@@ -722,7 +728,7 @@ ReturnedValue ArrayPrototype::method_every(CallContext *ctx)
     bool ok = true;
     for (uint k = 0; ok && k < len; ++k) {
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (!exists)
             continue;
 
@@ -755,7 +761,7 @@ ReturnedValue ArrayPrototype::method_some(CallContext *ctx)
     ScopedValue r(scope);
     for (uint k = 0; k < len; ++k) {
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (!exists)
             continue;
 
@@ -788,7 +794,7 @@ ReturnedValue ArrayPrototype::method_forEach(CallContext *ctx)
     ScopedValue v(scope);
     for (uint k = 0; k < len; ++k) {
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (!exists)
             continue;
 
@@ -824,7 +830,7 @@ ReturnedValue ArrayPrototype::method_map(CallContext *ctx)
     ScopedValue v(scope);
     for (uint k = 0; k < len; ++k) {
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (!exists)
             continue;
 
@@ -862,7 +868,7 @@ ReturnedValue ArrayPrototype::method_filter(CallContext *ctx)
     uint to = 0;
     for (uint k = 0; k < len; ++k) {
         bool exists;
-        v = instance->getIndexed(k, &exists);
+        v = instance->getArrayElement(k, &exists);
         if (!exists)
             continue;
 
@@ -899,7 +905,7 @@ ReturnedValue ArrayPrototype::method_reduce(CallContext *ctx)
     } else {
         bool kPresent = false;
         while (k < len && !kPresent) {
-            v = instance->getIndexed(k, &kPresent);
+            v = instance->getArrayElement(k, &kPresent);
             if (kPresent)
                 acc = v;
             ++k;
@@ -915,7 +921,7 @@ ReturnedValue ArrayPrototype::method_reduce(CallContext *ctx)
 
     while (k < len) {
         bool kPresent;
-        v = instance->getIndexed(k, &kPresent);
+        v = instance->getArrayElement(k, &kPresent);
         if (kPresent) {
             callData->args[0] = acc;
             callData->args[1] = v;
@@ -954,7 +960,7 @@ ReturnedValue ArrayPrototype::method_reduceRight(CallContext *ctx)
     } else {
         bool kPresent = false;
         while (k > 0 && !kPresent) {
-            v = instance->getIndexed(k - 1, &kPresent);
+            v = instance->getArrayElement(k - 1, &kPresent);
             if (kPresent)
                 acc = v;
             --k;
@@ -969,7 +975,7 @@ ReturnedValue ArrayPrototype::method_reduceRight(CallContext *ctx)
 
     while (k > 0) {
         bool kPresent;
-        v = instance->getIndexed(k - 1, &kPresent);
+        v = instance->getArrayElement(k - 1, &kPresent);
         if (kPresent) {
             callData->args[0] = acc;
             callData->args[1] = v;
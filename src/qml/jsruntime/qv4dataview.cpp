@@ -0,0 +1,230 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4dataview_p.h"
+
+#include <QtCore/qendian.h>
+#include <cstring>
+
+using namespace QV4;
+
+DEFINE_MANAGED_VTABLE(DataViewCtor);
+DEFINE_MANAGED_VTABLE(DataView);
+
+DataViewCtor::DataViewCtor(ExecutionContext *scope)
+    : FunctionObject(scope, QStringLiteral("DataView"))
+{
+    setVTable(&static_vtbl);
+}
+
+ReturnedValue DataViewCtor::construct(Managed *m, CallData *callData)
+{
+    ExecutionEngine *v4 = m->engine();
+    ExecutionContext *ctx = v4->currentContext();
+    Scope scope(v4);
+    Scoped<ArrayBuffer> buffer(scope, callData->argument(0));
+    if (!buffer)
+        return ctx->throwTypeError();
+
+    ScopedValue v(scope, callData->argument(1));
+    double dOffset = v->toInteger();
+    v = callData->argument(2);
+    double dLength = v->isUndefined() ? buffer->byteLength() - dOffset : v->toInteger();
+    if (scope.hasException())
+        return Encode::undefined();
+    if (dOffset < 0 || dLength < 0 || dOffset + dLength > buffer->byteLength())
+        return ctx->throwRangeError(QStringLiteral("new DataView: invalid byteOffset or byteLength"));
+
+    return (new (v4->memoryManager) DataView(v4, buffer.getPointer(), uint(dOffset), uint(dLength)))->asReturnedValue();
+}
+
+ReturnedValue DataViewCtor::call(Managed *that, CallData *)
+{
+    return that->engine()->currentContext()->throwTypeError(QStringLiteral("DataView must be called with new"));
+}
+
+DataView::DataView(ExecutionEngine *e, ArrayBuffer *buffer, uint byteOffset, uint byteLength)
+    : Object(e->dataViewClass)
+    , byteOffset(byteOffset)
+    , byteLength(byteLength)
+{
+    type = Type_DataView;
+    buffer->detach();
+    this->buffer = buffer;
+}
+
+void DataView::markObjects(Managed *that, ExecutionEngine *e)
+{
+    DataView *v = static_cast<DataView *>(that);
+    v->buffer.mark(e);
+    Object::markObjects(that, e);
+}
+
+void DataViewPrototype::init(ExecutionEngine *engine, ObjectRef ctor)
+{
+    Scope scope(engine);
+    ScopedObject o(scope);
+    ctor->defineReadonlyProperty(engine->id_length, Primitive::fromInt32(3));
+    ctor->defineReadonlyProperty(engine->id_prototype, (o = this));
+    defineDefaultProperty(QStringLiteral("constructor"), (o = ctor));
+    defineAccessorProperty(QStringLiteral("buffer"), method_get_buffer, 0);
+    defineAccessorProperty(QStringLiteral("byteLength"), method_get_byteLength, 0);
+    defineAccessorProperty(QStringLiteral("byteOffset"), method_get_byteOffset, 0);
+
+    defineDefaultProperty(QStringLiteral("getInt8"), method_get<qint8, qint8>, 1);
+    defineDefaultProperty(QStringLiteral("getUint8"), method_get<quint8, quint8>, 1);
+    defineDefaultProperty(QStringLiteral("getInt16"), method_get<qint16, qint16>, 1);
+    defineDefaultProperty(QStringLiteral("getUint16"), method_get<quint16, quint16>, 1);
+    defineDefaultProperty(QStringLiteral("getInt32"), method_get<qint32, qint32>, 1);
+    defineDefaultProperty(QStringLiteral("getUint32"), method_get<quint32, quint32>, 1);
+    defineDefaultProperty(QStringLiteral("getFloat32"), method_get<float, quint32>, 1);
+    defineDefaultProperty(QStringLiteral("getFloat64"), method_get<double, quint64>, 1);
+
+    defineDefaultProperty(QStringLiteral("setInt8"), method_set<qint8, qint8>, 2);
+    defineDefaultProperty(QStringLiteral("setUint8"), method_set<quint8, quint8>, 2);
+    defineDefaultProperty(QStringLiteral("setInt16"), method_set<qint16, qint16>, 2);
+    defineDefaultProperty(QStringLiteral("setUint16"), method_set<quint16, quint16>, 2);
+    defineDefaultProperty(QStringLiteral("setInt32"), method_set<qint32, qint32>, 2);
+    defineDefaultProperty(QStringLiteral("setUint32"), method_set<quint32, quint32>, 2);
+    defineDefaultProperty(QStringLiteral("setFloat32"), method_set<float, quint32>, 2);
+    defineDefaultProperty(QStringLiteral("setFloat64"), method_set<double, quint64>, 2);
+}
+
+ReturnedValue DataViewPrototype::method_get_buffer(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<DataView> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return v->buffer.asReturnedValue();
+}
+
+ReturnedValue DataViewPrototype::method_get_byteLength(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<DataView> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->length());
+}
+
+ReturnedValue DataViewPrototype::method_get_byteOffset(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<DataView> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteOffset);
+}
+
+namespace {
+inline ReturnedValue encodeElement(qint8 v) { return Encode(int(v)); }
+inline ReturnedValue encodeElement(quint8 v) { return Encode(int(v)); }
+inline ReturnedValue encodeElement(qint16 v) { return Encode(int(v)); }
+inline ReturnedValue encodeElement(quint16 v) { return Encode(int(v)); }
+inline ReturnedValue encodeElement(qint32 v) { return Encode(int(v)); }
+inline ReturnedValue encodeElement(quint32 v) { return Encode(uint(v)); }
+inline ReturnedValue encodeElement(float v) { return Encode(double(v)); }
+inline ReturnedValue encodeElement(double v) { return Encode(v); }
+
+template <typename T>
+inline T convertElement(double d) { return T(Primitive::toInt32(d)); }
+template <>
+inline quint32 convertElement<quint32>(double d) { return Primitive::toUInt32(d); }
+template <>
+inline float convertElement<float>(double d) { return float(d); }
+template <>
+inline double convertElement<double>(double d) { return d; }
+}
+
+template <typename T, typename Storage>
+ReturnedValue DataViewPrototype::method_get(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<DataView> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    ScopedValue arg(scope, ctx->argument(0));
+    double idx = arg->toInteger();
+    if (scope.hasException())
+        return Encode::undefined();
+    if (idx < 0 || idx + sizeof(T) > v->length())
+        return ctx->throwRangeError(QStringLiteral("DataView: index out of range"));
+    bool littleEndian = ctx->callData->argc > 1 && ctx->callData->args[1].toBoolean();
+
+    Storage s;
+    memcpy(&s, v->arrayBuffer()->constData() + v->byteOffset + uint(idx), sizeof(T));
+    s = littleEndian ? qFromLittleEndian(s) : qFromBigEndian(s);
+    T t;
+    memcpy(&t, &s, sizeof(T));
+    return encodeElement(t);
+}
+
+template <typename T, typename Storage>
+ReturnedValue DataViewPrototype::method_set(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<DataView> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    ScopedValue arg(scope, ctx->argument(0));
+    double idx = arg->toInteger();
+    arg = ctx->argument(1);
+    double d = arg->toNumber();
+    if (scope.hasException())
+        return Encode::undefined();
+    // check after converting the arguments, which can run script code
+    if (idx < 0 || idx + sizeof(T) > v->length())
+        return ctx->throwRangeError(QStringLiteral("DataView: index out of range"));
+    bool littleEndian = ctx->callData->argc > 2 && ctx->callData->args[2].toBoolean();
+
+    T t = convertElement<T>(d);
+    Storage s;
+    memcpy(&s, &t, sizeof(T));
+    s = littleEndian ? qToLittleEndian(s) : qToBigEndian(s);
+    memcpy(v->arrayBuffer()->writableData() + v->byteOffset + uint(idx), &s, sizeof(T));
+    return Encode::undefined();
+}
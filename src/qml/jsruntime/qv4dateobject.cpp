@@ -766,7 +766,7 @@ void DatePrototype::init(ExecutionEngine *engine, ObjectRef ctor)
     defineDefaultProperty(QStringLiteral("toUTCString"), method_toUTCString, 0);
     defineDefaultProperty(QStringLiteral("toGMTString"), method_toUTCString, 0);
     defineDefaultProperty(QStringLiteral("toISOString"), method_toISOString, 0);
-    defineDefaultProperty(QStringLiteral("toJSON"), method_toJSON, 1);
+    defineDefaultProperty(engine->id_toJSON, method_toJSON, 1);
 }
 
 double DatePrototype::getThisDate(ExecutionContext *ctx)
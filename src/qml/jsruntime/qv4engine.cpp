@@ -59,6 +59,9 @@
 #include "qv4mm_p.h"
 #include <qv4argumentsobject_p.h>
 #include <qv4dateobject_p.h>
+#include <qv4arraybuffer_p.h>
+#include <qv4typedarray_p.h>
+#include <qv4dataview_p.h>
 #include <qv4jsonobject_p.h>
 #include <qv4stringobject_p.h>
 #include <qv4identifiertable_p.h>
@@ -67,6 +70,7 @@
 #include "qv4sequenceobject_p.h"
 #include "qv4qobjectwrapper_p.h"
 #include "qv4qmlextensions_p.h"
+#include "qv4lookup_p.h"
 
 #ifdef V4_ENABLE_JIT
 #include "qv4isel_masm_p.h"
@@ -87,6 +91,7 @@ QT_BEGIN_NAMESPACE
 using namespace QV4;
 
 static QBasicAtomicInt engineSerial = Q_BASIC_ATOMIC_INITIALIZER(1);
+static QBasicAtomicInt forceInterpreter = Q_BASIC_ATOMIC_INITIALIZER(0);
 
 static ReturnedValue throwTypeError(CallContext *ctx)
 {
@@ -169,6 +174,7 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
     , v8Engine(0)
     , m_engineId(engineSerial.fetchAndAddOrdered(1))
     , regExpCache(0)
+    , lookupStubCache(0)
     , m_multiplyWrappedQObjects(0)
     , m_qmlExtensions(0)
 {
@@ -181,7 +187,7 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
 
 #ifdef V4_ENABLE_JIT
         static const bool forceMoth = !qgetenv("QV4_FORCE_INTERPRETER").isEmpty();
-        if (forceMoth)
+        if (forceMoth || forceInterpreter.load())
             factory = new QQmlJS::Moth::ISelFactory;
         else
             factory = new QQmlJS::MASM::ISelFactory;
@@ -245,6 +251,7 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
     id_input = newIdentifier(QStringLiteral("input"));
     id_toString = newIdentifier(QStringLiteral("toString"));
     id_valueOf = newIdentifier(QStringLiteral("valueOf"));
+    id_toJSON = newIdentifier(QStringLiteral("toJSON"));
 
     ObjectPrototype *objectPrototype = new (memoryManager) ObjectPrototype(emptyClass->changeVTable(&ObjectPrototype::static_vtbl));
     objectClass = InternalClass::create(this, &Object::static_vtbl, objectPrototype);
@@ -314,6 +321,16 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
 
     sequencePrototype = new (memoryManager) SequencePrototype(arrayClass);
 
+    ArrayBufferPrototype *arrayBufferPrototype = new (memoryManager) ArrayBufferPrototype(objectClass);
+    arrayBufferClass = InternalClass::create(this, &ArrayBuffer::static_vtbl, arrayBufferPrototype);
+    DataViewPrototype *dataViewPrototype = new (memoryManager) DataViewPrototype(objectClass);
+    dataViewClass = InternalClass::create(this, &DataView::static_vtbl, dataViewPrototype);
+    TypedArrayPrototype *typedArrayPrototypes[NTypedArrayTypes];
+    for (int i = 0; i < NTypedArrayTypes; ++i) {
+        typedArrayPrototypes[i] = new (memoryManager) TypedArrayPrototype(objectClass, TypedArrayType(i));
+        typedArrayClasses[i] = InternalClass::create(this, &TypedArray::static_vtbl, typedArrayPrototypes[i]);
+    }
+
     objectCtor = new (memoryManager) ObjectCtor(rootContext);
     stringCtor = new (memoryManager) StringCtor(rootContext);
     numberCtor = new (memoryManager) NumberCtor(rootContext);
@@ -329,6 +346,10 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
     syntaxErrorCtor = new (memoryManager) SyntaxErrorCtor(rootContext);
     typeErrorCtor = new (memoryManager) TypeErrorCtor(rootContext);
     uRIErrorCtor = new (memoryManager) URIErrorCtor(rootContext);
+    arrayBufferCtor = new (memoryManager) ArrayBufferCtor(rootContext);
+    dataViewCtor = new (memoryManager) DataViewCtor(rootContext);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayCtors[i] = new (memoryManager) TypedArrayCtor(rootContext, TypedArrayType(i));
 
     objectPrototype->init(this, objectCtor);
     stringPrototype->init(this, stringCtor);
@@ -345,6 +366,10 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
     syntaxErrorPrototype->init(this, syntaxErrorCtor);
     typeErrorPrototype->init(this, typeErrorCtor);
     uRIErrorPrototype->init(this, uRIErrorCtor);
+    arrayBufferPrototype->init(this, arrayBufferCtor);
+    dataViewPrototype->init(this, dataViewCtor);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayPrototypes[i]->init(this, typedArrayCtors[i]);
 
     variantPrototype->init();
     static_cast<SequencePrototype *>(sequencePrototype.managed())->init();
@@ -372,6 +397,10 @@ ExecutionEngine::ExecutionEngine(QQmlJS::EvalISelFactory *factory)
     globalObject->defineDefaultProperty(QStringLiteral("SyntaxError"), syntaxErrorCtor);
     globalObject->defineDefaultProperty(QStringLiteral("TypeError"), typeErrorCtor);
     globalObject->defineDefaultProperty(QStringLiteral("URIError"), uRIErrorCtor);
+    globalObject->defineDefaultProperty(QStringLiteral("ArrayBuffer"), arrayBufferCtor);
+    globalObject->defineDefaultProperty(QStringLiteral("DataView"), dataViewCtor);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        globalObject->defineDefaultProperty(QString::fromLatin1(typedArrayOperations[i].name), typedArrayCtors[i]);
     ScopedObject o(scope);
     globalObject->defineDefaultProperty(QStringLiteral("Math"), (o = new (memoryManager) MathObject(this)));
     globalObject->defineDefaultProperty(QStringLiteral("JSON"), (o = new (memoryManager) JsonObject(this)));
@@ -403,6 +432,8 @@ ExecutionEngine::~ExecutionEngine()
     delete debugger;
     delete m_multiplyWrappedQObjects;
     m_multiplyWrappedQObjects = 0;
+    if (!qgetenv("QV4_LOOKUP_STATS").isEmpty())
+        Lookup::dumpStatistics(this);
     delete identifierTable;
     delete memoryManager;
 
@@ -412,6 +443,7 @@ ExecutionEngine::~ExecutionEngine()
         unit->unlink();
 
     delete m_qmlExtensions;
+    delete lookupStubCache;
     emptyClass->destroy();
     delete classPool;
     delete bumperPointerAllocator;
@@ -422,6 +454,11 @@ ExecutionEngine::~ExecutionEngine()
     delete jsStack;
 }
 
+void ExecutionEngine::setForceInterpreter(bool force)
+{
+    forceInterpreter.store(force);
+}
+
 void ExecutionEngine::enableDebugger()
 {
     Q_ASSERT(!debugger);
@@ -631,6 +668,18 @@ Returned<Object> *ExecutionEngine::newVariantObject(const QVariant &v)
     return o->asReturned<Object>();
 }
 
+Returned<ArrayBuffer> *ExecutionEngine::newArrayBuffer(uint length)
+{
+    ArrayBuffer *object = new (memoryManager) ArrayBuffer(this, length);
+    return object->asReturned<ArrayBuffer>();
+}
+
+Returned<ArrayBuffer> *ExecutionEngine::newArrayBuffer(const QByteArray &array)
+{
+    ArrayBuffer *object = new (memoryManager) ArrayBuffer(this, array);
+    return object->asReturned<ArrayBuffer>();
+}
+
 Returned<Object> *ExecutionEngine::newForEachIteratorObject(ExecutionContext *ctx, const ObjectRef o)
 {
     Object *obj = new (memoryManager) ForEachIteratorObject(ctx, o);
@@ -821,6 +870,7 @@ void ExecutionEngine::markObjects()
     id_input->mark(this);
     id_toString->mark(this);
     id_valueOf->mark(this);
+    id_toJSON->mark(this);
 
     objectCtor.mark(this);
     stringCtor.mark(this);
@@ -837,6 +887,10 @@ void ExecutionEngine::markObjects()
     syntaxErrorCtor.mark(this);
     typeErrorCtor.mark(this);
     uRIErrorCtor.mark(this);
+    arrayBufferCtor.mark(this);
+    dataViewCtor.mark(this);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayCtors[i].mark(this);
     sequencePrototype.mark(this);
 
     exceptionValue.mark(this);
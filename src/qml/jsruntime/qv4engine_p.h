@@ -107,6 +107,7 @@ struct EvalFunction;
 struct IdentifierTable;
 struct InternalClass;
 struct InternalClassPool;
+struct LookupStubCache;
 class MultiplyWrappedQObjectMap;
 class RegExp;
 class RegExpCache;
@@ -146,9 +147,12 @@ public:
     WTF::PageAllocation *jsStack;
     SafeValue *jsStackBase;
 
+    // The garbage collector scans everything below jsStackTop, so new slots
+    // must not contain stale values from frames that were popped already.
     SafeValue *stackPush(uint nValues) {
         SafeValue *ptr = jsStackTop;
         jsStackTop = ptr + nValues;
+        memset(ptr, 0, nValues * sizeof(SafeValue));
         return ptr;
     }
     void stackPop(uint nValues) {
@@ -190,6 +194,9 @@ public:
     SafeValue syntaxErrorCtor;
     SafeValue typeErrorCtor;
     SafeValue uRIErrorCtor;
+    SafeValue arrayBufferCtor;
+    SafeValue dataViewCtor;
+    SafeValue typedArrayCtors[NTypedArrayTypes];
     SafeValue sequencePrototype;
 
     InternalClassPool *classPool;
@@ -224,6 +231,10 @@ public:
 
     InternalClass *variantClass;
 
+    InternalClass *arrayBufferClass;
+    InternalClass *dataViewClass;
+    InternalClass *typedArrayClasses[NTypedArrayTypes];
+
     EvalFunction *evalFunction;
     FunctionObject *thrower;
 
@@ -259,6 +270,7 @@ public:
     SafeString id_input;
     SafeString id_toString;
     SafeString id_valueOf;
+    SafeString id_toJSON;
 
     QSet<CompiledData::CompilationUnit*> compilationUnits;
     QMap<quintptr, QV4::Function*> allFunctions;
@@ -267,6 +279,9 @@ public:
 
     RegExpCache *regExpCache;
 
+    // shared by all megamorphic property lookups, created on demand
+    LookupStubCache *lookupStubCache;
+
     // Scarce resources are "exceptionally high cost" QVariant types where allowing the
     // normal JavaScript GC to clean them up is likely to lead to out-of-memory or other
     // out-of-resource situations.  When such a resource is passed into JavaScript we
@@ -289,6 +304,10 @@ public:
     ExecutionEngine(QQmlJS::EvalISelFactory *iselFactory = 0);
     ~ExecutionEngine();
 
+    // Makes engines created without an explicit factory use the interpreter, like
+    // QV4_FORCE_INTERPRETER does. Used by the tests of the interpreter's instructions.
+    static void setForceInterpreter(bool force);
+
     void enableDebugger();
 
     ExecutionContext *pushGlobalContext();
@@ -330,6 +349,9 @@ public:
 
     Returned<Object> *newVariantObject(const QVariant &v);
 
+    Returned<ArrayBuffer> *newArrayBuffer(uint length);
+    Returned<ArrayBuffer> *newArrayBuffer(const QByteArray &array);
+
     Returned<Object> *newForEachIteratorObject(ExecutionContext *ctx, const ObjectRef o);
 
     Returned<Object> *qmlContextObject() const;
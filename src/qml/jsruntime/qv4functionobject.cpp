@@ -137,6 +137,8 @@ void FunctionObject::init(const StringRef n, bool createProto)
     if (createProto) {
         Scoped<Object> proto(s, scope->engine->newObject(scope->engine->protoClass));
         proto->memberData[Index_ProtoConstructor].value = this->asReturnedValue();
+        // allocating the prototype may have promoted this function
+        writeBarrier();
         memberData[Index_Prototype].value = proto.asReturnedValue();
     }
 
@@ -134,6 +134,9 @@ struct DateObject;
 struct FunctionObject;
 struct ErrorObject;
 struct ArgumentsObject;
+struct ArrayBuffer;
+struct TypedArray;
+struct DataView;
 struct Managed;
 struct Lookup;
 struct ExecutionEngine;
@@ -170,6 +173,19 @@ namespace Global {
     };
 }
 
+enum TypedArrayType {
+    Int8Array,
+    UInt8Array,
+    UInt8ClampedArray,
+    Int16Array,
+    UInt16Array,
+    Int32Array,
+    UInt32Array,
+    Float32Array,
+    Float64Array,
+    NTypedArrayTypes
+};
+
 enum PropertyFlag {
     Attr_Data = 0,
     Attr_Accessor = 0x1,
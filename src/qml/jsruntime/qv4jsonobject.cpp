@@ -47,7 +47,7 @@
 #include <qv4scopedvalue_p.h>
 #include <qjsondocument.h>
 #include <qstack.h>
-#include <qstringlist.h>
+#include <private/qsimd_p.h>
 
 #include <wtf/MathExtras.h>
 
@@ -79,7 +79,9 @@ private:
 
     ReturnedValue parseObject();
     ReturnedValue parseArray();
-    bool parseMember(ObjectRef o);
+    bool parseMember(ObjectRef o, InternalClass *&shape, uint *matched);
+    bool matchKey(String *key);
+    void dropShape(ObjectRef o, InternalClass *shape, uint matched);
     bool parseString(QString *string);
     bool parseValue(ValueRef val);
     bool parseNumber(ValueRef val);
@@ -91,6 +93,9 @@ private:
 
     int nestingLevel;
     QJsonParseError::ParseError lastError;
+
+    // class of the last object completed on each nesting level
+    QVector<InternalClass *> shapes;
 };
 
 static const int nestingLimit = 1024;
@@ -159,6 +164,34 @@ bool JsonParser::eatSpace()
     return (json < end);
 }
 
+// Returns the first character at or after json that ends a run of plain
+// string characters: a quote, a backslash or a control character.
+static inline const QChar *scanStringRun(const QChar *json, const QChar *end)
+{
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi16(Quote);
+    const __m128i backslash = _mm_set1_epi16('\\');
+    const __m128i lastControl = _mm_set1_epi16(0x1f);
+    const __m128i zero = _mm_setzero_si128();
+    while (end - json >= 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(json));
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi16(data, quote), _mm_cmpeq_epi16(data, backslash));
+        // unsigned saturation leaves zero exactly for characters <= 0x1f
+        match = _mm_or_si128(match, _mm_cmpeq_epi16(_mm_subs_epu16(data, lastControl), zero));
+        if (_mm_movemask_epi8(match))
+            break;
+        json += 8;
+    }
+#endif
+    while (json < end) {
+        ushort c = json->unicode();
+        if (c == Quote || c == '\\' || c <= 0x1f)
+            break;
+        ++json;
+    }
+    return json;
+}
+
 QChar JsonParser::nextToken()
 {
     if (!eatSpace())
@@ -235,11 +268,19 @@ ReturnedValue JsonParser::parseObject()
     BEGIN << "parseObject pos=" << json;
     Scope scope(context);
 
-    ScopedObject o(scope, context->engine->newObject());
+    // Objects on the same nesting level usually have the same keys (think of
+    // an array of records). Create the object with the class of the last one
+    // completed on this level and fill in the values as long as the keys
+    // match, instead of adding the members one by one.
+    if (shapes.size() <= nestingLevel)
+        shapes.resize(nestingLevel + 1);
+    InternalClass *shape = shapes.at(nestingLevel);
+    ScopedObject o(scope, shape ? context->engine->newObject(shape) : context->engine->newObject());
+    uint matched = 0;
 
     QChar token = nextToken();
     while (token == Quote) {
-        if (!parseMember(o))
+        if (!parseMember(o, shape, &matched))
             return Encode::undefined();
         token = nextToken();
         if (token != ValueSeparator)
@@ -257,6 +298,10 @@ ReturnedValue JsonParser::parseObject()
         return Encode::undefined();
     }
 
+    if (shape && matched < shape->size)
+        dropShape(o, shape, matched);
+    shapes[nestingLevel] = o->internalClass;
+
     END;
 
     --nestingLevel;
@@ -266,11 +311,30 @@ ReturnedValue JsonParser::parseObject()
 /*
     member = string name-separator value
 */
-bool JsonParser::parseMember(ObjectRef o)
+bool JsonParser::parseMember(ObjectRef o, InternalClass *&shape, uint *matched)
 {
     BEGIN << "parseMember";
     Scope scope(context);
 
+    if (shape) {
+        if (*matched < shape->size && matchKey(shape->nameMap.at(*matched))) {
+            if (nextToken() != NameSeparator) {
+                lastError = QJsonParseError::MissingNameSeparator;
+                return false;
+            }
+            ScopedValue val(scope);
+            if (!parseValue(val))
+                return false;
+            o->memberData[*matched].value = val.asReturnedValue();
+            o->writeBarrier();
+            ++*matched;
+            END;
+            return true;
+        }
+        dropShape(o, shape, *matched);
+        shape = 0;
+    }
+
     QString key;
     if (!parseString(&key))
         return false;
@@ -296,6 +360,40 @@ bool JsonParser::parseMember(ObjectRef o)
     return true;
 }
 
+/*
+    Consumes the key and its closing quote if they spell out exactly the given
+    name without using any escapes.
+*/
+bool JsonParser::matchKey(String *key)
+{
+    const QString name = key->toQString();
+    const int length = name.length();
+    if (end - json <= length)
+        return false;
+    const QChar *n = name.constData();
+    for (int i = 0; i < length; ++i) {
+        ushort c = json[i].unicode();
+        if (c != n[i].unicode() || c == Quote || c == '\\' || c <= 0x1f)
+            return false;
+    }
+    if (json[length] != Quote)
+        return false;
+    json += length + 1;
+    return true;
+}
+
+/*
+    Gives the object the class holding just the members that were filled in
+    from the shape so far.
+*/
+void JsonParser::dropShape(ObjectRef o, InternalClass *shape, uint matched)
+{
+    InternalClass *ic = context->engine->objectClass;
+    for (uint i = 0; i < matched; ++i)
+        ic = ic->addMember(shape->nameMap.at(i), Attr_Data);
+    o->internalClass = ic;
+}
+
 /*
     array = begin-array [ value *( value-separator value ) ] end-array
 */
@@ -463,18 +561,31 @@ bool JsonParser::parseNumber(ValueRef val)
 
     const QChar *start = json;
     bool isInt = true;
+    bool negative = false;
+    int intValue = 0;
 
     // minus
-    if (json < end && *json == '-')
+    if (json < end && *json == '-') {
+        negative = true;
         ++json;
+    }
 
     // int = zero / ( digit1-9 *DIGIT )
+    const QChar *digits = json;
     if (json < end && *json == '0') {
         ++json;
     } else {
-        while (json < end && *json >= '0' && *json <= '9')
+        while (json < end && *json >= '0' && *json <= '9') {
+            // more than 9 digits could overflow, leave those to the slow path below
+            if (json - digits < 9)
+                intValue = intValue*10 + (json->unicode() - '0');
+            else
+                isInt = false;
             ++json;
+        }
     }
+    if (json == digits)
+        isInt = false;
 
     // frac = decimal-point 1*DIGIT
     if (json < end && *json == '.') {
@@ -494,19 +605,17 @@ bool JsonParser::parseNumber(ValueRef val)
             ++json;
     }
 
-    QString number(start, json - start);
-    DEBUG << "numberstring" << number;
-
     if (isInt) {
-        bool ok;
-        int n = number.toInt(&ok);
-        if (ok && n < (1<<25) && n > -(1<<25)) {
-            *val = Primitive::fromInt32(n);
-            END;
-            return true;
-        }
+        // no need to go through a string for the common case
+        int n = negative ? -intValue : intValue;
+        *val = (n < (1<<25) && n > -(1<<25)) ? Primitive::fromInt32(n) : Primitive::fromDouble(n);
+        END;
+        return true;
     }
 
+    QString number(start, json - start);
+    DEBUG << "numberstring" << number;
+
     bool ok;
     double d;
     d = number.toDouble(&ok);
@@ -609,6 +718,14 @@ bool JsonParser::parseString(QString *string)
     BEGIN << "parse string stringPos=" << json;
 
     while (json < end) {
+        // copy runs of plain characters in one go, most strings are nothing else
+        const QChar *run = json;
+        json = scanStringRun(json, end);
+        if (json != run)
+            string->append(run, int(json - run));
+        if (json >= end)
+            break;
+
         if (*json == '"')
             break;
         else if (*json == '\\') {
@@ -624,12 +741,9 @@ bool JsonParser::parseString(QString *string)
                 *string += QChar(ch);
             }
         } else {
-            if (json->unicode() <= 0x1f) {
-                lastError = QJsonParseError::IllegalEscapeSequence;
-                return false;
-            }
-            *string += *json;
-            ++json;
+            // a control character
+            lastError = QJsonParseError::IllegalEscapeSequence;
+            return false;
         }
     }
     ++json;
@@ -644,6 +758,8 @@ bool JsonParser::parseString(QString *string)
 }
 
 
+// Writes everything into one growing buffer instead of concatenating the
+// results of the recursive calls.
 struct Stringify
 {
     ExecutionContext *ctx;
@@ -651,24 +767,36 @@ struct Stringify
     QVector<String *> propertyList;
     QString gap;
     QString indent;
+    QString result;
 
     QStack<Object *> stack;
 
     Stringify(ExecutionContext *ctx) : ctx(ctx), replacerFunction(0) {}
 
-    QString Str(const QString &key, ValueRef v);
-    QString JA(ArrayObjectRef a);
-    QString JO(ObjectRef o);
+    bool Str(const ValueRef key, ValueRef v);
+    void JA(ArrayObjectRef a);
+    void JO(ObjectRef o);
 
-    QString makeMember(const QString &key, ValueRef v);
+    bool makeMember(const ValueRef key, ValueRef v, bool first);
+    void newLine(const QString &indentation);
 };
 
-static QString quote(const QString &str)
+static void quote(QString &product, const QString &str)
 {
-    QString product = QStringLiteral("\"");
-    for (int i = 0; i < str.length(); ++i) {
-        QChar c = str.at(i);
-        switch (c.unicode()) {
+    product += QLatin1Char('"');
+    const QChar *begin = str.constData();
+    const QChar *end = begin + str.length();
+    const QChar *c = begin;
+    while (c < end) {
+        // only quotes, backslashes and control characters need escaping
+        const QChar *run = c;
+        c = scanStringRun(c, end);
+        if (c != run)
+            product.append(run, int(c - run));
+        if (c == end)
+            break;
+
+        switch (c->unicode()) {
         case '"':
             product += QStringLiteral("\\\"");
             break;
@@ -691,32 +819,31 @@ static QString quote(const QString &str)
             product += QStringLiteral("\\t");
             break;
         default:
-            if (c.unicode() <= 0x1f) {
-                product += QStringLiteral("\\u00");
-                product += c.unicode() > 0xf ? QLatin1Char('1') : QLatin1Char('0');
-                product += QLatin1Char("0123456789abcdef"[c.unicode() & 0xf]);
-            } else {
-                product += c;
-            }
+            product += QStringLiteral("\\u00");
+            product += c->unicode() > 0xf ? QLatin1Char('1') : QLatin1Char('0');
+            product += QLatin1Char("0123456789abcdef"[c->unicode() & 0xf]);
         }
+        ++c;
     }
     product += QLatin1Char('"');
-    return product;
 }
 
-QString Stringify::Str(const QString &key, ValueRef v)
+/*
+    Appends the serialization of v to the result, returns false and appends
+    nothing if v is undefined or a function.
+*/
+bool Stringify::Str(const ValueRef key, ValueRef v)
 {
     Scope scope(ctx);
 
     ScopedValue value(scope, *v);
     ScopedObject o(scope, value);
     if (o) {
-        ScopedString s(scope, ctx->engine->newString(QStringLiteral("toJSON")));
-        Scoped<FunctionObject> toJSON(scope, o->get(s));
+        Scoped<FunctionObject> toJSON(scope, o->get(ctx->engine->id_toJSON));
         if (!!toJSON) {
             ScopedCallData callData(scope, 1);
             callData->thisObject = value;
-            callData->args[0] = ctx->engine->newString(key);
+            callData->args[0] = key->toString(ctx);
             value = toJSON->call(callData);
         }
     }
@@ -725,7 +852,7 @@ QString Stringify::Str(const QString &key, ValueRef v)
         ScopedObject holder(scope, ctx->engine->newObject());
         holder->put(ctx, QString(), value);
         ScopedCallData callData(scope, 2);
-        callData->args[0] = ctx->engine->newString(key);
+        callData->args[0] = key->toString(ctx);
         callData->args[1] = value;
         callData->thisObject = holder;
         value = replacerFunction->call(callData);
@@ -741,16 +868,33 @@ QString Stringify::Str(const QString &key, ValueRef v)
             value = b->value;
     }
 
-    if (value->isNull())
-        return QStringLiteral("null");
-    if (value->isBoolean())
-        return value->booleanValue() ? QStringLiteral("true") : QStringLiteral("false");
-    if (value->isString())
-        return quote(value->stringValue()->toQString());
+    if (value->isNull()) {
+        result += QStringLiteral("null");
+        return true;
+    }
+    if (value->isBoolean()) {
+        result += value->booleanValue() ? QStringLiteral("true") : QStringLiteral("false");
+        return true;
+    }
+    if (value->isString()) {
+        quote(result, value->stringValue()->toQString());
+        return true;
+    }
 
+    if (value->isInteger()) {
+        result += QString::number(value->integerValue());
+        return true;
+    }
     if (value->isNumber()) {
         double d = value->toNumber();
-        return std::isfinite(d) ? value->toString(ctx)->toQString() : QStringLiteral("null");
+        if (std::isfinite(d)) {
+            QString number;
+            __qmljs_numberToString(&number, d);
+            result += number;
+        } else {
+            result += QStringLiteral("null");
+        }
+        return true;
     }
 
     o = value.asReturnedValue();
@@ -758,44 +902,60 @@ QString Stringify::Str(const QString &key, ValueRef v)
         if (!o->asFunctionObject()) {
             if (o->asArrayObject()) {
                 ScopedArrayObject a(scope, o);
-                return JA(a);
+                JA(a);
             } else {
-                return JO(o);
+                JO(o);
             }
+            return true;
         }
     }
 
-    return QString();
+    return false;
 }
 
-QString Stringify::makeMember(const QString &key, ValueRef v)
+void Stringify::newLine(const QString &indentation)
 {
-    QString strP = Str(key, v);
-    if (!strP.isEmpty()) {
-        QString member = quote(key) + QLatin1Char(':');
-        if (!gap.isEmpty())
-            member += QLatin1Char(' ');
-        member += strP;
-        return member;
+    if (!gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += indentation;
     }
-    return QString();
 }
 
-QString Stringify::JO(ObjectRef o)
+/*
+    Appends the separator, key and value of a member, or nothing at all if
+    the value doesn't serialize.
+*/
+bool Stringify::makeMember(const ValueRef key, ValueRef v, bool first)
+{
+    const int mark = result.length();
+    if (!first)
+        result += QLatin1Char(',');
+    newLine(indent);
+    quote(result, key->stringValue()->toQString());
+    result += QLatin1Char(':');
+    if (!gap.isEmpty())
+        result += QLatin1Char(' ');
+    if (Str(key, v))
+        return true;
+    result.truncate(mark);
+    return false;
+}
+
+void Stringify::JO(ObjectRef o)
 {
     if (stack.contains(o.getPointer())) {
         ctx->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(ctx);
 
-    QString result;
     stack.push(o.getPointer());
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('{');
+    bool empty = true;
     if (propertyList.isEmpty()) {
         ObjectIterator it(scope, o, ObjectIterator::EnumerableOnly);
         ScopedValue name(scope);
@@ -805,82 +965,66 @@ QString Stringify::JO(ObjectRef o)
             name = it.nextPropertyNameAsString(val);
             if (name->isNull())
                 break;
-            QString key = name->toQString();
-            QString member = makeMember(key, val);
-            if (!member.isEmpty())
-                partial += member;
+            if (makeMember(name, val, empty))
+                empty = false;
         }
     } else {
         ScopedString s(scope);
+        ScopedValue name(scope);
         for (int i = 0; i < propertyList.size(); ++i) {
             bool exists;
             s = propertyList.at(i);
             ScopedValue v(scope, o->get(s, &exists));
             if (!exists)
                 continue;
-            QString member = makeMember(s->toQString(), v);
-            if (!member.isEmpty())
-                partial += member;
+            name = s.asReturnedValue();
+            if (makeMember(name, v, empty))
+                empty = false;
         }
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("{}");
-    } else if (gap.isEmpty()) {
-        result = QStringLiteral("{") + partial.join(QLatin1Char(',')) + QStringLiteral("}");
-    } else {
-        QString separator = QStringLiteral(",\n") + indent;
-        result = QStringLiteral("{\n") + indent + partial.join(separator) + QStringLiteral("\n") + stepback + QStringLiteral("}");
-    }
+    if (!empty)
+        newLine(stepback);
+    result += QLatin1Char('}');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
-QString Stringify::JA(ArrayObjectRef a)
+void Stringify::JA(ArrayObjectRef a)
 {
     if (stack.contains(a.getPointer())) {
         ctx->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(a->engine());
 
-    QString result;
     stack.push(a.getPointer());
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('[');
     uint len = a->arrayLength();
     ScopedValue v(scope);
+    ScopedValue key(scope);
     for (uint i = 0; i < len; ++i) {
+        if (i)
+            result += QLatin1Char(',');
+        newLine(indent);
         bool exists;
         v = a->getIndexed(i, &exists);
-        if (!exists) {
-            partial += QStringLiteral("null");
-            continue;
-        }
-        QString strP = Str(QString::number(i), v);
-        if (!strP.isEmpty())
-            partial += strP;
-        else
-            partial += QStringLiteral("null");
+        key = Primitive::fromUInt32(i);
+        if (!exists || !Str(key, v))
+            result += QStringLiteral("null");
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("[]");
-    } else if (gap.isEmpty()) {
-        result = QStringLiteral("[") + partial.join(QLatin1Char(',')) + QStringLiteral("]");
-    } else {
-        QString separator = QStringLiteral(",\n") + indent;
-        result = QStringLiteral("[\n") + indent + partial.join(separator) + QStringLiteral("\n") + stepback + QStringLiteral("]");
-    }
+    if (len)
+        newLine(stepback);
+    result += QLatin1Char(']');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
 
@@ -954,10 +1098,10 @@ ReturnedValue JsonObject::method_stringify(CallContext *ctx)
 
 
     ScopedValue arg0(scope, ctx->argument(0));
-    QString result = stringify.Str(QString(), arg0);
-    if (result.isEmpty() || scope.engine->hasException)
+    ScopedValue key(scope, ctx->engine->newString(QString()));
+    if (!stringify.Str(key, arg0) || scope.engine->hasException)
         return Encode::undefined();
-    return ctx->engine->newString(result)->asReturnedValue();
+    return ctx->engine->newString(stringify.result)->asReturnedValue();
 }
 
 
@@ -1057,8 +1201,11 @@ QV4::ReturnedValue JsonObject::fromJsonArray(ExecutionEngine *engine, const QJso
     int size = array.size();
     Scoped<ArrayObject> a(scope, engine->newArrayObject());
     a->arrayReserve(size);
+    ScopedValue v(scope);
     for (int i = 0; i < size; i++) {
-        a->arrayData[i].value = fromJsonValue(engine, array.at(i));
+        v = fromJsonValue(engine, array.at(i));
+        a->writeBarrier();
+        a->arrayData[i].value = v.asReturnedValue();
         a->arrayDataLen = i + 1;
     }
     a->setArrayLengthUnchecked(size);
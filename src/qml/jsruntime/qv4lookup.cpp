@@ -41,6 +41,12 @@
 #include "qv4lookup_p.h"
 #include "qv4functionobject_p.h"
 #include "qv4scopedvalue_p.h"
+#include "qv4identifiertable_p.h"
+#include "qv4arrayobject_p.h"
+#include <private/qv4compileddata_p.h>
+
+#include <algorithm>
+#include <iostream>
 
 QT_BEGIN_NAMESPACE
 
@@ -76,9 +82,108 @@ Property *Lookup::lookup(Object *obj, PropertyAttributes *attrs)
     return 0;
 }
 
+bool LookupStubCache::lookup(InternalClass *c, const Identifier *id, Entry **e)
+{
+    Entry *entry = this->entry(c, id);
+    *e = entry;
+    if (entry->internalClass == c && entry->identifier == id)
+        return true;
+
+    entry->internalClass = c;
+    entry->identifier = id;
+    entry->index = c->propertyTable.lookup(id);
+    if (entry->index < c->size)
+        entry->attrs = c->propertyData.at(entry->index);
+    else
+        entry->index = UINT_MAX;
+    return false;
+}
+
+// Returns the entry of the polymorphic cache for the receiver class c, which is
+// appended if c hasn't been seen yet. Returns 0 if there is no room left.
+Lookup::PolymorphicEntry *Lookup::polymorphicEntry(InternalClass *c)
+{
+    if (!polymorphic) {
+        polymorphic = new PolymorphicCache;
+        polymorphic->count = 0;
+    }
+    for (int i = 0; i < polymorphic->count; ++i) {
+        if (polymorphic->entries[i].objectClass == c)
+            return polymorphic->entries + i;
+    }
+    if (polymorphic->count == PolymorphicSize)
+        return 0;
+    PolymorphicEntry *e = polymorphic->entries + polymorphic->count++;
+    e->objectClass = c;
+    return e;
+}
+
+// Called after lookup() found a data property. Adds the class of the object to
+// the cache of the site, or switches the site to the megamorphic stub cache once
+// there is no room left. A receiver class that is cached already gets its entry
+// updated, e.g. when the prototype holding the property changed shape.
+void Lookup::addPolymorphicGetter()
+{
+    if (level > 1) {
+        getter = level == 2 ? getter2 : getterGeneric;
+        return;
+    }
+    PolymorphicEntry *e = polymorphicEntry(classList[0]);
+    if (!e) {
+        getter = getterMegamorphic;
+        return;
+    }
+    e->holderClass = level ? classList[1] : 0;
+    e->index = index;
+    getter = getterPolymorphic;
+}
+
+void Lookup::addPolymorphicSetter()
+{
+    PolymorphicEntry *e = polymorphicEntry(classList[0]);
+    if (!e) {
+        setter = setterMegamorphic;
+        return;
+    }
+    e->holderClass = 0;
+    e->index = index;
+    setter = setterPolymorphic;
+}
+
+// Called when a monomorphic get site misses, before lookup() overwrites the class
+// list. This way the class the site was specialized for stays cached if the site
+// turns polymorphic.
+void Lookup::keepMonomorphicGetter()
+{
+    PolymorphicEntry *e = polymorphicEntry(classList[0]);
+    if (!e)
+        return;
+    e->holderClass = level ? classList[1] : 0;
+    e->index = index;
+}
+
+void Lookup::keepMonomorphicSetter()
+{
+    PolymorphicEntry *e = polymorphicEntry(classList[0]);
+    if (!e)
+        return;
+    e->holderClass = 0;
+    e->index = index;
+}
+
+LookupStubCache *Lookup::stubCache()
+{
+    ExecutionEngine *engine = name->engine();
+    if (!engine->lookupStubCache)
+        engine->lookupStubCache = new LookupStubCache;
+    // make sure the name has been resolved to an identifier
+    engine->identifierTable->identifier(name);
+    return engine->lookupStubCache;
+}
 
 ReturnedValue Lookup::getterGeneric(QV4::Lookup *l, const ValueRef object)
 {
+    ++l->misses;
     if (Object *o = object->asObject())
         return o->getLookup(l);
 
@@ -137,6 +242,7 @@ ReturnedValue Lookup::getter0(Lookup *l, const ValueRef object)
         if (l->classList[0] == o->internalClass)
             return static_cast<Object *>(o)->memberData[l->index].value.asReturnedValue();
     }
+    l->keepMonomorphicGetter();
     l->getter = getterGeneric;
     return getterGeneric(l, object);
 }
@@ -151,6 +257,7 @@ ReturnedValue Lookup::getter1(Lookup *l, const ValueRef object)
             l->classList[1] == o->prototype()->internalClass)
             return o->prototype()->memberData[l->index].value.asReturnedValue();
     }
+    l->keepMonomorphicGetter();
     l->getter = getterGeneric;
     return getterGeneric(l, object);
 }
@@ -316,6 +423,61 @@ ReturnedValue Lookup::stringLengthGetter(Lookup *l, const ValueRef object)
     return getterGeneric(l, object);
 }
 
+ReturnedValue Lookup::getterPolymorphic(Lookup *l, const ValueRef object)
+{
+    if (object->isManaged()) {
+        // we can safely cast to a QV4::Object here. If object is actually a string,
+        // the internal class won't match
+        Object *o = object->objectValue();
+        InternalClass *c = o->internalClass;
+        const PolymorphicCache *cache = l->polymorphic;
+        for (int i = 0; i < cache->count; ++i) {
+            const PolymorphicEntry &e = cache->entries[i];
+            if (e.objectClass != c)
+                continue;
+            if (!e.holderClass) {
+                ++l->hits;
+                return o->memberData[e.index].value.asReturnedValue();
+            }
+            Object *p = c->prototype;
+            if (p && p->internalClass == e.holderClass) {
+                ++l->hits;
+                return p->memberData[e.index].value.asReturnedValue();
+            }
+            // the generic lookup replaces the stale holder of this entry
+            break;
+        }
+    }
+    // adds the class to the cache
+    return getterGeneric(l, object);
+}
+
+ReturnedValue Lookup::getterMegamorphic(Lookup *l, const ValueRef object)
+{
+    Object *o = object->asObject();
+    if (!o)
+        return getterGeneric(l, object);
+
+    LookupStubCache *cache = o->engine()->lookupStubCache;
+    const Identifier *id = l->name->identifier;
+    bool hit = true;
+    while (o) {
+        LookupStubCache::Entry *e;
+        if (!cache->lookup(o->internalClass, id, &e))
+            hit = false;
+        if (e->index != UINT_MAX) {
+            if (hit)
+                ++l->hits;
+            else
+                ++l->misses;
+            return Object::getValue(object, o->memberData + e->index, e->attrs);
+        }
+        o = o->prototype();
+    }
+    ++l->misses;
+    return Encode::undefined();
+}
+
 
 ReturnedValue Lookup::globalGetterGeneric(Lookup *l, ExecutionContext *ctx)
 {
@@ -443,6 +605,7 @@ ReturnedValue Lookup::globalGetterAccessor2(Lookup *l, ExecutionContext *ctx)
 
 void Lookup::setterGeneric(Lookup *l, const ValueRef object, const ValueRef value)
 {
+    ++l->misses;
     Scope scope(l->name->engine());
     ScopedObject o(scope, object);
     if (!o) {
@@ -460,10 +623,12 @@ void Lookup::setter0(Lookup *l, const ValueRef object, const ValueRef value)
 {
     Object *o = object->asObject();
     if (o && o->internalClass == l->classList[0]) {
+        o->writeBarrier();
         o->memberData[l->index].value = *value;
         return;
     }
 
+    l->keepMonomorphicSetter();
     l->setter = setterGeneric;
     setterGeneric(l, object, value);
 }
@@ -475,6 +640,7 @@ void Lookup::setterInsert0(Lookup *l, const ValueRef object, const ValueRef valu
         if (!o->prototype()) {
             if (l->index >= o->memberDataAlloc)
                 o->ensureMemberIndex(l->index);
+            o->writeBarrier();
             o->memberData[l->index].value = *value;
             o->internalClass = l->classList[3];
             return;
@@ -493,6 +659,7 @@ void Lookup::setterInsert1(Lookup *l, const ValueRef object, const ValueRef valu
         if (p && p->internalClass == l->classList[1]) {
             if (l->index >= o->memberDataAlloc)
                 o->ensureMemberIndex(l->index);
+            o->writeBarrier();
             o->memberData[l->index].value = *value;
             o->internalClass = l->classList[3];
             return;
@@ -513,6 +680,7 @@ void Lookup::setterInsert2(Lookup *l, const ValueRef object, const ValueRef valu
             if (p && p->internalClass == l->classList[2]) {
                 if (l->index >= o->memberDataAlloc)
                     o->ensureMemberIndex(l->index);
+                o->writeBarrier();
                 o->memberData[l->index].value = *value;
                 o->internalClass = l->classList[3];
                 return;
@@ -524,4 +692,99 @@ void Lookup::setterInsert2(Lookup *l, const ValueRef object, const ValueRef valu
     setterGeneric(l, object, value);
 }
 
+void Lookup::setterPolymorphic(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    Object *o = object->asObject();
+    if (o) {
+        const PolymorphicCache *cache = l->polymorphic;
+        for (int i = 0; i < cache->count; ++i) {
+            const PolymorphicEntry &e = cache->entries[i];
+            if (e.objectClass == o->internalClass) {
+                ++l->hits;
+                o->writeBarrier();
+                o->memberData[e.index].value = *value;
+                return;
+            }
+        }
+    }
+
+    // adds the class to the cache
+    setterGeneric(l, object, value);
+}
+
+void Lookup::setterMegamorphic(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    Object *o = object->asObject();
+    if (o) {
+        LookupStubCache::Entry *e;
+        const bool hit = o->engine()->lookupStubCache->lookup(o->internalClass, l->name->identifier, &e);
+        if (e->index != UINT_MAX && e->attrs.isData() && e->attrs.isWritable()
+                && (!o->isArrayObject() || e->index != ArrayObject::LengthPropertyIndex)) {
+            if (hit)
+                ++l->hits;
+            else
+                ++l->misses;
+            o->writeBarrier();
+            o->memberData[e->index].value = *value;
+            return;
+        }
+    }
+
+    // the site stays megamorphic
+    ++l->misses;
+    Scope scope(l->name->engine());
+    ScopedObject obj(scope, object);
+    if (!obj) {
+        obj = __qmljs_convert_to_object(scope.engine->currentContext(), object);
+        if (!obj) // type error
+            return;
+    }
+    ScopedString s(scope, l->name);
+    obj->put(s, value);
+}
+
+static bool lookupStatisticsLessThan(const LookupStatistics &a, const LookupStatistics &b)
+{
+    return a.misses > b.misses;
+}
+
+// Returns the get and set sites of all compilation units that have missed their
+// inline cache, the ones with the most misses first.
+QVector<LookupStatistics> Lookup::statistics(ExecutionEngine *engine)
+{
+    QVector<LookupStatistics> result;
+    foreach (CompiledData::CompilationUnit *unit, engine->compilationUnits) {
+        if (!unit->runtimeLookups)
+            continue;
+        const CompiledData::Lookup *compiledLookups = unit->data->lookupTable();
+        for (uint i = 0; i < unit->data->lookupTableSize; ++i) {
+            const Lookup &l = unit->runtimeLookups[i];
+            if (compiledLookups[i].type_and_flags == CompiledData::Lookup::Type_GlobalGetter || l.misses <= 1)
+                continue;
+            LookupStatistics stats;
+            stats.fileName = unit->fileName();
+            stats.name = l.name->toQString();
+            stats.hits = l.hits;
+            stats.misses = l.misses;
+            stats.classes = l.polymorphic ? l.polymorphic->count : 1;
+            stats.megamorphic = l.getter == getterMegamorphic || l.setter == setterMegamorphic;
+            result.append(stats);
+        }
+    }
+    std::sort(result.begin(), result.end(), lookupStatisticsLessThan);
+    return result;
+}
+
+void Lookup::dumpStatistics(ExecutionEngine *engine)
+{
+    const QVector<LookupStatistics> stats = statistics(engine);
+    std::cerr << "=================" << std::endl;
+    std::cerr << "Property lookups with cache misses:" << std::endl;
+    for (QVector<LookupStatistics>::const_iterator it = stats.constBegin(), end = stats.constEnd(); it != end; ++it) {
+        std::cerr << "\t" << qPrintable(it->fileName) << ": " << qPrintable(it->name)
+                  << (it->megamorphic ? " (megamorphic)" : "")
+                  << " classes " << it->classes << ", hits " << it->hits << ", misses " << it->misses << std::endl;
+    }
+}
+
 QT_END_NAMESPACE
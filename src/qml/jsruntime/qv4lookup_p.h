@@ -52,8 +52,51 @@ QT_BEGIN_NAMESPACE
 
 namespace QV4 {
 
-struct Lookup {
-    enum { Size = 4 };
+struct LookupStatistics {
+    QString fileName;
+    QString name;
+    uint hits;
+    uint misses;
+    // classes seen by a polymorphic site
+    int classes;
+    bool megamorphic;
+};
+
+// Caches own properties by internal class and name for all megamorphic sites
+// of an engine. Entries with an index of UINT_MAX record that there is no such
+// property, so that lookups on the prototype chain can be cached as well.
+struct LookupStubCache {
+    enum { Size = 1024 };
+    struct Entry {
+        InternalClass *internalClass;
+        const Identifier *identifier;
+        uint index;
+        PropertyAttributes attrs;
+    };
+    Entry entries[Size];
+
+    LookupStubCache() { memset(entries, 0, sizeof(entries)); }
+
+    Entry *entry(InternalClass *c, const Identifier *id) {
+        return entries + ((uint(quintptr(c) >> 4) ^ uint(quintptr(id) >> 3)) & (Size - 1));
+    }
+    // returns true if the entry for c and id was already cached
+    bool lookup(InternalClass *c, const Identifier *id, Entry **e);
+};
+
+struct Q_QML_EXPORT Lookup {
+    enum { Size = 4, PolymorphicSize = 8 };
+    struct PolymorphicEntry {
+        InternalClass *objectClass;
+        // class of the prototype the property lives on, 0 for own properties
+        InternalClass *holderClass;
+        uint index;
+    };
+    struct PolymorphicCache {
+        int count;
+        PolymorphicEntry entries[PolymorphicSize];
+    };
+
     union {
         ReturnedValue (*getter)(Lookup *l, const ValueRef object);
         ReturnedValue (*globalGetter)(Lookup *l, ExecutionContext *ctx);
@@ -71,6 +114,12 @@ struct Lookup {
     int level;
     uint index;
     String *name;
+    // allocated once a get or set site has seen more than one internal class
+    PolymorphicCache *polymorphic;
+    // misses are counted for every trip through the generic lookup, hits only
+    // once the site is polymorphic
+    uint hits;
+    uint misses;
 
     static ReturnedValue getterGeneric(Lookup *l, const ValueRef object);
     static ReturnedValue getter0(Lookup *l, const ValueRef object);
@@ -85,6 +134,8 @@ struct Lookup {
     static ReturnedValue primitiveGetterAccessor0(Lookup *l, const ValueRef object);
     static ReturnedValue primitiveGetterAccessor1(Lookup *l, const ValueRef object);
     static ReturnedValue stringLengthGetter(Lookup *l, const ValueRef object);
+    static ReturnedValue getterPolymorphic(Lookup *l, const ValueRef object);
+    static ReturnedValue getterMegamorphic(Lookup *l, const ValueRef object);
 
     static ReturnedValue globalGetterGeneric(Lookup *l, ExecutionContext *ctx);
     static ReturnedValue globalGetter0(Lookup *l, ExecutionContext *ctx);
@@ -99,8 +150,20 @@ struct Lookup {
     static void setterInsert0(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterInsert1(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterInsert2(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterPolymorphic(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterMegamorphic(Lookup *l, const ValueRef object, const ValueRef value);
 
     Property *lookup(Object *obj, PropertyAttributes *attrs);
+    bool isPolymorphic() const { return misses > 1; }
+    PolymorphicEntry *polymorphicEntry(InternalClass *c);
+    void addPolymorphicGetter();
+    void addPolymorphicSetter();
+    void keepMonomorphicGetter();
+    void keepMonomorphicSetter();
+    LookupStubCache *stubCache();
+
+    static QVector<LookupStatistics> statistics(ExecutionEngine *engine);
+    static void dumpStatistics(ExecutionEngine *engine);
 
 };
 
@@ -42,6 +42,7 @@
 #include "qv4managed_p.h"
 #include "qv4mm_p.h"
 #include "qv4errorobject_p.h"
+#include "qv4typedarray_p.h"
 
 using namespace QV4;
 
@@ -98,6 +99,12 @@ ExecutionEngine *Managed::engine() const
     return internalClass ? internalClass->engine : 0;
 }
 
+void Managed::remember()
+{
+    Q_ASSERT(internalClass);
+    internalClass->engine->memoryManager->remember(this);
+}
+
 QString Managed::className() const
 {
     const char *s = 0;
@@ -169,6 +176,15 @@ QString Managed::className() const
     case Type_RegExp:
         s = "RegExp";
         break;
+    case Type_ArrayBuffer:
+        s = "ArrayBuffer";
+        break;
+    case Type_TypedArray:
+        s = typedArrayOperations[subtype].name;
+        break;
+    case Type_DataView:
+        s = "DataView";
+        break;
     case Type_QmlSequence:
         s = "QmlSequence";
         break;
@@ -169,6 +169,14 @@ public:
     void operator delete(void *ptr, MemoryManager *mm);
 
     inline void mark(QV4::ExecutionEngine *engine);
+    inline void writeBarrier()
+    {
+        // Outside of a collection, only objects that survived one in generational
+        // mode or that were scanned by an incremental collection carry a mark bit,
+        // see MemoryManager::remember()
+        if (markBit && !(flags & Remembered))
+            remember();
+    }
 
     enum Type {
         Type_Invalid,
@@ -187,6 +195,9 @@ public:
         Type_MathObject,
         Type_ForeachIteratorObject,
         Type_RegExp,
+        Type_ArrayBuffer,
+        Type_TypedArray,
+        Type_DataView,
 
         Type_QmlSequence
     };
@@ -224,6 +235,8 @@ public:
     DateObject *asDateObject() { return type == Type_DateObject ? reinterpret_cast<DateObject *>(this) : 0; }
     ErrorObject *asErrorObject() { return type == Type_ErrorObject ? reinterpret_cast<ErrorObject *>(this) : 0; }
     ArgumentsObject *asArgumentsObject() { return type == Type_ArgumentsObject ? reinterpret_cast<ArgumentsObject *>(this) : 0; }
+    ArrayBuffer *asArrayBuffer() { return type == Type_ArrayBuffer ? reinterpret_cast<ArrayBuffer *>(this) : 0; }
+    TypedArray *asTypedArray() { return type == Type_TypedArray ? reinterpret_cast<TypedArray *>(this) : 0; }
 
     bool isListType() const { return type == Type_QmlSequence; }
 
@@ -282,7 +295,8 @@ public:
     InternalClass *internalClass;
 
     enum {
-        SimpleArray = 1
+        SimpleArray = 1,
+        Remembered = 2
     };
 
     union {
@@ -303,6 +317,8 @@ public:
     };
 
 private:
+    void remember();
+
     friend class MemoryManager;
     friend struct Identifiers;
     friend struct ObjectIterator;
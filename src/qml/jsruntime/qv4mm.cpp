@@ -49,6 +49,7 @@
 #include "StdLibExtras.h"
 
 #include <QTime>
+#include <QElapsedTimer>
 #include <QVector>
 #include <QVector>
 #include <QMap>
@@ -77,6 +78,12 @@ using namespace QV4;
 using namespace WTF;
 
 static const std::size_t CHUNK_SIZE = 1024*32;
+static const std::size_t NURSERY_SIZE = 1024*1024*4;
+static const int INCREMENTAL_BUDGET = 2000;
+// allocations in between two marking steps run from alloc()
+static const uint INCREMENTAL_STEP_ALLOCATIONS = 4096;
+// memory held outside the heap, e.g. by ArrayBuffers, that triggers a collection
+static const std::size_t MIN_UNMANAGED_HEAP_LIMIT = 1024*1024*4;
 
 #if OS(WINCE)
 void* g_stackBase = 0;
@@ -142,26 +149,80 @@ struct MemoryManager::Data
     bool scribble;
     bool aggressiveGC;
     bool exactGC;
+    bool generationalGC;
+    bool collectingNursery;
+    bool forceFullGC;
+    bool incrementalGC;
+    bool incrementalMarking;
+    bool lazySweep;
+    bool sweepingFullHeap;
+    bool printStats;
     ExecutionEngine *engine;
     quintptr *stackTop;
 
     enum { MaxItemSize = 512 };
+    struct Chunk {
+        PageAllocation memory;
+        int chunkSize;
+        // items freed by the last sweep of this chunk
+        Managed *freeItems;
+        // start of the part of the chunk that has never been allocated from
+        char *unusedItems;
+        bool inNursery;
+        // nothing in the chunk survived its last sweep
+        bool empty;
+
+        char *end() const {
+            return reinterpret_cast<char *>(memory.base()) + (memory.size() / chunkSize) * chunkSize;
+        }
+    };
+
+    // allocation state of the chunk we're currently allocating from, per size class
+    Chunk *currentChunk[MaxItemSize/16];
     Managed *smallItems[MaxItemSize/16];
+    char *unusedItems[MaxItemSize/16];
+    char *unusedItemsEnd[MaxItemSize/16];
+
     uint nChunks[MaxItemSize/16];
     uint availableItems[MaxItemSize/16];
     uint allocCount[MaxItemSize/16];
     int totalItems;
     int totalAlloc;
-    struct Chunk {
-        PageAllocation memory;
-        int chunkSize;
-    };
-
-    QVector<Chunk> heapChunks;
 
+    QVector<Chunk *> heapChunks;
+    QVector<Chunk *> chunksWithFreeItems[MaxItemSize/16];
+    // chunks left to be swept after the last collection, see MemoryManager::sweepUnsweptChunk()
+    QVector<Chunk *> unsweptChunks[MaxItemSize/16];
+    int unsweptChunkCount;
+
+    // Chunks that have been allocated from since the last collection. With
+    // generational collection enabled these are the only chunks that can
+    // contain young objects, so a minor collection only sweeps those.
+    QVector<Chunk *> nursery;
+    std::size_t nurserySize;
+    std::size_t nurseryLimit;
+    std::size_t heapSize;
+    std::size_t heapSizeAfterFullGC;
+    // see MemoryManager::changeUnmanagedHeapSizeUsage()
+    std::size_t unmanagedHeapSize;
+    std::size_t unmanagedHeapLimit;
+
+    // old objects written to since the last collection, see MemoryManager::remember()
+    QVector<Managed *> rememberedSet;
+    // old execution contexts, which the JIT and the interpreter write to without a barrier
+    QVector<Managed *> oldContexts;
+
+    // incremental collection: time per marking step in microseconds
+    int incrementalBudget;
+    uint allocationsSinceStep;
+    // items still to be scanned when the last marking step ran out of time
+    QVector<Managed *> greyItems;
+    // contexts scanned by marking steps, their locals are rescanned in the final pause
+    QVector<Managed *> markedContexts;
 
     struct LargeItem {
         LargeItem *next;
+        std::size_t size;
         void *data;
 
         Managed *managed() {
@@ -170,7 +231,9 @@ struct MemoryManager::Data
     };
 
     LargeItem *largeItems;
+    LargeItem *youngLargeItems;
 
+    GCStatistics statistics;
 
     // statistics:
 #ifdef DETAILED_MM_STATS
@@ -180,25 +243,133 @@ struct MemoryManager::Data
     Data(bool enableGC)
         : enableGC(enableGC)
         , gcBlocked(false)
+        , collectingNursery(false)
+        , forceFullGC(false)
+        , incrementalMarking(false)
+        , sweepingFullHeap(false)
         , engine(0)
         , stackTop(0)
         , totalItems(0)
         , totalAlloc(0)
+        , unsweptChunkCount(0)
+        , nurserySize(0)
+        , nurseryLimit(NURSERY_SIZE)
+        , heapSize(0)
+        , heapSizeAfterFullGC(0)
+        , unmanagedHeapSize(0)
+        , unmanagedHeapLimit(MIN_UNMANAGED_HEAP_LIMIT)
+        , incrementalBudget(INCREMENTAL_BUDGET)
+        , allocationsSinceStep(0)
         , largeItems(0)
+        , youngLargeItems(0)
     {
+        memset(currentChunk, 0, sizeof(currentChunk));
         memset(smallItems, 0, sizeof(smallItems));
+        memset(unusedItems, 0, sizeof(unusedItems));
+        memset(unusedItemsEnd, 0, sizeof(unusedItemsEnd));
         memset(nChunks, 0, sizeof(nChunks));
         memset(availableItems, 0, sizeof(availableItems));
         memset(allocCount, 0, sizeof(allocCount));
         scribble = !qgetenv("QV4_MM_SCRIBBLE").isEmpty();
         aggressiveGC = !qgetenv("QV4_MM_AGGRESSIVE_GC").isEmpty();
         exactGC = qgetenv("QV4_MM_CONSERVATIVE_GC").isEmpty();
+        generationalGC = !qgetenv("QV4_MM_GENERATIONAL_GC").isEmpty();
+        incrementalGC = !qgetenv("QV4_MM_INCREMENTAL_GC").isEmpty();
+        lazySweep = !qgetenv("QV4_MM_LAZY_SWEEP").isEmpty();
+        printStats = !qgetenv("QV4_MM_STATS").isEmpty();
+
+        bool ok;
+        uint nurseryKB = qgetenv("QV4_MM_NURSERY_SIZE").toUInt(&ok);
+        if (ok && nurseryKB)
+            nurseryLimit = nurseryKB * 1024;
+        int budget = qgetenv("QV4_MM_INCREMENTAL_BUDGET").toInt(&ok);
+        if (ok && budget > 0)
+            incrementalBudget = budget;
+    }
+
+    void releaseChunk(Chunk *c)
+    {
+        const size_t pos = c->chunkSize >> 4;
+        const uint items = uint(c->memory.size() / c->chunkSize);
+        heapChunks.remove(heapChunks.indexOf(c));
+        // the next chunk of this size class can be smaller again
+        if (nChunks[pos])
+            --nChunks[pos];
+        availableItems[pos] -= qMin(availableItems[pos], items);
+        totalItems -= qMin(totalItems, int(items));
+        ++statistics.releasedChunks;
+        c->memory.deallocate();
+        delete c;
     }
 
     ~Data()
     {
-        for (QVector<Chunk>::iterator i = heapChunks.begin(), ei = heapChunks.end(); i != ei; ++i)
-            i->memory.deallocate();
+        for (QVector<Chunk *>::iterator i = heapChunks.begin(), ei = heapChunks.end(); i != ei; ++i) {
+            (*i)->memory.deallocate();
+            delete *i;
+        }
+    }
+
+    void useChunk(size_t pos, Chunk *c)
+    {
+        currentChunk[pos] = c;
+        smallItems[pos] = c->freeItems;
+        c->freeItems = 0;
+        unusedItems[pos] = c->unusedItems;
+        unusedItemsEnd[pos] = c->unusedItems ? c->end() : 0;
+        c->unusedItems = 0;
+        c->empty = false;
+        if (!c->inNursery) {
+            c->inNursery = true;
+            nursery.append(c);
+        }
+    }
+
+    void retireChunk(size_t pos)
+    {
+        Chunk *c = currentChunk[pos];
+        if (!c)
+            return;
+        c->freeItems = smallItems[pos];
+        c->unusedItems = unusedItems[pos] < unusedItemsEnd[pos] ? unusedItems[pos] : 0;
+        currentChunk[pos] = 0;
+        smallItems[pos] = 0;
+        unusedItems[pos] = 0;
+        unusedItemsEnd[pos] = 0;
+    }
+
+    bool needsFullGC() const
+    {
+        // fall back to a full collection once the old generation has grown
+        // by more than its size after the last full one
+        return !generationalGC || forceFullGC
+                || heapSize > heapSizeAfterFullGC + qMax(heapSizeAfterFullGC, nurseryLimit);
+    }
+
+    bool switchChunk(size_t pos)
+    {
+        retireChunk(pos);
+        if (chunksWithFreeItems[pos].isEmpty())
+            return false;
+        useChunk(pos, chunksWithFreeItems[pos].takeLast());
+        return true;
+    }
+
+    // called for every item that survives a collection
+    void survived(Managed *m)
+    {
+        if (!generationalGC) {
+            m->markBit = 0;
+            return;
+        }
+
+        // Survivors keep their mark bit and are old from now on. Execution contexts
+        // are always rescanned in minor collections, as their locals are written
+        // to directly from generated code.
+        if (m->internalClass == engine->executionContextClass && !(m->flags & Managed::Remembered)) {
+            m->flags |= Managed::Remembered;
+            oldContexts.append(m);
+        }
     }
 };
 
@@ -207,15 +378,11 @@ struct MemoryManager::Data
         ::memset((void *)(obj + 1), c, size - sizeof(Managed));
 
 
-namespace QV4 {
-
-bool operator<(const MemoryManager::Data::Chunk &a, const MemoryManager::Data::Chunk &b)
+static bool chunkLessThan(const MemoryManager::Data::Chunk *a, const MemoryManager::Data::Chunk *b)
 {
-    return a.memory.base() < b.memory.base();
+    return a->memory.base() < b->memory.base();
 }
 
-} // namespace QV4
-
 MemoryManager::MemoryManager()
     : m_d(new Data(true))
     , m_persistentValues(0)
@@ -275,6 +442,19 @@ Managed *MemoryManager::alloc(std::size_t size)
 {
     if (m_d->aggressiveGC)
         runGC();
+
+    // Objects that hold on to memory outside the heap barely grow it, so their
+    // memory would otherwise not be released until something else triggers a
+    // collection.
+    if (m_d->unmanagedHeapSize > m_d->unmanagedHeapLimit) {
+        m_d->unmanagedHeapLimit = qMax(MIN_UNMANAGED_HEAP_LIMIT, 2 * m_d->unmanagedHeapSize);
+        requestGC(/*minor*/false);
+    }
+
+    // an ongoing incremental collection is advanced by the allocations as well,
+    // so that it finishes even if nothing calls incrementalGCStep()
+    if (m_d->incrementalMarking && ++m_d->allocationsSinceStep >= INCREMENTAL_STEP_ALLOCATIONS)
+        incrementalGCStep();
 #ifdef DETAILED_MM_STATS
     willAllocate(size);
 #endif // DETAILED_MM_STATS
@@ -286,23 +466,53 @@ Managed *MemoryManager::alloc(std::size_t size)
 
     // doesn't fit into a small bucket
     if (size >= MemoryManager::Data::MaxItemSize) {
+        if (m_d->generationalGC && m_d->nurserySize > m_d->nurseryLimit)
+            requestGC(/*minor*/true);
+        m_d->nurserySize += size;
+
         // we use malloc for this
         MemoryManager::Data::LargeItem *item = static_cast<MemoryManager::Data::LargeItem *>(malloc(size + sizeof(MemoryManager::Data::LargeItem)));
-        item->next = m_d->largeItems;
-        m_d->largeItems = item;
+        item->next = m_d->youngLargeItems;
+        item->size = size;
+        m_d->youngLargeItems = item;
         return item->managed();
     }
 
     Managed *m = m_d->smallItems[pos];
-    if (m)
+    if (m) {
+        m_d->smallItems[pos] = m->nextFree();
         goto found;
+    }
+
+    if (m_d->unusedItems[pos] < m_d->unusedItemsEnd[pos])
+        goto bump;
+
+    // sweep the chunks of this size class that were left over by the last collection
+    if (m_d->chunksWithFreeItems[pos].isEmpty() && !m_d->unsweptChunks[pos].isEmpty()) {
+        QElapsedTimer t;
+        t.start();
+        GCDeletable *deletable = 0;
+        while (m_d->chunksWithFreeItems[pos].isEmpty() && !m_d->unsweptChunks[pos].isEmpty())
+            sweepUnsweptChunk(pos, &deletable);
+        recordLazySweep(t.nsecsElapsed() / 1000);
+        // destroying QObjects can run JavaScript, and thus allocate
+        deleteDeletables(deletable, /*lastCall*/false);
+        if (m_d->smallItems[pos] || m_d->unusedItems[pos] < m_d->unusedItemsEnd[pos])
+            goto take;
+    }
+
+    // the current chunk is used up, collect the nursery once it has grown large enough
+    if (m_d->generationalGC && m_d->nurserySize > m_d->nurseryLimit && !m_d->aggressiveGC)
+        requestGC(/*minor*/true);
+
+    if (m_d->switchChunk(pos))
+        goto take;
 
     // try to free up space, otherwise allocate
-    if (m_d->allocCount[pos] > (m_d->availableItems[pos] >> 1) && m_d->totalAlloc > (m_d->totalItems >> 1) && !m_d->aggressiveGC) {
-        runGC();
-        m = m_d->smallItems[pos];
-        if (m)
-            goto found;
+    if (!m_d->generationalGC && m_d->allocCount[pos] > (m_d->availableItems[pos] >> 1) && m_d->totalAlloc > (m_d->totalItems >> 1) && !m_d->aggressiveGC) {
+        requestGC(/*minor*/false);
+        if (m_d->switchChunk(pos))
+            goto take;
     }
 
     // no free item available, allocate a new chunk
@@ -313,34 +523,43 @@ Managed *MemoryManager::alloc(std::size_t size)
             shift = 10;
         std::size_t allocSize = CHUNK_SIZE*(size_t(1) << shift);
         allocSize = roundUpToMultipleOf(WTF::pageSize(), allocSize);
-        Data::Chunk allocation;
-        allocation.memory = PageAllocation::allocate(allocSize, OSAllocator::JSGCHeapPages);
-        allocation.chunkSize = int(size);
+        Data::Chunk *allocation = new Data::Chunk;
+        allocation->memory = PageAllocation::allocate(allocSize, OSAllocator::JSGCHeapPages);
+        allocation->chunkSize = int(size);
+        allocation->freeItems = 0;
+        allocation->inNursery = false;
+        allocation->empty = false;
         m_d->heapChunks.append(allocation);
-        std::sort(m_d->heapChunks.begin(), m_d->heapChunks.end());
-        char *chunk = (char *)allocation.memory.base();
-        char *end = chunk + allocation.memory.size() - size;
+        std::sort(m_d->heapChunks.begin(), m_d->heapChunks.end(), chunkLessThan);
+        char *chunk = (char *)allocation->memory.base();
 #ifndef QT_NO_DEBUG
-        memset(chunk, 0, allocation.memory.size());
+        memset(chunk, 0, allocation->memory.size());
 #endif
-        Managed **last = &m_d->smallItems[pos];
-        while (chunk <= end) {
-            Managed *o = reinterpret_cast<Managed *>(chunk);
-            o->_data = 0;
-            *last = o;
-            last = o->nextFreeRef();
-            chunk += size;
-        }
-        *last = 0;
-        m = m_d->smallItems[pos];
-        const size_t increase = allocation.memory.size()/size - 1;
+        // items are handed out front to back, fresh pages are zeroed and thus
+        // never look like they're in use
+        allocation->unusedItems = chunk;
+        m_d->retireChunk(pos);
+        m_d->useChunk(pos, allocation);
+        const size_t increase = allocation->memory.size()/size - 1;
         m_d->availableItems[pos] += uint(increase);
         m_d->totalItems += int(increase);
 #ifdef V4_USE_VALGRIND
-        VALGRIND_MAKE_MEM_NOACCESS(allocation.memory, allocation.chunkSize);
+        VALGRIND_MAKE_MEM_NOACCESS(allocation->memory, allocation->chunkSize);
 #endif
     }
 
+  take:
+    m = m_d->smallItems[pos];
+    if (m) {
+        m_d->smallItems[pos] = m->nextFree();
+        goto found;
+    }
+
+  bump:
+    Q_ASSERT(m_d->unusedItems[pos] < m_d->unusedItemsEnd[pos]);
+    m = reinterpret_cast<Managed *>(m_d->unusedItems[pos]);
+    m_d->unusedItems[pos] += size;
+
   found:
 #ifdef V4_USE_VALGRIND
     VALGRIND_MEMPOOL_ALLOC(this, m, size);
@@ -348,7 +567,7 @@ Managed *MemoryManager::alloc(std::size_t size)
 
     ++m_d->allocCount[pos];
     ++m_d->totalAlloc;
-    m_d->smallItems[pos] = m->nextFree();
+    m_d->nurserySize += size;
     return m;
 }
 
@@ -356,6 +575,13 @@ void MemoryManager::mark()
 {
     SafeValue *markBase = m_d->engine->jsStackTop;
 
+    // the final pause of an incremental collection continues where the last marking step stopped
+    for (QVector<Managed *>::const_iterator it = m_d->greyItems.constBegin(), end = m_d->greyItems.constEnd(); it != end; ++it) {
+        if ((*it)->inUse)
+            m_d->engine->pushForGC(*it);
+    }
+    m_d->greyItems.clear();
+
     m_d->engine->markObjects();
 
     PersistentValuePrivate *persistent = m_persistentValues;
@@ -373,6 +599,9 @@ void MemoryManager::mark()
 
     collectFromJSStack();
 
+    if (m_d->collectingNursery || m_d->incrementalMarking)
+        collectFromRememberedSet();
+
     if (!m_d->exactGC) {
         // push all caller saved registers to the stack, so we can find the objects living in these registers
 #if COMPILER(MSVC) && !OS(WINRT) // WinRT must use exact GC
@@ -435,6 +664,11 @@ void MemoryManager::mark()
     }
 
     // now that we marked all roots, start marking recursively and popping from the mark stack
+    drainMarkStack(markBase);
+}
+
+void MemoryManager::drainMarkStack(SafeValue *markBase)
+{
     while (m_d->engine->jsStackTop > markBase) {
         Managed *m = m_d->engine->popForGC();
         Q_ASSERT (m->internalClass->vtable->markObjects);
@@ -442,6 +676,57 @@ void MemoryManager::mark()
     }
 }
 
+void MemoryManager::collectFromRememberedSet()
+{
+    // A minor collection doesn't traverse the old generation, as all old objects
+    // already carry their mark bit. Everything they could have picked up since
+    // the last collection is reached from here instead. The same holds for objects
+    // that were already scanned by the marking steps of an incremental collection.
+    SafeValue *markBase = m_d->engine->jsStackTop;
+
+    for (QVector<Managed *>::const_iterator it = m_d->rememberedSet.constBegin(), end = m_d->rememberedSet.constEnd(); it != end; ++it) {
+        Managed *m = *it;
+        if (!m->inUse)
+            continue;
+        m->flags &= ~Managed::Remembered;
+        m->internalClass->vtable->markObjects(m, m_d->engine);
+        drainMarkStack(markBase);
+    }
+    m_d->rememberedSet.clear();
+
+    const QVector<Managed *> &contexts = m_d->incrementalMarking ? m_d->markedContexts : m_d->oldContexts;
+    for (QVector<Managed *>::const_iterator it = contexts.constBegin(), end = contexts.constEnd(); it != end; ++it) {
+        Managed *m = *it;
+        if (!m->inUse)
+            continue;
+        m->internalClass->vtable->markObjects(m, m_d->engine);
+        drainMarkStack(markBase);
+    }
+}
+
+static std::size_t sweepLargeItems(MemoryManager::Data *d, MemoryManager::Data::LargeItem **list)
+{
+    std::size_t freedBytes = 0;
+    MemoryManager::Data::LargeItem *i = *list;
+    MemoryManager::Data::LargeItem **last = list;
+    while (i) {
+        Managed *m = i->managed();
+        Q_ASSERT(m->inUse);
+        if (m->markBit) {
+            d->survived(m);
+            last = &i->next;
+            i = i->next;
+            continue;
+        }
+
+        *last = i->next;
+        freedBytes += i->size;
+        free(i);
+        i = *last;
+    }
+    return freedBytes;
+}
+
 void MemoryManager::sweep(bool lastSweep)
 {
     PersistentValuePrivate *weak = m_weakValues;
@@ -474,42 +759,119 @@ void MemoryManager::sweep(bool lastSweep)
         }
     }
 
-    GCDeletable *deletable = 0;
-    GCDeletable **firstDeletable = &deletable;
+    std::size_t freedBytes = 0;
+    if (!m_d->collectingNursery)
+        freedBytes += sweepLargeItems(m_d.data(), &m_d->largeItems);
+    freedBytes += sweepLargeItems(m_d.data(), &m_d->youngLargeItems);
+    m_d->heapSize -= qMin(freedBytes, m_d->heapSize);
+
+    // large items that survived are old from now on
+    Data::LargeItem **last = &m_d->youngLargeItems;
+    while (*last)
+        last = &(*last)->next;
+    *last = m_d->largeItems;
+    m_d->largeItems = m_d->youngLargeItems;
+    m_d->youngLargeItems = 0;
+
+    // The chunks themselves are only queued up here. Unmarked items keep their
+    // inUse bit until their chunk is swept, either on demand by alloc() or by
+    // finishSweeping() before the next collection starts marking.
+    // A minor collection only needs to look at the chunks allocated from since the last one.
+    if (!m_d->collectingNursery) {
+        for (int pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+            m_d->chunksWithFreeItems[pos].clear();
+            m_d->unsweptChunks[pos].clear();
+        }
+        m_d->unsweptChunkCount = 0;
+    }
+    const QVector<Data::Chunk *> &chunks = m_d->collectingNursery ? m_d->nursery : m_d->heapChunks;
+    for (QVector<Data::Chunk *>::const_iterator i = chunks.begin(), ei = chunks.end(); i != ei; ++i) {
+        Data::Chunk *c = *i;
+        c->inNursery = false;
+        m_d->unsweptChunks[c->chunkSize >> 4].append(c);
+        ++m_d->unsweptChunkCount;
+    }
+    m_d->nursery.clear();
+    m_d->sweepingFullHeap = !m_d->collectingNursery;
 
-    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i)
-        sweep(reinterpret_cast<char*>(i->memory.base()), i->memory.size(), i->chunkSize, &deletable);
+    if (lastSweep || !m_d->lazySweep)
+        finishSweeping(lastSweep);
+    else if (!m_d->unsweptChunkCount)
+        sweepingDone();
+}
 
-    Data::LargeItem *i = m_d->largeItems;
-    Data::LargeItem **last = &m_d->largeItems;
-    while (i) {
-        Managed *m = i->managed();
-        Q_ASSERT(m->inUse);
-        if (m->markBit) {
-            m->markBit = 0;
-            last = &i->next;
-            i = i->next;
-            continue;
-        }
+// Sweeps the last of the unswept chunks of size class pos. Returns true if the
+// chunk has free items afterwards.
+bool MemoryManager::sweepUnsweptChunk(int pos, GCDeletable **deletable)
+{
+    Data::Chunk *c = m_d->unsweptChunks[pos].takeLast();
+    const std::size_t freedBytes = sweep(reinterpret_cast<char*>(c->memory.base()), c->memory.size(), c->chunkSize, &c->freeItems, deletable, &c->empty);
+    m_d->heapSize -= qMin(freedBytes, m_d->heapSize);
+
+    // Give chunks that are completely free back to the system, unless this size
+    // class has nowhere else to allocate from. That one is kept to avoid mapping
+    // a new chunk right away, trimHeap() releases it as well.
+    bool hasFreeItems = c->freeItems || c->unusedItems;
+    if (c->empty && !m_d->chunksWithFreeItems[pos].isEmpty()) {
+        m_d->releaseChunk(c);
+        hasFreeItems = false;
+    } else if (hasFreeItems) {
+        m_d->chunksWithFreeItems[pos].append(c);
+    }
 
-        *last = i->next;
-        free(i);
-        i = *last;
+    if (!--m_d->unsweptChunkCount)
+        sweepingDone();
+    return hasFreeItems;
+}
+
+// Sweeps all chunks that are left over from the last collection.
+void MemoryManager::finishSweeping(bool lastSweep)
+{
+    if (!m_d->unsweptChunkCount)
+        return;
+
+    GCDeletable *deletable = 0;
+    for (int pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+        while (!m_d->unsweptChunks[pos].isEmpty())
+            sweepUnsweptChunk(pos, &deletable);
+    }
+    deleteDeletables(deletable, lastSweep);
+}
+
+void MemoryManager::sweepingDone()
+{
+    // only now the heap size reflects what survived the collection
+    if (m_d->sweepingFullHeap) {
+        m_d->heapSizeAfterFullGC = m_d->heapSize;
+        m_d->unmanagedHeapLimit = qMax(MIN_UNMANAGED_HEAP_LIMIT, 2 * m_d->unmanagedHeapSize);
     }
+    m_d->sweepingFullHeap = false;
+}
 
-    deletable = *firstDeletable;
+void MemoryManager::deleteDeletables(GCDeletable *deletable, bool lastCall)
+{
     while (deletable) {
         GCDeletable *next = deletable->next;
-        deletable->lastCall = lastSweep;
+        deletable->lastCall = lastCall;
         delete deletable;
         deletable = next;
     }
 }
 
-void MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size, GCDeletable **deletable)
+void MemoryManager::recordLazySweep(qint64 usecs)
 {
-//    qDebug("chunkStart @ %p, size=%x, pos=%x (%x)", chunkStart, size, size>>4, m_d->smallItems[size >> 4]);
-    Managed **f = &m_d->smallItems[size >> 4];
+    GCStatistics &stats = m_d->statistics;
+    ++stats.lazySweeps;
+    stats.totalLazySweepTime += usecs;
+    stats.maxLazySweepTime = qMax(stats.maxLazySweepTime, usecs);
+}
+
+std::size_t MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size, Managed **freeList, GCDeletable **deletable, bool *empty)
+{
+//    qDebug("chunkStart @ %p, size=%x, pos=%x (%x)", chunkStart, size, size>>4, *freeList);
+    Managed **f = freeList;
+    std::size_t freedBytes = 0;
+    *empty = true;
 
 #ifdef V4_USE_VALGRIND
     VALGRIND_DISABLE_ERROR_REPORTING;
@@ -523,7 +885,8 @@ void MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size,
 
         if (m->inUse) {
             if (m->markBit) {
-                m->markBit = 0;
+                m_d->survived(m);
+                *empty = false;
             } else {
 //                qDebug() << "-- collecting it." << m << *f << m->nextFree();
 #ifdef V4_USE_VALGRIND
@@ -539,6 +902,7 @@ void MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size,
                 VALGRIND_MEMPOOL_FREE(this, m);
 #endif
                 *f = m;
+                freedBytes += size;
                 SCRIBBLE(m, 0x99, size);
             }
         }
@@ -546,6 +910,7 @@ void MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size,
 #ifdef V4_USE_VALGRIND
     VALGRIND_ENABLE_ERROR_REPORTING;
 #endif
+    return freedBytes;
 }
 
 bool MemoryManager::isGCBlocked() const
@@ -558,29 +923,357 @@ void MemoryManager::setGCBlocked(bool blockGC)
     m_d->gcBlocked = blockGC;
 }
 
-void MemoryManager::runGC()
+// A minor collection only collects the nursery, if generational collection is
+// enabled. It mostly serves to test the write barrier.
+void MemoryManager::runGC(bool minor)
 {
     if (!m_d->enableGC || m_d->gcBlocked) {
 //        qDebug() << "Not running GC.";
         return;
     }
 
-//    QTime t; t.start();
+    // finish an ongoing incremental collection, so that this one sees all garbage
+    if (m_d->incrementalMarking)
+        collect(/*minor*/false);
+    collect(minor && m_d->generationalGC);
 
-//    qDebug() << ">>>>>>>>runGC";
+    // an explicit collection frees everything it found before returning, so
+    // that JavaScript owned QObjects get deleted in time
+    finishSweeping();
+}
+
+// Called from alloc() whenever the heap should be collected. With incremental
+// collection enabled, full collections are spread over marking steps that run
+// from here and from incrementalGCStep().
+void MemoryManager::requestGC(bool minor)
+{
+    if (!m_d->enableGC || m_d->gcBlocked)
+        return;
 
+    if (m_d->incrementalMarking) {
+        // make sure marking keeps up with the allocations
+        incrementalGCStep();
+        return;
+    }
+
+    if (m_d->incrementalGC && (!minor || m_d->needsFullGC())) {
+        startIncrementalGC();
+        incrementalGCStep();
+        return;
+    }
+
+    collect(minor);
+}
+
+void MemoryManager::collect(bool minor)
+{
+    if (!m_d->enableGC || m_d->gcBlocked)
+        return;
+
+    QElapsedTimer t;
+    t.start();
+
+    // items left unswept by the last collection must not be found by marking
+    finishSweeping();
+
+    if (m_d->incrementalMarking || m_d->needsFullGC())
+        minor = false;
+
+    if (!m_d->incrementalMarking) {
+        if (m_d->generationalGC && !minor)
+            clearMarkBits();
+        m_d->collectingNursery = minor;
+    }
+
+    // for an incremental collection this is the final pause, rescanning the
+    // roots and everything written to since its marking steps
     mark();
-//    std::cerr << "GC: marked " << marks
-//              << " objects in " << t.elapsed()
-//              << "ms" << std::endl;
-
-//    t.restart();
-    /*std::size_t freedCount =*/ sweep();
-//    std::cerr << "GC: sweep freed " << freedCount
-//              << " objects in " << t.elapsed()
-//              << "ms" << std::endl;
+
+    retireAllocationChunks();
+    m_d->heapSize += m_d->nurserySize;
+    m_d->nurserySize = 0;
+
+    sweep();
+    m_d->collectingNursery = false;
+    m_d->incrementalMarking = false;
+    m_d->markedContexts.clear();
+    m_d->forceFullGC = false;
+
     memset(m_d->allocCount, 0, sizeof(m_d->allocCount));
     m_d->totalAlloc = 0;
+
+    const qint64 pause = t.nsecsElapsed() / 1000;
+    GCStatistics &stats = m_d->statistics;
+    if (minor) {
+        ++stats.minorCollections;
+        stats.totalMinorPause += pause;
+        stats.maxMinorPause = qMax(stats.maxMinorPause, pause);
+    } else {
+        ++stats.fullCollections;
+        stats.totalFullPause += pause;
+        stats.maxFullPause = qMax(stats.maxFullPause, pause);
+    }
+}
+
+void MemoryManager::startIncrementalGC()
+{
+    Q_ASSERT(!m_d->incrementalMarking);
+
+    finishSweeping();
+    if (m_d->generationalGC)
+        clearMarkBits();
+    m_d->incrementalMarking = true;
+
+    // Only the roots that aren't stored on the stacks are marked here. The stacks
+    // are rescanned in the final pause, together with the contexts and all objects
+    // that were written to in between (see Managed::writeBarrier()).
+    SafeValue *markBase = m_d->engine->jsStackTop;
+    m_d->engine->markObjects();
+    for (PersistentValuePrivate *persistent = m_persistentValues; persistent; persistent = persistent->next) {
+        if (persistent->refcount)
+            persistent->value.mark(m_d->engine);
+    }
+
+    for (SafeValue *v = markBase; v < m_d->engine->jsStackTop; ++v)
+        m_d->greyItems.append(v->managed());
+    m_d->engine->jsStackTop = markBase;
+}
+
+// Scans grey items until there are none left or budget (in nanoseconds) is used up.
+bool MemoryManager::markStep(qint64 budget)
+{
+    QElapsedTimer t;
+    t.start();
+
+    ExecutionEngine *e = m_d->engine;
+    SafeValue *markBase = e->jsStackTop;
+    for (QVector<Managed *>::const_iterator it = m_d->greyItems.constBegin(), end = m_d->greyItems.constEnd(); it != end; ++it) {
+        if ((*it)->inUse)
+            e->pushForGC(*it);
+    }
+    m_d->greyItems.clear();
+
+    // objects written to since the last step need to be scanned again
+    for (QVector<Managed *>::const_iterator it = m_d->rememberedSet.constBegin(), end = m_d->rememberedSet.constEnd(); it != end; ++it) {
+        Managed *m = *it;
+        if (!m->inUse)
+            continue;
+        m->flags &= ~Managed::Remembered;
+        e->pushForGC(m);
+    }
+    m_d->rememberedSet.clear();
+
+    int scanned = 0;
+    while (e->jsStackTop > markBase) {
+        Managed *m = e->popForGC();
+        if (m->internalClass == e->executionContextClass)
+            m_d->markedContexts.append(m);
+        m->internalClass->vtable->markObjects(m, e);
+        if (!(++scanned % 64) && t.nsecsElapsed() > budget)
+            break;
+    }
+
+    const bool done = e->jsStackTop == markBase;
+    for (SafeValue *v = markBase; v < e->jsStackTop; ++v)
+        m_d->greyItems.append(v->managed());
+    e->jsStackTop = markBase;
+    return done;
+}
+
+// Runs one marking step of an ongoing incremental collection, taking about usecs
+// microseconds, or incrementalGCBudget() if usecs is negative. Once marking is
+// complete, the collection is finished in a final pause. Returns true if no collection
+// is in progress afterwards. Steps also run from alloc() while a collection is in
+// progress, calling this in idle time, e.g. once per frame from the render loop, takes
+// work off them.
+bool MemoryManager::incrementalGCStep(int usecs)
+{
+    const qint64 budget = qint64(usecs < 0 ? m_d->incrementalBudget : usecs) * 1000;
+    if (!m_d->incrementalMarking) {
+        sweepStep(budget);
+        return true;
+    }
+    if (!m_d->enableGC || m_d->gcBlocked)
+        return false;
+
+    m_d->allocationsSinceStep = 0;
+    QElapsedTimer t;
+    t.start();
+    const bool done = markStep(budget);
+
+    const qint64 pause = t.nsecsElapsed() / 1000;
+    GCStatistics &stats = m_d->statistics;
+    ++stats.incrementalSlices;
+    stats.totalSlicePause += pause;
+    stats.maxSlicePause = qMax(stats.maxSlicePause, pause);
+
+    if (!done)
+        return false;
+
+    collect(/*minor*/false);
+    return true;
+}
+
+// Sweeps chunks left over from the last collection until there are none left or
+// budget (in nanoseconds) is used up. This way garbage found by a collection gets
+// destroyed eventually, even if nothing is allocated from its chunks.
+void MemoryManager::sweepStep(qint64 budget)
+{
+    if (!m_d->unsweptChunkCount)
+        return;
+
+    QElapsedTimer t;
+    t.start();
+    GCDeletable *deletable = 0;
+    for (int pos = 0; pos < Data::MaxItemSize/16 && t.nsecsElapsed() < budget; ++pos) {
+        while (!m_d->unsweptChunks[pos].isEmpty() && t.nsecsElapsed() < budget)
+            sweepUnsweptChunk(pos, &deletable);
+    }
+    recordLazySweep(t.nsecsElapsed() / 1000);
+    deleteDeletables(deletable, /*lastCall*/false);
+}
+
+bool MemoryManager::isIncrementalGC() const
+{
+    return m_d->incrementalGC;
+}
+
+void MemoryManager::setIncrementalGC(bool incremental)
+{
+    if (!incremental && m_d->incrementalMarking)
+        collect(/*minor*/false);
+    m_d->incrementalGC = incremental;
+}
+
+int MemoryManager::incrementalGCBudget() const
+{
+    return m_d->incrementalBudget;
+}
+
+void MemoryManager::setIncrementalGCBudget(int usecs)
+{
+    m_d->incrementalBudget = qMax(1, usecs);
+}
+
+bool MemoryManager::isLazySweep() const
+{
+    return m_d->lazySweep;
+}
+
+void MemoryManager::setLazySweep(bool lazy)
+{
+    if (!lazy)
+        finishSweeping();
+    m_d->lazySweep = lazy;
+}
+
+// Returns all chunks without any live items to the system. Call this after
+// a collection to make the heap as small as possible, e.g. under memory pressure.
+void MemoryManager::trimHeap()
+{
+    finishSweeping();
+
+    for (int pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+        QVector<Data::Chunk *> &chunks = m_d->chunksWithFreeItems[pos];
+        for (int i = 0; i < chunks.size(); ) {
+            Data::Chunk *c = chunks.at(i);
+            if (!c->empty) {
+                ++i;
+                continue;
+            }
+            chunks.remove(i);
+            m_d->releaseChunk(c);
+        }
+    }
+}
+
+std::size_t MemoryManager::heapSize() const
+{
+    std::size_t size = 0;
+    for (QVector<Data::Chunk *>::const_iterator i = m_d->heapChunks.constBegin(), ei = m_d->heapChunks.constEnd(); i != ei; ++i)
+        size += (*i)->memory.size();
+    return size;
+}
+
+// Reports memory that a managed object allocated, or released, outside the heap.
+// Once that has grown to twice its size after the last full collection, the next
+// allocation triggers a full collection.
+void MemoryManager::changeUnmanagedHeapSizeUsage(qptrdiff delta)
+{
+    Q_ASSERT(delta >= 0 || std::size_t(-delta) <= m_d->unmanagedHeapSize);
+    m_d->unmanagedHeapSize += delta;
+}
+
+std::size_t MemoryManager::unmanagedHeapSize() const
+{
+    return m_d->unmanagedHeapSize;
+}
+
+void MemoryManager::retireAllocationChunks()
+{
+    for (int pos = 0; pos < Data::MaxItemSize/16; ++pos)
+        m_d->retireChunk(pos);
+}
+
+void MemoryManager::clearMarkBits()
+{
+    for (QVector<Data::Chunk *>::const_iterator i = m_d->heapChunks.constBegin(), ei = m_d->heapChunks.constEnd(); i != ei; ++i) {
+        const std::size_t size = (*i)->chunkSize;
+        for (char *item = reinterpret_cast<char *>((*i)->memory.base()), *end = (*i)->end(); item < end; item += size) {
+            Managed *m = reinterpret_cast<Managed *>(item);
+            if (m->inUse) {
+                m->markBit = 0;
+                m->flags &= ~Managed::Remembered;
+            }
+        }
+    }
+
+    Data::LargeItem *lists[] = { m_d->largeItems, m_d->youngLargeItems };
+    for (int l = 0; l < 2; ++l) {
+        for (Data::LargeItem *i = lists[l]; i; i = i->next) {
+            Managed *m = i->managed();
+            m->markBit = 0;
+            m->flags &= ~Managed::Remembered;
+        }
+    }
+
+    m_d->rememberedSet.clear();
+    m_d->oldContexts.clear();
+}
+
+bool MemoryManager::isGenerationalGC() const
+{
+    return m_d->generationalGC;
+}
+
+void MemoryManager::setGenerationalGC(bool generational)
+{
+    if (m_d->generationalGC == generational)
+        return;
+
+    // old objects carry their mark bit between collections in generational mode
+    if (!generational) {
+        finishSweeping();
+        clearMarkBits();
+    }
+    m_d->generationalGC = generational;
+    m_d->forceFullGC = generational;
+}
+
+// Write barrier for generational and incremental collection: m is an old or an
+// already scanned object that is about to be written to, so it needs to be scanned
+// again during the next minor collection or marking step.
+void MemoryManager::remember(Managed *m)
+{
+    if (!m_d->generationalGC && !m_d->incrementalMarking)
+        return;
+    m->flags |= Managed::Remembered;
+    m_d->rememberedSet.append(m);
+}
+
+const MemoryManager::GCStatistics &MemoryManager::statistics() const
+{
+    return m_d->statistics;
 }
 
 void MemoryManager::setEnableGC(bool enableGC)
@@ -600,6 +1293,14 @@ MemoryManager::~MemoryManager()
         persistent = n;
     }
 
+    if (m_d->printStats)
+        dumpStats();
+
+    retireAllocationChunks();
+    finishSweeping(/*lastSweep*/true);
+    clearMarkBits();
+    m_d->incrementalMarking = false;
+    m_d->greyItems.clear();
     sweep(/*lastSweep*/true);
 #ifdef V4_USE_VALGRIND
     VALGRIND_DESTROY_MEMPOOL(this);
@@ -613,6 +1314,28 @@ void MemoryManager::setExecutionEngine(ExecutionEngine *engine)
 
 void MemoryManager::dumpStats() const
 {
+    const GCStatistics &stats = m_d->statistics;
+    std::cerr << "=================" << std::endl;
+    std::cerr << "GC stats (" << (m_d->generationalGC ? "generational" : "non-generational") << "):" << std::endl;
+    std::cerr << "\tminor collections: " << stats.minorCollections
+              << ", total pause " << stats.totalMinorPause << "us"
+              << ", max pause " << stats.maxMinorPause << "us" << std::endl;
+    std::cerr << "\tfull collections: " << stats.fullCollections
+              << ", total pause " << stats.totalFullPause << "us"
+              << ", max pause " << stats.maxFullPause << "us" << std::endl;
+    if (stats.incrementalSlices)
+        std::cerr << "\tincremental marking steps: " << stats.incrementalSlices
+                  << ", total " << stats.totalSlicePause << "us"
+                  << ", max " << stats.maxSlicePause << "us" << std::endl;
+    if (stats.lazySweeps)
+        std::cerr << "\tlazy sweeps: " << stats.lazySweeps
+                  << ", total " << stats.totalLazySweepTime << "us"
+                  << ", max " << stats.maxLazySweepTime << "us" << std::endl;
+    std::cerr << "\theap size after last collection: " << m_d->heapSize << " bytes" << std::endl;
+    std::cerr << "\theap chunks: " << m_d->heapChunks.size() << " (" << heapSize() << " bytes)"
+              << ", released " << stats.releasedChunks << std::endl;
+    std::cerr << "\tmemory held outside the heap: " << m_d->unmanagedHeapSize << " bytes" << std::endl;
+
 #ifdef DETAILED_MM_STATS
     std::cerr << "=================" << std::endl;
     std::cerr << "Allocation stats:" << std::endl;
@@ -659,10 +1382,10 @@ void MemoryManager::collectFromStack() const
     char** heapChunkBoundaries = (char**)alloca(m_d->heapChunks.count() * 2 * sizeof(char*));
     char** heapChunkBoundariesEnd = heapChunkBoundaries + 2 * m_d->heapChunks.count();
     int i = 0;
-    for (QVector<Data::Chunk>::Iterator it = m_d->heapChunks.begin(), end =
+    for (QVector<Data::Chunk *>::Iterator it = m_d->heapChunks.begin(), end =
          m_d->heapChunks.end(); it != end; ++it) {
-        heapChunkBoundaries[i++] = reinterpret_cast<char*>(it->memory.base()) - 1;
-        heapChunkBoundaries[i++] = reinterpret_cast<char*>(it->memory.base()) + it->memory.size() - it->chunkSize;
+        heapChunkBoundaries[i++] = reinterpret_cast<char*>((*it)->memory.base()) - 1;
+        heapChunkBoundaries[i++] = reinterpret_cast<char*>((*it)->memory.base()) + (*it)->memory.size() - (*it)->chunkSize;
     }
     Q_ASSERT(i == m_d->heapChunks.count() * 2);
 
@@ -675,7 +1398,7 @@ void MemoryManager::collectFromStack() const
         // An odd index means the pointer is _before_ the end of a heap chunk and therefore valid.
         Q_ASSERT(index >= 0 && index < m_d->heapChunks.count() * 2);
         if (index & 1) {
-            int size = m_d->heapChunks.at(index >> 1).chunkSize;
+            int size = m_d->heapChunks.at(index >> 1)->chunkSize;
             Managed *m = reinterpret_cast<Managed *>(genericPtr);
 //            qDebug() << "   inside" << size;
 
@@ -693,6 +1416,9 @@ void MemoryManager::collectFromStack() const
     }
 }
 
+// The JS stack holds the exact roots of all JavaScript frames, of the interpreter
+// and the JIT alike, and the scoped values of native code. Slots are cleared when
+// they're pushed, so everything below jsStackTop is a valid value.
 void MemoryManager::collectFromJSStack() const
 {
     SafeValue *v = engine()->jsStackBase;
@@ -87,6 +87,43 @@ public:
         bool wasBlocked;
     };
 
+    struct GCStatistics
+    {
+        GCStatistics()
+            : minorCollections(0)
+            , fullCollections(0)
+            , totalMinorPause(0)
+            , maxMinorPause(0)
+            , totalFullPause(0)
+            , maxFullPause(0)
+            , incrementalSlices(0)
+            , totalSlicePause(0)
+            , maxSlicePause(0)
+            , lazySweeps(0)
+            , totalLazySweepTime(0)
+            , maxLazySweepTime(0)
+            , releasedChunks(0)
+        {}
+
+        // pause times are in microseconds
+        uint minorCollections;
+        uint fullCollections;
+        qint64 totalMinorPause;
+        qint64 maxMinorPause;
+        qint64 totalFullPause;
+        qint64 maxFullPause;
+        // marking steps of incremental collections, the final pause is accounted as a full collection
+        uint incrementalSlices;
+        qint64 totalSlicePause;
+        qint64 maxSlicePause;
+        // chunks swept after a collection, by alloc() or incrementalGCStep()
+        uint lazySweeps;
+        qint64 totalLazySweepTime;
+        qint64 maxLazySweepTime;
+        // empty chunks that were returned to the system
+        uint releasedChunks;
+    };
+
 public:
     MemoryManager();
     ~MemoryManager();
@@ -105,11 +142,31 @@ public:
 
     bool isGCBlocked() const;
     void setGCBlocked(bool blockGC);
-    void runGC();
+    void runGC(bool minor = false);
 
     void setEnableGC(bool enableGC);
     void setExecutionEngine(ExecutionEngine *engine);
 
+    bool isGenerationalGC() const;
+    void setGenerationalGC(bool generational);
+    void remember(Managed *m);
+
+    bool isIncrementalGC() const;
+    void setIncrementalGC(bool incremental);
+    int incrementalGCBudget() const;
+    void setIncrementalGCBudget(int usecs);
+    bool incrementalGCStep(int usecs = -1);
+
+    bool isLazySweep() const;
+    void setLazySweep(bool lazy);
+
+    void trimHeap();
+    std::size_t heapSize() const;
+
+    void changeUnmanagedHeapSizeUsage(qptrdiff delta);
+    std::size_t unmanagedHeapSize() const;
+
+    const GCStatistics &statistics() const;
     void dumpStats() const;
 
 protected:
@@ -124,11 +181,25 @@ protected:
 #endif // DETAILED_MM_STATS
 
 private:
+    void requestGC(bool minor);
+    void collect(bool minor);
+    void startIncrementalGC();
+    bool markStep(qint64 budget);
+    void retireAllocationChunks();
+    void clearMarkBits();
     void collectFromStack() const;
     void collectFromJSStack() const;
+    void collectFromRememberedSet();
+    void drainMarkStack(SafeValue *markBase);
     void mark();
     void sweep(bool lastSweep = false);
-    void sweep(char *chunkStart, std::size_t chunkSize, size_t size, GCDeletable **deletable);
+    bool sweepUnsweptChunk(int pos, GCDeletable **deletable);
+    void finishSweeping(bool lastSweep = false);
+    void sweepStep(qint64 budget);
+    void sweepingDone();
+    void deleteDeletables(GCDeletable *deletable, bool lastCall);
+    void recordLazySweep(qint64 usecs);
+    std::size_t sweep(char *chunkStart, std::size_t chunkSize, size_t size, Managed **freeList, GCDeletable **deletable, bool *empty);
 
 protected:
     QScopedPointer<Data> m_d;
@@ -45,6 +45,7 @@
 #include "qv4objectproto_p.h"
 #include "qv4stringobject_p.h"
 #include "qv4argumentsobject_p.h"
+#include "qv4typedarray_p.h"
 #include "qv4mm_p.h"
 #include "qv4lookup_p.h"
 #include "qv4scopedvalue_p.h"
@@ -164,6 +165,7 @@ void Object::putValue(Property *pd, PropertyAttributes attrs, const ValueRef val
     if (!attrs.isWritable())
         goto reject;
 
+    writeBarrier();
     pd->value = *value;
     return;
 
@@ -216,12 +218,21 @@ void Object::defineAccessorProperty(const QString &name, ReturnedValue (*getter)
 void Object::defineAccessorProperty(const StringRef name, ReturnedValue (*getter)(CallContext *), ReturnedValue (*setter)(CallContext *))
 {
     ExecutionEngine *v4 = engine();
+    Scope scope(v4);
+    Scoped<FunctionObject> function(scope);
     Property *p = insertMember(name, QV4::Attr_Accessor|QV4::Attr_NotConfigurable|QV4::Attr_NotEnumerable);
 
-    if (getter)
-        p->setGetter(v4->newBuiltinFunction(v4->rootContext, name, getter)->getPointer());
-    if (setter)
-        p->setSetter(v4->newBuiltinFunction(v4->rootContext, name, setter)->getPointer());
+    // allocating the functions may promote this object
+    if (getter) {
+        function = v4->newBuiltinFunction(v4->rootContext, name, getter);
+        writeBarrier();
+        p->setGetter(function.getPointer());
+    }
+    if (setter) {
+        function = v4->newBuiltinFunction(v4->rootContext, name, setter);
+        writeBarrier();
+        p->setSetter(function.getPointer());
+    }
 }
 
 void Object::defineReadonlyProperty(const QString &name, ValueRef value)
@@ -298,6 +309,7 @@ Property *Object::insertMember(const StringRef s, PropertyAttributes attributes)
     if (attributes.isAccessor())
         hasAccessorProperty = 1;
 
+    writeBarrier();
     ensureMemberIndex(idx);
 
     return memberData + idx;
@@ -338,6 +350,12 @@ Property *Object::__getOwnProperty__(uint index, PropertyAttributes *attrs)
             *attrs = Attr_NotConfigurable|Attr_NotWritable;
         return static_cast<StringObject *>(this)->getIndex(index);
     }
+    if (TypedArray *a = asTypedArray()) {
+        Property *p = a->getIndex(index);
+        if (attrs)
+            *attrs = p ? PropertyAttributes(Attr_NotConfigurable) : PropertyAttributes(Attr_Invalid);
+        return p;
+    }
 
     if (attrs)
         *attrs = Attr_Invalid;
@@ -494,6 +512,12 @@ ReturnedValue Object::getLookup(Managed *m, Lookup *l)
     PropertyAttributes attrs;
     Property *p = l->lookup(o, &attrs);
     if (p) {
+        if (attrs.isData() && l->isPolymorphic()) {
+            l->addPolymorphicGetter();
+            if (l->getter == Lookup::getterMegamorphic)
+                l->stubCache();
+            return p->value.asReturnedValue();
+        }
         if (attrs.isData()) {
             if (l->level == 0)
                 l->getter = Lookup::getter0;
@@ -526,7 +550,14 @@ void Object::setLookup(Managed *m, Lookup *l, const ValueRef value)
         if (idx != UINT_MAX && o->internalClass->propertyData[idx].isData() && o->internalClass->propertyData[idx].isWritable()) {
             l->classList[0] = o->internalClass;
             l->index = idx;
-            l->setter = Lookup::setter0;
+            if (l->isPolymorphic()) {
+                l->addPolymorphicSetter();
+                if (l->setter == Lookup::setterMegamorphic)
+                    l->stubCache();
+            } else {
+                l->setter = Lookup::setter0;
+            }
+            o->writeBarrier();
             o->memberData[idx].value = *value;
             return;
         }
@@ -570,26 +601,23 @@ Property *Object::advanceIterator(Managed *m, ObjectIterator *it, StringRef name
     name = (String *)0;
     *index = UINT_MAX;
 
-    if (!it->arrayIndex)
-        it->arrayNode = o->sparseArrayBegin();
-
     // sparse arrays
-    if (it->arrayNode) {
-        while (it->arrayNode != o->sparseArrayEnd()) {
-            int k = it->arrayNode->key();
-            uint pidx = it->arrayNode->value;
-            Property *p = o->arrayData + pidx;
-            it->arrayNode = it->arrayNode->nextNode();
+    // only the next index is remembered, so the iteration continues correctly
+    // if the array gets modified in between
+    if (o->sparseArray && it->arrayIndex != UINT_MAX) {
+        SparseArray::iterator n = o->sparseArray->lowerBound(it->arrayIndex);
+        for (; n != o->sparseArray->end(); ++n) {
+            uint pidx = n.value();
             PropertyAttributes a = o->arrayAttributes ? o->arrayAttributes[pidx] : PropertyAttributes(Attr_Data);
             if (!(it->flags & ObjectIterator::EnumerableOnly) || a.isEnumerable()) {
+                uint k = n.key();
                 it->arrayIndex = k + 1;
                 *index = k;
                 if (attrs)
                     *attrs = a;
-                return p;
+                return o->arrayData + pidx;
             }
         }
-        it->arrayNode = 0;
         it->arrayIndex = UINT_MAX;
     }
     // dense arrays
@@ -727,6 +755,7 @@ void Object::internalPut(const StringRef name, const ValueRef value)
             if (!ok)
                 goto reject;
         } else {
+            writeBarrier();
             pd->value = *value;
         }
         return;
@@ -805,8 +834,8 @@ void Object::internalPutIndexed(uint index, const ValueRef value)
             goto reject;
         } else if (!attrs.isWritable())
             goto reject;
-        else
-            pd->value = *value;
+        writeBarrier();
+        pd->value = *value;
         return;
     } else if (!prototype()) {
         if (!extensible)
@@ -1067,6 +1096,7 @@ bool Object::__defineOwnProperty__(ExecutionContext *ctx, Property *current, con
 
   accept:
 
+    writeBarrier();
     current->merge(cattrs, p, attrs);
     if (!member.isNull()) {
         internalClass = internalClass->changeMember(member.getPointer(), cattrs);
@@ -1110,6 +1140,7 @@ void Object::copyArrayData(Object *other)
     } else {
         arrayReserve(other->arrayDataLen);
         arrayDataLen = other->arrayDataLen;
+        writeBarrier();
         memcpy(arrayData, other->arrayData, arrayDataLen*sizeof(Property));
     }
 
@@ -1143,12 +1174,12 @@ ReturnedValue Object::arrayIndexOf(const ValueRef v, uint fromIndex, uint endInd
                 return Encode(i);
         }
     } else if (sparseArray) {
-        for (SparseArrayNode *n = sparseArray->lowerBound(fromIndex); n != sparseArray->end() && n->key() < endIndex; n = n->nextNode()) {
-            value = o->getValue(arrayData + n->value, arrayAttributes ? arrayAttributes[n->value] : Attr_Data);
+        for (SparseArray::iterator n = sparseArray->lowerBound(fromIndex); n != sparseArray->end() && n.key() < endIndex; ++n) {
+            value = o->getValue(arrayData + n.value(), arrayAttributes ? arrayAttributes[n.value()] : Attr_Data);
             if (scope.hasException())
                 return Encode::undefined();
             if (__qmljs_strict_equal(value, v))
-                return Encode(n->key());
+                return Encode(n.key());
         }
     } else {
         if (endIndex > arrayDataLen)
@@ -1156,6 +1187,16 @@ ReturnedValue Object::arrayIndexOf(const ValueRef v, uint fromIndex, uint endInd
         Property *pd = arrayData;
         Property *end = pd + endIndex;
         pd += fromIndex;
+        if (!arrayAttributes && v->isNumber()) {
+            // Plain data and a number to look for, so strict equality is a numeric
+            // comparison. Holes are empty values, which are not numbers.
+            const double d = v->asDouble();
+            for (; pd < end; ++pd) {
+                if (pd->value.isNumber() && pd->value.asDouble() == d)
+                    return Encode((uint)(pd - arrayData));
+            }
+            return Encode(-1);
+        }
         while (pd < end) {
             if (!pd->value.isEmpty()) {
                 value = o->getValue(pd, arrayAttributes ? arrayAttributes[pd - arrayData] : Attr_Data);
@@ -1172,24 +1213,23 @@ ReturnedValue Object::arrayIndexOf(const ValueRef v, uint fromIndex, uint endInd
 
 void Object::arrayConcat(const ArrayObject *other)
 {
+    writeBarrier();
     int newLen = arrayDataLen + other->arrayLength();
     if (other->sparseArray)
         initSparse();
     // ### copy attributes as well!
     if (sparseArray) {
         if (other->sparseArray) {
-            for (const SparseArrayNode *it = other->sparseArray->begin(); it != other->sparseArray->end(); it = it->nextNode())
-                arraySet(arrayDataLen + it->key(), other->arrayData + it->value);
+            for (SparseArray::iterator it = other->sparseArray->begin(); it != other->sparseArray->end(); ++it)
+                arraySet(arrayDataLen + it.key(), other->arrayData + it.value());
         } else {
             int oldSize = arrayDataLen;
             arrayReserve(oldSize + other->arrayLength());
             memcpy(arrayData + oldSize, other->arrayData, other->arrayLength()*sizeof(Property));
             if (arrayAttributes)
                 std::fill(arrayAttributes + oldSize, arrayAttributes + oldSize + other->arrayLength(), PropertyAttributes(Attr_Data));
-            for (uint i = 0; i < other->arrayLength(); ++i) {
-                SparseArrayNode *n = sparseArray->insert(arrayDataLen + i);
-                n->value = oldSize + i;
-            }
+            for (uint i = 0; i < other->arrayLength(); ++i)
+                sparseArray->insert(arrayDataLen + i).value() = oldSize + i;
         }
     } else {
         uint oldSize = arrayLength();
@@ -1199,9 +1239,14 @@ void Object::arrayConcat(const ArrayObject *other)
                 arrayData[i].value = Primitive::emptyValue();
         }
         if (other->arrayAttributes) {
+            Scope scope(engine());
+            ScopedValue v(scope);
             for (uint i = 0; i < other->arrayDataLen; ++i) {
                 bool exists;
-                arrayData[oldSize + i].value = const_cast<ArrayObject *>(other)->getIndexed(i, &exists);
+                // getters can allocate, and thus promote this array
+                v = const_cast<ArrayObject *>(other)->getIndexed(i, &exists);
+                writeBarrier();
+                arrayData[oldSize + i].value = v.asReturnedValue();
                 arrayDataLen = oldSize + i + 1;
                 if (arrayAttributes)
                     arrayAttributes[oldSize + i] = Attr_Data;
@@ -1259,14 +1304,71 @@ void Object::arraySort(ExecutionContext *context, ObjectRef thisObject, const Va
         return;
     }
 
-    ArrayElementLessThan lessThan(context, thisObject, comparefn);
-
     if (!len)
         return;
+
+    if (comparefn->isUndefined() && !arrayAttributes && sortPrimitivesByString(len))
+        return;
+
+    ArrayElementLessThan lessThan(context, thisObject, comparefn);
+
     Property *begin = arrayData;
     std::sort(begin, begin + len, lessThan);
 }
 
+namespace {
+struct SortKey {
+    QString string;
+    Value value;
+};
+
+inline bool sortKeyLessThan(const SortKey &k1, const SortKey &k2)
+{
+    return k1.string < k2.string;
+}
+}
+
+/*
+    The default sort order compares the string conversions of the elements. Converting
+    them once instead of in every comparison makes sorting an array of numbers or strings
+    several times faster. Only done for primitive values, as converting an object can run
+    script code. Returns false if the array was left untouched.
+*/
+bool Object::sortPrimitivesByString(uint len)
+{
+    QVector<SortKey> keys;
+    keys.reserve(len);
+    uint undefinedCount = 0;
+    for (uint i = 0; i < len; ++i) {
+        const Value &v = arrayData[i].value;
+        if (v.isEmpty())
+            continue;
+        if (v.isUndefined()) {
+            ++undefinedCount;
+            continue;
+        }
+        if (v.isManaged() && !v.isString())
+            return false;
+        SortKey key;
+        key.string = v.toQString();
+        key.value = v;
+        keys.append(key);
+    }
+
+    // Converting primitives does not allocate on the JS heap, so no GC can have run
+    // and the copied values are still valid. Undefined sorts after everything else,
+    // followed by the holes.
+    std::sort(keys.begin(), keys.end(), sortKeyLessThan);
+    uint i = 0;
+    for (; i < (uint)keys.size(); ++i)
+        arrayData[i].value = keys.at(i).value;
+    for (uint end = i + undefinedCount; i < end; ++i)
+        arrayData[i].value = Primitive::undefinedValue();
+    for (; i < len; ++i)
+        arrayData[i].value = Primitive::emptyValue();
+    return true;
+}
+
 
 void Object::initSparse()
 {
@@ -1274,10 +1376,8 @@ void Object::initSparse()
         flags &= ~SimpleArray;
         sparseArray = new SparseArray;
         for (uint i = 0; i < arrayDataLen; ++i) {
-            if (!((arrayAttributes && arrayAttributes[i].isGeneric()) || arrayData[i].value.isEmpty())) {
-                SparseArrayNode *n = sparseArray->insert(i);
-                n->value = i + arrayOffset;
-            }
+            if (!((arrayAttributes && arrayAttributes[i].isGeneric()) || arrayData[i].value.isEmpty()))
+                sparseArray->push_back(i + arrayOffset, i);
         }
 
         uint off = arrayOffset;
@@ -1366,30 +1466,27 @@ bool Object::setArrayLength(uint newLen) {
     bool ok = true;
     if (newLen < oldLen) {
         if (sparseArray) {
-            SparseArrayNode *begin = sparseArray->lowerBound(newLen);
-            if (begin != sparseArray->end()) {
-                SparseArrayNode *it = sparseArray->end()->previousNode();
-                while (1) {
-                    Property &pd = arrayData[it->value];
-                    if (arrayAttributes) {
-                        if (!arrayAttributes[it->value].isConfigurable()) {
-                            ok = false;
-                            newLen = it->key() + 1;
-                            break;
-                        } else {
-                            arrayAttributes[it->value].clear();
-                        }
-                    }
-                    pd.value.tag = Value::Empty_Type;
-                    pd.value.int_32 = arrayFreeList;
-                    arrayFreeList = it->value;
-                    bool brk = (it == begin);
-                    SparseArrayNode *prev = it->previousNode();
-                    sparseArray->erase(it);
-                    if (brk)
+            SparseArray::iterator it = sparseArray->end();
+            while (it != sparseArray->begin()) {
+                --it;
+                if (it.key() < newLen)
+                    break;
+                uint pidx = it.value();
+                Property &pd = arrayData[pidx];
+                if (arrayAttributes) {
+                    if (!arrayAttributes[pidx].isConfigurable()) {
+                        ok = false;
+                        newLen = it.key() + 1;
                         break;
-                    it = prev;
+                    } else {
+                        arrayAttributes[pidx].clear();
+                    }
                 }
+                pd.value.tag = Value::Empty_Type;
+                pd.value.int_32 = arrayFreeList;
+                arrayFreeList = pidx;
+                // erasing the last entry leaves us at the end again
+                it = sparseArray->erase(it);
             }
         } else {
             Property *it = arrayData + arrayDataLen;
@@ -1431,8 +1528,11 @@ ArrayObject::ArrayObject(ExecutionEngine *engine, const QStringList &list)
     // elements converted to JS Strings.
     int len = list.count();
     arrayReserve(len);
+    ScopedValue v(scope);
     for (int ii = 0; ii < len; ++ii) {
-        arrayData[ii].value = Encode(engine->newString(list.at(ii)));
+        v = engine->newString(list.at(ii));
+        writeBarrier();
+        arrayData[ii].value = v.asReturnedValue();
         arrayDataLen = ii + 1;
     }
     setArrayLengthUnchecked(len);
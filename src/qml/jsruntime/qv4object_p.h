@@ -112,6 +112,9 @@ struct Q_QML_EXPORT Object: Managed {
     uint arrayDataLen;
     uint arrayAlloc;
     PropertyAttributes *arrayAttributes;
+    // Every element takes a full Property slot, whatever its type. There are no
+    // packed int or double stores; the JIT, the runtime and the QML glue all index
+    // arrayData directly, so those would need a separate rework of this layout.
     Property *arrayData;
     SparseArray *sparseArray;
 
@@ -184,6 +187,7 @@ struct Q_QML_EXPORT Object: Managed {
 
     uint allocArrayValue(const ValueRef v) {
         uint idx = allocArrayValue();
+        writeBarrier();
         Property *pd = &arrayData[idx];
         pd->value = *v;
         return idx;
@@ -233,10 +237,10 @@ public:
                 return UINT_MAX;
             return index;
         } else {
-            SparseArrayNode *n = sparseArray->findNode(index);
-            if (!n)
+            SparseArray::iterator n = sparseArray->find(index);
+            if (n == sparseArray->end())
                 return UINT_MAX;
-            return n->value;
+            return n.value();
         }
     }
 
@@ -257,9 +261,6 @@ public:
 
     void push_back(const ValueRef v);
 
-    SparseArrayNode *sparseArrayBegin() { return sparseArray ? sparseArray->begin() : 0; }
-    SparseArrayNode *sparseArrayEnd() { return sparseArray ? sparseArray->end() : 0; }
-
     void arrayConcat(const ArrayObject *other);
     void arraySort(ExecutionContext *context, ObjectRef thisObject, const ValueRef comparefn, uint arrayDataLen);
     ReturnedValue arrayIndexOf(const ValueRef v, uint fromIndex, uint arrayDataLen, ExecutionContext *ctx, Object *o);
@@ -283,6 +284,22 @@ public:
     { return internalClass->vtable->get(this, name, hasProperty); }
     inline ReturnedValue getIndexed(uint idx, bool *hasProperty = 0)
     { return internalClass->vtable->getIndexed(this, idx, hasProperty); }
+    // Same as getIndexed(), but reads plain data elements of the dense array storage
+    // directly instead of going through the vtable and the prototype chain. This only
+    // saves the call overhead; the elements are still read from Property slots.
+    inline ReturnedValue getArrayElement(uint idx, bool *hasProperty = 0)
+    {
+        if (!sparseArray && !arrayAttributes && idx < arrayDataLen
+            && internalClass->vtable->getIndexed == static_cast<ReturnedValue (*)(Managed *, uint, bool *)>(&Object::getIndexed)) {
+            const Value &v = arrayData[idx].value;
+            if (!v.isEmpty()) {
+                if (hasProperty)
+                    *hasProperty = true;
+                return v.asReturnedValue();
+            }
+        }
+        return internalClass->vtable->getIndexed(this, idx, hasProperty);
+    }
     inline void put(const StringRef name, const ValueRef v)
     { internalClass->vtable->put(this, name, v); }
     inline void putIndexed(uint idx, const ValueRef v)
@@ -321,6 +338,7 @@ private:
     void internalPutIndexed(uint index, const ValueRef value);
     bool internalDeleteProperty(const StringRef name);
     bool internalDeleteIndexedProperty(uint index);
+    bool sortPrimitivesByString(uint len);
 
     friend struct ObjectIterator;
     friend struct ObjectPrototype;
@@ -397,6 +415,7 @@ inline void Object::setArrayLengthUnchecked(uint l)
 inline void Object::push_back(const ValueRef v)
 {
     uint idx = arrayLength();
+    writeBarrier();
     if (!sparseArray) {
         if (idx >= arrayAlloc)
             arrayReserve(idx + 1);
@@ -412,6 +431,7 @@ inline void Object::push_back(const ValueRef v)
 inline Property *Object::arrayInsert(uint index, PropertyAttributes attributes) {
     if (attributes.isAccessor())
         hasAccessorProperty = 1;
+    writeBarrier();
 
     Property *pd;
     if (!sparseArray && (index < 0x1000 || index < arrayDataLen + (arrayDataLen >> 2))) {
@@ -429,10 +449,10 @@ inline Property *Object::arrayInsert(uint index, PropertyAttributes attributes)
         pd = arrayData + index;
     } else {
         initSparse();
-        SparseArrayNode *n = sparseArray->insert(index);
-        if (n->value == UINT_MAX)
-            n->value = allocArrayValue();
-        pd = arrayData + n->value;
+        SparseArray::iterator n = sparseArray->insert(index);
+        if (n.value() == UINT_MAX)
+            n.value() = allocArrayValue();
+        pd = arrayData + n.value();
     }
     if (index >= arrayLength())
         setArrayLengthUnchecked(index + 1);
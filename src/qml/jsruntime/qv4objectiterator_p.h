@@ -50,7 +50,6 @@ QT_BEGIN_NAMESPACE
 
 namespace QV4 {
 
-struct SparseArrayNode;
 struct Object;
 struct ArrayObject;
 struct PropertyAttributes;
@@ -69,7 +68,6 @@ struct Q_QML_EXPORT ObjectIterator
 
     ObjectRef object;
     ObjectRef current;
-    SparseArrayNode *arrayNode;
     uint arrayIndex;
     uint memberIndex;
     uint flags;
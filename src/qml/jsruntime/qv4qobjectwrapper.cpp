@@ -1692,8 +1692,11 @@ QV4::ReturnedValue CallArgument::toValue(QV8Engine *engine)
         QList<QObject *> &list = *qlistPtr;
         QV4::Scoped<ArrayObject> array(scope, v4->newArrayObject());
         array->arrayReserve(list.count());
+        QV4::ScopedValue v(scope);
         for (int ii = 0; ii < list.count(); ++ii) {
-            array->arrayData[ii].value = QV4::QObjectWrapper::wrap(v4, list.at(ii));
+            v = QV4::QObjectWrapper::wrap(v4, list.at(ii));
+            array->writeBarrier();
+            array->arrayData[ii].value = v.asReturnedValue();
             array->arrayDataLen = ii + 1;
         }
         array->setArrayLengthUnchecked(list.count());
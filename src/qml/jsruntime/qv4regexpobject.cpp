@@ -387,13 +387,18 @@ ReturnedValue RegExpPrototype::method_exec(CallContext *ctx)
     Scoped<ArrayObject> array(scope, ctx->engine->newArrayObject(ctx->engine->regExpExecArrayClass));
     int len = r->value->captureCount();
     array->arrayReserve(len);
+    ScopedValue v(scope);
     for (int i = 0; i < len; ++i) {
         int start = matchOffsets[i * 2];
         int end = matchOffsets[i * 2 + 1];
-        array->arrayData[i].value = (start != -1 && end != -1) ? ctx->engine->newString(s.mid(start, end - start))->asReturnedValue() : Encode::undefined();
+        v = (start != -1 && end != -1) ? ctx->engine->newString(s.mid(start, end - start))->asReturnedValue() : Encode::undefined();
+        // the barrier has to come after the allocation, which may promote the array
+        array->writeBarrier();
+        array->arrayData[i].value = v.asReturnedValue();
         array->arrayDataLen = i + 1;
     }
     array->setArrayLengthUnchecked(len);
+    array->writeBarrier();
     array->memberData[Index_ArrayIndex].value = Primitive::fromInt32(result);
     array->memberData[Index_ArrayInput].value = arg.asReturnedValue();
 
@@ -437,6 +442,7 @@ ReturnedValue RegExpPrototype::method_compile(CallContext *ctx)
 
     Scoped<RegExpObject> re(scope, ctx->engine->regExpCtor.asFunctionObject()->construct(callData));
 
+    r->writeBarrier();
     r->value = re->value;
     r->global = re->global;
     return Encode::undefined();
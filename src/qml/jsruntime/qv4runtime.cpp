@@ -47,6 +47,7 @@
 #include "qv4globalobject_p.h"
 #include "qv4stringobject_p.h"
 #include "qv4argumentsobject_p.h"
+#include "qv4typedarray_p.h"
 #include "qv4lookup_p.h"
 #include "qv4function_p.h"
 #include "private/qlocale_tools_p.h"
@@ -589,6 +590,13 @@ ReturnedValue __qmljs_get_element(ExecutionContext *ctx, const ValueRef object,
     }
 
     if (idx < UINT_MAX) {
+        if (o->internalType() == Managed::Type_TypedArray) {
+            TypedArray *a = static_cast<TypedArray *>(o.getPointer());
+            if (idx < a->length())
+                return a->element(idx);
+            return Encode::undefined();
+        }
+
         uint pidx = o->propertyIndexFromArrayIndex(idx);
         if (pidx < UINT_MAX) {
             if (!o->arrayAttributes || o->arrayAttributes[pidx].isData()) {
@@ -615,6 +623,13 @@ void __qmljs_set_element(ExecutionContext *ctx, const ValueRef object, const Val
 
     uint idx = index->asArrayIndex();
     if (idx < UINT_MAX) {
+        if (o->internalType() == Managed::Type_TypedArray && value->isNumber()) {
+            TypedArray *a = static_cast<TypedArray *>(o.getPointer());
+            if (idx < a->length())
+                a->setElement(idx, value->asDouble());
+            return;
+        }
+
         uint pidx = o->propertyIndexFromArrayIndex(idx);
         if (pidx < UINT_MAX) {
             if (o->arrayAttributes && !o->arrayAttributes[pidx].isEmpty() && !o->arrayAttributes[pidx].isWritable()) {
@@ -625,6 +640,9 @@ void __qmljs_set_element(ExecutionContext *ctx, const ValueRef object, const Val
 
             Property *p = o->arrayData + pidx;
             if (!o->arrayAttributes || o->arrayAttributes[pidx].isData()) {
+                // the generated code of both the JIT and the interpreter stores
+                // array elements through here
+                o->writeBarrier();
                 p->value = *value;
                 return;
             }
@@ -81,8 +81,7 @@ struct Scope {
     }
 
     SafeValue *alloc(int nValues) {
-        SafeValue *ptr = engine->jsStackTop;
-        engine->jsStackTop += nValues;
+        SafeValue *ptr = engine->stackPush(nValues);
 #ifndef QT_NO_DEBUG
         size += nValues;
 #endif
@@ -110,6 +109,7 @@ struct ScopedValue
     ScopedValue(const Scope &scope)
     {
         ptr = scope.engine->jsStackTop++;
+        ptr->val = 0;
 #ifndef QT_NO_DEBUG
         ++scope.size;
 #endif
@@ -208,6 +208,7 @@ struct Scoped
     Scoped(const Scope &scope)
     {
         ptr = scope.engine->jsStackTop++;
+        ptr->val = 0;
 #ifndef QT_NO_DEBUG
         ++scope.size;
 #endif
@@ -50,6 +50,14 @@
 #include <private/qv4regexpobject_p.h>
 #include <private/qv4sequenceobject_p.h>
 #include <private/qv4objectproto_p.h>
+#include <private/qv4arraybuffer_p.h>
+#include <private/qv4typedarray_p.h>
+#include <private/qv4dataview_p.h>
+#include <private/qv4mm_p.h>
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -67,6 +75,7 @@ using namespace QV4;
 //    + Number
 //    + Date
 //    + RegExp
+//    + ArrayBuffer, typed arrays and DataView
 // <quint8 type><quint24 size><data>
 
 enum Type {
@@ -84,9 +93,18 @@ enum Type {
     WorkerDate,
     WorkerRegexp,
     WorkerListModel,
-    WorkerSequence
+    WorkerSequence,
+    WorkerSharedString,
+    WorkerPrimitiveArray,
+    WorkerArrayBuffer,
+    WorkerTypedArray,
+    WorkerDataView
 };
 
+// Strings at least this long go into Serialize::Data::strings instead of
+// being copied into the stream
+static const int sharedStringLength = 256;
+
 static inline quint32 valueheader(Type type, quint32 size = 0)
 {
     return quint8(type) << 24 | (size & 0xFFFFFF);
@@ -143,92 +161,146 @@ static inline void *popPtr(const char *&data)
     return rv;
 }
 
+// Arrays that only hold numbers, booleans, null and undefined don't refer to
+// anything in the sending engine, so their values can be copied as a block.
+static bool isPrimitiveArray(ArrayObject *array, uint length)
+{
+    if (!length || array->sparseArray || array->arrayAttributes || array->arrayDataLen != length)
+        return false;
+    for (uint i = 0; i < length; ++i) {
+        const Value &v = array->arrayData[i].value;
+        if (v.isEmpty() || v.asManaged())
+            return false;
+    }
+    return true;
+}
+
+struct Serialize::Serializer
+{
+    Serializer(QV8Engine *engine) : engine(engine) {}
+
+    void serialize(const ValueRef v);
+    void serializeArrayBuffer(ArrayBuffer *buffer);
+
+    Data data;
+    QV8Engine *engine;
+    // a buffer that is referenced more than once also arrives as one buffer
+    QHash<ArrayBuffer *, quint32> bufferIndexes;
+    QSet<ArrayBuffer *> transferred;
+};
+
 // XXX TODO: Check that worker script is exception safe in the case of 
 // serialization/deserialization failures
 
 #define ALIGN(size) (((size) + 3) & ~3)
-void Serialize::serialize(QByteArray &data, const QV4::ValueRef v, QV8Engine *engine)
+void Serialize::Serializer::serialize(const QV4::ValueRef v)
 {
     QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
     QV4::Scope scope(v4);
+    QByteArray &stream = data.stream;
 
     if (v->isEmpty()) {
         Q_ASSERT(!"Serialize: got empty value");
     } else if (v->isUndefined()) {
-        push(data, valueheader(WorkerUndefined));
+        push(stream, valueheader(WorkerUndefined));
     } else if (v->isNull()) {
-        push(data, valueheader(WorkerNull));
+        push(stream, valueheader(WorkerNull));
     } else if (v->isBoolean()) {
-        push(data, valueheader(v->booleanValue() == true ? WorkerTrue : WorkerFalse));
+        push(stream, valueheader(v->booleanValue() == true ? WorkerTrue : WorkerFalse));
     } else if (v->isString()) {
         const QString &qstr = v->toQString();
         int length = qstr.length();
-        if (length > 0xFFFFFF) {
-            push(data, valueheader(WorkerUndefined));
+        if (length >= sharedStringLength) {
+            push(stream, valueheader(WorkerSharedString));
+            push(stream, (quint32)data.strings.size());
+            data.strings.append(qstr);
             return;
         }
         int utf16size = ALIGN(length * sizeof(uint16_t));
 
-        reserve(data, utf16size + sizeof(quint32));
-        push(data, valueheader(WorkerString, length));
+        reserve(stream, utf16size + sizeof(quint32));
+        push(stream, valueheader(WorkerString, length));
         
-        int offset = data.size();
-        data.resize(data.size() + utf16size);
-        char *buffer = data.data() + offset;
+        int offset = stream.size();
+        stream.resize(stream.size() + utf16size);
+        char *buffer = stream.data() + offset;
 
         memcpy(buffer, qstr.constData(), length*sizeof(QChar));
     } else if (v->asFunctionObject()) {
         // XXX TODO: Implement passing function objects between the main and
         // worker scripts
-        push(data, valueheader(WorkerUndefined));
+        push(stream, valueheader(WorkerUndefined));
     } else if (v->asArrayObject()) {
         QV4::ScopedArrayObject array(scope, v);
         uint32_t length = array->arrayLength();
+        if (isPrimitiveArray(array.getPointer(), length)) {
+            reserve(stream, 2 * sizeof(quint32) + length * sizeof(Value));
+            push(stream, valueheader(WorkerPrimitiveArray));
+            push(stream, (quint32)length);
+            int offset = stream.size();
+            stream.resize(stream.size() + length * sizeof(Value));
+            char *buffer = stream.data() + offset;
+            for (uint32_t ii = 0; ii < length; ++ii)
+                memcpy(buffer + ii * sizeof(Value), &array->arrayData[ii].value, sizeof(Value));
+            return;
+        }
         if (length > 0xFFFFFF) {
-            push(data, valueheader(WorkerUndefined));
+            push(stream, valueheader(WorkerUndefined));
             return;
         }
-        reserve(data, sizeof(quint32) + length * sizeof(quint32));
-        push(data, valueheader(WorkerArray, length));
+        reserve(stream, sizeof(quint32) + length * sizeof(quint32));
+        push(stream, valueheader(WorkerArray, length));
         ScopedValue val(scope);
         for (uint32_t ii = 0; ii < length; ++ii)
-            serialize(data, (val = array->getIndexed(ii)), engine);
+            serialize((val = array->getIndexed(ii)));
     } else if (v->isInteger()) {
-        reserve(data, 2 * sizeof(quint32));
-        push(data, valueheader(WorkerInt32));
-        push(data, (quint32)v->integerValue());
+        reserve(stream, 2 * sizeof(quint32));
+        push(stream, valueheader(WorkerInt32));
+        push(stream, (quint32)v->integerValue());
 //    } else if (v->IsUint32()) {
 //        reserve(data, 2 * sizeof(quint32));
 //        push(data, valueheader(WorkerUint32));
 //        push(data, v->Uint32Value());
     } else if (v->isNumber()) {
-        reserve(data, sizeof(quint32) + sizeof(double));
-        push(data, valueheader(WorkerNumber));
-        push(data, v->asDouble());
+        reserve(stream, sizeof(quint32) + sizeof(double));
+        push(stream, valueheader(WorkerNumber));
+        push(stream, v->asDouble());
     } else if (QV4::DateObject *d = v->asDateObject()) {
-        reserve(data, sizeof(quint32) + sizeof(double));
-        push(data, valueheader(WorkerDate));
-        push(data, d->value.asDouble());
+        reserve(stream, sizeof(quint32) + sizeof(double));
+        push(stream, valueheader(WorkerDate));
+        push(stream, d->value.asDouble());
     } else if (v->as<RegExpObject>()) {
         Scoped<RegExpObject> re(scope, v);
         quint32 flags = re->flags();
         QString pattern = re->source();
         int length = pattern.length() + 1;
         if (length > 0xFFFFFF) {
-            push(data, valueheader(WorkerUndefined));
+            push(stream, valueheader(WorkerUndefined));
             return;
         }
         int utf16size = ALIGN(length * sizeof(uint16_t));
 
-        reserve(data, sizeof(quint32) + utf16size);
-        push(data, valueheader(WorkerRegexp, flags));
-        push(data, (quint32)length);
+        reserve(stream, sizeof(quint32) + utf16size);
+        push(stream, valueheader(WorkerRegexp, flags));
+        push(stream, (quint32)length);
 
-        int offset = data.size();
-        data.resize(data.size() + utf16size);
-        char *buffer = data.data() + offset;
+        int offset = stream.size();
+        stream.resize(stream.size() + utf16size);
+        char *buffer = stream.data() + offset;
 
         memcpy(buffer, pattern.constData(), length*sizeof(QChar));
+    } else if (ArrayBuffer *buffer = v->as<ArrayBuffer>()) {
+        serializeArrayBuffer(buffer);
+    } else if (TypedArray *array = v->as<TypedArray>()) {
+        push(stream, valueheader(WorkerTypedArray, array->arrayType()));
+        serializeArrayBuffer(array->arrayBuffer());
+        push(stream, (quint32)array->byteOffset);
+        push(stream, (quint32)array->byteLength);
+    } else if (DataView *view = v->as<DataView>()) {
+        push(stream, valueheader(WorkerDataView));
+        serializeArrayBuffer(view->arrayBuffer());
+        push(stream, (quint32)view->byteOffset);
+        push(stream, (quint32)view->byteLength);
     } else if (v->as<QV4::QObjectWrapper>()) {
         Scoped<QObjectWrapper> qobjectWrapper(scope, v);
         // XXX TODO: Generalize passing objects between the main thread and worker scripts so
@@ -237,12 +309,12 @@ void Serialize::serialize(QByteArray &data, const QV4::ValueRef v, QV8Engine *en
         if (lm && lm->agent()) {
             QQmlListModelWorkerAgent *agent = lm->agent();
             agent->addref();
-            push(data, valueheader(WorkerListModel));
-            push(data, (void *)agent);
+            push(stream, valueheader(WorkerListModel));
+            push(stream, (void *)agent);
             return;
         }
         // No other QObject's are allowed to be sent
-        push(data, valueheader(WorkerUndefined));
+        push(stream, valueheader(WorkerUndefined));
     } else if (v->asObject()) {
         ScopedObject o(scope, v);
         if (o->isListType()) {
@@ -250,15 +322,15 @@ void Serialize::serialize(QByteArray &data, const QV4::ValueRef v, QV8Engine *en
             uint32_t seqLength = ScopedValue(scope, o->get(v4->id_length))->toUInt32();
             uint32_t length = seqLength + 1;
             if (length > 0xFFFFFF) {
-                push(data, valueheader(WorkerUndefined));
+                push(stream, valueheader(WorkerUndefined));
                 return;
             }
-            reserve(data, sizeof(quint32) + length * sizeof(quint32));
-            push(data, valueheader(WorkerSequence, length));
-            serialize(data, QV4::Primitive::fromInt32(QV4::SequencePrototype::metaTypeForSequence(o)), engine); // sequence type
+            reserve(stream, sizeof(quint32) + length * sizeof(quint32));
+            push(stream, valueheader(WorkerSequence, length));
+            serialize(QV4::Primitive::fromInt32(QV4::SequencePrototype::metaTypeForSequence(o))); // sequence type
             ScopedValue val(scope);
             for (uint32_t ii = 0; ii < seqLength; ++ii)
-                serialize(data, (val = o->getIndexed(ii)), engine); // sequence elements
+                serialize((val = o->getIndexed(ii))); // sequence elements
 
             return;
         }
@@ -268,16 +340,16 @@ void Serialize::serialize(QByteArray &data, const QV4::ValueRef v, QV8Engine *en
         QV4::ScopedArrayObject properties(scope, QV4::ObjectPrototype::getOwnPropertyNames(v4, val));
         quint32 length = properties->arrayLength();
         if (length > 0xFFFFFF) {
-            push(data, valueheader(WorkerUndefined));
+            push(stream, valueheader(WorkerUndefined));
             return;
         }
-        push(data, valueheader(WorkerObject, length));
+        push(stream, valueheader(WorkerObject, length));
 
         QV4::ScopedValue s(scope);
         QV4::ScopedString str(scope);
         for (quint32 ii = 0; ii < length; ++ii) {
             s = properties->getIndexed(ii);
-            serialize(data, s, engine);
+            serialize(s);
 
             QV4::ExecutionContext *ctx = v4->currentContext();
             str = s;
@@ -285,17 +357,73 @@ void Serialize::serialize(QByteArray &data, const QV4::ValueRef v, QV8Engine *en
             if (scope.hasException())
                 ctx->catchException();
 
-            serialize(data, val, engine);
+            serialize(val);
         }
         return;
     } else {
-        push(data, valueheader(WorkerUndefined));
+        push(stream, valueheader(WorkerUndefined));
+    }
+}
+
+void Serialize::Serializer::serializeArrayBuffer(ArrayBuffer *buffer)
+{
+    quint32 index;
+    QHash<ArrayBuffer *, quint32>::const_iterator it = bufferIndexes.constFind(buffer);
+    if (it != bufferIndexes.constEnd()) {
+        index = it.value();
+    } else {
+        index = data.buffers.size();
+        // transferred contents are handed over, others are copied if script can write to them
+        data.buffers.append(transferred.contains(buffer) ? buffer->data : buffer->asByteArray());
+        bufferIndexes.insert(buffer, index);
     }
+    push(data.stream, valueheader(WorkerArrayBuffer));
+    push(data.stream, index);
 }
 
-ReturnedValue Serialize::deserialize(const char *&data, QV8Engine *engine)
+Serialize::Deserializer::Deserializer(Data &data, QV8Engine *engine)
+    : engine(engine)
+    , done(false)
 {
-    quint32 header = popUint32(data);
+    this->data.swap(data);
+    stream = this->data.stream.constData();
+    buffers.resize(this->data.buffers.size());
+    containers = QV8Engine::getV4(engine)->newArrayObject();
+}
+
+QString Serialize::Deserializer::readString(quint32 header)
+{
+    if (headertype(header) == WorkerSharedString)
+        return data.strings.at(popUint32(stream));
+
+    quint32 size = headersize(header);
+    QString qstr((QChar *)stream, size);
+    stream += ALIGN(size * sizeof(uint16_t));
+    return qstr;
+}
+
+ReturnedValue Serialize::Deserializer::readArrayBuffer()
+{
+    quint32 index = popUint32(stream);
+    if (buffers.at(index).isUndefined()) {
+        Scope scope(QV8Engine::getV4(engine));
+        Scoped<ArrayBuffer> buffer(scope, scope.engine->newArrayBuffer(data.buffers.at(index)));
+        // the ArrayBuffer now holds the only reference, so taking over the contents
+        // doesn't copy them
+        data.buffers[index] = QByteArray();
+        buffer->detach();
+        buffers[index] = buffer;
+    }
+    return buffers.at(index).value();
+}
+
+/*
+    Returns the next value, or an empty value if it's a container that got
+    pushed onto the frames to be filled in by the following values.
+*/
+ReturnedValue Serialize::Deserializer::read()
+{
+    quint32 header = popUint32(stream);
     Type type = headertype(header);
 
     QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
@@ -311,60 +439,78 @@ ReturnedValue Serialize::deserialize(const char *&data, QV8Engine *engine)
     case WorkerFalse:
         return QV4::Encode(false);
     case WorkerString:
-    {
-        quint32 size = headersize(header);
-        QString qstr((QChar *)data, size);
-        data += ALIGN(size * sizeof(uint16_t));
-        return QV4::Encode(v4->newString(qstr));
-    }
+    case WorkerSharedString:
+        return QV4::Encode(v4->newString(readString(header)));
     case WorkerFunction:
         Q_ASSERT(!"Unreachable");
         break;
     case WorkerArray:
+    case WorkerObject:
+    case WorkerSequence:
     {
-        quint32 size = headersize(header);
-        Scoped<ArrayObject> a(scope, v4->newArrayObject());
-        ScopedValue v(scope);
-        for (quint32 ii = 0; ii < size; ++ii) {
-            v = deserialize(data, engine);
-            a->putIndexed(ii, v);
+        Frame frame;
+        frame.type = type;
+        frame.size = headersize(header);
+        frame.index = 0;
+        frame.sequenceType = 0;
+        if (type == WorkerSequence) {
+            // one more for the sequence type, which is always an int
+            --frame.size;
+            popUint32(stream);
+            frame.sequenceType = (qint32)popUint32(stream);
         }
-        return a.asReturnedValue();
+        ScopedObject container(scope, type == WorkerObject ? v4->newObject()->asReturnedValue()
+                                                           : v4->newArrayObject()->asReturnedValue());
+        Scoped<ArrayObject> stack(scope, containers.value());
+        stack->putIndexed(frames.size(), container);
+        frames.append(frame);
+        return QV4::Primitive::emptyValue().asReturnedValue();
     }
-    case WorkerObject:
+    case WorkerPrimitiveArray:
     {
-        quint32 size = headersize(header);
-        Scoped<Object> o(scope, v4->newObject());
-        ScopedValue name(scope);
-        ScopedString n(scope);
-        ScopedValue value(scope);
-        for (quint32 ii = 0; ii < size; ++ii) {
-            name = deserialize(data, engine);
-            value = deserialize(data, engine);
-            n = name.asReturnedValue();
-            o->put(n, value);
+        quint32 length = popUint32(stream);
+        Scoped<ArrayObject> a(scope, v4->newArrayObject());
+        a->arrayReserve(length);
+        for (quint32 ii = 0; ii < length; ++ii) {
+            memcpy(&a->arrayData[ii].value, stream, sizeof(Value));
+            stream += sizeof(Value);
         }
-        return o.asReturnedValue();
+        a->arrayDataLen = length;
+        a->setArrayLengthUnchecked(length);
+        return a.asReturnedValue();
     }
     case WorkerInt32:
-        return QV4::Encode((qint32)popUint32(data));
+        return QV4::Encode((qint32)popUint32(stream));
     case WorkerUint32:
-        return QV4::Encode(popUint32(data));
+        return QV4::Encode(popUint32(stream));
     case WorkerNumber:
-        return QV4::Encode(popDouble(data));
+        return QV4::Encode(popDouble(stream));
     case WorkerDate:
-        return QV4::Encode(v4->newDateObject(QV4::Primitive::fromDouble(popDouble(data))));
+        return QV4::Encode(v4->newDateObject(QV4::Primitive::fromDouble(popDouble(stream))));
     case WorkerRegexp:
     {
         quint32 flags = headersize(header);
-        quint32 length = popUint32(data);
-        QString pattern = QString((QChar *)data, length - 1);
-        data += ALIGN(length * sizeof(uint16_t));
+        quint32 length = popUint32(stream);
+        QString pattern = QString((QChar *)stream, length - 1);
+        stream += ALIGN(length * sizeof(uint16_t));
         return Encode(v4->newRegExpObject(pattern, flags));
     }
+    case WorkerArrayBuffer:
+        return readArrayBuffer();
+    case WorkerTypedArray:
+    case WorkerDataView:
+    {
+        popUint32(stream); // the header of the buffer
+        Scoped<ArrayBuffer> buffer(scope, readArrayBuffer());
+        quint32 byteOffset = popUint32(stream);
+        quint32 byteLength = popUint32(stream);
+        if (type == WorkerDataView)
+            return (new (v4->memoryManager) DataView(v4, buffer.getPointer(), byteOffset, byteLength))->asReturnedValue();
+        return (new (v4->memoryManager) TypedArray(v4, TypedArrayType(headersize(header)), buffer.getPointer(), byteOffset, byteLength))->asReturnedValue();
+    }
     case WorkerListModel:
     {
-        void *ptr = popPtr(data);
+        void *ptr = popPtr(stream);
         QQmlListModelWorkerAgent *agent = (QQmlListModelWorkerAgent *)ptr;
         QV4::ScopedValue rv(scope, QV4::QObjectWrapper::wrap(v4, agent));
         // ### Find a better solution then the ugly property
@@ -378,42 +524,112 @@ ReturnedValue Serialize::deserialize(const char *&data, QV8Engine *engine)
         agent->setV8Engine(engine);
         return rv.asReturnedValue();
     }
-    case WorkerSequence:
-    {
-        ScopedValue value(scope);
-        bool succeeded = false;
-        quint32 length = headersize(header);
-        quint32 seqLength = length - 1;
-        value = deserialize(data, engine);
-        int sequenceType = value->integerValue();
-        Scoped<ArrayObject> array(scope, v4->newArrayObject());
-        array->arrayReserve(seqLength);
-        for (quint32 ii = 0; ii < seqLength; ++ii) {
-            value = deserialize(data, engine);
-            array->arrayData[ii].value = value.asReturnedValue();
-            array->arrayDataLen = ii + 1;
-        }
-        array->setArrayLengthUnchecked(seqLength);
-        QVariant seqVariant = QV4::SequencePrototype::toVariant(array, sequenceType, &succeeded);
-        return QV4::SequencePrototype::fromVariant(v4, seqVariant, &succeeded);
-    }
     }
     Q_ASSERT(!"Unreachable");
     return QV4::Encode::undefined();
 }
 
-QByteArray Serialize::serialize(const QV4::ValueRef value, QV8Engine *engine)
+void Serialize::Deserializer::store(const ValueRef v)
 {
-    QByteArray rv;
-    serialize(rv, value, engine);
-    return rv;
+    if (frames.isEmpty()) {
+        value = v;
+        done = true;
+        return;
+    }
+
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
+    Scope scope(v4);
+    Scoped<ArrayObject> stack(scope, containers.value());
+    ScopedObject container(scope, stack->getIndexed(frames.size() - 1));
+    Frame &frame = frames.last();
+    if (frame.type == WorkerObject) {
+        ScopedString key(scope, v4->newString(frame.key));
+        container->put(key, v);
+    } else {
+        container->putIndexed(frame.index, v);
+    }
+    ++frame.index;
 }
 
-ReturnedValue Serialize::deserialize(const QByteArray &data, QV8Engine *engine)
+bool Serialize::Deserializer::run(int msecs)
 {
-    const char *stream = data.constData();
-    return deserialize(stream, engine);
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
+    Scope scope(v4);
+    ScopedValue v(scope);
+
+    QElapsedTimer timer;
+    if (msecs >= 0)
+        timer.start();
+
+    for (uint count = 1; !done; ++count) {
+        // reading the clock isn't free, so only check it every now and then
+        if (msecs >= 0 && !(count % 256) && timer.elapsed() >= msecs)
+            return false;
+
+        if (!frames.isEmpty()) {
+            Frame &frame = frames.last();
+            if (frame.index == frame.size) {
+                Scoped<ArrayObject> stack(scope, containers.value());
+                v = stack->getIndexed(frames.size() - 1);
+                if (frame.type == WorkerSequence) {
+                    bool succeeded = false;
+                    Scoped<ArrayObject> array(scope, v);
+                    QVariant seqVariant = QV4::SequencePrototype::toVariant(array, frame.sequenceType, &succeeded);
+                    v = QV4::SequencePrototype::fromVariant(v4, seqVariant, &succeeded);
+                }
+                frames.removeLast();
+                store(v);
+                continue;
+            }
+            // object members are stored as a string key followed by the value
+            if (frame.type == WorkerObject)
+                frame.key = readString(popUint32(stream));
+        }
+
+        v = read();
+        if (!v->isEmpty())
+            store(v);
+    }
+    return true;
 }
 
-QT_END_NAMESPACE
+Serialize::Data Serialize::serialize(const QV4::ValueRef value, QV8Engine *engine)
+{
+    Serializer serializer(engine);
+    serializer.serialize(value);
+    return serializer.data;
+}
+
+Serialize::Data Serialize::serialize(const QV4::ValueRef value, QV8Engine *engine, const QV4::ValueRef transferList)
+{
+    Serializer serializer(engine);
+
+    Scope scope(QV8Engine::getV4(engine));
+    ScopedArrayObject list(scope, transferList);
+    if (list) {
+        Scoped<ArrayBuffer> buffer(scope);
+        uint length = list->arrayLength();
+        for (uint ii = 0; ii < length; ++ii) {
+            buffer = list->getIndexed(ii);
+            if (buffer)
+                serializer.transferred.insert(buffer.getPointer());
+        }
+    }
+
+    serializer.serialize(value);
+
+    // the message holds the only reference to the contents from now on,
+    // so neither side has to copy them
+    foreach (ArrayBuffer *buffer, serializer.transferred)
+        buffer->clear();
+    return serializer.data;
+}
 
+ReturnedValue Serialize::deserialize(Data &data, QV8Engine *engine)
+{
+    Deserializer deserializer(data, engine);
+    deserializer.run();
+    return deserializer.result();
+}
+
+QT_END_NAMESPACE
@@ -54,6 +54,7 @@
 //
 
 #include <QtCore/qbytearray.h>
+#include <QtCore/qvector.h>
 #include <private/qv4value_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -64,13 +65,73 @@ namespace QV4 {
 
 class Serialize {
 public:
+    // Long strings and the contents of array buffers are not copied into the
+    // stream. They are implicitly shared with the sending engine instead and
+    // only get copied if one of the sides modifies them.
+    struct Data {
+        QByteArray stream;
+        QVector<QString> strings;
+        QVector<QByteArray> buffers;
 
-    static QByteArray serialize(const ValueRef, QV8Engine *);
-    static ReturnedValue deserialize(const QByteArray &, QV8Engine *);
+        void swap(Data &other)
+        {
+            qSwap(stream, other.stream);
+            qSwap(strings, other.strings);
+            qSwap(buffers, other.buffers);
+        }
+    };
+
+    static Data serialize(const ValueRef, QV8Engine *);
+    // The ArrayBuffers in transferList are handed over to the receiver and
+    // left empty on the sending side.
+    static Data serialize(const ValueRef, QV8Engine *, const ValueRef transferList);
+    // Takes over the contents of the data, see Deserializer
+    static ReturnedValue deserialize(Data &, QV8Engine *);
+
+    // Rebuilds a value in slices of limited duration, so that receiving a
+    // large message doesn't block the event loop of the receiving thread.
+    // It takes over the contents of data and drops its references to the
+    // array buffer contents once they are handed to the new ArrayBuffers, so
+    // that those can be written to without copying them first.
+    class Deserializer {
+    public:
+        Deserializer(Data &data, QV8Engine *engine);
+
+        // Returns true once the value is complete. A negative time limit
+        // deserializes everything in one go.
+        bool run(int msecs = -1);
+        ReturnedValue result() const { return value.value(); }
+
+    private:
+        // an array, object or sequence that is being filled in, the
+        // container itself lives in the containers array to keep it alive
+        struct Frame {
+            int type;
+            quint32 size;
+            quint32 index;
+            int sequenceType;
+            QString key;
+        };
+
+        ReturnedValue read();
+        QString readString(quint32 header);
+        ReturnedValue readArrayBuffer();
+        void store(const ValueRef v);
+
+        Q_DISABLE_COPY(Deserializer)
+
+        Data data;
+        const char *stream;
+        QV8Engine *engine;
+        QVector<Frame> frames;
+        PersistentValue containers;
+        QVector<PersistentValue> buffers;
+        PersistentValue value;
+        bool done;
+    };
 
 private:
-    static void serialize(QByteArray &, const ValueRef, QV8Engine *);
-    static ReturnedValue deserialize(const char *&, QV8Engine *);
+    struct Serializer;
 };
 
 }
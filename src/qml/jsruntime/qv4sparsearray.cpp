@@ -45,11 +45,7 @@
 #include "qv4functionobject_p.h"
 #include "qv4scopedvalue_p.h"
 #include <stdlib.h>
-
-#ifdef QT_QMAP_DEBUG
-# include <qstring.h>
-# include <qvector.h>
-#endif
+#include <string.h>
 
 using namespace QV4;
 
@@ -79,389 +75,148 @@ bool ArrayElementLessThan::operator()(const Property &p1, const Property &p2) co
 }
 
 
-const SparseArrayNode *SparseArrayNode::nextNode() const
+SparseArrayChunk *SparseArrayChunk::allocate(int alloc)
 {
-    const SparseArrayNode *n = this;
-    if (n->right) {
-        n = n->right;
-        while (n->left)
-            n = n->left;
-    } else {
-        const SparseArrayNode *y = n->parent();
-        while (y && n == y->right) {
-            n = y;
-            y = n->parent();
-        }
-        n = y;
-    }
-    return n;
+    SparseArrayChunk *c = static_cast<SparseArrayChunk *>(malloc(sizeof(SparseArrayChunk) + alloc*(sizeof(quint64) + sizeof(uint))));
+    c->size = 0;
+    c->alloc = alloc;
+    return c;
 }
 
-const SparseArrayNode *SparseArrayNode::previousNode() const
+SparseArray::SparseArray()
+    : origin(Q_UINT64_C(1) << 62)
+    , numEntries(0)
 {
-    const SparseArrayNode *n = this;
-    if (n->left) {
-        n = n->left;
-        while (n->right)
-            n = n->right;
-    } else {
-        const SparseArrayNode *y = n->parent();
-        while (y && n == y->left) {
-            n = y;
-            y = n->parent();
-        }
-        n = y;
-    }
-    return n;
 }
 
-SparseArrayNode *SparseArrayNode::copy(SparseArray *d) const
+SparseArray::~SparseArray()
 {
-    SparseArrayNode *n = d->createNode(size_left, 0, false);
-    n->value = value;
-    n->setColor(color());
-    if (left) {
-        n->left = left->copy(d);
-        n->left->setParent(n);
-    } else {
-        n->left = 0;
-    }
-    if (right) {
-        n->right = right->copy(d);
-        n->right->setParent(n);
-    } else {
-        n->right = 0;
-    }
-    return n;
+    for (int i = 0; i < chunks.size(); ++i)
+        free(chunks.at(i));
 }
 
-/*
-     x              y
-      \            / \
-       y    -->   x   b
-      / \          \
-     a   b          a
-*/
-void SparseArray::rotateLeft(SparseArrayNode *x)
-{
-    SparseArrayNode *&root = header.left;
-    SparseArrayNode *y = x->right;
-    x->right = y->left;
-    if (y->left != 0)
-        y->left->setParent(x);
-    y->setParent(x->parent());
-    if (x == root)
-        root = y;
-    else if (x == x->parent()->left)
-        x->parent()->left = y;
-    else
-        x->parent()->right = y;
-    y->left = x;
-    x->setParent(y);
-    y->size_left += x->size_left;
+SparseArray::SparseArray(const SparseArray &other)
+    : origin(other.origin)
+    , numEntries(other.numEntries)
+{
+    chunks.reserve(other.chunks.size());
+    for (int i = 0; i < other.chunks.size(); ++i) {
+        const SparseArrayChunk *o = other.chunks.at(i);
+        SparseArrayChunk *c = SparseArrayChunk::allocate(o->size);
+        c->size = o->size;
+        memcpy(c->keys(), o->keys(), o->size*sizeof(quint64));
+        memcpy(c->values(), o->values(), o->size*sizeof(uint));
+        chunks.append(c);
+    }
 }
 
-
-/*
-         x          y
-        /          / \
-       y    -->   a   x
-      / \            /
-     a   b          b
-*/
-void SparseArray::rotateRight(SparseArrayNode *x)
+SparseArrayChunk *SparseArray::reserve(int chunk, int size)
 {
-    SparseArrayNode *&root = header.left;
-    SparseArrayNode *y = x->left;
-    x->left = y->right;
-    if (y->right != 0)
-        y->right->setParent(x);
-    y->setParent(x->parent());
-    if (x == root)
-        root = y;
-    else if (x == x->parent()->right)
-        x->parent()->right = y;
-    else
-        x->parent()->left = y;
-    y->right = x;
-    x->setParent(y);
-    x->size_left -= y->size_left;
-}
-
+    SparseArrayChunk *c = chunks.at(chunk);
+    if (size <= c->alloc)
+        return c;
 
-void SparseArray::rebalance(SparseArrayNode *x)
-{
-    SparseArrayNode *&root = header.left;
-    x->setColor(SparseArrayNode::Red);
-    while (x != root && x->parent()->color() == SparseArrayNode::Red) {
-        if (x->parent() == x->parent()->parent()->left) {
-            SparseArrayNode *y = x->parent()->parent()->right;
-            if (y && y->color() == SparseArrayNode::Red) {
-                x->parent()->setColor(SparseArrayNode::Black);
-                y->setColor(SparseArrayNode::Black);
-                x->parent()->parent()->setColor(SparseArrayNode::Red);
-                x = x->parent()->parent();
-            } else {
-                if (x == x->parent()->right) {
-                    x = x->parent();
-                    rotateLeft(x);
-                }
-                x->parent()->setColor(SparseArrayNode::Black);
-                x->parent()->parent()->setColor(SparseArrayNode::Red);
-                rotateRight (x->parent()->parent());
-            }
-        } else {
-            SparseArrayNode *y = x->parent()->parent()->left;
-            if (y && y->color() == SparseArrayNode::Red) {
-                x->parent()->setColor(SparseArrayNode::Black);
-                y->setColor(SparseArrayNode::Black);
-                x->parent()->parent()->setColor(SparseArrayNode::Red);
-                x = x->parent()->parent();
-            } else {
-                if (x == x->parent()->left) {
-                    x = x->parent();
-                    rotateRight(x);
-                }
-                x->parent()->setColor(SparseArrayNode::Black);
-                x->parent()->parent()->setColor(SparseArrayNode::Red);
-                rotateLeft(x->parent()->parent());
-            }
-        }
-    }
-    root->setColor(SparseArrayNode::Black);
+    SparseArrayChunk *n = SparseArrayChunk::allocate(qMin(qMax(size, 2*c->alloc), int(ChunkSize)));
+    n->size = c->size;
+    memcpy(n->keys(), c->keys(), c->size*sizeof(quint64));
+    memcpy(n->values(), c->values(), c->size*sizeof(uint));
+    free(c);
+    chunks[chunk] = n;
+    return n;
 }
 
-void SparseArray::deleteNode(SparseArrayNode *z)
-{
-    SparseArrayNode *&root = header.left;
-    SparseArrayNode *y = z;
-    SparseArrayNode *x;
-    SparseArrayNode *x_parent;
-    if (y->left == 0) {
-        x = y->right;
-        if (y == mostLeftNode) {
-            if (x)
-                mostLeftNode = x; // It cannot have (left) children due the red black invariant.
-            else
-                mostLeftNode = y->parent();
-        }
-    } else {
-        if (y->right == 0) {
-            x = y->left;
+void SparseArray::mergeWithNext(int chunk)
+{
+    SparseArrayChunk *next = chunks.at(chunk + 1);
+    SparseArrayChunk *c = reserve(chunk, chunks.at(chunk)->size + next->size);
+    memcpy(c->keys() + c->size, next->keys(), next->size*sizeof(quint64));
+    memcpy(c->values() + c->size, next->values(), next->size*sizeof(uint));
+    c->size += next->size;
+    free(next);
+    chunks.remove(chunk + 1);
+}
+
+SparseArray::iterator SparseArray::insert(uint akey)
+{
+    const quint64 k = origin + akey;
+    if (chunks.isEmpty())
+        chunks.append(SparseArrayChunk::allocate(4));
+
+    int c = findChunk(k);
+    if (c == chunks.size())
+        --c;
+    SparseArrayChunk *chunk = chunks.at(c);
+    int pos = chunk->lowerBound(k);
+    if (pos < chunk->size && chunk->keys()[pos] == k)
+        return iterator(this, c, pos);
+
+    if (chunk->size == ChunkSize) {
+        if (pos == ChunkSize || !pos) {
+            // the array is being filled in ascending or descending order,
+            // start a new chunk instead of leaving two half empty ones behind
+            if (pos)
+                ++c;
+            chunk = SparseArrayChunk::allocate(ChunkSize);
+            chunks.insert(c, chunk);
+            pos = 0;
         } else {
-            y = y->right;
-            while (y->left != 0)
-                y = y->left;
-            x = y->right;
-        }
-    }
-    if (y != z) {
-        z->left->setParent(y);
-        y->left = z->left;
-        if (y != z->right) {
-            x_parent = y->parent();
-            if (x)
-                x->setParent(y->parent());
-            y->parent()->left = x;
-            y->right = z->right;
-            z->right->setParent(y);
-        } else {
-            x_parent = y;
-        }
-        if (root == z)
-            root = y;
-        else if (z->parent()->left == z)
-            z->parent()->left = y;
-        else
-            z->parent()->right = y;
-        y->setParent(z->parent());
-        // Swap the colors
-        SparseArrayNode::Color c = y->color();
-        y->setColor(z->color());
-        z->setColor(c);
-        y = z;
-    } else {
-        x_parent = y->parent();
-        if (x)
-            x->setParent(y->parent());
-        if (root == z)
-            root = x;
-        else if (z->parent()->left == z)
-            z->parent()->left = x;
-        else
-            z->parent()->right = x;
-    }
-    if (y->color() != SparseArrayNode::Red) {
-        while (x != root && (x == 0 || x->color() == SparseArrayNode::Black)) {
-            if (x == x_parent->left) {
-                SparseArrayNode *w = x_parent->right;
-                if (w->color() == SparseArrayNode::Red) {
-                    w->setColor(SparseArrayNode::Black);
-                    x_parent->setColor(SparseArrayNode::Red);
-                    rotateLeft(x_parent);
-                    w = x_parent->right;
-                }
-                if ((w->left == 0 || w->left->color() == SparseArrayNode::Black) &&
-                    (w->right == 0 || w->right->color() == SparseArrayNode::Black)) {
-                    w->setColor(SparseArrayNode::Red);
-                    x = x_parent;
-                    x_parent = x_parent->parent();
-                } else {
-                    if (w->right == 0 || w->right->color() == SparseArrayNode::Black) {
-                        if (w->left)
-                            w->left->setColor(SparseArrayNode::Black);
-                        w->setColor(SparseArrayNode::Red);
-                        rotateRight(w);
-                        w = x_parent->right;
-                    }
-                    w->setColor(x_parent->color());
-                    x_parent->setColor(SparseArrayNode::Black);
-                    if (w->right)
-                        w->right->setColor(SparseArrayNode::Black);
-                    rotateLeft(x_parent);
-                    break;
-                }
-            } else {
-            SparseArrayNode *w = x_parent->left;
-            if (w->color() == SparseArrayNode::Red) {
-                w->setColor(SparseArrayNode::Black);
-                x_parent->setColor(SparseArrayNode::Red);
-                rotateRight(x_parent);
-                w = x_parent->left;
-            }
-            if ((w->right == 0 || w->right->color() == SparseArrayNode::Black) &&
-                (w->left == 0 || w->left->color() == SparseArrayNode::Black)) {
-                w->setColor(SparseArrayNode::Red);
-                x = x_parent;
-                x_parent = x_parent->parent();
-            } else {
-                if (w->left == 0 || w->left->color() == SparseArrayNode::Black) {
-                    if (w->right)
-                        w->right->setColor(SparseArrayNode::Black);
-                    w->setColor(SparseArrayNode::Red);
-                    rotateLeft(w);
-                    w = x_parent->left;
-                }
-                w->setColor(x_parent->color());
-                x_parent->setColor(SparseArrayNode::Black);
-                if (w->left)
-                    w->left->setColor(SparseArrayNode::Black);
-                rotateRight(x_parent);
-                break;
+            const int half = ChunkSize/2;
+            SparseArrayChunk *next = SparseArrayChunk::allocate(ChunkSize);
+            next->size = ChunkSize - half;
+            memcpy(next->keys(), chunk->keys() + half, next->size*sizeof(quint64));
+            memcpy(next->values(), chunk->values() + half, next->size*sizeof(uint));
+            chunk->size = half;
+            chunks.insert(c + 1, next);
+            if (pos > half) {
+                ++c;
+                pos -= half;
+                chunk = next;
             }
         }
+    } else {
+        chunk = reserve(c, chunk->size + 1);
     }
-    if (x)
-        x->setColor(SparseArrayNode::Black);
-    }
-    free(y);
-    --numEntries;
-}
-
-void SparseArray::recalcMostLeftNode()
-{
-    mostLeftNode = &header;
-    while (mostLeftNode->left)
-        mostLeftNode = mostLeftNode->left;
-}
-
-static inline int qMapAlignmentThreshold()
-{
-    // malloc on 32-bit platforms should return pointers that are 8-byte
-    // aligned or more while on 64-bit platforms they should be 16-byte aligned
-    // or more
-    return 2 * sizeof(void*);
-}
-
-static inline void *qMapAllocate(int alloc, int alignment)
-{
-    return alignment > qMapAlignmentThreshold()
-        ? qMallocAligned(alloc, alignment)
-        : ::malloc(alloc);
-}
-
-static inline void qMapDeallocate(SparseArrayNode *node, int alignment)
-{
-    if (alignment > qMapAlignmentThreshold())
-        qFreeAligned(node);
-    else
-        ::free(node);
-}
 
-SparseArrayNode *SparseArray::createNode(uint sl, SparseArrayNode *parent, bool left)
-{
-    SparseArrayNode *node = static_cast<SparseArrayNode *>(qMapAllocate(sizeof(SparseArrayNode), Q_ALIGNOF(SparseArrayNode)));
-    Q_CHECK_PTR(node);
-
-    node->p = (quintptr)parent;
-    node->left = 0;
-    node->right = 0;
-    node->size_left = sl;
-    node->value = UINT_MAX;
+    memmove(chunk->keys() + pos + 1, chunk->keys() + pos, (chunk->size - pos)*sizeof(quint64));
+    memmove(chunk->values() + pos + 1, chunk->values() + pos, (chunk->size - pos)*sizeof(uint));
+    chunk->keys()[pos] = k;
+    chunk->values()[pos] = UINT_MAX;
+    ++chunk->size;
     ++numEntries;
-
-    if (parent) {
-        if (left) {
-            parent->left = node;
-            if (parent == mostLeftNode)
-                mostLeftNode = node;
-        } else {
-            parent->right = node;
-        }
-        node->setParent(parent);
-        rebalance(node);
-    }
-    return node;
+    return iterator(this, c, pos);
 }
 
-void SparseArray::freeTree(SparseArrayNode *root, int alignment)
+SparseArray::iterator SparseArray::erase(iterator it)
 {
-    if (root->left)
-        freeTree(root->left, alignment);
-    if (root->right)
-        freeTree(root->right, alignment);
-    qMapDeallocate(root, alignment);
-}
+    if (it == end())
+        return it;
 
-SparseArray::SparseArray()
-    : numEntries(0)
-{
-    header.p = 0;
-    header.left = 0;
-    header.right = 0;
-    mostLeftNode = &header;
-}
+    int c = it.chunk;
+    int pos = it.pos;
+    SparseArrayChunk *chunk = chunks.at(c);
+    --chunk->size;
+    --numEntries;
+    memmove(chunk->keys() + pos, chunk->keys() + pos + 1, (chunk->size - pos)*sizeof(quint64));
+    memmove(chunk->values() + pos, chunk->values() + pos + 1, (chunk->size - pos)*sizeof(uint));
 
-SparseArray::SparseArray(const SparseArray &other)
-{
-    header.p = 0;
-    header.right = 0;
-    if (other.header.left) {
-        header.left = other.header.left->copy(this);
-        header.left->setParent(&header);
-        recalcMostLeftNode();
+    if (!chunk->size) {
+        free(chunk);
+        chunks.remove(c);
+        return iterator(this, c, 0);
     }
-}
 
-SparseArrayNode *SparseArray::insert(uint akey)
-{
-    SparseArrayNode *n = root();
-    SparseArrayNode *y = end();
-    bool  left = true;
-    uint s = akey;
-    while (n) {
-        y = n;
-        if (s == n->size_left) {
-            return n;
-        } else if (s < n->size_left) {
-            left = true;
-            n = n->left;
-        } else {
-            left = false;
-            s -= n->size_left;
-            n = n->right;
-        }
+    // keep the chunks reasonably full when entries get removed
+    if (c + 1 < chunks.size() && chunk->size + chunks.at(c + 1)->size <= ChunkSize/2) {
+        mergeWithNext(c);
+    } else if (c > 0 && chunks.at(c - 1)->size + chunk->size <= ChunkSize/2) {
+        pos += chunks.at(c - 1)->size;
+        --c;
+        mergeWithNext(c);
     }
 
-    return createNode(s, y, left);
+    if (pos == chunks.at(c)->size) {
+        ++c;
+        pos = 0;
+    }
+    return iterator(this, c, pos);
 }
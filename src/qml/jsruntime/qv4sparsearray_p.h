@@ -43,17 +43,14 @@
 #define QV4ARRAY_H
 
 #include "qv4global_p.h"
-#include <QtCore/qmap.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qvector.h>
 #include "qv4value_p.h"
 #include "qv4scopedvalue_p.h"
 #include "qv4property_p.h"
 #include <assert.h>
 
-#ifdef Q_MAP_DEBUG
-#include <QtCore/qdebug.h>
-#endif
-
-#include <new>
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
@@ -76,111 +73,99 @@ private:
 };
 
 
-struct SparseArrayNode
-{
-    quintptr p;
-    SparseArrayNode *left;
-    SparseArrayNode *right;
-    uint size_left;
-    uint value;
-
-    enum Color { Red = 0, Black = 1 };
-    enum { Mask = 3 }; // reserve the second bit as well
-
-    const SparseArrayNode *nextNode() const;
-    SparseArrayNode *nextNode() { return const_cast<SparseArrayNode *>(const_cast<const SparseArrayNode *>(this)->nextNode()); }
-    const SparseArrayNode *previousNode() const;
-    SparseArrayNode *previousNode() { return const_cast<SparseArrayNode *>(const_cast<const SparseArrayNode *>(this)->previousNode()); }
-
-    Color color() const { return Color(p & 1); }
-    void setColor(Color c) { if (c == Black) p |= Black; else p &= ~Black; }
-    SparseArrayNode *parent() const { return reinterpret_cast<SparseArrayNode *>(p & ~Mask); }
-    void setParent(SparseArrayNode *pp) { p = (p & Mask) | quintptr(pp); }
-
-    uint key() const {
-        uint k = size_left;
-        const SparseArrayNode *n = this;
-        while (SparseArrayNode *p = n->parent()) {
-            if (p && p->right == n)
-                k += p->size_left;
-            n = p;
-        }
-        return k;
-    }
-
-    SparseArrayNode *copy(SparseArray *d) const;
-
-    SparseArrayNode *lowerBound(uint key);
-    SparseArrayNode *upperBound(uint key);
-};
-
-
-inline SparseArrayNode *SparseArrayNode::lowerBound(uint akey)
+// The entries of a sparse array are kept in key order in a list of chunks,
+// each of which stores up to ChunkSize packed keys followed by the matching
+// values (indices into Object::arrayData). Lookups are a binary search over
+// the chunks followed by one inside a chunk, and iteration walks contiguous
+// memory instead of chasing tree nodes.
+//
+// Keys are stored as 64 bit offsets from a movable origin, so that
+// push_front() and pop_front() (Array.prototype.unshift/shift) renumber all
+// entries by moving the origin instead of touching every key.
+struct SparseArrayChunk
 {
-    SparseArrayNode *n = this;
-    SparseArrayNode *last = 0;
-    while (n) {
-        if (akey <= n->size_left) {
-            last = n;
-            n = n->left;
-        } else {
-            akey -= n->size_left;
-            n = n->right;
-        }
-    }
-    return last;
-}
+    int size;
+    int alloc;
 
+    quint64 *keys() { return reinterpret_cast<quint64 *>(this + 1); }
+    const quint64 *keys() const { return reinterpret_cast<const quint64 *>(this + 1); }
+    uint *values() { return reinterpret_cast<uint *>(keys() + alloc); }
+    const uint *values() const { return reinterpret_cast<const uint *>(keys() + alloc); }
 
-inline SparseArrayNode *SparseArrayNode::upperBound(uint akey)
-{
-    SparseArrayNode *n = this;
-    SparseArrayNode *last = 0;
-    while (n) {
-        if (akey < n->size_left) {
-            last = n;
-            n = n->left;
-        } else {
-            akey -= n->size_left;
-            n = n->right;
-        }
-    }
-    return last;
-}
-
+    quint64 lastKey() const { return keys()[size - 1]; }
+    int lowerBound(quint64 key) const { return int(std::lower_bound(keys(), keys() + size, key) - keys()); }
 
+    static SparseArrayChunk *allocate(int alloc);
+};
 
 struct Q_QML_EXPORT SparseArray
 {
+    enum { ChunkSize = 128 };
+
     SparseArray();
-    ~SparseArray() {
-        if (root())
-            freeTree(header.left, Q_ALIGNOF(SparseArrayNode));
-    }
+    ~SparseArray();
 
     SparseArray(const SparseArray &other);
 private:
     SparseArray &operator=(const SparseArray &other);
 
+    QVector<SparseArrayChunk *> chunks;
+    quint64 origin;
     int numEntries;
-    SparseArrayNode header;
-    SparseArrayNode *mostLeftNode;
 
-    void rotateLeft(SparseArrayNode *x);
-    void rotateRight(SparseArrayNode *x);
-    void rebalance(SparseArrayNode *x);
-    void recalcMostLeftNode();
+    int findChunk(quint64 key) const;
+    SparseArrayChunk *reserve(int chunk, int size);
+    void mergeWithNext(int chunk);
 
-    SparseArrayNode *root() const { return header.left; }
+public:
+    struct iterator;
+    friend struct iterator;
+
+    // Iterators are invalidated by insert() and erase(), except for the one
+    // returned from them.
+    struct iterator
+    {
+        iterator() : d(0), chunk(0), pos(0) {}
+        iterator(const SparseArray *d, int chunk, int pos) : d(d), chunk(chunk), pos(pos) {}
+
+        uint key() const { return uint(d->chunks.at(chunk)->keys()[pos] - d->origin); }
+        uint &value() const { return d->chunks.at(chunk)->values()[pos]; }
+
+        iterator &operator++() {
+            if (++pos == d->chunks.at(chunk)->size) {
+                ++chunk;
+                pos = 0;
+            }
+            return *this;
+        }
+        iterator &operator--() {
+            if (!pos) {
+                --chunk;
+                pos = d->chunks.at(chunk)->size;
+            }
+            --pos;
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return chunk == other.chunk && pos == other.pos; }
+        bool operator!=(const iterator &other) const { return chunk != other.chunk || pos != other.pos; }
 
-    void deleteNode(SparseArrayNode *z);
+        const SparseArray *d;
+        int chunk;
+        int pos;
+    };
 
+    iterator begin() const { return iterator(this, 0, 0); }
+    iterator end() const { return iterator(this, chunks.size(), 0); }
 
-public:
-    SparseArrayNode *createNode(uint sl, SparseArrayNode *parent, bool left);
-    void freeTree(SparseArrayNode *root, int alignment);
+    int size() const { return numEntries; }
+
+    iterator find(uint akey) const;
+    iterator lowerBound(uint akey) const;
+    iterator upperBound(uint akey) const;
 
-    SparseArrayNode *findNode(uint akey) const;
+    // returns the existing entry for akey, or a new one with a value of UINT_MAX
+    iterator insert(uint akey);
+    iterator erase(iterator it);
 
     uint pop_front();
     void push_front(uint at);
@@ -189,76 +174,76 @@ public:
 
     QList<int> keys() const;
 
-    const SparseArrayNode *end() const { return &header; }
-    SparseArrayNode *end() { return &header; }
-    const SparseArrayNode *begin() const { if (root()) return mostLeftNode; return end(); }
-    SparseArrayNode *begin() { if (root()) return mostLeftNode; return end(); }
-
-    SparseArrayNode *erase(SparseArrayNode *n);
-
-    SparseArrayNode *lowerBound(uint key);
-    const SparseArrayNode *lowerBound(uint key) const;
-    SparseArrayNode *upperBound(uint key);
-    const SparseArrayNode *upperBound(uint key) const;
-    SparseArrayNode *insert(uint akey);
-
     // STL compatibility
     typedef uint key_type;
     typedef int mapped_type;
     typedef qptrdiff difference_type;
     typedef int size_type;
-
-#ifdef Q_MAP_DEBUG
-    void dump() const;
-#endif
 };
 
-inline SparseArrayNode *SparseArray::findNode(uint akey) const
+inline int SparseArray::findChunk(quint64 key) const
 {
-    SparseArrayNode *n = root();
-
-    while (n) {
-        if (akey == n->size_left) {
-            return n;
-        } else if (akey < n->size_left) {
-            n = n->left;
-        } else {
-            akey -= n->size_left;
-            n = n->right;
-        }
+    // first chunk that contains an entry not less than key
+    int lo = 0;
+    int hi = chunks.size();
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (chunks.at(mid)->lastKey() < key)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    return lo;
+}
 
-    return 0;
+inline SparseArray::iterator SparseArray::lowerBound(uint akey) const
+{
+    const quint64 k = origin + akey;
+    int c = findChunk(k);
+    if (c == chunks.size())
+        return end();
+    return iterator(this, c, chunks.at(c)->lowerBound(k));
+}
+
+inline SparseArray::iterator SparseArray::upperBound(uint akey) const
+{
+    if (akey == UINT_MAX)
+        return end();
+    return lowerBound(akey + 1);
+}
+
+inline SparseArray::iterator SparseArray::find(uint akey) const
+{
+    const quint64 k = origin + akey;
+    int c = findChunk(k);
+    if (c == chunks.size())
+        return end();
+    const SparseArrayChunk *chunk = chunks.at(c);
+    int pos = chunk->lowerBound(k);
+    if (chunk->keys()[pos] != k)
+        return end();
+    return iterator(this, c, pos);
 }
 
 inline uint SparseArray::pop_front()
 {
-    uint idx = UINT_MAX ;
-
-    SparseArrayNode *n = findNode(0);
-    if (n) {
-        idx = n->value;
-        deleteNode(n);
-        // adjust all size_left indices on the path to leftmost item by 1
-        SparseArrayNode *n = root();
-        while (n) {
-            n->size_left -= 1;
-            n = n->left;
-        }
+    uint idx = UINT_MAX;
+
+    iterator n = begin();
+    if (n != end() && !n.key()) {
+        idx = n.value();
+        erase(n);
     }
+    // all remaining keys move down by one
+    ++origin;
     return idx;
 }
 
 inline void SparseArray::push_front(uint value)
 {
-    // adjust all size_left indices on the path to leftmost item by 1
-    SparseArrayNode *n = root();
-    while (n) {
-        n->size_left += 1;
-        n = n->left;
-    }
-    n = insert(0);
-    n->value = value;
+    // all keys move up by one
+    --origin;
+    insert(0).value() = value;
 }
 
 inline uint SparseArray::pop_back(uint len)
@@ -267,100 +252,28 @@ inline uint SparseArray::pop_back(uint len)
     if (!len)
         return idx;
 
-    SparseArrayNode *n = findNode(len - 1);
-    if (n) {
-        idx = n->value;
-        deleteNode(n);
+    iterator n = find(len - 1);
+    if (n != end()) {
+        idx = n.value();
+        erase(n);
     }
     return idx;
 }
 
 inline void SparseArray::push_back(uint index, uint len)
 {
-    SparseArrayNode *n = insert(len);
-    n->value = index;
-}
-
-#ifdef Q_MAP_DEBUG
-
-void SparseArray::dump() const
-{
-    const_iterator it = begin();
-    qDebug() << "map dump:";
-    while (it != end()) {
-        const SparseArrayNode *n = it.i;
-        int depth = 0;
-        while (n && n != root()) {
-            ++depth;
-            n = n->parent();
-        }
-        QByteArray space(4*depth, ' ');
-        qDebug() << space << (it.i->color() == SparseArrayNode::Red ? "Red  " : "Black") << it.i << it.i->left << it.i->right
-                 << it.key() << it.value();
-        ++it;
-    }
-    qDebug() << "---------";
-}
-#endif
-
-
-inline SparseArrayNode *SparseArray::erase(SparseArrayNode *n)
-{
-    if (n == end())
-        return n;
-
-    SparseArrayNode *next = n->nextNode();
-    deleteNode(n);
-    return next;
+    insert(len).value() = index;
 }
 
 inline QList<int> SparseArray::keys() const
 {
     QList<int> res;
     res.reserve(numEntries);
-    SparseArrayNode *n = mostLeftNode;
-    while (n != end()) {
-        res.append(n->key());
-        n = n->nextNode();
-    }
+    for (iterator it = begin(); it != end(); ++it)
+        res.append(it.key());
     return res;
 }
 
-inline const SparseArrayNode *SparseArray::lowerBound(uint akey) const
-{
-    const SparseArrayNode *lb = root()->lowerBound(akey);
-    if (!lb)
-        lb = end();
-    return lb;
-}
-
-
-inline SparseArrayNode *SparseArray::lowerBound(uint akey)
-{
-    SparseArrayNode *lb = root()->lowerBound(akey);
-    if (!lb)
-        lb = end();
-    return lb;
-}
-
-
-inline const SparseArrayNode *SparseArray::upperBound(uint akey) const
-{
-    const SparseArrayNode *ub = root()->upperBound(akey);
-    if (!ub)
-        ub = end();
-    return ub;
-}
-
-
-inline SparseArrayNode *SparseArray::upperBound(uint akey)
-{
-    SparseArrayNode *ub = root()->upperBound(akey);
-    if (!ub)
-        ub = end();
-    return ub;
-}
-
 }
 
 QT_END_NAMESPACE
@@ -150,10 +150,6 @@ Property *StringObject::advanceIterator(Managed *m, ObjectIterator *it, StringRe
                 *attrs = s->arrayAttributes ? s->arrayAttributes[it->arrayIndex] : PropertyAttributes(Attr_NotWritable|Attr_NotConfigurable);
             return s->__getOwnProperty__(*index);
         }
-        it->arrayNode = s->sparseArrayBegin();
-        // iterate until we're past the end of the string
-        while (it->arrayNode && it->arrayNode->key() < slen)
-            it->arrayNode = it->arrayNode->nextNode();
     }
 
     return Object::advanceIterator(m, it, name, index, attrs);
@@ -0,0 +1,474 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4typedarray_p.h"
+#include "qv4objectiterator_p.h"
+
+#include <QtCore/qvector.h>
+#include <cmath>
+#include <cstring>
+
+using namespace QV4;
+
+namespace {
+
+template <typename T>
+ReturnedValue readInt(const char *data)
+{
+    T v;
+    memcpy(&v, data, sizeof(T));
+    return Encode(int(v));
+}
+
+template <typename T>
+void writeInt(char *data, double value)
+{
+    T v = T(Primitive::toInt32(value));
+    memcpy(data, &v, sizeof(T));
+}
+
+ReturnedValue readUInt32(const char *data)
+{
+    quint32 v;
+    memcpy(&v, data, sizeof(quint32));
+    return Encode(uint(v));
+}
+
+void writeUInt32(char *data, double value)
+{
+    quint32 v = Primitive::toUInt32(value);
+    memcpy(data, &v, sizeof(quint32));
+}
+
+void writeUInt8Clamped(char *data, double value)
+{
+    // rounds half to even, NaN becomes 0
+    uchar v;
+    if (!(value > 0)) {
+        v = 0;
+    } else if (value >= 255) {
+        v = 255;
+    } else {
+        double f = std::floor(value);
+        double r = value - f;
+        if (r > 0.5 || (r == 0.5 && (int(f) & 1)))
+            f += 1;
+        v = uchar(f);
+    }
+    *data = char(v);
+}
+
+template <typename T>
+ReturnedValue readFloat(const char *data)
+{
+    T v;
+    memcpy(&v, data, sizeof(T));
+    return Encode(double(v));
+}
+
+template <typename T>
+void writeFloat(char *data, double value)
+{
+    T v = T(value);
+    memcpy(data, &v, sizeof(T));
+}
+
+}
+
+const TypedArrayOperations QV4::typedArrayOperations[NTypedArrayTypes] = {
+    { 1, "Int8Array", readInt<qint8>, writeInt<qint8> },
+    { 1, "Uint8Array", readInt<quint8>, writeInt<quint8> },
+    { 1, "Uint8ClampedArray", readInt<quint8>, writeUInt8Clamped },
+    { 2, "Int16Array", readInt<qint16>, writeInt<qint16> },
+    { 2, "Uint16Array", readInt<quint16>, writeInt<quint16> },
+    { 4, "Int32Array", readInt<qint32>, writeInt<qint32> },
+    { 4, "Uint32Array", readUInt32, writeUInt32 },
+    { 4, "Float32Array", readFloat<float>, writeFloat<float> },
+    { 8, "Float64Array", readFloat<double>, writeFloat<double> }
+};
+
+DEFINE_MANAGED_VTABLE(TypedArrayCtor);
+DEFINE_MANAGED_VTABLE(TypedArray);
+
+TypedArrayCtor::TypedArrayCtor(ExecutionContext *scope, TypedArrayType t)
+    : FunctionObject(scope, QString::fromLatin1(typedArrayOperations[t].name))
+    , arrayType(t)
+{
+    setVTable(&static_vtbl);
+}
+
+ReturnedValue TypedArrayCtor::construct(Managed *m, CallData *callData)
+{
+    ExecutionEngine *v4 = m->engine();
+    ExecutionContext *ctx = v4->currentContext();
+    Scope scope(v4);
+    TypedArrayType type = static_cast<TypedArrayCtor *>(m)->arrayType;
+    const uint bytesPerElement = typedArrayOperations[type].bytesPerElement;
+
+    Scoped<ArrayBuffer> buffer(scope, callData->argument(0));
+    if (!!buffer) {
+        // new TypedArray(buffer, byteOffset, length), a view on existing data
+        ScopedValue v(scope, callData->argument(1));
+        double dOffset = v->toInteger();
+        if (scope.hasException())
+            return Encode::undefined();
+        if (dOffset < 0 || dOffset > buffer->byteLength() || uint(dOffset) % bytesPerElement)
+            return ctx->throwRangeError(QStringLiteral("new TypedArray: invalid byteOffset"));
+        uint byteOffset = uint(dOffset);
+
+        uint byteLength;
+        v = callData->argument(2);
+        if (v->isUndefined()) {
+            byteLength = buffer->byteLength() - byteOffset;
+            if (byteLength % bytesPerElement)
+                return ctx->throwRangeError(QStringLiteral("new TypedArray: invalid length"));
+        } else {
+            double l = v->toInteger() * bytesPerElement;
+            if (scope.hasException())
+                return Encode::undefined();
+            if (l < 0 || l > buffer->byteLength() - byteOffset)
+                return ctx->throwRangeError(QStringLiteral("new TypedArray: invalid length"));
+            byteLength = uint(l);
+        }
+
+        return (new (v4->memoryManager) TypedArray(v4, type, buffer.getPointer(), byteOffset, byteLength))->asReturnedValue();
+    }
+
+    ScopedObject source(scope, callData->argument(0));
+    if (!source) {
+        // new TypedArray(length)
+        ScopedValue v(scope, callData->argument(0));
+        double l = v->toInteger();
+        if (scope.hasException())
+            return Encode::undefined();
+        if (l < 0 || l * bytesPerElement > INT_MAX)
+            return ctx->throwRangeError(QStringLiteral("new TypedArray: invalid length"));
+        uint byteLength = uint(l) * bytesPerElement;
+        buffer = v4->newArrayBuffer(byteLength);
+        return (new (v4->memoryManager) TypedArray(v4, type, buffer.getPointer(), 0, byteLength))->asReturnedValue();
+    }
+
+    // new TypedArray(typedArray) or new TypedArray(arrayLike), a copy of the elements
+    Scoped<TypedArray> sourceArray(scope, source);
+    double l;
+    if (!!sourceArray) {
+        l = sourceArray->length();
+    } else {
+        ScopedValue len(scope, source->get(v4->id_length));
+        l = len->toUInt32();
+        if (scope.hasException())
+            return Encode::undefined();
+    }
+    if (l * bytesPerElement > INT_MAX)
+        return ctx->throwRangeError(QStringLiteral("new TypedArray: invalid length"));
+    uint length = uint(l);
+
+    buffer = v4->newArrayBuffer(length * bytesPerElement);
+    Scoped<TypedArray> array(scope, new (v4->memoryManager) TypedArray(v4, type, buffer.getPointer(), 0, length * bytesPerElement));
+
+    if (!!sourceArray && sourceArray->arrayType() == type) {
+        memcpy(buffer->writableData(), sourceArray->arrayBuffer()->constData() + sourceArray->byteOffset, length * bytesPerElement);
+        return array.asReturnedValue();
+    }
+
+    ScopedValue val(scope);
+    for (uint i = 0; i < length; ++i) {
+        val = !!sourceArray ? sourceArray->element(i) : source->getIndexed(i);
+        double d = val->toNumber();
+        if (scope.hasException())
+            return Encode::undefined();
+        array->setElement(i, d);
+    }
+    return array.asReturnedValue();
+}
+
+ReturnedValue TypedArrayCtor::call(Managed *that, CallData *)
+{
+    return that->engine()->currentContext()->throwTypeError(QStringLiteral("%1 must be called with new")
+                                                           .arg(QLatin1String(typedArrayOperations[static_cast<TypedArrayCtor *>(that)->arrayType].name)));
+}
+
+TypedArray::TypedArray(ExecutionEngine *engine, TypedArrayType t, ArrayBuffer *buffer, uint byteOffset, uint byteLength)
+    : Object(engine->typedArrayClasses[t])
+    , byteOffset(byteOffset)
+    , byteLength(byteLength)
+{
+    type = Type_TypedArray;
+    subtype = t;
+    // elements are not stored in arrayData, keep the generated code off its fast path
+    flags &= ~SimpleArray;
+    // views write to the contents in place, so they must not be shared with C++
+    buffer->detach();
+    this->buffer = buffer;
+    tmpProperty.value = Primitive::undefinedValue();
+}
+
+Property *TypedArray::getIndex(uint index) const
+{
+    if (index >= length())
+        return 0;
+    tmpProperty.value = element(index);
+    return &tmpProperty;
+}
+
+ReturnedValue TypedArray::getIndexed(Managed *m, uint index, bool *hasProperty)
+{
+    TypedArray *a = static_cast<TypedArray *>(m);
+    // integer indexes never reach the prototype chain
+    if (index >= a->length()) {
+        if (hasProperty)
+            *hasProperty = false;
+        return Encode::undefined();
+    }
+    if (hasProperty)
+        *hasProperty = true;
+    return a->element(index);
+}
+
+void TypedArray::putIndexed(Managed *m, uint index, const ValueRef value)
+{
+    ExecutionEngine *v4 = m->engine();
+    if (v4->hasException)
+        return;
+
+    Scope scope(v4);
+    Scoped<TypedArray> a(scope, static_cast<TypedArray *>(m));
+    double d = value->toNumber();
+    if (scope.hasException())
+        return;
+    // converting the value can run script code, so check the range afterwards
+    if (index < a->length())
+        a->setElement(index, d);
+}
+
+PropertyAttributes TypedArray::queryIndexed(const Managed *m, uint index)
+{
+    const TypedArray *a = static_cast<const TypedArray *>(m);
+    if (index < a->length())
+        return Attr_NotConfigurable;
+    return Attr_Invalid;
+}
+
+bool TypedArray::deleteIndexedProperty(Managed *m, uint index)
+{
+    TypedArray *a = static_cast<TypedArray *>(m);
+    if (index < a->length()) {
+        ExecutionContext *ctx = m->engine()->currentContext();
+        if (ctx->strictMode)
+            ctx->throwTypeError();
+        return false;
+    }
+    return true;
+}
+
+Property *TypedArray::advanceIterator(Managed *m, ObjectIterator *it, StringRef name, uint *index, PropertyAttributes *attrs)
+{
+    name = (String *)0;
+    TypedArray *a = static_cast<TypedArray *>(m);
+    uint length = a->length();
+    if (it->arrayIndex < length) {
+        *index = it->arrayIndex;
+        ++it->arrayIndex;
+        if (attrs)
+            *attrs = Attr_NotConfigurable;
+        return a->getIndex(*index);
+    }
+    it->arrayIndex = UINT_MAX;
+
+    return Object::advanceIterator(m, it, name, index, attrs);
+}
+
+void TypedArray::markObjects(Managed *that, ExecutionEngine *e)
+{
+    TypedArray *a = static_cast<TypedArray *>(that);
+    a->buffer.mark(e);
+    Object::markObjects(that, e);
+}
+
+void TypedArrayPrototype::init(ExecutionEngine *engine, ObjectRef ctor)
+{
+    Scope scope(engine);
+    ScopedObject o(scope);
+    const TypedArrayOperations &ops = typedArrayOperations[arrayType];
+
+    ctor->defineReadonlyProperty(engine->id_length, Primitive::fromInt32(3));
+    ctor->defineReadonlyProperty(engine->id_prototype, (o = this));
+    ctor->defineReadonlyProperty(QStringLiteral("BYTES_PER_ELEMENT"), Primitive::fromInt32(ops.bytesPerElement));
+    defineDefaultProperty(QStringLiteral("constructor"), (o = ctor));
+    defineReadonlyProperty(QStringLiteral("BYTES_PER_ELEMENT"), Primitive::fromInt32(ops.bytesPerElement));
+    defineAccessorProperty(QStringLiteral("buffer"), method_get_buffer, 0);
+    defineAccessorProperty(QStringLiteral("byteLength"), method_get_byteLength, 0);
+    defineAccessorProperty(QStringLiteral("byteOffset"), method_get_byteOffset, 0);
+    defineAccessorProperty(QStringLiteral("length"), method_get_length, 0);
+
+    defineDefaultProperty(QStringLiteral("set"), method_set, 1);
+    defineDefaultProperty(QStringLiteral("subarray"), method_subarray, 2);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_buffer(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return v->buffer.asReturnedValue();
+}
+
+ReturnedValue TypedArrayPrototype::method_get_byteLength(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->length() * v->operations().bytesPerElement);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_byteOffset(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteOffset);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_length(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->length());
+}
+
+ReturnedValue TypedArrayPrototype::method_set(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    ScopedValue v(scope, ctx->argument(1));
+    double dOffset = v->toInteger();
+    if (scope.hasException())
+        return Encode::undefined();
+    if (dOffset < 0 || dOffset > a->length())
+        return ctx->throwRangeError(QStringLiteral("TypedArray.set: out of range"));
+    uint offset = uint(dOffset);
+
+    ScopedObject source(scope, ctx->argument(0));
+    if (!source)
+        return ctx->throwTypeError();
+
+    Scoped<TypedArray> sourceArray(scope, source);
+    if (!sourceArray) {
+        ScopedValue len(scope, source->get(ctx->engine->id_length));
+        uint l = len->toUInt32();
+        if (scope.hasException())
+            return Encode::undefined();
+        if (l > a->length() - offset)
+            return ctx->throwRangeError(QStringLiteral("TypedArray.set: out of range"));
+
+        ScopedValue val(scope);
+        for (uint i = 0; i < l; ++i) {
+            val = source->getIndexed(i);
+            double d = val->toNumber();
+            if (scope.hasException())
+                return Encode::undefined();
+            if (offset + i < a->length())
+                a->setElement(offset + i, d);
+        }
+        return Encode::undefined();
+    }
+
+    uint l = sourceArray->length();
+    if (l > a->length() - offset)
+        return ctx->throwRangeError(QStringLiteral("TypedArray.set: out of range"));
+    if (!l)
+        return Encode::undefined();
+
+    const uint bytesPerElement = a->operations().bytesPerElement;
+    if (sourceArray->arrayType() == a->arrayType()) {
+        // source and target can be views on the same buffer. Get the target first, as
+        // that can detach the data.
+        char *dst = a->arrayBuffer()->writableData() + a->byteOffset + offset * bytesPerElement;
+        const char *src = sourceArray->arrayBuffer()->constData() + sourceArray->byteOffset;
+        memmove(dst, src, l * bytesPerElement);
+        return Encode::undefined();
+    }
+
+    // different element types, read all elements before writing in case the views overlap
+    QVector<double> values(l);
+    ScopedValue val(scope);
+    for (uint i = 0; i < l; ++i) {
+        val = sourceArray->element(i);
+        values[i] = val->toNumber();
+    }
+    for (uint i = 0; i < l; ++i)
+        a->setElement(offset + i, values.at(i));
+    return Encode::undefined();
+}
+
+ReturnedValue TypedArrayPrototype::method_subarray(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    uint length = a->length();
+    ScopedValue begin(scope, ctx->argument(0));
+    ScopedValue end(scope, ctx->argument(1));
+    uint first = relativeIndex(begin, length, 0);
+    uint last = relativeIndex(end, length, length);
+    if (scope.hasException())
+        return Encode::undefined();
+
+    const uint bytesPerElement = a->operations().bytesPerElement;
+    uint newLength = last > first ? last - first : 0;
+    Scoped<ArrayBuffer> buffer(scope, a->buffer);
+    return (new (ctx->engine->memoryManager) TypedArray(ctx->engine, a->arrayType(), buffer.getPointer(),
+                                                         a->byteOffset + first * bytesPerElement, newLength * bytesPerElement))->asReturnedValue();
+}
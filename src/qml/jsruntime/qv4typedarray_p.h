@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4TYPEDARRAY_H
+#define QV4TYPEDARRAY_H
+
+#include "qv4object_p.h"
+#include "qv4functionobject_p.h"
+#include "qv4arraybuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+
+typedef ReturnedValue (*TypedArrayRead)(const char *data);
+typedef void (*TypedArrayWrite)(char *data, double value);
+
+struct TypedArrayOperations {
+    uint bytesPerElement;
+    const char *name;
+    TypedArrayRead read;
+    TypedArrayWrite write;
+};
+
+extern const TypedArrayOperations typedArrayOperations[NTypedArrayTypes];
+
+struct TypedArray : Object
+{
+    Q_MANAGED
+    TypedArray(ExecutionEngine *engine, TypedArrayType t, ArrayBuffer *buffer, uint byteOffset, uint byteLength);
+
+    SafeValue buffer;
+    uint byteOffset;
+    uint byteLength;
+    mutable Property tmpProperty;
+
+    // the element type is kept in the subtype, like the kind of an ErrorObject
+    TypedArrayType arrayType() const { return TypedArrayType(subtype); }
+    const TypedArrayOperations &operations() const { return typedArrayOperations[subtype]; }
+    ArrayBuffer *arrayBuffer() const { return static_cast<ArrayBuffer *>(buffer.managed()); }
+
+    // The view is empty once its buffer no longer covers it
+    uint length() const {
+        if (byteOffset + byteLength > arrayBuffer()->byteLength())
+            return 0;
+        return byteLength / operations().bytesPerElement;
+    }
+
+    inline ReturnedValue element(uint index) const {
+        const TypedArrayOperations &ops = operations();
+        return ops.read(arrayBuffer()->constData() + byteOffset + index * ops.bytesPerElement);
+    }
+    inline void setElement(uint index, double value) {
+        const TypedArrayOperations &ops = operations();
+        ops.write(arrayBuffer()->writableData() + byteOffset + index * ops.bytesPerElement, value);
+    }
+
+    Property *getIndex(uint index) const;
+
+    static ReturnedValue getIndexed(Managed *m, uint index, bool *hasProperty);
+    static void putIndexed(Managed *m, uint index, const ValueRef value);
+    static PropertyAttributes queryIndexed(const Managed *m, uint index);
+    static bool deleteIndexedProperty(Managed *m, uint index);
+
+protected:
+    static Property *advanceIterator(Managed *m, ObjectIterator *it, StringRef name, uint *index, PropertyAttributes *attrs);
+    static void markObjects(Managed *that, ExecutionEngine *e);
+};
+
+struct TypedArrayCtor: FunctionObject
+{
+    Q_MANAGED
+    TypedArrayCtor(ExecutionContext *scope, TypedArrayType t);
+
+    TypedArrayType arrayType;
+
+    static ReturnedValue construct(Managed *m, CallData *callData);
+    static ReturnedValue call(Managed *that, CallData *callData);
+};
+
+struct TypedArrayPrototype: Object
+{
+    TypedArrayPrototype(InternalClass *ic, TypedArrayType t): Object(ic), arrayType(t) {}
+    void init(ExecutionEngine *engine, ObjectRef ctor);
+
+    TypedArrayType arrayType;
+
+    static ReturnedValue method_get_buffer(CallContext *ctx);
+    static ReturnedValue method_get_byteLength(CallContext *ctx);
+    static ReturnedValue method_get_byteOffset(CallContext *ctx);
+    static ReturnedValue method_get_length(CallContext *ctx);
+
+    static ReturnedValue method_set(CallContext *ctx);
+    static ReturnedValue method_subarray(CallContext *ctx);
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif
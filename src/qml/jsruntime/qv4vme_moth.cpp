@@ -47,6 +47,8 @@
 #include <private/qv4scopedvalue_p.h>
 #include <private/qv4lookup_p.h>
 #include <iostream>
+#include <algorithm>
+#include <limits.h>
 
 #include "qv4alloca_p.h"
 
@@ -64,6 +66,7 @@ using namespace QQmlJS::Moth;
 #define MOTH_BEGIN_INSTR_COMMON(I) { \
     const InstrMeta<(int)Instr::I>::DataType &instr = InstrMeta<(int)Instr::I>::data(*genericInstr); \
     code += InstrMeta<(int)Instr::I>::Size; \
+    VMSTATS_INSTR(I); \
     if (debugger && (instr.breakPoint || debugger->pauseAtNextOpportunity())) \
         debugger->maybeBreakAtInstruction(code, instr.breakPoint); \
     Q_UNUSED(instr); \
@@ -100,6 +103,10 @@ using namespace QQmlJS::Moth;
 
 #ifdef WITH_STATS
 namespace {
+#define MOTH_COUNT_INSTR(I, FMT) + 1
+static const int instructionCount = 0 FOR_EACH_MOTH_INSTR(MOTH_COUNT_INSTR);
+#undef MOTH_COUNT_INSTR
+
 struct VMStats {
     quint64 paramIsValue;
     quint64 paramIsArg;
@@ -107,17 +114,35 @@ struct VMStats {
     quint64 paramIsTemp;
     quint64 paramIsScopedLocal;
 
+    // executed instructions, and how often each instruction was directly followed by another one.
+    // The pairs at the top of the histogram are the candidates for superinstructions.
+    quint64 instructions[instructionCount];
+    quint64 instructionPairs[instructionCount][instructionCount];
+    int previousInstruction;
+
     VMStats()
         : paramIsValue(0)
         , paramIsArg(0)
         , paramIsLocal(0)
         , paramIsTemp(0)
         , paramIsScopedLocal(0)
-    {}
+        , previousInstruction(-1)
+    {
+        memset(instructions, 0, sizeof(instructions));
+        memset(instructionPairs, 0, sizeof(instructionPairs));
+    }
 
     ~VMStats()
     { show(); }
 
+    void countInstruction(int instruction)
+    {
+        ++instructions[instruction];
+        if (previousInstruction >= 0)
+            ++instructionPairs[previousInstruction][instruction];
+        previousInstruction = instruction;
+    }
+
     void show() {
         fprintf(stderr, "VM stats:\n");
         fprintf(stderr, "         value: %lu\n", paramIsValue);
@@ -125,15 +150,77 @@ struct VMStats {
         fprintf(stderr, "         local: %lu\n", paramIsLocal);
         fprintf(stderr, "          temp: %lu\n", paramIsTemp);
         fprintf(stderr, "  scoped local: %lu\n", paramIsScopedLocal);
+
+#define MOTH_INSTR_NAME(I, FMT) #I,
+        static const char *names[] = {
+            FOR_EACH_MOTH_INSTR(MOTH_INSTR_NAME)
+        };
+#undef MOTH_INSTR_NAME
+
+        quint64 total = 0;
+        QVector<QPair<quint64, int> > pairs;
+        for (int i = 0; i < instructionCount; ++i) {
+            total += instructions[i];
+            for (int j = 0; j < instructionCount; ++j) {
+                if (instructionPairs[i][j])
+                    pairs.append(qMakePair(instructionPairs[i][j], i * instructionCount + j));
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        fprintf(stderr, "Instruction pairs (%llu instructions executed):\n", total);
+        for (int i = pairs.size() - 1, shown = 0; i >= 0 && shown < 40; --i, ++shown) {
+            const int first = pairs.at(i).second / instructionCount;
+            const int second = pairs.at(i).second % instructionCount;
+            fprintf(stderr, "  %12llu %5.2f%%  %s -> %s\n", pairs.at(i).first,
+                    total ? 100. * pairs.at(i).first / total : 0., names[first], names[second]);
+        }
     }
 };
 static VMStats vmStats;
 #define VMSTATS(what) ++vmStats.what
+#define VMSTATS_INSTR(I) vmStats.countInstruction(Instr::I)
 }
 #else // !WITH_STATS
 #define VMSTATS(what) {}
+#define VMSTATS_INSTR(I) {}
 #endif // WITH_STATS
 
+// Comparisons of two integers or two doubles don't need to go through the runtime, and
+// can't throw.
+template <typename T>
+static inline bool compareNumbers(quint8 op, T lhs, T rhs)
+{
+    switch (op) {
+    case CompareGt: return lhs > rhs;
+    case CompareLt: return lhs < rhs;
+    case CompareGe: return lhs >= rhs;
+    case CompareLe: return lhs <= rhs;
+    case CompareEqual:
+    case CompareStrictEqual: return lhs == rhs;
+    case CompareNotEqual:
+    case CompareStrictNotEqual: return lhs != rhs;
+    }
+    Q_UNREACHABLE();
+    return false;
+}
+
+static inline bool compareValues(quint8 op, const QV4::ValueRef lhs, const QV4::ValueRef rhs)
+{
+    switch (op) {
+    case CompareGt: return __qmljs_cmp_gt(lhs, rhs);
+    case CompareLt: return __qmljs_cmp_lt(lhs, rhs);
+    case CompareGe: return __qmljs_cmp_ge(lhs, rhs);
+    case CompareLe: return __qmljs_cmp_le(lhs, rhs);
+    case CompareEqual: return __qmljs_cmp_eq(lhs, rhs);
+    case CompareNotEqual: return __qmljs_cmp_ne(lhs, rhs);
+    case CompareStrictEqual: return __qmljs_cmp_se(lhs, rhs);
+    case CompareStrictNotEqual: return __qmljs_cmp_sne(lhs, rhs);
+    }
+    Q_UNREACHABLE();
+    return false;
+}
+
 #ifdef DO_TRACE_INSTR
 Param traceParam(const Param &param)
 {
@@ -300,6 +387,12 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
         STOREVALUE(instr.result, l->getter(l, VALUEPTR(instr.base)));
     MOTH_END_INSTR(GetLookup)
 
+    MOTH_BEGIN_INSTR(GetLookupMove)
+        QV4::Lookup *l = context->lookups + instr.index;
+        STOREVALUE(instr.result, l->getter(l, VALUEPTR(instr.base)));
+        VALUE(instr.moveResult) = VALUE(instr.result);
+    MOTH_END_INSTR(GetLookupMove)
+
     MOTH_BEGIN_INSTR(StoreProperty)
         __qmljs_set_property(context, VALUEPTR(instr.base), runtimeStrings[instr.name], VALUEPTR(instr.source));
         CHECK_EXCEPTION;
@@ -320,6 +413,15 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
         STOREVALUE(instr.result, __qmljs_get_qobject_property(context, VALUEPTR(instr.base), instr.propertyIndex, instr.captureRequired));
     MOTH_END_INSTR(LoadQObjectProperty)
 
+    MOTH_BEGIN_INSTR(LoadQObjectPropertyCJump)
+        STOREVALUE(instr.result, __qmljs_get_qobject_property(context, VALUEPTR(instr.base), instr.propertyIndex, instr.captureRequired));
+        uint cond = __qmljs_to_boolean(VALUEPTR(instr.result));
+        if (instr.invert)
+            cond = !cond;
+        if (cond)
+            code = ((uchar *)&instr.offset) + instr.offset;
+    MOTH_END_INSTR(LoadQObjectPropertyCJump)
+
     MOTH_BEGIN_INSTR(LoadAttachedQObjectProperty)
         STOREVALUE(instr.result, __qmljs_get_attached_property(context, instr.attachedPropertiesId, instr.propertyIndex));
     MOTH_END_INSTR(LoadAttachedQObjectProperty)
@@ -328,7 +430,6 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
         TRACE(inline, "stack size: %u", instr.value);
         stackSize = instr.value;
         stack = context->engine->stackPush(stackSize);
-        memset(stack, 0, stackSize * sizeof(QV4::SafeValue));
         scopes[1] = stack;
     MOTH_END_INSTR(Push)
 
@@ -553,6 +654,24 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
             code = ((uchar *)&instr.offset) + instr.offset;
     MOTH_END_INSTR(CJump)
 
+    MOTH_BEGIN_INSTR(CmpJump)
+        const QV4::SafeValue *lhs = VALUEPTR(instr.lhs);
+        const QV4::SafeValue *rhs = VALUEPTR(instr.rhs);
+        bool cond;
+        if (lhs->isInteger() && rhs->isInteger()) {
+            cond = compareNumbers(instr.op, lhs->integerValue(), rhs->integerValue());
+        } else if (QV4::Value::bothDouble(*lhs, *rhs)) {
+            cond = compareNumbers(instr.op, lhs->doubleValue(), rhs->doubleValue());
+        } else {
+            cond = compareValues(instr.op, VALUEPTR(instr.lhs), VALUEPTR(instr.rhs));
+            CHECK_EXCEPTION;
+        }
+        if (instr.invert)
+            cond = !cond;
+        if (cond)
+            code = ((uchar *)&instr.offset) + instr.offset;
+    MOTH_END_INSTR(CmpJump)
+
     MOTH_BEGIN_INSTR(UNot)
         STOREVALUE(instr.result, __qmljs_not(VALUEPTR(instr.source)));
     MOTH_END_INSTR(UNot)
@@ -579,19 +698,40 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
     MOTH_END_INSTR(UComplInt)
 
     MOTH_BEGIN_INSTR(Increment)
-        STOREVALUE(instr.result, __qmljs_increment(VALUEPTR(instr.source)));
+        const QV4::SafeValue *source = VALUEPTR(instr.source);
+        if (source->isInteger() && source->integerValue() < INT_MAX)
+            VALUE(instr.result) = QV4::Encode(source->integerValue() + 1);
+        else if (source->isDouble())
+            VALUEPTR(instr.result)->setDouble(source->doubleValue() + 1);
+        else
+            STOREVALUE(instr.result, __qmljs_increment(VALUEPTR(instr.source)));
     MOTH_END_INSTR(Increment)
 
     MOTH_BEGIN_INSTR(Decrement)
-        STOREVALUE(instr.result, __qmljs_decrement(VALUEPTR(instr.source)));
+        const QV4::SafeValue *source = VALUEPTR(instr.source);
+        if (source->isInteger() && source->integerValue() > INT_MIN)
+            VALUE(instr.result) = QV4::Encode(source->integerValue() - 1);
+        else if (source->isDouble())
+            VALUEPTR(instr.result)->setDouble(source->doubleValue() - 1);
+        else
+            STOREVALUE(instr.result, __qmljs_decrement(VALUEPTR(instr.source)));
     MOTH_END_INSTR(Decrement)
 
     MOTH_BEGIN_INSTR(Binop)
         STOREVALUE(instr.result, instr.alu(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Binop)
 
+    // Add, Sub and Mul handle int and double operands in place, only other types go through
+    // the runtime and need the exception check.
     MOTH_BEGIN_INSTR(Add)
-        STOREVALUE(instr.result, __qmljs_add(context, VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
+        const QV4::SafeValue *lhs = VALUEPTR(instr.lhs);
+        const QV4::SafeValue *rhs = VALUEPTR(instr.rhs);
+        if (lhs->isInteger() && rhs->isInteger())
+            VALUE(instr.result) = QV4::add_int32(lhs->integerValue(), rhs->integerValue()).asReturnedValue();
+        else if (QV4::Value::bothDouble(*lhs, *rhs))
+            VALUEPTR(instr.result)->setDouble(lhs->doubleValue() + rhs->doubleValue());
+        else
+            STOREVALUE(instr.result, __qmljs_add(context, VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Add)
 
     MOTH_BEGIN_INSTR(BitAnd)
@@ -622,11 +762,25 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code,
     MOTH_END_INSTR(BitXor)
 
     MOTH_BEGIN_INSTR(Mul)
-        STOREVALUE(instr.result, __qmljs_mul(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
+        const QV4::SafeValue *lhs = VALUEPTR(instr.lhs);
+        const QV4::SafeValue *rhs = VALUEPTR(instr.rhs);
+        if (lhs->isInteger() && rhs->isInteger())
+            VALUE(instr.result) = QV4::mul_int32(lhs->integerValue(), rhs->integerValue()).asReturnedValue();
+        else if (QV4::Value::bothDouble(*lhs, *rhs))
+            VALUEPTR(instr.result)->setDouble(lhs->doubleValue() * rhs->doubleValue());
+        else
+            STOREVALUE(instr.result, __qmljs_mul(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Mul)
 
     MOTH_BEGIN_INSTR(Sub)
-        STOREVALUE(instr.result, __qmljs_sub(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
+        const QV4::SafeValue *lhs = VALUEPTR(instr.lhs);
+        const QV4::SafeValue *rhs = VALUEPTR(instr.rhs);
+        if (lhs->isInteger() && rhs->isInteger())
+            VALUE(instr.result) = QV4::sub_int32(lhs->integerValue(), rhs->integerValue()).asReturnedValue();
+        else if (QV4::Value::bothDouble(*lhs, *rhs))
+            VALUEPTR(instr.result)->setDouble(lhs->doubleValue() - rhs->doubleValue());
+        else
+            STOREVALUE(instr.result, __qmljs_sub(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Sub)
 
     MOTH_BEGIN_INSTR(BinopContext)
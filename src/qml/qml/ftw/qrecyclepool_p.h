@@ -53,6 +53,9 @@
 // We mean it.
 //
 
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadstorage.h>
+
 QT_BEGIN_NAMESPACE
 
 #define QRECYCLEPOOLCOOKIE 0x33218ADF
@@ -63,24 +66,35 @@ class QRecyclePoolPrivate
 public:
     QRecyclePoolPrivate()
     : recyclePoolHold(true), outstandingItems(0), cookie(QRECYCLEPOOLCOOKIE),
-      currentPage(0), nextAllocated(0)
+      ownerThread(QThread::currentThreadId()), currentPage(0), availablePages(0), pageCount(0)
     {
     }
 
     bool recyclePoolHold;
     int outstandingItems;
     quint32 cookie;
+    // Pools are not thread safe.  Only the thread that created the pool may use it, until
+    // the pool is released by its owner.
+    Qt::HANDLE ownerThread;
 
+    struct Page;
     struct PoolType : public T {
         union {
-            QRecyclePoolPrivate<T, Step> *pool;
+            Page *page;
             PoolType *nextAllocated;
         };
     };
 
+    // Items returned to a page go on the page's own free list, so that a page can be
+    // released as soon as none of its items are in use.  Pages other than the current
+    // one that have free items are kept in the availablePages list.
     struct Page {
-        Page *nextPage;
-        unsigned int free;
+        QRecyclePoolPrivate<T, Step> *pool;
+        Page *nextAvailable;
+        Page **prevAvailable;
+        PoolType *nextAllocated;
+        unsigned int free;          // Items never handed out
+        unsigned int outstanding;   // Items in use
         union {
             char array[Step * sizeof(PoolType)];
             qint64 q_for_alignment_1;
@@ -89,11 +103,14 @@ public:
     };
 
     Page *currentPage;
-    PoolType *nextAllocated;
+    Page *availablePages;
+    int pageCount;
 
     inline T *allocate();
     static inline void dispose(T *);
     inline void releaseIfPossible();
+    inline void makeAvailable(Page *);
+    static inline void makeUnavailable(Page *);
 };
 
 template<typename T, int Step = 1024>
@@ -111,6 +128,12 @@ public:
 
     static inline void Delete(T *);
 
+    // Uninitialized memory for a T, for use in class specific operator new/delete
+    inline void *Allocate();
+    static inline void Deallocate(void *);
+
+    inline int pageCount() const;
+
 private:
     QRecyclePoolPrivate<T, Step> *d;
 };
@@ -161,43 +184,90 @@ void QRecyclePool<T, Step>::Delete(T *t)
     QRecyclePoolPrivate<T, Step>::dispose(t);
 }
 
+template<typename T, int Step>
+void *QRecyclePool<T, Step>::Allocate()
+{
+    return d->allocate();
+}
+
+template<typename T, int Step>
+void QRecyclePool<T, Step>::Deallocate(void *t)
+{
+    QRecyclePoolPrivate<T, Step>::dispose(static_cast<T *>(t));
+}
+
+template<typename T, int Step>
+int QRecyclePool<T, Step>::pageCount() const
+{
+    return d->pageCount;
+}
+
 template<typename T, int Step>
 void QRecyclePoolPrivate<T, Step>::releaseIfPossible()
 {
     if (recyclePoolHold || outstandingItems)
         return;
 
-    Page *p = currentPage;
-    while (p) {
-        Page *n = p->nextPage;
-        free(p);
-        p = n;
-    }
+    // Pages other than the current one are released when their last item is returned
+    Q_ASSERT(!availablePages);
+    free(currentPage);
 
     delete this;
 }
 
+template<typename T, int Step>
+void QRecyclePoolPrivate<T, Step>::makeAvailable(Page *p)
+{
+    p->nextAvailable = availablePages;
+    if (p->nextAvailable) p->nextAvailable->prevAvailable = &p->nextAvailable;
+    p->prevAvailable = &availablePages;
+    availablePages = p;
+}
+
+template<typename T, int Step>
+void QRecyclePoolPrivate<T, Step>::makeUnavailable(Page *p)
+{
+    if (p->nextAvailable) p->nextAvailable->prevAvailable = p->prevAvailable;
+    *p->prevAvailable = p->nextAvailable;
+    p->nextAvailable = 0;
+    p->prevAvailable = 0;
+}
+
 template<typename T, int Step>
 T *QRecyclePoolPrivate<T, Step>::allocate()
 {
-    PoolType *rv = 0;
-    if (nextAllocated) {
-        rv = nextAllocated;
-        nextAllocated = rv->nextAllocated;
-    } else if (currentPage && currentPage->free) {
-        rv = (PoolType *)(currentPage->array + (Step - currentPage->free) * sizeof(PoolType));
-        currentPage->free--;
-    } else {
-        Page *p = (Page *)malloc(sizeof(Page));
-        p->nextPage = currentPage;
-        p->free = Step;
+    Q_ASSERT(ownerThread == QThread::currentThreadId());
+
+    Page *p = currentPage;
+    if (!p || (!p->nextAllocated && !p->free)) {
+        // The current page is full, it becomes available again once an item is returned
+        if (availablePages) {
+            p = availablePages;
+            makeUnavailable(p);
+        } else {
+            p = (Page *)malloc(sizeof(Page));
+            p->pool = this;
+            p->nextAvailable = 0;
+            p->prevAvailable = 0;
+            p->nextAllocated = 0;
+            p->free = Step;
+            p->outstanding = 0;
+            ++pageCount;
+        }
         currentPage = p;
+    }
 
-        rv = (PoolType *)currentPage->array;
-        currentPage->free--;
+    PoolType *rv = 0;
+    if (p->nextAllocated) {
+        rv = p->nextAllocated;
+        p->nextAllocated = rv->nextAllocated;
+    } else {
+        rv = (PoolType *)(p->array + (Step - p->free) * sizeof(PoolType));
+        p->free--;
     }
 
-    rv->pool = this;
+    rv->page = p;
+    ++p->outstanding;
     ++outstandingItems;
     return rv;
 }
@@ -206,15 +276,52 @@ template<typename T, int Step>
 void QRecyclePoolPrivate<T, Step>::dispose(T *t)
 {
     PoolType *pt = static_cast<PoolType *>(t);
-    Q_ASSERT(pt->pool && pt->pool->cookie == QRECYCLEPOOLCOOKIE);
+    Q_ASSERT(pt->page && pt->page->pool->cookie == QRECYCLEPOOLCOOKIE);
 
-    QRecyclePoolPrivate<T, Step> *This = pt->pool;
-    pt->nextAllocated = This->nextAllocated;
-    This->nextAllocated = pt;
+    Page *p = pt->page;
+    QRecyclePoolPrivate<T, Step> *This = p->pool;
+    Q_ASSERT(!This->recyclePoolHold || This->ownerThread == QThread::currentThreadId());
+
+    pt->nextAllocated = p->nextAllocated;
+    p->nextAllocated = pt;
+    --p->outstanding;
     --This->outstandingItems;
+
+    if (p != This->currentPage) {
+        if (!p->outstanding) {
+            if (p->prevAvailable)
+                makeUnavailable(p);
+            free(p);
+            --This->pageCount;
+        } else if (!p->prevAvailable) {
+            This->makeAvailable(p);
+        }
+    }
+
     This->releaseIfPossible();
 }
 
+/*
+    Returns memory for a T from the recycle pool of the calling thread, creating the
+    pool on first use.  The memory must be returned with QRecyclePool::Deallocate() from
+    the same thread, or from any one thread after the allocating thread has exited.  A
+    pool outlives its thread as long as items are outstanding.
+*/
+template<typename T, int Step>
+inline void *qAllocateFromThreadRecyclePool(QThreadStorage<QRecyclePool<T, Step> *> *pools)
+{
+    if (!pools) {
+        // The storage was already destroyed, so hand out an item from a pool that is
+        // released together with it.
+        QRecyclePool<T, Step> pool;
+        return pool.Allocate();
+    }
+
+    if (!pools->hasLocalData())
+        pools->setLocalData(new QRecyclePool<T, Step>);
+    return pools->localData()->Allocate();
+}
+
 QT_END_NAMESPACE
 
 #endif // QRECYCLEPOOL_P_H
@@ -44,15 +44,18 @@
 #include <QtQml/qqmlinfo.h>
 #include <private/qqmlbinding_p.h>
 #include <private/qqmlvaluetypeproxybinding_p.h>
+#include <private/qqmlnativebinding_p.h>
 
 QT_BEGIN_NAMESPACE
 
 extern QQmlAbstractBinding::VTable QQmlBinding_vtable;
 extern QQmlAbstractBinding::VTable QQmlValueTypeProxyBinding_vtable;
+extern QQmlAbstractBinding::VTable QQmlNativeBinding_vtable;
 
 QQmlAbstractBinding::VTable *QQmlAbstractBinding::vTables[] = {
     &QQmlBinding_vtable,
-    &QQmlValueTypeProxyBinding_vtable
+    &QQmlValueTypeProxyBinding_vtable,
+    &QQmlNativeBinding_vtable
 };
 
 QQmlAbstractBinding::QQmlAbstractBinding(BindingType bt)
@@ -93,7 +93,7 @@ public:
 
     typedef QWeakPointer<QQmlAbstractBinding> Pointer;
 
-    enum BindingType { Binding = 0, ValueTypeProxy = 1 };
+    enum BindingType { Binding = 0, ValueTypeProxy = 1, Native = 2 };
     inline BindingType bindingType() const;
 
     // Destroy the binding.  Use this instead of calling delete.
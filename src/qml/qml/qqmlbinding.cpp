@@ -52,6 +52,7 @@
 #include <private/qqmlscriptstring_p.h>
 #include <private/qqmlcontextwrapper_p.h>
 #include <private/qsystrace_p.h>
+#include <private/qrecyclepool_p.h>
 
 #include <QVariant>
 #include <QtCore/qdebug.h>
@@ -71,6 +72,26 @@ QQmlAbstractBinding::VTable QQmlBinding_vtable = {
 
 QQmlBinding::Identifier QQmlBinding::Invalid = -1;
 
+// Component instances create and destroy their bindings in bulk, so they are taken from
+// a per-thread pool rather than the general purpose heap.
+typedef QRecyclePool<QQmlBinding, 256> QQmlBindingPool;
+Q_GLOBAL_STATIC(QThreadStorage<QQmlBindingPool *>, bindingPools)
+
+void *QQmlBinding::operator new(size_t size)
+{
+    if (size != sizeof(QQmlBinding))
+        return ::operator new(size);
+    return qAllocateFromThreadRecyclePool(bindingPools());
+}
+
+void QQmlBinding::operator delete(void *ptr, size_t size)
+{
+    if (size != sizeof(QQmlBinding))
+        ::operator delete(ptr);
+    else
+        QQmlBindingPool::Deallocate(ptr);
+}
+
 QQmlBinding *
 QQmlBinding::createBinding(Identifier id, QObject *obj, QQmlContext *ctxt,
                                    const QString &url, quint16 lineNumber)
@@ -110,7 +131,7 @@ static QQmlJavaScriptExpression::VTable QQmlBinding_jsvtable = {
 
 QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContext *ctxt)
 : QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
-  m_lineNumber(0), m_columnNumber(0)
+  m_lineNumber(0), m_columnNumber(0), m_queueLevel(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(QQmlContextData::get(ctxt));
@@ -121,7 +142,8 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContext *ctxt)
 }
 
 QQmlBinding::QQmlBinding(const QQmlScriptString &script, QObject *obj, QQmlContext *ctxt)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_queueLevel(0)
 {
     if (ctxt && !ctxt->isValid())
         return;
@@ -162,7 +184,7 @@ QQmlBinding::QQmlBinding(const QQmlScriptString &script, QObject *obj, QQmlConte
 
 QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContextData *ctxt)
 : QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
-  m_lineNumber(0), m_columnNumber(0)
+  m_lineNumber(0), m_columnNumber(0), m_queueLevel(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(ctxt);
@@ -176,7 +198,7 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj,
                          QQmlContextData *ctxt,
                          const QString &url, quint16 lineNumber, quint16 columnNumber)
 : QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
-  m_url(url), m_lineNumber(lineNumber), m_columnNumber(columnNumber)
+  m_url(url), m_lineNumber(lineNumber), m_columnNumber(columnNumber), m_queueLevel(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(ctxt);
@@ -190,7 +212,7 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj,
 QQmlBinding::QQmlBinding(const QV4::ValueRef functionPtr, QObject *obj, QQmlContextData *ctxt,
                          const QString &url, quint16 lineNumber, quint16 columnNumber)
 : QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
-  m_url(url), m_lineNumber(lineNumber), m_columnNumber(columnNumber)
+  m_url(url), m_lineNumber(lineNumber), m_columnNumber(columnNumber), m_queueLevel(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(ctxt);
@@ -210,6 +232,9 @@ void QQmlBinding::setNotifyOnValueChanged(bool v)
 
 void QQmlBinding::update(QQmlPropertyPrivate::WriteFlags flags)
 {
+    // An explicit update supersedes a batched one
+    m_queueNode.remove();
+
     if (!enabledFlag() || !context() || !context()->isValid())
         return;
 
@@ -310,6 +335,14 @@ QString QQmlBinding::expressionIdentifier(QQmlJavaScriptExpression *e)
 void QQmlBinding::expressionChanged(QQmlJavaScriptExpression *e)
 {
     QQmlBinding *This = static_cast<QQmlBinding *>(e);
+    QQmlContextData *context = This->context();
+    if (context && context->engine) {
+        QQmlEnginePrivate *ep = QQmlEnginePrivate::get(context->engine);
+        if (ep->bindingQueue.isEnabled()) {
+            ep->bindingQueue.enqueue(This);
+            return;
+        }
+    }
     This->update();
 }
 
@@ -67,6 +67,7 @@
 #include <private/qqmlabstractbinding_p.h>
 #include <private/qqmlabstractexpression_p.h>
 #include <private/qqmljavascriptexpression_p.h>
+#include <private/qintrusivelist_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -120,8 +121,12 @@ public:
     static QString expressionIdentifier(QQmlJavaScriptExpression *);
     static void expressionChanged(QQmlJavaScriptExpression *);
 
+    static void *operator new(size_t);
+    static void operator delete(void *, size_t);
+
 protected:
     friend class QQmlAbstractBinding;
+    friend class QQmlBindingQueue;
     ~QQmlBinding();
 
 private:
@@ -149,6 +154,10 @@ private:
     quint16 m_lineNumber;
     quint16 m_columnNumber;
     QByteArray m_expression;
+
+    // Used by QQmlBindingQueue when bindings are evaluated in batches
+    QIntrusiveListNode m_queueNode;
+    quint16 m_queueLevel;
 };
 
 bool QQmlBinding::updatingFlag() const
@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qqmlbindingqueue_p.h"
+
+#include <private/qqmlbinding_p.h>
+#include <private/qintrusivelist_p.h>
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qthreadstorage.h>
+
+QT_BEGIN_NAMESPACE
+
+// A binding that is pushed deeper than this is considered to be part of a
+// binding loop.  Real dependency chains are much shorter.
+static const int MaximumLevel = 1024;
+
+struct QQmlBindingQueue::Level
+{
+    QIntrusiveList<QQmlBinding, &QQmlBinding::m_queueNode> bindings;
+};
+
+// Queues of the current thread that have bindings waiting for a flush
+static QThreadStorage<QVector<QQmlBindingQueue *> > pendingQueues;
+
+QQmlBindingQueue::QQmlBindingQueue(QQmlEngine *engine)
+: m_engine(engine), m_currentLevel(0), m_enabled(false),
+  m_flushing(false), m_flushPosted(false), m_pending(false)
+{
+}
+
+QQmlBindingQueue::~QQmlBindingQueue()
+{
+    setPending(false);
+    qDeleteAll(m_levels);
+}
+
+/*!
+    Enables or disables batched binding evaluation.  Bindings that are still
+    queued when the queue is disabled are evaluated immediately.
+*/
+void QQmlBindingQueue::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    if (!enabled)
+        flush();
+    m_enabled = enabled;
+}
+
+bool QQmlBindingQueue::isEmpty() const
+{
+    for (int ii = 0; ii < m_levels.count(); ++ii) {
+        if (!m_levels.at(ii)->bindings.isEmpty())
+            return false;
+    }
+    return true;
+}
+
+/*!
+    Marks \a binding dirty.  The binding is evaluated by the next flush(),
+    regardless of how many of its dependencies change until then.
+*/
+void QQmlBindingQueue::enqueue(QQmlBinding *binding)
+{
+    ++m_statistics.notifications;
+
+    if (binding->updatingFlag()) {
+        // The binding changed one of its own dependencies
+        QQmlProperty p = binding->property();
+        QQmlAbstractBinding::printBindingLoopError(p);
+        return;
+    }
+
+    // A binding dirtied by the binding that is being evaluated has to be
+    // evaluated after it
+    int level = m_flushing ? m_currentLevel + 1 : 0;
+
+    if (binding->m_queueNode.isInList()) {
+        ++m_statistics.avoidedEvaluations;
+        if (level <= binding->m_queueLevel)
+            return;
+    } else if (level < binding->m_queueLevel) {
+        level = binding->m_queueLevel;
+    }
+
+    if (level > MaximumLevel) {
+        binding->m_queueNode.remove();
+        binding->m_queueLevel = 0;
+        QQmlProperty p = binding->property();
+        QQmlAbstractBinding::printBindingLoopError(p);
+        return;
+    }
+
+    binding->m_queueLevel = level;
+    while (m_levels.count() <= level)
+        m_levels.append(new Level);
+    m_levels.at(level)->bindings.insert(binding);
+    if (uint(level) > m_statistics.maxLevel)
+        m_statistics.maxLevel = level;
+
+    setPending(true);
+    if (!m_flushPosted && !m_flushing) {
+        m_flushPosted = true;
+        QCoreApplication::postEvent(m_engine, new QEvent(QEvent::Type(flushEventType())));
+    }
+}
+
+/*!
+    Evaluates all queued bindings, level by level.  Bindings that are dirtied
+    while flushing are evaluated by the same flush.
+*/
+void QQmlBindingQueue::flush()
+{
+    if (m_flushing)
+        return;
+
+    m_flushing = true;
+    ++m_statistics.flushes;
+
+    for (int ii = 0; ii < m_levels.count(); ++ii) {
+        Level *level = m_levels.at(ii);
+        while (QQmlBinding *binding = level->bindings.first()) {
+            level->bindings.remove(binding);
+            m_currentLevel = ii;
+            ++m_statistics.evaluations;
+            binding->update();
+        }
+    }
+
+    m_currentLevel = 0;
+    m_flushing = false;
+    setPending(false);
+}
+
+/*!
+    Handles the flush event posted by enqueue().  Returns true if \a e was
+    the flush event.
+*/
+bool QQmlBindingQueue::processEvent(QEvent *e)
+{
+    if (e->type() != flushEventType())
+        return false;
+    m_flushPosted = false;
+    flush();
+    return true;
+}
+
+/*!
+    Flushes the binding queues of all engines in the current thread.  This is
+    called before items are polished, so that layouting sees the final
+    values of all bindings.
+*/
+void QQmlBindingQueue::flushAll()
+{
+    if (!pendingQueues.hasLocalData())
+        return;
+
+    const QVector<QQmlBindingQueue *> queues = pendingQueues.localData();
+    for (int ii = 0; ii < queues.count(); ++ii)
+        queues.at(ii)->flush();
+}
+
+int QQmlBindingQueue::flushEventType()
+{
+    static int type = QEvent::registerEventType();
+    return type;
+}
+
+void QQmlBindingQueue::setPending(bool pending)
+{
+    if (m_pending == pending)
+        return;
+    m_pending = pending;
+
+    QVector<QQmlBindingQueue *> &queues = pendingQueues.localData();
+    if (pending)
+        queues.append(this);
+    else
+        queues.remove(queues.indexOf(this));
+}
+
+QT_END_NAMESPACE
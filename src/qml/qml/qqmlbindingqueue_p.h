@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QQMLBINDINGQUEUE_P_H
+#define QQMLBINDINGQUEUE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <private/qtqmlglobal_p.h>
+
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+class QQmlEngine;
+class QQmlBinding;
+class QEvent;
+
+// Batched binding re-evaluation.
+//
+// When enabled, a change notification does not re-evaluate the dependent
+// binding synchronously.  The binding is marked dirty and put into the queue
+// instead, so that a binding that depends on several properties which change
+// together is evaluated only once.  The queue is flushed from the event loop
+// and before QQuickWindow polishes its items.
+//
+// Bindings are flushed by level.  A binding that is marked dirty by the write
+// of another binding during a flush is moved to a level below the writer.  The
+// level is kept in the binding, so after the first flush the queue evaluates a
+// dependency graph in topological order.  A binding that keeps being pushed to
+// deeper levels is part of a cycle and reported as a binding loop.
+class Q_QML_PRIVATE_EXPORT QQmlBindingQueue
+{
+public:
+    struct Statistics
+    {
+        Statistics()
+            : notifications(0)
+            , evaluations(0)
+            , avoidedEvaluations(0)
+            , flushes(0)
+            , maxLevel(0)
+        {}
+
+        // change notifications received for queued bindings
+        quint64 notifications;
+        // bindings evaluated by flush()
+        quint64 evaluations;
+        // notifications for bindings that were already queued
+        quint64 avoidedEvaluations;
+        uint flushes;
+        // deepest level of the learned evaluation order
+        uint maxLevel;
+    };
+
+    QQmlBindingQueue(QQmlEngine *engine);
+    ~QQmlBindingQueue();
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    bool isEmpty() const;
+    void enqueue(QQmlBinding *binding);
+    void flush();
+    bool processEvent(QEvent *e);
+
+    static void flushAll();
+    static int flushEventType();
+
+    const Statistics &statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics = Statistics(); }
+
+private:
+    Q_DISABLE_COPY(QQmlBindingQueue)
+
+    struct Level;
+
+    void setPending(bool pending);
+
+    QQmlEngine *m_engine;
+    QVector<Level *> m_levels;
+    // level of the binding that is being evaluated by flush()
+    int m_currentLevel;
+
+    bool m_enabled:1;
+    bool m_flushing:1;
+    bool m_flushPosted:1;
+    bool m_pending:1;
+
+    Statistics m_statistics;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLBINDINGQUEUE_P_H
@@ -53,6 +53,7 @@
 #include <private/qqmlprofilerservice_p.h>
 #include <private/qv4debugservice_p.h>
 #include <private/qsystrace_p.h>
+#include <private/qrecyclepool_p.h>
 #include "qqmlinfo.h"
 
 #include <private/qv4value_p.h>
@@ -301,6 +302,26 @@ QQmlBoundSignal::~QQmlBoundSignal()
     m_expression = 0;
 }
 
+// Like bindings, signal handlers are created and destroyed together with the
+// component instance they belong to.
+typedef QRecyclePool<QQmlBoundSignal, 256> QQmlBoundSignalPool;
+Q_GLOBAL_STATIC(QThreadStorage<QQmlBoundSignalPool *>, boundSignalPools)
+
+void *QQmlBoundSignal::operator new(size_t size)
+{
+    if (size != sizeof(QQmlBoundSignal))
+        return ::operator new(size);
+    return qAllocateFromThreadRecyclePool(boundSignalPools());
+}
+
+void QQmlBoundSignal::operator delete(void *ptr, size_t size)
+{
+    if (size != sizeof(QQmlBoundSignal))
+        ::operator delete(ptr);
+    else
+        QQmlBoundSignalPool::Deallocate(ptr);
+}
+
 /*!
     Returns the signal index in the range returned by QObjectPrivate::signalIndex().
     This is different from QMetaMethod::methodIndex().
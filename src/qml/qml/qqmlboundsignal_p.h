@@ -158,6 +158,9 @@ public:
 
     bool isEvaluating() const { return m_isEvaluating; }
 
+    static void *operator new(size_t);
+    static void operator delete(void *, size_t);
+
 private:
     friend void QQmlBoundSignal_callback(QQmlNotifierEndpoint *, void **);
 
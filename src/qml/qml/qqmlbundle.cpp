@@ -46,6 +46,17 @@
 static const unsigned char qmlBundleHeaderData[] = { 255, 'q', 'm', 'l', 'd', 'i', 'r', 255 };
 static const unsigned int qmlBundleHeaderLength = 8;
 
+// Version 1 bundles are a plain sequence of entries.  Version 2 bundles start with a
+// Header entry, and end with an Index entry that is rewritten whenever files are added
+// or removed.  File entries are unchanged, so version 1 readers still find them.
+static const quint32 qmlBundleVersion = 2;
+static const quint32 qmlBundleAlignment = 8;
+
+static inline quint32 alignedSize(quint32 size)
+{
+    return (size + qmlBundleAlignment - 1) & ~(qmlBundleAlignment - 1);
+}
+
 //
 // Entries
 //
@@ -77,8 +88,12 @@ QQmlBundle::QQmlBundle(const QString &fileName)
 : file(fileName),
   buffer(0),
   bufferSize(0),
+  formatVersion(qmlBundleVersion),
   opened(false),
-  headerWritten(false)
+  headerWritten(false),
+  indexed(false),
+  indexOutdated(false),
+  storedIndex(0)
 {
 }
 
@@ -100,6 +115,10 @@ bool QQmlBundle::open(QIODevice::OpenMode mode)
             (bufferSize >= 8 && 0 == ::memcmp(buffer, qmlBundleHeaderData, qmlBundleHeaderLength))) {
             opened = true;
             headerWritten = false;
+            if (!readHeader() || (!(mode & QIODevice::WriteOnly) && !buildIndex())) {
+                close();
+                return false;
+            }
             return true;
         } else {
             close();
@@ -112,13 +131,25 @@ bool QQmlBundle::open(QIODevice::OpenMode mode)
 void QQmlBundle::close()
 {
     if (opened) {
+        if (indexOutdated)
+            writeIndex();
         opened = false;
         headerWritten = false;
+        indexed = false;
+        indexOutdated = false;
+        storedIndex = 0;
+        index.clear();
+        addedFiles.clear();
         file.unmap(buffer);
         file.close();
     }
 }
 
+int QQmlBundle::version() const
+{
+    return formatVersion;
+}
+
 QList<const QQmlBundle::FileEntry *> QQmlBundle::files() const
 {
     QList<const FileEntry *> files;
@@ -135,7 +166,9 @@ QList<const QQmlBundle::FileEntry *> QQmlBundle::files() const
         }   break;
 
         case Entry::Link:
-        case Entry::Skip: {
+        case Entry::Skip:
+        case Entry::Header:
+        case Entry::Index: {
             // Skip
         }   break;
 
@@ -155,6 +188,7 @@ void QQmlBundle::remove(const FileEntry *entry)
     Q_ASSERT(entry->kind == Entry::File); // ### throw an error
     Q_ASSERT(file.isWritable());
     const_cast<FileEntry *>(entry)->kind = Entry::Skip;
+    indexOutdated = formatVersion >= 2;
 }
 
 int QQmlBundle::bundleHeaderLength()
@@ -193,8 +227,126 @@ const QQmlBundle::Entry *QQmlBundle::findInsertPoint(quint32 size, qint32 *offse
     return 0;
 }
 
+//
+// returns the entry of the given kind at offset, or 0 if there is no valid one.
+// Offsets are read from the bundle, so they can't be trusted.
+//
+const QQmlBundle::FileEntry *QQmlBundle::entryAt(quint32 offset, int kind) const
+{
+    if (offset < qmlBundleHeaderLength || offset >= bufferSize ||
+        bufferSize - offset < sizeof(FileEntry))
+        return 0;
+
+    const FileEntry *entry = (const FileEntry *)(buffer + offset);
+    if (entry->kind != kind || entry->size < sizeof(FileEntry) || entry->size > bufferSize - offset ||
+        entry->fileNameLength < 0 || quint32(entry->fileNameLength) > entry->size - sizeof(FileEntry))
+        return 0;
+    return entry;
+}
+
+//
+// reads the format version, and the stored index of read-only version 2 bundles.
+//
+bool QQmlBundle::readHeader()
+{
+    if (bufferSize == 0) {
+        formatVersion = qmlBundleVersion;
+        return true;
+    }
+
+    const HeaderEntry *header = (const HeaderEntry *)(buffer + qmlBundleHeaderLength);
+    if (bufferSize - qmlBundleHeaderLength < sizeof(HeaderEntry) ||
+        header->kind != Entry::Header || header->size != sizeof(HeaderEntry)) {
+        formatVersion = 1;
+        return true;
+    }
+
+    formatVersion = header->version;
+    if (formatVersion < 2 || formatVersion > qmlBundleVersion)
+        return false;
+
+    if (file.isWritable() || !header->indexOffset)
+        return true;
+
+    const quint32 offset = header->indexOffset;
+    if (offset % qmlBundleAlignment || offset >= bufferSize ||
+        bufferSize - offset < sizeof(IndexEntry))
+        return false;
+
+    const IndexEntry *indexEntry = (const IndexEntry *)(buffer + offset);
+    if (indexEntry->kind != Entry::Index || indexEntry->size < sizeof(IndexEntry) ||
+        indexEntry->size > bufferSize - offset ||
+        indexEntry->count > (indexEntry->size - sizeof(IndexEntry)) / sizeof(quint32))
+        return false;
+
+    storedIndex = indexEntry;
+    indexed = true;
+    return true;
+}
+
+//
+// index the file entries of a read-only bundle, so lookups don't need to walk
+// (and page in) the whole mapping.
+//
+bool QQmlBundle::buildIndex()
+{
+    if (indexed)
+        return true; // the bundle stores its index
+
+    const char *ptr = (const char *) buffer + qmlBundleHeaderLength;
+    const char *end = (const char *) buffer + bufferSize;
+
+    while (ptr < end) {
+        const Entry *cmd = (const Entry *) ptr;
+
+        if (end - ptr < (int)sizeof(Entry) || cmd->size < sizeof(Entry) ||
+            cmd->size > quint32(end - ptr))
+            return false;
+
+        if (cmd->kind == Entry::File) {
+            const FileEntry *fileEntry = static_cast<const FileEntry *>(cmd);
+            if (fileEntry->fileNameLength < 0 ||
+                sizeof(FileEntry) + quint32(fileEntry->fileNameLength) > cmd->size)
+                return false;
+
+            // The first entry wins, as it does for the linear search
+            QString fileName = fileEntry->fileName();
+            if (!index.contains(fileName))
+                index.insert(fileName, fileEntry);
+        }
+
+        ptr += cmd->size;
+    }
+
+    indexed = true;
+    return true;
+}
+
 const QQmlBundle::FileEntry *QQmlBundle::find(const QString &fileName) const
 {
+    if (storedIndex) {
+        // Binary search, only the entries on the way are paged in
+        int low = 0;
+        int high = int(storedIndex->count) - 1;
+        while (low <= high) {
+            const int mid = (low + high) / 2;
+            const FileEntry *fileEntry = entryAt(storedIndex->offsets[mid], Entry::File);
+            if (!fileEntry)
+                return 0; // corrupt index
+            const int cmp = QString::compare(fileName, fileEntry->fileName());
+            if (cmp == 0)
+                return fileEntry;
+            else if (cmp < 0)
+                high = mid - 1;
+            else
+                low = mid + 1;
+        }
+        return 0;
+    }
+
+    if (indexed)
+        return index.value(fileName);
+
     const char *ptr = (const char *) buffer + qmlBundleHeaderLength;
     const char *end = (const char *) buffer + bufferSize;
 
@@ -217,17 +369,23 @@ const QQmlBundle::FileEntry *QQmlBundle::find(const QString &fileName) const
 
 const QQmlBundle::FileEntry *QQmlBundle::link(const FileEntry *entry, const QString &linkName) const
 {
-    const char *ptr = (const char *) buffer + entry->link;
-
-    while (ptr != (const char *)buffer) {
-        const Entry *cmd = (const Entry *) ptr;
-        Q_ASSERT(cmd->kind == Entry::Link);
-
-        const FileEntry *fileEntry = static_cast<const FileEntry *>(cmd);
-        if (fileEntry->fileName() == linkName)
+    // Each link is added after the previous one, so the chain must go backwards
+    // through the bundle.  Anything else is a corrupt bundle, and could loop.
+    quint32 offset = entry->link;
+    quint32 limit = bufferSize;
+
+    while (offset) {
+        if (offset >= limit)
+            return 0;
+
+        const FileEntry *fileEntry = entryAt(offset, Entry::Link);
+        if (!fileEntry)
+            return 0;
+        if (fileEntry->isFileName(linkName))
             return fileEntry;
 
-        ptr = (const char *) buffer + fileEntry->link;
+        limit = offset;
+        offset = fileEntry->link;
     }
 
     return 0;
@@ -238,6 +396,108 @@ const QQmlBundle::FileEntry *QQmlBundle::find(const QChar *fileName, int length)
     return find(QString::fromRawData(fileName, length));
 }
 
+void QQmlBundle::writeHeader()
+{
+    if (bufferSize != 0 || headerWritten)
+        return;
+
+    file.write((const char *)qmlBundleHeaderData, qmlBundleHeaderLength);
+    if (formatVersion >= 2) {
+        HeaderEntry header;
+        header.kind = Entry::Header;
+        header.size = sizeof(HeaderEntry);
+        header.version = formatVersion;
+        header.indexOffset = 0;
+        file.write((const char *) &header, sizeof(HeaderEntry));
+    }
+    headerWritten = true;
+}
+
+//
+// appends an entry with the given name and data, and returns its offset.
+//
+quint32 QQmlBundle::writeEntry(int kind, quint32 link, const QString &name, const char *data, quint32 size)
+{
+    writeHeader();
+    if (!file.atEnd())
+        file.seek(file.size());
+    const quint32 offset = file.size();
+
+    const quint32 nameLength = name.length() * sizeof(QChar);
+
+    FileEntry cmd;
+    cmd.kind = kind;
+    cmd.link = link;
+    cmd.size = sizeof(FileEntry) + nameLength + size;
+    cmd.fileNameLength = nameLength;
+
+    file.write((const char *) &cmd, sizeof(FileEntry));
+    file.write((const char *) name.constData(), nameLength);
+    file.write(data, size);
+    return offset;
+}
+
+//
+// appends a new index of the file entries, and points the header to it.  The index is
+// read in place, so it is aligned by a Skip entry in front of it.
+//
+void QQmlBundle::writeIndex()
+{
+    Q_ASSERT(formatVersion >= 2);
+
+    QList<QPair<QString, quint32> > entries;
+    const char *ptr = (const char *) buffer + qmlBundleHeaderLength;
+    const char *end = (const char *) buffer + bufferSize;
+    while (ptr < end) {
+        Entry *cmd = (Entry *) ptr;
+        if (cmd->size < sizeof(Entry))
+            break; // throw an error
+        if (cmd->kind == Entry::File)
+            entries.append(qMakePair(static_cast<FileEntry *>(cmd)->fileName(), quint32(ptr - (const char *) buffer)));
+        else if (cmd->kind == Entry::Index)
+            cmd->kind = Entry::Skip; // replaced below
+        ptr += cmd->size;
+    }
+    entries += addedFiles;
+    // The first entry wins, as it does for the linear search
+    qStableSort(entries);
+    QByteArray offsets;
+    for (int ii = 0; ii < entries.count(); ++ii) {
+        if (ii && entries.at(ii).first == entries.at(ii - 1).first)
+            continue;
+        offsets.append((const char *) &entries.at(ii).second, sizeof(quint32));
+    }
+
+    writeHeader();
+    if (!file.atEnd())
+        file.seek(file.size());
+    if (const quint32 padding = alignedSize(file.size()) - file.size()) {
+        Entry skip;
+        skip.kind = Entry::Skip;
+        skip.size = sizeof(Entry) + padding;
+        file.write((const char *) &skip, sizeof(Entry));
+        file.write(QByteArray(skip.size - sizeof(Entry), '\0'));
+    }
+    const quint32 offset = file.size();
+
+    IndexEntry cmd;
+    cmd.kind = Entry::Index;
+    cmd.size = alignedSize(sizeof(IndexEntry) + offsets.size());
+    cmd.count = offsets.size() / sizeof(quint32);
+    file.write((const char *) &cmd, sizeof(IndexEntry));
+    file.write(offsets);
+    file.write(QByteArray(cmd.size - sizeof(IndexEntry) - offsets.size(), '\0'));
+
+    HeaderEntry header;
+    header.kind = Entry::Header;
+    header.size = sizeof(HeaderEntry);
+    header.version = formatVersion;
+    header.indexOffset = offset;
+    file.seek(qmlBundleHeaderLength);
+    file.write((const char *) &header, sizeof(HeaderEntry));
+    file.seek(file.size());
+}
+
 bool QQmlBundle::add(const QString &name, const QString &fileName)
 {
     if (!file.isWritable())
@@ -250,28 +510,15 @@ bool QQmlBundle::add(const QString &name, const QString &fileName)
         return false;
 
     // ### use best-fit algorithm
-    if (!file.atEnd())
-        file.seek(file.size());
-
-    FileEntry cmd;
     const quint32 inputFileSize = inputFile.size();
-
-    cmd.kind = Entry::File;
-    cmd.link = 0;
-    cmd.size = sizeof(FileEntry) + name.length() * sizeof(QChar) + inputFileSize;
-    cmd.fileNameLength = name.length() * sizeof(QChar);
-
-    if (bufferSize == 0 && headerWritten == false) {
-        file.write((const char *)qmlBundleHeaderData, qmlBundleHeaderLength);
-        headerWritten = true;
-    }
-
-    file.write((const char *) &cmd, sizeof(FileEntry));
-    file.write((const char *) name.constData(), name.length() * sizeof(QChar));
-
     uchar *source = inputFile.map(0, inputFileSize);
-    file.write((const char *) source, inputFileSize);
+    const quint32 offset = writeEntry(Entry::File, 0, name, (const char *) source, inputFileSize);
     inputFile.unmap(source);
+
+    if (formatVersion >= 2) {
+        addedFiles.append(qMakePair(name, offset));
+        indexOutdated = true;
+    }
     return true;
 }
 
@@ -292,27 +539,7 @@ bool QQmlBundle::addMetaLink(const QString &fileName,
         return false;
 
     // ### use best-fit algorithm
-    if (!file.atEnd())
-        file.seek(file.size());
-
-    FileEntry cmd;
-
-    const quint32 inputFileSize = data.size();
-
-    cmd.kind = Entry::Link;
-    cmd.link = fileEntry->link;
-    cmd.size = sizeof(FileEntry) + linkName.length() * sizeof(QChar) + inputFileSize;
-    cmd.fileNameLength = linkName.length() * sizeof(QChar);
-
-    if (bufferSize == 0 && headerWritten == false) {
-        file.write((const char *)qmlBundleHeaderData, qmlBundleHeaderLength);
-        headerWritten = true;
-    }
-
-    const_cast<FileEntry *>(fileEntry)->link = file.size();
-
-    file.write((const char *) &cmd, sizeof(FileEntry));
-    file.write((const char *) linkName.constData(), linkName.length() * sizeof(QChar));
-    file.write((const char *) data.constData(), inputFileSize);
+    const quint32 offset = writeEntry(Entry::Link, fileEntry->link, linkName, data.constData(), data.size());
+    const_cast<FileEntry *>(fileEntry)->link = offset;
     return true;
 }
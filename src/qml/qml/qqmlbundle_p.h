@@ -43,6 +43,9 @@
 #define QQMLBUNDLE_P_H
 
 #include <QtCore/qfile.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qpair.h>
 #include <QtCore/qstring.h>
 #include <private/qtqmlglobal_p.h>
 
@@ -62,9 +65,11 @@ public:
         enum Kind {
             File = 123, // Normal file
             Skip,       // Empty space
-            Link        // A meta data linked file
+            Link,       // A meta data linked file
+            Header,     // Format version, first entry of version 2 bundles
+            Index       // Sorted offsets of the File entries
 
-            // ### add entries for qmldir, index, ...
+            // ### add entries for qmldir, ...
         };
 
         int kind;
@@ -109,17 +114,48 @@ public:
 
     const FileEntry *link(const FileEntry *, const QString &linkName) const;
 
+    int version() const;
+
     static int bundleHeaderLength();
     static bool isBundleHeader(const char *, int size);
 private:
+    struct HeaderEntry : public Entry
+    {
+        quint32 version;
+        quint32 indexOffset; // 0 if the bundle has no index
+    };
+
+    struct IndexEntry : public Entry
+    {
+        quint32 count;
+        quint32 offsets[]; // of the File entries, sorted by file name
+    };
+
     const Entry *findInsertPoint(quint32 size, qint32 *offset);
+    const FileEntry *entryAt(quint32 offset, int kind) const;
+    bool readHeader();
+    bool buildIndex();
+    void writeHeader();
+    quint32 writeEntry(int kind, quint32 link, const QString &name, const char *data, quint32 size);
+    void writeIndex();
 
 private:
     QFile file;
     uchar *buffer;
     quint32 bufferSize;
+    quint32 formatVersion;
     bool opened:1;
     bool headerWritten:1;
+    bool indexed:1;
+    bool indexOutdated:1;
+
+    // Only used for bundles opened read-only, which can't change under it.  Version 2
+    // bundles store an index, older ones are indexed when they are opened.
+    const IndexEntry *storedIndex;
+    QHash<QString, const FileEntry *> index;
+
+    // Files added since the bundle was opened, which are not part of the mapping
+    QList<QPair<QString, quint32> > addedFiles;
 };
 
 QT_END_NAMESPACE
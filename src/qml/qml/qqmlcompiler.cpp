@@ -61,6 +61,7 @@
 #include "qqmlscriptstring.h"
 #include "qqmlglobal_p.h"
 #include "qqmlbinding_p.h"
+#include "qqmlnativebinding_p.h"
 #include "qqmlabstracturlinterceptor.h"
 
 #include <QDebug>
@@ -82,6 +83,7 @@ QT_BEGIN_NAMESPACE
 
 DEFINE_BOOL_CONFIG_OPTION(compilerDump, QML_COMPILER_DUMP);
 DEFINE_BOOL_CONFIG_OPTION(compilerStatDump, QML_COMPILER_STATS);
+DEFINE_BOOL_CONFIG_OPTION(disableNativeBindings, QML_DISABLE_NATIVE_BINDINGS);
 
 using namespace QQmlJS;
 using namespace QQmlScript;
@@ -1351,7 +1353,7 @@ void QQmlCompiler::genObjectBody(QQmlScript::Object *obj)
             Instruction::StoreSignal store;
             store.runtimeFunctionIndex = compileState->jsCompileData[v->signalData.signalScopeObject].runtimeFunctionIndices.at(v->signalData.functionIndex);
             store.handlerName = output->indexForString(prop->name().toString());
-            store.parameters = output->indexForString(obj->metatype->signalParameterStringForJS(prop->index));
+            store.parameters = output->indexForString(obj->metatype->signalParameterStringForJS(engine, prop->index));
             store.signalIndex = prop->index;
             store.value = output->indexForString(v->value.asScript());
             store.context = v->signalData.signalExpressionContextStack;
@@ -1763,7 +1765,7 @@ bool QQmlCompiler::buildSignal(QQmlScript::Property *prop, QQmlScript::Object *o
             prop->values.first()->signalData.functionIndex = cd->functionsToCompile.count() - 1;
 
             QString errorString;
-            obj->metatype->signalParameterStringForJS(prop->index, &errorString);
+            obj->metatype->signalParameterStringForJS(engine, prop->index, &errorString);
             if (!errorString.isEmpty())
                 COMPILE_EXCEPTION(prop, errorString);
         }
@@ -3606,7 +3608,23 @@ void QQmlCompiler::genBindingAssignment(QQmlScript::Value *binding,
         output->addInstruction(store);
     } else
 #endif
-    if (ref.dataType == BindingReference::QtScript) {
+    if (ref.dataType == BindingReference::QtScript && static_cast<const JSBindingReference &>(ref).native) {
+        const JSBindingReference &js = static_cast<const JSBindingReference &>(ref);
+        Q_ASSERT(js.bindingContext.owner == 0 && !prop->isAlias);
+
+        Instruction::StoreNativeBinding store;
+        store.property = prop->core;
+        store.source = js.native->source;
+        store.expression = output->indexForString(js.expression.asScript());
+        store.context = js.bindingContext.stack;
+        store.idIndex = js.native->idIndex;
+        store.sourceKind = js.native->sourceKind;
+        store.conversion = js.native->conversion;
+        store.isRoot = (compileState->root == obj);
+        store.line = binding->location.start.line;
+        store.column = binding->location.start.column;
+        output->addInstruction(store);
+    } else if (ref.dataType == BindingReference::QtScript) {
         const JSBindingReference &js = static_cast<const JSBindingReference &>(ref);
 
         Instruction::StoreBinding store;
@@ -3679,6 +3697,13 @@ bool QQmlCompiler::completeComponentBuild()
         JSBindingReference &binding = *b;
         binding.dataType = BindingReference::QtScript;
 
+        binding.native = buildNativeBinding(binding);
+        if (binding.native) {
+            if (componentStats)
+                componentStats->componentStat.nativeBindings++;
+            continue;
+        }
+
         QQmlJS::AST::Node *node = binding.expression.asAST();
         // Always wrap this in an ExpressionStatement, to make sure that
         // property var foo: function() { ... } results in a closure initialization.
@@ -3746,6 +3771,8 @@ bool QQmlCompiler::completeComponentBuild()
 
         for (JSBindingReference *b = compileState->bindings.first(); b; b = b->nextReference) {
             JSBindingReference &binding = *b;
+            if (binding.native)
+                continue;
             binding.compiledIndex = compileState->jsCompileData[binding.bindingContext.object].runtimeFunctionIndices[binding.compiledIndex];
             if (!binding.value) { // Must be a binding requested from custom parser
                 Q_ASSERT(binding.customParserBindingsIndex >= 0 && binding.customParserBindingsIndex < output->customParserBindings.count());
@@ -3763,6 +3790,110 @@ bool QQmlCompiler::completeComponentBuild()
     return true;
 }
 
+// Looks up \a name the way JSCodeGen resolves properties of the scope, context
+// and id objects at compile time.  Sets \a lookupAtRuntime if a method of that
+// name shadows the property, which means the name has to be resolved at run-time.
+static QQmlPropertyData *nativeBindingProperty(QQmlPropertyCache *cache, const QString &name,
+                                               bool *lookupAtRuntime)
+{
+    QQmlPropertyData *pd = cache ? cache->property(name, /*object*/0, /*context*/0) : 0;
+    if (pd && pd->isFunction()) {
+        *lookupAtRuntime = true;
+        return 0;
+    }
+    if (pd && !cache->isAllowedInRevision(pd))
+        return 0;
+    return pd;
+}
+
+/*!
+    Returns a description of \a binding as a native binding, or 0 if it has to be
+    compiled to JavaScript.
+
+    Native bindings cover expressions that only read a single property, such as
+    "value", "someId.value" or "!someId.enabled", and must resolve to exactly the
+    same property as the accelerated lookups in JSCodeGen::fallbackNameLookup().
+*/
+QQmlCompilerTypes::NativeBindingReference *QQmlCompiler::buildNativeBinding(const JSBindingReference &binding)
+{
+    if (disableNativeBindings())
+        return 0;
+
+    // Custom parser bindings are evaluated as expressions and value type
+    // and alias bindings need the retargeting support of QQmlBinding.
+    if (!binding.value || binding.disableLookupAcceleration || binding.bindingContext.owner != 0)
+        return 0;
+
+    const QQmlScript::Property *prop = binding.property;
+    if (prop->isAlias || prop->core.isValueTypeVirtual() || prop->core.isVarProperty())
+        return 0;
+
+    AST::Node *node = binding.expression.asAST();
+    if (AST::ExpressionStatement *statement = AST::cast<AST::ExpressionStatement *>(node))
+        node = statement->expression;
+    while (AST::NestedExpression *nested = AST::cast<AST::NestedExpression *>(node))
+        node = nested->expression;
+
+    bool negate = false;
+    if (AST::NotExpression *notExpression = AST::cast<AST::NotExpression *>(node)) {
+        negate = true;
+        node = notExpression->expression;
+        while (AST::NestedExpression *nested = AST::cast<AST::NestedExpression *>(node))
+            node = nested->expression;
+    }
+
+    QQmlPropertyData *source = 0;
+    int sourceKind = QQmlNativeBinding::ScopeObject;
+    int idIndex = -1;
+    bool lookupAtRuntime = false;
+
+    if (AST::IdentifierExpression *identifier = AST::cast<AST::IdentifierExpression *>(node)) {
+        const QString name = identifier->name.toString();
+
+        // Ids and imports are looked up before properties
+        if (compileState->ids.value(name))
+            return 0;
+        if (output->importCache && output->importCache->query(QHashedStringRef(name)).isValid())
+            return 0;
+
+        source = nativeBindingProperty(binding.bindingContext.object->metatype, name, &lookupAtRuntime);
+        if (!source && !lookupAtRuntime) {
+            source = nativeBindingProperty(compileState->root->metatype, name, &lookupAtRuntime);
+            sourceKind = QQmlNativeBinding::ContextObject;
+        }
+    } else if (AST::FieldMemberExpression *member = AST::cast<AST::FieldMemberExpression *>(node)) {
+        AST::IdentifierExpression *base = AST::cast<AST::IdentifierExpression *>(member->base);
+        if (!base)
+            return 0;
+
+        QQmlScript::Object *idObject = compileState->ids.value(base->name.toString());
+        if (!idObject || output->types[idObject->type].isFullyDynamicType)
+            return 0;
+
+        source = nativeBindingProperty(idObject->metatype, member->name.toString(), &lookupAtRuntime);
+        sourceKind = QQmlNativeBinding::IdObject;
+        idIndex = idObject->idIndex;
+    }
+
+    if (!source || lookupAtRuntime)
+        return 0;
+
+    // Leave the warning about non-NOTIFYable properties to the JavaScript binding
+    if (!source->isConstant() && source->notifyIndex == -1)
+        return 0;
+
+    QQmlNativeBinding::Conversion conversion;
+    if (!QQmlNativeBinding::canConvert(source->propType, prop->core.propType, negate, &conversion))
+        return 0;
+
+    NativeBindingReference *native = pool->New<NativeBindingReference>();
+    native->source = *source;
+    native->sourceKind = sourceKind;
+    native->idIndex = idIndex;
+    native->conversion = conversion;
+    return native;
+}
+
 void QQmlCompiler::dumpStats()
 {
     Q_ASSERT(componentStats);
@@ -3791,6 +3922,7 @@ void QQmlCompiler::dumpStats()
         if (!output.isEmpty())
             qWarning().nospace() << output.constData();
         }
+        qWarning().nospace() << "        Native Bindings:    " << stat.nativeBindings;
     }
 }
 
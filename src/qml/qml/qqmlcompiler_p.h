@@ -229,10 +229,19 @@ namespace QQmlCompilerTypes {
         DataType dataType;
     };
 
+    // Describes a binding that can be evaluated by QQmlNativeBinding
+    struct NativeBindingReference : public QQmlPool::POD
+    {
+        QQmlPropertyRawData source;
+        int sourceKind; // QQmlNativeBinding::SourceKind
+        int idIndex;
+        int conversion; // QQmlNativeBinding::Conversion
+    };
+
     struct JSBindingReference : public QQmlPool::Class,
                                 public BindingReference
     {
-        JSBindingReference() : disableLookupAcceleration(false), nextReference(0) {}
+        JSBindingReference() : disableLookupAcceleration(false), native(0), nextReference(0) {}
 
         QQmlScript::Variant expression;
         QQmlScript::Property *property;
@@ -242,6 +251,9 @@ namespace QQmlCompilerTypes {
         int customParserBindingsIndex : 15;
         int disableLookupAcceleration: 1;
 
+        // Set if the binding is emitted as a native binding instead of being compiled to JavaScript
+        NativeBindingReference *native;
+
         BindingContext bindingContext;
 
         JSBindingReference *nextReference;
@@ -420,6 +432,7 @@ private:
                              const QQmlCompilerTypes::BindingContext &ctxt);
     bool buildComponentFromRoot(QQmlScript::Object *obj, const QQmlCompilerTypes::BindingContext &);
     bool completeComponentBuild();
+    QQmlCompilerTypes::NativeBindingReference *buildNativeBinding(const QQmlCompilerTypes::JSBindingReference &);
     bool checkValidId(QQmlScript::Value *, const QString &);
 
 
@@ -490,12 +503,13 @@ private:
     // Compiler component statistics.  Only collected if QML_COMPILER_STATS=1
     struct ComponentStat
     {
-        ComponentStat() : lineNumber(0), ids(0), objects(0) {}
+        ComponentStat() : lineNumber(0), ids(0), nativeBindings(0), objects(0) {}
 
         quint16 lineNumber;
 
         int ids;
         QList<QQmlScript::LocationSpan> scriptBindings;
+        int nativeBindings;
         int objects;
     };
     struct ComponentStats : public QQmlPool::Class
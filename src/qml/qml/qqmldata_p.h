@@ -148,6 +148,7 @@ public:
     void addNotify(int index, QQmlNotifierEndpoint *);
     int endpointCount(int index);
     bool signalHasEndpoint(int index);
+    void updateConnectionMask(int index);
     void disconnectNotifiers();
 
     // The context that created the C++ object
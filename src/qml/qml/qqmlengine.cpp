@@ -69,6 +69,7 @@
 #include "qqmlabstracturlinterceptor.h"
 #include <private/qv8profilerservice_p.h>
 #include <private/qqmlboundsignal_p.h>
+#include <private/qqmlmemoryprofiler_p.h>
 
 #include <QtCore/qstandardpaths.h>
 #include <QtCore/qsettings.h>
@@ -551,9 +552,10 @@ the same object as is returned from the Qt.include() call.
 // Qt.include() is implemented in qv4include.cpp
 
 DEFINE_BOOL_CONFIG_OPTION(qmlUseNewCompiler, QML_NEW_COMPILER)
+DEFINE_BOOL_CONFIG_OPTION(qmlBatchedBindings, QML_BATCHED_BINDINGS)
 
 QQmlEnginePrivate::QQmlEnginePrivate(QQmlEngine *e)
-: propertyCapture(0), rootContext(0), isDebugging(false),
+: propertyCapture(0), bindingQueue(e), rootContext(0), isDebugging(false),
   outputWarningsToStdErr(true),
   cleanup(0), erroredBindings(0), inProgressCreations(0),
   workerScriptEngine(0), activeVME(0),
@@ -563,6 +565,7 @@ QQmlEnginePrivate::QQmlEnginePrivate(QQmlEngine *e)
   incubatorCount(0), incubationController(0), mutex(QMutex::Recursive)
 {
     useNewCompiler = qmlUseNewCompiler();
+    bindingQueue.setEnabled(qmlBatchedBindings());
 }
 
 QQmlEnginePrivate::~QQmlEnginePrivate()
@@ -736,6 +739,8 @@ int QQmlData::endpointCount(int index)
     QQmlNotifierEndpoint *ep = notify(index);
     if (!ep)
         return count;
+    if (QQmlNotifier::isArray(ep))
+        return QQmlNotifier::arrayEndpointCount(ep);
     ++count;
     while (ep->next) {
         ++count;
@@ -1320,6 +1325,8 @@ bool QQmlEngine::event(QEvent *e)
     Q_D(QQmlEngine);
     if (e->type() == QEvent::User)
         d->doDeleteInEngineThread();
+    else if (d->bindingQueue.processEvent(e))
+        return true;
 
     return QJSEngine::event(e);
 }
@@ -1474,6 +1481,13 @@ void QQmlData::NotifyList::layout(QQmlNotifierEndpoint *endpoint)
     int index = endpoint->sourceSignal;
     index = qMin(index, 0xFFFF - 1);
 
+    if (QQmlNotifier::isArray(notifies[index])) {
+        endpoint->next = 0;
+        endpoint->prev = 0;
+        QQmlNotifier::appendToArray(notifies[index], endpoint);
+        return;
+    }
+
     endpoint->next = notifies[index];
     if (endpoint->next) endpoint->next->prev = &endpoint->next;
     endpoint->prev = &notifies[index];
@@ -1493,9 +1507,12 @@ void QQmlData::NotifyList::layout()
         memset(notifies + notifiesSize, 0, memsetSize);
 
         if (notifies != old) {
-            for (int ii = 0; ii < notifiesSize; ++ii)
-                if (notifies[ii])
+            for (int ii = 0; ii < notifiesSize; ++ii) {
+                if (QQmlNotifier::isArray(notifies[ii]))
+                    QQmlNotifier::relocateArray(&notifies[ii]);
+                else if (notifies[ii])
                     notifies[ii]->prev = &notifies[ii];
+            }
         }
 
         notifiesSize = maximumTodoIndex + 1;
@@ -1523,7 +1540,11 @@ void QQmlData::addNotify(int index, QQmlNotifierEndpoint *endpoint)
     index = qMin(index, 0xFFFF - 1);
     notifyList->connectionMask |= (1ULL << quint64(index % 64));
 
-    if (index < notifyList->notifiesSize) {
+    if (index < notifyList->notifiesSize && QQmlNotifier::isArray(notifyList->notifies[index])) {
+
+        QQmlNotifier::appendToArray(notifyList->notifies[index], endpoint);
+
+    } else if (index < notifyList->notifiesSize) {
 
         endpoint->next = notifyList->notifies[index];
         if (endpoint->next) endpoint->next->prev = &endpoint->next;
@@ -1549,12 +1570,38 @@ bool QQmlData::signalHasEndpoint(int index)
     return notifyList && (notifyList->connectionMask & (1ULL << quint64(index % 64)));
 }
 
+/*
+    Clears the connection mask bit of \a index if no signal sharing it has endpoints.
+    index MUST in the range returned by QObjectPrivate::signalIndex()
+*/
+void QQmlData::updateConnectionMask(int index)
+{
+    if (!notifyList)
+        return;
+
+    index = qMin(index, 0xFFFF - 1);
+    const int bit = index % 64;
+    for (QQmlNotifierEndpoint *ep = notifyList->todo; ep; ep = ep->next) {
+        if (qMin(int(ep->sourceSignal), 0xFFFF - 1) % 64 == bit)
+            return;
+    }
+    for (int ii = bit; ii < notifyList->notifiesSize; ii += 64) {
+        if (notifyList->notifies[ii])
+            return;
+    }
+    notifyList->connectionMask &= ~(1ULL << quint64(bit));
+}
+
 void QQmlData::disconnectNotifiers()
 {
     if (notifyList) {
         while (notifyList->todo)
             notifyList->todo->disconnect();
         for (int ii = 0; ii < notifyList->notifiesSize; ++ii) {
+            if (QQmlNotifier::isArray(notifyList->notifies[ii])) {
+                QQmlNotifier::disconnectArray(notifyList->notifies[ii]);
+                notifyList->notifies[ii] = 0;
+            }
             while (QQmlNotifierEndpoint *ep = notifyList->notifies[ii])
                 ep->disconnect();
         }
@@ -2023,6 +2070,14 @@ QQmlPropertyCache *QQmlEnginePrivate::createCache(const QMetaObject *mo)
 {
     Q_Q(QQmlEngine);
 
+    if (QQmlPropertyCache *rv = QQmlPropertyCache::sharedCache(mo)) {
+        rv->addref();
+        propertyCache.insert(mo, rv);
+        return rv;
+    }
+
+    QML_MEMORY_SCOPE_STRING("QQmlPropertyCache");
+
     if (!mo->superClass()) {
         QQmlPropertyCache *rv = new QQmlPropertyCache(q, mo);
         propertyCache.insert(mo, rv);
@@ -2038,6 +2093,7 @@ QQmlPropertyCache *QQmlEnginePrivate::createCache(const QMetaObject *mo)
 QQmlPropertyCache *QQmlEnginePrivate::createCache(QQmlType *type, int minorVersion,
                                                                   QQmlError &error)
 {
+    Q_Q(QQmlEngine);
     QList<QQmlType *> types;
 
     int maxMinorVersion = 0;
@@ -2077,7 +2133,7 @@ QQmlPropertyCache *QQmlEnginePrivate::createCache(QQmlType *type, int minorVersi
 
         if (raw->allowedRevisionCache[moIndex] != rev) {
             if (!hasCopied) {
-                raw = raw->copy();
+                raw = raw->copy(q);
                 hasCopied = true;
             }
             raw->allowedRevisionCache[moIndex] = rev;
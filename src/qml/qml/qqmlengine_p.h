@@ -67,6 +67,7 @@
 #include "qqmlpropertycache_p.h"
 #include "qqmlmetatype_p.h"
 #include "qqmldirparser_p.h"
+#include "qqmlbindingqueue_p.h"
 #include <private/qintrusivelist_p.h>
 #include <private/qrecyclepool_p.h>
 
@@ -142,6 +143,7 @@ public:
     inline void captureProperty(QObject *, int, int);
 
     QRecyclePool<QQmlJavaScriptExpressionGuard> jsExpressionGuardPool;
+    QQmlBindingQueue bindingQueue;
 
     QQmlContext *rootContext;
     bool isDebugging;
@@ -394,7 +394,9 @@ void QQmlFile::load(QQmlEngine *engine, const QString &url)
             QString filename = url.mid(index);
             const QQmlBundle::FileEntry *entry = bundle->find(filename);
             if (entry) {
-                d->data = QByteArray(entry->contents(), entry->fileSize());
+                d->file = entry;
+                d->bundle = bundle;
+                d->bundle->addref();
                 d->error = QQmlFilePrivate::None;
             }
             bundle->release();
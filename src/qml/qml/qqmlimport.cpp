@@ -48,6 +48,11 @@
 #include <QtCore/qpluginloader.h>
 #include <QtCore/qlibraryinfo.h>
 #include <QtCore/qreadwritelock.h>
+#include <QtCore/qdatastream.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qsavefile.h>
 #include <QtQml/qqmlextensioninterface.h>
 #include <QtQml/qqmlextensionplugin.h>
 #include <private/qqmlextensionplugin_p.h>
@@ -64,6 +69,7 @@ QT_BEGIN_NAMESPACE
 
 DEFINE_BOOL_CONFIG_OPTION(qmlImportTrace, QML_IMPORT_TRACE)
 DEFINE_BOOL_CONFIG_OPTION(qmlCheckTypes, QML_CHECK_TYPES)
+DEFINE_BOOL_CONFIG_OPTION(qmlDisableImportCache, QML_DISABLE_IMPORT_CACHE)
 
 static const QLatin1Char Dot('.');
 static const QLatin1Char Slash('/');
@@ -1049,6 +1055,223 @@ QString QQmlImportsPrivate::resolvedUri(const QString &dir_arg, QQmlImportDataba
     return stableRelativePath;
 }
 
+namespace {
+
+/*
+Caches where the qmldir file of a library import was found, for all engines in the
+process that use the same import paths.  Every engine otherwise probes all its
+import paths again for each module it imports.
+
+Each entry records the modification times of the directories that were probed,
+and is checked against them whenever it is used, so that a qmldir created or
+removed since then is noticed.  That takes one stat per directory, instead of
+one per version form and import path.
+
+If QML_IMPORT_CACHE_FILE names a file, the cache is read from it on first use and
+written back when an engine is destroyed, so that the next run can skip the probing
+too.
+*/
+class QQmlImportResolutionCache
+{
+public:
+    struct Entry {
+        Entry() : persistent(true) {}
+
+        QString qmldirFilePath;
+        QString qmldirPathUrl;
+        // The nearest existing directory of every probed location, with its
+        // modification time.  Adding or removing a qmldir changes one of them.
+        QList<QPair<QString, qint64> > stamps;
+        // False if resources were probed, which are not covered by the stamps
+        bool persistent;
+    };
+
+    QQmlImportResolutionCache() : loaded(false), dirty(false) {}
+
+    static QString key(const QString &uri, int vmaj, int vmin, const QStringList &importPaths);
+
+    bool lookup(const QString &key, QString *qmldirFilePath, QString *qmldirPathUrl);
+    void insert(const QString &key, const QString &qmldirFilePath, const QString &qmldirPathUrl,
+                const QStringList &probedPaths);
+    void save();
+
+private:
+    static QString cacheFileName();
+    static qint64 modificationTime(const QFileInfo &);
+    static bool isValid(const Entry &);
+    void addStamp(Entry *entry, QSet<QString> *seen, const QString &path);
+    void load();
+
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+    bool loaded;
+    bool dirty;
+};
+
+Q_GLOBAL_STATIC(QQmlImportResolutionCache, importResolutionCache)
+
+static const quint32 importCacheMagic = 0x716d6c69; // "qmli"
+static const quint32 importCacheVersion = 1;
+
+QString QQmlImportResolutionCache::key(const QString &uri, int vmaj, int vmin, const QStringList &importPaths)
+{
+    QString rv = uri;
+    rv += QLatin1Char(' ') + QString::number(vmaj) + Dot + QString::number(vmin);
+    foreach (const QString &path, importPaths)
+        rv += QLatin1Char('\n') + path;
+    return rv;
+}
+
+QString QQmlImportResolutionCache::cacheFileName()
+{
+    return QString::fromLocal8Bit(qgetenv("QML_IMPORT_CACHE_FILE"));
+}
+
+qint64 QQmlImportResolutionCache::modificationTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+bool QQmlImportResolutionCache::isValid(const Entry &entry)
+{
+    for (int ii = 0; ii < entry.stamps.count(); ++ii) {
+        const QPair<QString, qint64> &stamp = entry.stamps.at(ii);
+        QFileInfo info(stamp.first);
+        if (!info.isDir() || modificationTime(info) != stamp.second)
+            return false;
+    }
+    return true;
+}
+
+bool QQmlImportResolutionCache::lookup(const QString &key, QString *qmldirFilePath, QString *qmldirPathUrl)
+{
+    QMutexLocker locker(&mutex);
+    if (!loaded)
+        load();
+
+    QHash<QString, Entry>::Iterator iter = entries.find(key);
+    if (iter == entries.end())
+        return false;
+
+    if (!isValid(*iter)) {
+        if (iter->persistent)
+            dirty = true;
+        entries.erase(iter);
+        return false;
+    }
+
+    *qmldirFilePath = iter->qmldirFilePath;
+    *qmldirPathUrl = iter->qmldirPathUrl;
+    return true;
+}
+
+void QQmlImportResolutionCache::addStamp(Entry *entry, QSet<QString> *seen, const QString &path)
+{
+    QString dir = path.left(path.lastIndexOf(Slash));
+    while (!dir.isEmpty()) {
+        QFileInfo info(dir);
+        if (info.isDir()) {
+            if (!seen->contains(dir)) {
+                seen->insert(dir);
+                entry->stamps.append(qMakePair(dir, modificationTime(info)));
+            }
+            return;
+        }
+        int index = dir.lastIndexOf(Slash);
+        if (index <= 0)
+            return;
+        dir.truncate(index);
+    }
+}
+
+void QQmlImportResolutionCache::insert(const QString &key, const QString &qmldirFilePath,
+                                       const QString &qmldirPathUrl, const QStringList &probedPaths)
+{
+    Entry entry;
+    entry.qmldirFilePath = qmldirFilePath;
+    entry.qmldirPathUrl = qmldirPathUrl;
+
+    QSet<QString> seen;
+    foreach (const QString &path, probedPaths) {
+        // Resources can't change while the application runs, but they can between
+        // runs without touching the file system.
+        if (path.startsWith(Colon))
+            entry.persistent = false;
+        else
+            addStamp(&entry, &seen, path);
+    }
+
+    QMutexLocker locker(&mutex);
+    entries.insert(key, entry);
+    if (entry.persistent && !cacheFileName().isEmpty())
+        dirty = true;
+}
+
+void QQmlImportResolutionCache::load()
+{
+    loaded = true;
+
+    QString fileName = cacheFileName();
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != importCacheMagic || version != importCacheVersion)
+        return;
+
+    for (quint32 ii = 0; ii < count && stream.status() == QDataStream::Ok; ++ii) {
+        QString key;
+        Entry entry;
+        stream >> key >> entry.qmldirFilePath >> entry.qmldirPathUrl >> entry.stamps;
+        if (stream.status() == QDataStream::Ok)
+            entries.insert(key, entry);
+    }
+}
+
+void QQmlImportResolutionCache::save()
+{
+    QMutexLocker locker(&mutex);
+    if (!dirty)
+        return;
+
+    QString fileName = cacheFileName();
+    if (fileName.isEmpty())
+        return;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    // Entries that involve resources are only valid for this run
+    quint32 count = 0;
+    for (QHash<QString, Entry>::ConstIterator iter = entries.constBegin(); iter != entries.constEnd(); ++iter) {
+        if (iter->persistent)
+            ++count;
+    }
+
+    stream << importCacheMagic << importCacheVersion << count;
+    for (QHash<QString, Entry>::ConstIterator iter = entries.constBegin(); iter != entries.constEnd(); ++iter) {
+        if (iter->persistent)
+            stream << iter.key() << iter->qmldirFilePath << iter->qmldirPathUrl << iter->stamps;
+    }
+
+    if (file.commit())
+        dirty = false;
+}
+
+}
+
 /*
 Locates the qmldir file for \a uri version \a vmaj.vmin.  Returns true if found,
 and fills in outQmldirFilePath and outQmldirUrl appropriately.  Otherwise returns
@@ -1082,10 +1305,34 @@ bool QQmlImportsPrivate::locateQmldir(const QString &uri, int vmaj, int vmin, QQ
 
     QStringList localImportPaths = database->importPathList(QQmlImportDatabase::Local);
 
+    // Then the cache shared with the other engines
+    QString sharedKey;
+    if (!qmlDisableImportCache()) {
+        sharedKey = QQmlImportResolutionCache::key(uri, vmaj, vmin, localImportPaths);
+        QString qmldirFilePath, qmldirPathUrl;
+        if (importResolutionCache()->lookup(sharedKey, &qmldirFilePath, &qmldirPathUrl)) {
+            QQmlImportDatabase::QmldirCache *cache = new QQmlImportDatabase::QmldirCache;
+            cache->versionMajor = vmaj;
+            cache->versionMinor = vmin;
+            cache->qmldirFilePath = qmldirFilePath;
+            cache->qmldirPathUrl = qmldirPathUrl;
+            cache->next = cacheHead;
+            database->qmldirCache.insert(uri, cache);
+
+            *outQmldirFilePath = qmldirFilePath;
+            *outQmldirPathUrl = qmldirPathUrl;
+            return !qmldirFilePath.isEmpty();
+        }
+    }
+
+    QStringList probedPaths;
+
     // Search local import paths for a matching version
     for (int version = QQmlImports::FullyVersioned; version <= QQmlImports::Unversioned; ++version) {
         foreach (const QString &path, localImportPaths) {
             QString qmldirPath = QQmlImports::completeQmldirPath(uri, path, vmaj, vmin, static_cast<QQmlImports::ImportVersion>(version));
+            if (!sharedKey.isEmpty())
+                probedPaths.append(qmldirPath);
 
             QString absoluteFilePath = typeLoader.absoluteFilePath(qmldirPath);
             if (!absoluteFilePath.isEmpty()) {
@@ -1104,6 +1351,9 @@ bool QQmlImportsPrivate::locateQmldir(const QString &uri, int vmaj, int vmin, QQ
                 cache->next = cacheHead;
                 database->qmldirCache.insert(uri, cache);
 
+                if (!sharedKey.isEmpty())
+                    importResolutionCache()->insert(sharedKey, absoluteFilePath, url, probedPaths);
+
                 *outQmldirFilePath = absoluteFilePath;
                 *outQmldirPathUrl = url;
 
@@ -1118,6 +1368,9 @@ bool QQmlImportsPrivate::locateQmldir(const QString &uri, int vmaj, int vmin, QQ
     cache->next = cacheHead;
     database->qmldirCache.insert(uri, cache);
 
+    if (!sharedKey.isEmpty())
+        importResolutionCache()->insert(sharedKey, QString(), QString(), probedPaths);
+
     return false;
 }
 
@@ -1487,11 +1740,18 @@ bool QQmlImports::addFileImport(QQmlImportDatabase *importDb,
     Q_ASSERT(importDb);
     Q_ASSERT(errors);
 
-    if (qmlImportTrace())
-        qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addFileImport: "
-                           << uri << ' ' << vmaj << '.' << vmin << " as " << prefix;
+    if (!qmlImportTrace())
+        return d->addFileImport(uri, prefix, vmaj, vmin, false, incomplete, importDb, errors);
+
+    qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addFileImport: "
+                       << uri << ' ' << vmaj << '.' << vmin << " as " << prefix;
 
-    return d->addFileImport(uri, prefix, vmaj, vmin, false, incomplete, importDb, errors);
+    QElapsedTimer timer;
+    timer.start();
+    bool rv = d->addFileImport(uri, prefix, vmaj, vmin, false, incomplete, importDb, errors);
+    qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addFileImport: "
+                       << uri << " took " << timer.nsecsElapsed() / 1000 << "us";
+    return rv;
 }
 
 bool QQmlImports::addLibraryImport(QQmlImportDatabase *importDb,
@@ -1501,11 +1761,18 @@ bool QQmlImports::addLibraryImport(QQmlImportDatabase *importDb,
     Q_ASSERT(importDb);
     Q_ASSERT(errors);
 
-    if (qmlImportTrace())
-        qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addLibraryImport: "
-                           << uri << ' ' << vmaj << '.' << vmin << " as " << prefix;
+    if (!qmlImportTrace())
+        return d->addLibraryImport(uri, prefix, vmaj, vmin, qmldirIdentifier, qmldirUrl, incomplete, importDb, errors);
 
-    return d->addLibraryImport(uri, prefix, vmaj, vmin, qmldirIdentifier, qmldirUrl, incomplete, importDb, errors);
+    qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addLibraryImport: "
+                       << uri << ' ' << vmaj << '.' << vmin << " as " << prefix;
+
+    QElapsedTimer timer;
+    timer.start();
+    bool rv = d->addLibraryImport(uri, prefix, vmaj, vmin, qmldirIdentifier, qmldirUrl, incomplete, importDb, errors);
+    qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::addLibraryImport: "
+                       << uri << " took " << timer.nsecsElapsed() / 1000 << "us";
+    return rv;
 }
 
 bool QQmlImports::updateQmldirContent(QQmlImportDatabase *importDb,
@@ -1526,7 +1793,16 @@ bool QQmlImports::locateQmldir(QQmlImportDatabase *importDb,
                                const QString& uri, int vmaj, int vmin,
                                QString *qmldirFilePath, QString *url)
 {
-    return d->locateQmldir(uri, vmaj, vmin, importDb, qmldirFilePath, url);
+    if (!qmlImportTrace())
+        return d->locateQmldir(uri, vmaj, vmin, importDb, qmldirFilePath, url);
+
+    QElapsedTimer timer;
+    timer.start();
+    bool rv = d->locateQmldir(uri, vmaj, vmin, importDb, qmldirFilePath, url);
+    qDebug().nospace() << "QQmlImports(" << qPrintable(baseUrl().toString()) << ')' << "::locateQmldir: "
+                       << uri << ' ' << vmaj << '.' << vmin << " -> " << *qmldirFilePath
+                       << " took " << timer.nsecsElapsed() / 1000 << "us";
+    return rv;
 }
 
 bool QQmlImports::isLocal(const QString &url)
@@ -1575,6 +1851,9 @@ QQmlImportDatabase::~QQmlImportDatabase()
 {
     qDeleteAll(qmldirCache);
     qmldirCache.clear();
+
+    if (!qmlDisableImportCache() && importResolutionCache())
+        importResolutionCache()->save();
 }
 
 /*!
@@ -46,6 +46,7 @@
 #include "qqmlcompiler_p.h"
 #include "qqmlexpression_p.h"
 #include "qqmlmemoryprofiler_p.h"
+#include <private/qqmlprofilerservice_p.h>
 
 // XXX TODO 
 //   - check that the Component.onCompleted behavior is the same as 4.8 in the synchronous and 
@@ -389,6 +390,7 @@ void QQmlIncubationController::incubateFor(int msecs)
     if (!d || !d->incubatorCount)
         return;
 
+    QQmlIncubatingProfiler profiler(msecs);
     QQmlVME::Interrupt i(msecs * 1000000);
     i.reset();
     do {
@@ -408,6 +410,7 @@ void QQmlIncubationController::incubateWhile(volatile bool *flag, int msecs)
     if (!d || !d->incubatorCount)
         return;
 
+    QQmlIncubatingProfiler profiler(msecs);
     QQmlVME::Interrupt i(flag, msecs * 1000000);
     i.reset();
     do {
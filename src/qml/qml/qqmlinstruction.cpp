@@ -224,6 +224,9 @@ void QQmlCompiledData::dump(QQmlInstruction *instr, int idx)
     case QQmlInstruction::StoreBinding:
         qWarning().nospace() << idx << "\t\t" << "STORE_BINDING\t" << instr->assignBinding.property.coreIndex << "\t" << instr->assignBinding.functionIndex << "\t" << instr->assignBinding.context;
         break;
+    case QQmlInstruction::StoreNativeBinding:
+        qWarning().nospace() << idx << "\t\t" << "STORE_NATIVE_BINDING\t" << instr->assignNativeBinding.property.coreIndex << "\t" << instr->assignNativeBinding.source.coreIndex << "\t" << int(instr->assignNativeBinding.sourceKind) << "\t" << instr->assignNativeBinding.idIndex << "\t\t" << primitives.at(instr->assignNativeBinding.expression);
+        break;
     case QQmlInstruction::StoreValueSource:
         qWarning().nospace() << idx << "\t\t" << "STORE_VALUE_SOURCE\t" << instr->assignValueSource.property.coreIndex << "\t" << instr->assignValueSource.castValue;
         break;
@@ -117,6 +117,7 @@ QT_BEGIN_NAMESPACE
     F(StoreScriptString, storeScriptString) \
     F(BeginObject, begin) \
     F(StoreBinding, assignBinding) \
+    F(StoreNativeBinding, assignNativeBinding) \
     F(StoreValueSource, assignValueSource) \
     F(StoreValueInterceptor, assignValueInterceptor) \
     F(StoreObjectQList, common) \
@@ -249,6 +250,19 @@ union QQmlInstruction
         ushort line;
         ushort column;
     };
+    struct instr_assignNativeBinding {
+        QML_INSTR_HEADER
+        QQmlPropertyRawData property;
+        QQmlPropertyRawData source;
+        int expression; // index in CompiledData::primitives
+        short context;
+        short idIndex;
+        quint8 sourceKind; // QQmlNativeBinding::SourceKind
+        quint8 conversion; // QQmlNativeBinding::Conversion
+        bool isRoot:1;
+        ushort line;
+        ushort column;
+    };
     struct instr_fetch {
         QML_INSTR_HEADER
         int property;
@@ -489,6 +503,7 @@ union QQmlInstruction
     instr_assignValueSource assignValueSource;
     instr_assignValueInterceptor assignValueInterceptor;
     instr_assignBinding assignBinding;
+    instr_assignNativeBinding assignNativeBinding;
     instr_fetch fetch;
     instr_fetchValue fetchValue;
     instr_fetchQmlList fetchQmlList;
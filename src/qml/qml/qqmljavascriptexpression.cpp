@@ -113,6 +113,17 @@ void QQmlJavaScriptExpression::resetNotifyOnValueChanged()
     clearGuards();
 }
 
+/*
+    An expression with static dependencies reads the same properties on every
+    evaluation, as proven by the compiler. Its guards are captured by the first
+    successful evaluation and kept for all later ones.
+*/
+void QQmlJavaScriptExpression::setHasStaticDependencies(bool v)
+{
+    activeGuards.setFlag2Value(v);
+    m_vtable.clearFlag();
+}
+
 QV4::ReturnedValue QQmlJavaScriptExpression::evaluate(QQmlContextData *context,
                                    const QV4::ValueRef function, bool *isUndefined)
 {
@@ -145,11 +156,14 @@ QV4::ReturnedValue QQmlJavaScriptExpression::evaluate(QQmlContextData *context,
     Q_ASSERT(notifyOnValueChanged() || activeGuards.isEmpty());
     GuardCapture capture(context->engine, this, &watcher);
 
+    // Static dependencies only need to be captured once
+    const bool captureDependencies = notifyOnValueChanged() && !(hasStaticDependencies() && m_vtable.flag());
+
     QQmlEnginePrivate::PropertyCapture *lastPropertyCapture = ep->propertyCapture;
-    ep->propertyCapture = notifyOnValueChanged()?&capture:0;
+    ep->propertyCapture = captureDependencies?&capture:0;
 
 
-    if (notifyOnValueChanged())
+    if (captureDependencies)
         capture.guards.copyAndClearPrepend(activeGuards);
 
     QV4::ExecutionEngine *v4 = QV8Engine::getV4(ep->v8engine());
@@ -171,12 +185,19 @@ QV4::ReturnedValue QQmlJavaScriptExpression::evaluate(QQmlContextData *context,
             delayedError()->catchJavaScriptException(ctx);
         if (isUndefined)
             *isUndefined = true;
+        // An exception may have cut the evaluation short, capture everything again next time
+        if (!watcher.wasDeleted())
+            m_vtable.clearFlag();
     } else {
         if (isUndefined)
             *isUndefined = result->isUndefined();
 
-        if (!watcher.wasDeleted() && hasDelayedError())
-            delayedError()->clearError();
+        if (!watcher.wasDeleted()) {
+            if (hasDelayedError())
+                delayedError()->clearError();
+            if (captureDependencies && hasStaticDependencies())
+                m_vtable.setFlag();
+        }
     }
 
     if (capture.errorString) {
@@ -362,6 +383,7 @@ void QQmlJavaScriptExpression::clearGuards()
 {
     while (Guard *g = activeGuards.takeFirst())
         g->Delete();
+    m_vtable.clearFlag();
 }
 
 void QQmlJavaScriptExpressionGuard_callback(QQmlNotifierEndpoint *e, void **)
@@ -122,6 +122,9 @@ public:
     void setNotifyOnValueChanged(bool v);
     void resetNotifyOnValueChanged();
 
+    inline bool hasStaticDependencies() const;
+    void setHasStaticDependencies(bool v);
+
     inline QObject *scopeObject() const;
     inline void setScopeObject(QObject *v);
 
@@ -182,8 +185,9 @@ private:
     QPointerValuePair<VTable, QQmlDelayedError> m_vtable;
 
     // We store some flag bits in the following flag pointers.
+    //    m_vtable:flag       - dependenciesCaptured
     //    activeGuards:flag1  - notifyOnValueChanged
-    //    activeGuards:flag2  - useSharedContext
+    //    activeGuards:flag2  - hasStaticDependencies
     QBiPointer<QObject, DeleteWatcher> m_scopeObject;
     QForwardFieldList<Guard, &Guard::next> activeGuards;
 };
@@ -218,6 +222,11 @@ bool QQmlJavaScriptExpression::notifyOnValueChanged() const
     return activeGuards.flag();
 }
 
+bool QQmlJavaScriptExpression::hasStaticDependencies() const
+{
+    return activeGuards.flag2();
+}
+
 QObject *QQmlJavaScriptExpression::scopeObject() const
 {
     if (m_scopeObject.isT1()) return m_scopeObject.asT1();
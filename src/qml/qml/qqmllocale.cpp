@@ -577,8 +577,11 @@ QV4::ReturnedValue QQmlLocaleData::method_get_uiLanguages(QV4::CallContext *ctx)
     QStringList langs = locale->uiLanguages();
     QV4::Scoped<QV4::ArrayObject> result(scope, ctx->engine->newArrayObject());
     result->arrayReserve(langs.size());
+    QV4::ScopedValue v(scope);
     for (int i = 0; i < langs.size(); ++i) {
-        result->arrayData[i].value = ctx->engine->newString(langs.at(i));
+        v = ctx->engine->newString(langs.at(i));
+        result->writeBarrier();
+        result->arrayData[i].value = v.asReturnedValue();
         result->arrayDataLen = i + 1;
     }
 
@@ -0,0 +1,340 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qqmlnativebinding_p.h"
+
+#include <private/qqmlengine_p.h>
+#include <private/qqmlglobal_p.h>
+#include <private/qqmlprofilerservice_p.h>
+
+#include <QtCore/qvariant.h>
+
+QT_BEGIN_NAMESPACE
+
+// Used in qqmlabstractbinding.cpp
+QQmlAbstractBinding::VTable QQmlNativeBinding_vtable = {
+    QQmlAbstractBinding::default_destroy<QQmlNativeBinding>,
+    QQmlNativeBinding::expression,
+    QQmlNativeBinding::propertyIndex,
+    QQmlNativeBinding::object,
+    QQmlNativeBinding::setEnabled,
+    QQmlNativeBinding::update,
+    QQmlAbstractBinding::default_retargetBinding
+};
+
+namespace {
+
+inline void readProperty(QObject *object, const QQmlPropertyData &property, void *value)
+{
+    if (property.hasAccessors()) {
+        property.accessors->read(object, property.accessorData, value);
+    } else {
+        void *args[] = { value, 0 };
+        if (property.isDirect())
+            object->qt_metacall(QMetaObject::ReadProperty, property.coreIndex, args);
+        else
+            QMetaObject::metacall(object, QMetaObject::ReadProperty, property.coreIndex, args);
+    }
+}
+
+inline void writeProperty(QObject *object, const QQmlPropertyData &property, void *value,
+                          QQmlPropertyPrivate::WriteFlags flags)
+{
+    int status = -1;
+    void *args[] = { value, 0, &status, &flags };
+    QMetaObject::metacall(object, QMetaObject::WriteProperty, property.coreIndex, args);
+}
+
+template<typename T>
+inline void copyProperty(QObject *source, const QQmlPropertyData &sourceProperty,
+                         QObject *target, const QQmlPropertyData &targetProperty,
+                         QQmlPropertyPrivate::WriteFlags flags)
+{
+    T value = T();
+    readProperty(source, sourceProperty, &value);
+    writeProperty(target, targetProperty, &value, flags);
+}
+
+}
+
+QQmlNativeBinding::QQmlNativeBinding(QObject *target, const QQmlPropertyRawData &property,
+                                     QObject *scope, QQmlContextData *ctxt,
+                                     SourceKind kind, int idIndex, const QQmlPropertyRawData &source,
+                                     Conversion conversion, const QString &expression,
+                                     const QString &url, quint16 line, quint16 column)
+: QQmlAbstractBinding(Native), m_target(target), m_scope(scope),
+  m_property(property), m_source(source), m_sourceEndpoint(this), m_idEndpoint(this),
+  m_expression(expression), m_url(url), m_line(line), m_column(column),
+  m_idIndex(idIndex), m_kind(kind), m_conversion(conversion), m_enabled(false), m_updating(false)
+{
+    QQmlAbstractExpression::setContext(ctxt);
+}
+
+QQmlNativeBinding::~QQmlNativeBinding()
+{
+}
+
+/*!
+Returns true if a value of \a sourceType, or its negation if \a negate is
+true, can be assigned to a property of \a targetType by a native binding, and
+sets \a conversion accordingly.
+
+Only types whose round trip through JavaScript is lossless qualify, so that
+a native binding always produces the same value as the equivalent
+JavaScript binding.
+*/
+bool QQmlNativeBinding::canConvert(int sourceType, int targetType, bool negate, Conversion *conversion)
+{
+    if (negate) {
+        *conversion = Negate;
+        return sourceType == QMetaType::Bool && targetType == QMetaType::Bool;
+    }
+
+    if (sourceType == QMetaType::Int && targetType == QMetaType::Double) {
+        *conversion = IntToDouble;
+        return true;
+    }
+
+    *conversion = NoConversion;
+    if (sourceType != targetType)
+        return false;
+
+    switch (sourceType) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::QString:
+    case QMetaType::QPoint:
+    case QMetaType::QPointF:
+    case QMetaType::QSize:
+    case QMetaType::QSizeF:
+    case QMetaType::QRect:
+    case QMetaType::QRectF:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void QQmlNativeBinding::setEnabled(bool e, QQmlPropertyPrivate::WriteFlags flags)
+{
+    m_enabled = e;
+
+    if (e) {
+        update(flags);
+    } else {
+        m_sourceEndpoint.disconnect();
+        m_idEndpoint.disconnect();
+    }
+}
+
+void QQmlNativeBinding::update(QQmlPropertyPrivate::WriteFlags flags)
+{
+    if (!m_enabled || !context() || !context()->isValid())
+        return;
+
+    // Check that the target has not been deleted
+    if (QQmlData::wasDeleted(m_target))
+        return;
+
+    if (m_updating) {
+        QQmlProperty p = QQmlPropertyPrivate::restore(m_target, m_property, context());
+        QQmlAbstractBinding::printBindingLoopError(p);
+        return;
+    }
+
+    QQmlBindingProfiler prof(m_url, qmlSourceCoordinate(m_line), qmlSourceCoordinate(m_column),
+                             QQmlProfilerService::V4Binding);
+    m_updating = true;
+
+    QQmlAbstractExpression::DeleteWatcher watcher(this);
+
+    if (m_kind == IdObject && !m_idEndpoint.isConnected())
+        m_idEndpoint.connect(&context()->idValues[m_idIndex].bindings);
+
+    QObject *source = sourceObject();
+    if (!source) {
+        m_sourceEndpoint.disconnect();
+        reportNullSource();
+    } else {
+        subscribe(source);
+
+        switch (m_conversion) {
+        case Negate: {
+            bool value = false;
+            readProperty(source, m_source, &value);
+            value = !value;
+            writeProperty(m_target, m_property, &value, flags);
+            break;
+        }
+        case IntToDouble: {
+            int value = 0;
+            readProperty(source, m_source, &value);
+            double converted = value;
+            writeProperty(m_target, m_property, &converted, flags);
+            break;
+        }
+        default:
+            switch (m_source.propType) {
+            case QMetaType::Bool:
+                copyProperty<bool>(source, m_source, m_target, m_property, flags);
+                break;
+            case QMetaType::Int:
+                copyProperty<int>(source, m_source, m_target, m_property, flags);
+                break;
+            case QMetaType::Double:
+                copyProperty<double>(source, m_source, m_target, m_property, flags);
+                break;
+            case QMetaType::QString:
+                copyProperty<QString>(source, m_source, m_target, m_property, flags);
+                break;
+            default: {
+                QVariant value(m_source.propType, (const void *)0);
+                readProperty(source, m_source, value.data());
+                writeProperty(m_target, m_property, value.data(), flags);
+                break;
+            }
+            }
+            break;
+        }
+    }
+
+    if (!watcher.wasDeleted())
+        m_updating = false;
+}
+
+void QQmlNativeBinding::refresh()
+{
+    update();
+}
+
+QObject *QQmlNativeBinding::sourceObject() const
+{
+    switch (m_kind) {
+    case ScopeObject:
+        return m_scope;
+    case ContextObject:
+        return context()->contextObject;
+    default:
+        Q_ASSERT(m_idIndex >= 0 && m_idIndex < context()->idValueCount);
+        return context()->idValues[m_idIndex].data();
+    }
+}
+
+void QQmlNativeBinding::subscribe(QObject *source)
+{
+    if (m_source.hasAccessors() && m_source.accessors->notifier) {
+        QQmlNotifier *n = 0;
+        m_source.accessors->notifier(source, m_source.accessorData, &n);
+        if (!n)
+            m_sourceEndpoint.disconnect();
+        else if (!m_sourceEndpoint.isConnected(n))
+            m_sourceEndpoint.connect(n);
+    } else if (m_source.notifyIndex != -1) {
+        if (!m_sourceEndpoint.isConnected(source, m_source.notifyIndex))
+            m_sourceEndpoint.connect(source, m_source.notifyIndex, context()->engine);
+    }
+}
+
+// Mirrors the TypeError the equivalent JavaScript binding would throw
+void QQmlNativeBinding::reportNullSource()
+{
+    QString name = m_expression.mid(m_expression.lastIndexOf(QLatin1Char('.')) + 1);
+
+    QQmlError error;
+    error.setUrl(QUrl(m_url));
+    error.setLine(qmlSourceCoordinate(m_line));
+    error.setColumn(qmlSourceCoordinate(m_column));
+    error.setDescription(QLatin1String("TypeError: Cannot read property '") + name +
+                         QLatin1String("' of null"));
+    QQmlEnginePrivate::warning(context()->engine, error);
+}
+
+QString QQmlNativeBinding::expression() const
+{
+    return m_expression;
+}
+
+int QQmlNativeBinding::propertyIndex() const
+{
+    return m_property.coreIndex;
+}
+
+QObject *QQmlNativeBinding::object() const
+{
+    return m_target;
+}
+
+QString QQmlNativeBinding::expression(const QQmlAbstractBinding *This)
+{
+    return static_cast<const QQmlNativeBinding *>(This)->expression();
+}
+
+int QQmlNativeBinding::propertyIndex(const QQmlAbstractBinding *This)
+{
+    return static_cast<const QQmlNativeBinding *>(This)->propertyIndex();
+}
+
+QObject *QQmlNativeBinding::object(const QQmlAbstractBinding *This)
+{
+    return static_cast<const QQmlNativeBinding *>(This)->object();
+}
+
+void QQmlNativeBinding::setEnabled(QQmlAbstractBinding *This, bool e, QQmlPropertyPrivate::WriteFlags f)
+{
+    static_cast<QQmlNativeBinding *>(This)->setEnabled(e, f);
+}
+
+void QQmlNativeBinding::update(QQmlAbstractBinding *This, QQmlPropertyPrivate::WriteFlags f)
+{
+    static_cast<QQmlNativeBinding *>(This)->update(f);
+}
+
+void QQmlNativeBinding_callback(QQmlNotifierEndpoint *e, void **)
+{
+    QQmlNativeBinding *binding = static_cast<QQmlNativeBinding::Endpoint *>(e)->binding;
+    binding->update();
+}
+
+QT_END_NAMESPACE
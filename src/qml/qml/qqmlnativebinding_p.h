@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QQMLNATIVEBINDING_P_H
+#define QQMLNATIVEBINDING_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <private/qqmlabstractbinding_p.h>
+#include <private/qqmlabstractexpression_p.h>
+#include <private/qqmlnotifier_p.h>
+#include <private/qqmlpropertycache_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// A binding whose expression is a plain property read, such as "value",
+// "someId.value" or "!someId.enabled".  The compiler recognizes these and
+// emits them as native bindings, which copy the source property into the
+// target property with a single metacall instead of running a JavaScript
+// function.
+class Q_QML_PRIVATE_EXPORT QQmlNativeBinding : public QQmlAbstractExpression,
+                                               public QQmlAbstractBinding
+{
+public:
+    enum SourceKind { ScopeObject, ContextObject, IdObject };
+    enum Conversion { NoConversion, IntToDouble, Negate };
+
+    QQmlNativeBinding(QObject *target, const QQmlPropertyRawData &property,
+                      QObject *scope, QQmlContextData *ctxt,
+                      SourceKind kind, int idIndex, const QQmlPropertyRawData &source,
+                      Conversion conversion, const QString &expression,
+                      const QString &url, quint16 line, quint16 column);
+
+    static bool canConvert(int sourceType, int targetType, bool negate, Conversion *conversion);
+
+    void setEnabled(bool, QQmlPropertyPrivate::WriteFlags flags = QQmlPropertyPrivate::DontRemoveBinding);
+    void update(QQmlPropertyPrivate::WriteFlags flags = QQmlPropertyPrivate::DontRemoveBinding);
+
+    QString expression() const;
+    int propertyIndex() const;
+    QObject *object() const;
+
+    // "Inherited" from QQmlAbstractExpression
+    virtual void refresh();
+
+    // "Inherited" from QQmlAbstractBinding
+    static QString expression(const QQmlAbstractBinding *);
+    static int propertyIndex(const QQmlAbstractBinding *);
+    static QObject *object(const QQmlAbstractBinding *);
+    static void setEnabled(QQmlAbstractBinding *, bool, QQmlPropertyPrivate::WriteFlags);
+    static void update(QQmlAbstractBinding *, QQmlPropertyPrivate::WriteFlags);
+
+protected:
+    ~QQmlNativeBinding();
+
+private:
+    friend class QQmlAbstractBinding;
+    friend void QQmlNativeBinding_callback(QQmlNotifierEndpoint *, void **);
+
+    class Endpoint : public QQmlNotifierEndpoint
+    {
+    public:
+        Endpoint(QQmlNativeBinding *b) : binding(b) { setCallback(QQmlNotifierEndpoint::QQmlNativeBinding); }
+        QQmlNativeBinding *binding;
+    };
+
+    QObject *sourceObject() const;
+    void subscribe(QObject *source);
+    void reportNullSource();
+
+    QObject *m_target;
+    QObject *m_scope;
+    QQmlPropertyData m_property;
+    QQmlPropertyData m_source;
+
+    Endpoint m_sourceEndpoint;
+    // Only connected for IdObject sources, notifies when the id is reassigned or deleted
+    Endpoint m_idEndpoint;
+
+    QString m_expression;
+    QString m_url;
+    quint16 m_line;
+    quint16 m_column;
+
+    int m_idIndex;
+    quint8 m_kind;
+    quint8 m_conversion;
+    bool m_enabled:1;
+    bool m_updating:1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLNATIVEBINDING_P_H
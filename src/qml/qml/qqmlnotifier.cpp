@@ -41,7 +41,9 @@
 
 #include "qqmlnotifier_p.h"
 #include "qqmlproperty_p.h"
+#include "qqmldata_p.h"
 #include <QtCore/qdebug.h>
+#include <QtCore/qvarlengtharray.h>
 #include <private/qthread_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -51,15 +53,194 @@ typedef void (*Callback)(QQmlNotifierEndpoint *, void **);
 void QQmlBoundSignal_callback(QQmlNotifierEndpoint *, void **);
 void QQmlJavaScriptExpressionGuard_callback(QQmlNotifierEndpoint *, void **);
 void QQmlVMEMetaObjectEndpoint_callback(QQmlNotifierEndpoint *, void **);
+void QQmlNativeBinding_callback(QQmlNotifierEndpoint *, void **);
 
 static Callback QQmlNotifier_callbacks[] = {
     0,
     QQmlBoundSignal_callback,
     QQmlJavaScriptExpressionGuard_callback,
-    QQmlVMEMetaObjectEndpoint_callback
+    QQmlVMEMetaObjectEndpoint_callback,
+    QQmlNativeBinding_callback
 };
 
+// Contiguous storage for the endpoints of a notifier, used once it has many
+// endpoints.  Walking an array of pointers lets the CPU load the endpoints in
+// parallel, where the linked list forces it to chase one pointer at a time.
+//
+// Endpoints are appended at the end.  Their prev pointer refers to their slot
+// and their next pointer is the tagged array head, so disconnecting clears the
+// slot.  Cleared slots are reused by compacting the array, which is never done
+// while an emission is in progress.  Once the last endpoint disconnects, the
+// array is freed and the notifier goes back to an empty list.
+struct QQmlNotifier::EndpointArray
+{
+    QQmlNotifierEndpoint **endpoints;
+    QQmlNotifierEndpoint **headSlot; // Where the tagged head is stored
+    int count;      // Used slots, including cleared ones
+    int live;       // Connected endpoints
+    int size;       // Allocated slots
+    int emitting;   // Depth of emissions in progress
+    bool *deleted;  // Set if the array is deleted during the innermost emission
+
+    static EndpointArray *get(QQmlNotifierEndpoint *head)
+    { return reinterpret_cast<EndpointArray *>(quintptr(head) & ~quintptr(0x1)); }
+    QQmlNotifierEndpoint *head()
+    { return reinterpret_cast<QQmlNotifierEndpoint *>(quintptr(this) | 0x1); }
+};
+
+void QQmlNotifier::resizeArray(EndpointArray *array, int size)
+{
+    array->endpoints = (QQmlNotifierEndpoint **)realloc(array->endpoints, size * sizeof(QQmlNotifierEndpoint *));
+    array->size = size;
+    for (int ii = 0; ii < array->count; ++ii) {
+        if (QQmlNotifierEndpoint *endpoint = array->endpoints[ii])
+            endpoint->prev = &array->endpoints[ii];
+    }
+}
+
+void QQmlNotifier::compactArray(EndpointArray *array)
+{
+    Q_ASSERT(!array->emitting);
+    int used = 0;
+    for (int ii = 0; ii < array->count; ++ii) {
+        if (QQmlNotifierEndpoint *endpoint = array->endpoints[ii]) {
+            array->endpoints[used] = endpoint;
+            endpoint->prev = &array->endpoints[used];
+            ++used;
+        }
+    }
+    array->count = used;
+}
+
+QQmlNotifier::EndpointArray *QQmlNotifier::promoteToArray(QQmlNotifierEndpoint *head)
+{
+    Q_ASSERT(!isArray(head));
+    QQmlNotifierEndpoint **slot = head->prev;
+    Q_ASSERT(slot && *slot == head);
+
+    int count = 0;
+    for (QQmlNotifierEndpoint *endpoint = head; endpoint; endpoint = endpoint->next)
+        ++count;
+
+    EndpointArray *array = (EndpointArray *)malloc(sizeof(EndpointArray));
+    array->endpoints = 0;
+    array->headSlot = slot;
+    array->count = count;
+    array->live = count;
+    array->size = 0;
+    array->emitting = 0;
+    array->deleted = 0;
+    resizeArray(array, qMax(2 * count, 2 * int(ArrayThreshold)));
+
+    // The list is ordered from the newest to the oldest endpoint, while
+    // arrays are ordered the other way round.
+    QQmlNotifierEndpoint *endpoint = head;
+    for (int ii = count - 1; ii >= 0; --ii) {
+        QQmlNotifierEndpoint *next = endpoint->next;
+        array->endpoints[ii] = endpoint;
+        endpoint->prev = &array->endpoints[ii];
+        endpoint->next = array->head();
+        endpoint = next;
+    }
+
+    *slot = array->head();
+    return array;
+}
+
+void QQmlNotifier::appendToArray(QQmlNotifierEndpoint *head, QQmlNotifierEndpoint *endpoint)
+{
+    Q_ASSERT(isArray(head));
+    Q_ASSERT(!endpoint->isConnected());
+    EndpointArray *array = EndpointArray::get(head);
+
+    if (array->count == array->size) {
+        if (!array->emitting)
+            compactArray(array);
+        if (array->count > array->size - array->size / 4)
+            resizeArray(array, 2 * array->size);
+    }
+
+    array->endpoints[array->count] = endpoint;
+    endpoint->prev = &array->endpoints[array->count];
+    endpoint->next = head;
+    ++array->count;
+    ++array->live;
+}
+
+void QQmlNotifier::removeFromArray(QQmlNotifierEndpoint *endpoint)
+{
+    Q_ASSERT(isArray(endpoint->next));
+    EndpointArray *array = EndpointArray::get(endpoint->next);
+    Q_ASSERT(endpoint->prev && *endpoint->prev == endpoint);
+
+    *endpoint->prev = 0;
+    endpoint->prev = 0;
+    endpoint->next = 0;
+    if (--array->live)
+        return;
+
+    *array->headSlot = 0;
+    if (array->deleted)
+        *array->deleted = true;
+    free(array->endpoints);
+    free(array);
+
+    // The signal may have no endpoints left, let QObject skip its emission again
+    if (endpoint->sourceSignal != -1) {
+        if (QQmlData *ddata = QQmlData::get(endpoint->senderAsObject(), false))
+            ddata->updateConnectionMask(endpoint->sourceSignal);
+    }
+}
+
+void QQmlNotifier::relocateArray(QQmlNotifierEndpoint **slot)
+{
+    Q_ASSERT(isArray(*slot));
+    EndpointArray::get(*slot)->headSlot = slot;
+}
+
+void QQmlNotifier::disconnectArray(QQmlNotifierEndpoint *head)
+{
+    Q_ASSERT(isArray(head));
+    EndpointArray *array = EndpointArray::get(head);
+
+    // Detach the endpoints first, so that disconnecting them does not free the array
+    for (int ii = 0; ii < array->count; ++ii) {
+        if (QQmlNotifierEndpoint *endpoint = array->endpoints[ii]) {
+            endpoint->next = 0;
+            endpoint->disconnect();
+        }
+    }
+
+    if (array->deleted)
+        *array->deleted = true;
+    free(array->endpoints);
+    free(array);
+}
+
+int QQmlNotifier::arrayEndpointCount(QQmlNotifierEndpoint *head)
+{
+    Q_ASSERT(isArray(head));
+    return EndpointArray::get(head)->live;
+}
+
 void QQmlNotifier::emitNotify(QQmlNotifierEndpoint *endpoint, void **a)
+{
+    if (isArray(endpoint)) {
+        emitArrayNotify(EndpointArray::get(endpoint), a);
+        return;
+    }
+
+    int length = 0;
+    for (QQmlNotifierEndpoint *e = endpoint; e && length < ArrayThreshold; e = e->next)
+        ++length;
+
+    if (length == ArrayThreshold)
+        emitArrayNotify(promoteToArray(endpoint), a);
+    else
+        emitListNotify(endpoint, a);
+}
+
+void QQmlNotifier::emitListNotify(QQmlNotifierEndpoint *endpoint, void **a)
 {
     qintptr originalSenderPtr;
     qintptr *disconnectWatch;
@@ -73,7 +254,7 @@ void QQmlNotifier::emitNotify(QQmlNotifierEndpoint *endpoint, void **a)
     }
 
     if (endpoint->next)
-        emitNotify(endpoint->next, a);
+        emitListNotify(endpoint->next, a);
 
     if (*disconnectWatch) {
 
@@ -87,6 +268,68 @@ void QQmlNotifier::emitNotify(QQmlNotifierEndpoint *endpoint, void **a)
     } 
 }
 
+void QQmlNotifier::emitArrayNotify(EndpointArray *array, void **a)
+{
+    // Endpoints connected by the callbacks are not notified by this emission
+    const int count = array->count;
+
+    // As in emitListNotify(), all endpoints are put into the notifying state before
+    // the first callback runs, so that a callback can cancel the notification of a
+    // later endpoint, and disconnecting an endpoint is noticed.
+    struct Watch {
+        qintptr originalSenderPtr;
+        qintptr *disconnectWatch;
+    };
+    QVarLengthArray<Watch, 64> watches(count);
+    for (int ii = 0; ii < count; ++ii) {
+        QQmlNotifierEndpoint *endpoint = array->endpoints[ii];
+        if (!endpoint)
+            continue;
+        Watch &watch = watches[ii];
+        if (!endpoint->isNotifying()) {
+            watch.originalSenderPtr = endpoint->senderPtr;
+            watch.disconnectWatch = &watch.originalSenderPtr;
+            endpoint->senderPtr = qintptr(watch.disconnectWatch) | 0x1;
+        } else {
+            watch.disconnectWatch = (qintptr *)(endpoint->senderPtr & ~0x1);
+        }
+    }
+
+    bool deleted = false;
+    bool *outerDeleted = array->deleted;
+    array->deleted = &deleted;
+    ++array->emitting;
+
+    for (int ii = 0; ii < count; ++ii) {
+        // Re-read the storage, a callback may have connected more endpoints and resized it
+        QQmlNotifierEndpoint *endpoint = array->endpoints[ii];
+        if (!endpoint)
+            continue;
+
+        Watch &watch = watches[ii];
+        if (!*watch.disconnectWatch)
+            continue;
+
+        Q_ASSERT(QQmlNotifier_callbacks[endpoint->callback]);
+        QQmlNotifier_callbacks[endpoint->callback](endpoint, a);
+
+        if (deleted) {
+            // All endpoints were disconnected, which cleared their watches
+            if (outerDeleted)
+                *outerDeleted = true;
+            return;
+        }
+
+        if (watch.disconnectWatch == &watch.originalSenderPtr && watch.originalSenderPtr) {
+            // End of notifying, restore values
+            endpoint->senderPtr = watch.originalSenderPtr;
+        }
+    }
+
+    --array->emitting;
+    array->deleted = outerDeleted;
+}
+
 /*! \internal
     \a sourceSignal MUST be in the signal index range (see QObjectPrivate::signalIndex()).
     This is different from QMetaMethod::methodIndex().
@@ -61,7 +61,25 @@ private:
     friend class QQmlNotifierEndpoint;
     friend class QQmlThreadNotifierProxyObject;
 
+    // A list of endpoints is either an intrusive linked list, or, once it has
+    // been emitted with at least ArrayThreshold endpoints connected, a contiguous
+    // EndpointArray.  In the latter case the head pointer is tagged with 0x1.
+    enum { ArrayThreshold = 8 };
+    struct EndpointArray;
+
+    static inline bool isArray(QQmlNotifierEndpoint *head);
+    static EndpointArray *promoteToArray(QQmlNotifierEndpoint *head);
+    static void resizeArray(EndpointArray *, int size);
+    static void compactArray(EndpointArray *);
+    static void appendToArray(QQmlNotifierEndpoint *head, QQmlNotifierEndpoint *);
+    static void removeFromArray(QQmlNotifierEndpoint *);
+    static void relocateArray(QQmlNotifierEndpoint **slot);
+    static void disconnectArray(QQmlNotifierEndpoint *head);
+    static int arrayEndpointCount(QQmlNotifierEndpoint *head);
+
     static void emitNotify(QQmlNotifierEndpoint *, void **a);
+    static void emitListNotify(QQmlNotifierEndpoint *, void **a);
+    static void emitArrayNotify(EndpointArray *, void **a);
     QQmlNotifierEndpoint *endpoints;
 };
 
@@ -81,7 +99,7 @@ public:
         QQmlBoundSignal = 1,
         QQmlJavaScriptExpressionGuard = 2,
         QQmlVMEMetaObjectEndpoint = 3,
-        QV4BindingsSubscription = 4
+        QQmlNativeBinding = 4
     };
 
     inline void setCallback(Callback c) { callback = c; }
@@ -122,8 +140,19 @@ QQmlNotifier::QQmlNotifier()
 {
 }
 
+bool QQmlNotifier::isArray(QQmlNotifierEndpoint *head)
+{
+    return quintptr(head) & 0x1;
+}
+
 QQmlNotifier::~QQmlNotifier()
 {    
+    if (isArray(endpoints)) {
+        disconnectArray(endpoints);
+        endpoints = 0;
+        return;
+    }
+
     QQmlNotifierEndpoint *endpoint = endpoints;
     while (endpoint) {
         QQmlNotifierEndpoint *n = endpoint;
@@ -179,19 +208,29 @@ void QQmlNotifierEndpoint::connect(QQmlNotifier *notifier)
 {
     disconnect();
 
+    senderPtr = qintptr(notifier);
+    if (QQmlNotifier::isArray(notifier->endpoints)) {
+        QQmlNotifier::appendToArray(notifier->endpoints, this);
+        return;
+    }
+
     next = notifier->endpoints;
     if (next) { next->prev = &next; }
     notifier->endpoints = this;
     prev = &notifier->endpoints;
-    senderPtr = qintptr(notifier);
 }
 
 void QQmlNotifierEndpoint::disconnect()
 {
     // Remove from notifier chain before calling disconnectNotify(), so that that
-    // QObject::receivers() returns the correct value in there
-    if (next) next->prev = prev;
-    if (prev) *prev = next;
+    // QObject::receivers() returns the correct value in there.  Endpoints stored
+    // in an EndpointArray have the tagged array head as next pointer.
+    if (QQmlNotifier::isArray(next)) {
+        QQmlNotifier::removeFromArray(this);
+    } else {
+        if (next) next->prev = prev;
+        if (prev) *prev = next;
+    }
 
     if (sourceSignal != -1) {
         QObject * const obj = senderAsObject();
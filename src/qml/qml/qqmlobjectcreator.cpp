@@ -1099,6 +1099,8 @@ bool QmlObjectCreator::setPropertyValue(QQmlPropertyData *property, int bindingI
         } else {
             QQmlBinding *qmlBinding = new QQmlBinding(function, _qobject, context,
                                                       QString(), 0, 0); // ###
+            if (binding->flags & QV4::CompiledData::Binding::HasStaticDependencies)
+                qmlBinding->setHasStaticDependencies(true);
 
             // When writing bindings to grouped properties implemented as value types,
             // such as point.x: { someExpression; }, then the binding is installed on
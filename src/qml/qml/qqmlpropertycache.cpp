@@ -49,10 +49,13 @@
 #include <private/qmetaobject_p.h>
 #include <private/qqmlaccessors_p.h>
 #include <private/qmetaobjectbuilder_p.h>
+#include <private/qqmlmemoryprofiler_p.h>
+#include <private/qqmlglobal_p.h>
 
 #include <private/qv4value_p.h>
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qmutex.h>
 
 #include <ctype.h> // for toupper
 #include <limits.h>
@@ -134,6 +137,54 @@ static QQmlPropertyData::Flags flagsForPropertyType(int propType, QQmlEngine *en
     return flags;
 }
 
+DEFINE_BOOL_CONFIG_OPTION(disableSharedPropertyCaches, QML_DISABLE_SHARED_PROPERTY_CACHES)
+
+// The property caches of plain C++ meta objects only depend on the meta object,
+// so they are created once and then used by all the engines in the process.
+// Types are still resolved lazily, so that types registered after the cache
+// was built are found. Shared entries are resolved with the mutex locked, and
+// the method arguments are only accessed with the mutex locked.
+struct QQmlSharedPropertyCaches
+{
+    QQmlSharedPropertyCaches() : mutex(QMutex::Recursive) {}
+    ~QQmlSharedPropertyCaches()
+    {
+        for (QHash<const QMetaObject *, QQmlPropertyCache *>::ConstIterator iter = caches.constBegin();
+             iter != caches.constEnd(); ++iter)
+            (*iter)->release();
+    }
+
+    QQmlPropertyCache *cache(const QMetaObject *);
+
+    QMutex mutex;
+    QHash<const QMetaObject *, QQmlPropertyCache *> caches;
+};
+
+Q_GLOBAL_STATIC(QQmlSharedPropertyCaches, sharedPropertyCaches)
+
+// Called with the mutex locked
+QQmlPropertyCache *QQmlSharedPropertyCaches::cache(const QMetaObject *metaObject)
+{
+    QQmlPropertyCache *rv = caches.value(metaObject);
+    if (rv)
+        return rv;
+
+    if (!metaObject->superClass()) {
+        rv = new QQmlPropertyCache;
+        rv->update(0, metaObject);
+    } else {
+        rv = cache(metaObject->superClass())->copyAndAppend(0, metaObject);
+    }
+
+    caches.insert(metaObject, rv);
+    return rv;
+}
+
+static inline QMutex *sharedCacheMutex(const QQmlPropertyCache *cache)
+{
+    return cache->isShared() ? &sharedPropertyCaches()->mutex : 0;
+}
+
 static int metaObjectSignalCount(const QMetaObject *metaObject)
 {
     int signalCount = 0;
@@ -244,7 +295,7 @@ Creates a new empty QQmlPropertyCache.
 QQmlPropertyCache::QQmlPropertyCache(QQmlEngine *e)
 : engine(e), _parent(0), propertyIndexCacheStart(0), methodIndexCacheStart(0),
   signalHandlerIndexCacheStart(0), _hasPropertyOverrides(false), _ownMetaObject(false),
-  _metaObject(0), argumentsCache(0)
+  _shared(false), _metaObject(0), argumentsCache(0)
 {
     Q_ASSERT(engine);
 }
@@ -255,7 +306,7 @@ Creates a new QQmlPropertyCache of \a metaObject.
 QQmlPropertyCache::QQmlPropertyCache(QQmlEngine *e, const QMetaObject *metaObject)
 : engine(e), _parent(0), propertyIndexCacheStart(0), methodIndexCacheStart(0),
   signalHandlerIndexCacheStart(0), _hasPropertyOverrides(false), _ownMetaObject(false),
-  _metaObject(0), argumentsCache(0)
+  _shared(false), _metaObject(0), argumentsCache(0)
 {
     Q_ASSERT(engine);
     Q_ASSERT(metaObject);
@@ -263,6 +314,16 @@ QQmlPropertyCache::QQmlPropertyCache(QQmlEngine *e, const QMetaObject *metaObjec
     update(engine, metaObject);
 }
 
+/*!
+Creates a new empty QQmlPropertyCache that is shared by all engines.
+*/
+QQmlPropertyCache::QQmlPropertyCache()
+: engine(0), _parent(0), propertyIndexCacheStart(0), methodIndexCacheStart(0),
+  signalHandlerIndexCacheStart(0), _hasPropertyOverrides(false), _ownMetaObject(false),
+  _shared(true), _metaObject(0), argumentsCache(0)
+{
+}
+
 QQmlPropertyCache::~QQmlPropertyCache()
 {
     clear();
@@ -289,7 +350,7 @@ QQmlPropertyCache::~QQmlPropertyCache()
 
 void QQmlPropertyCache::destroy()
 {
-    Q_ASSERT(engine);
+    Q_ASSERT(engine || _shared);
     delete this;
 }
 
@@ -300,9 +361,14 @@ void QQmlPropertyCache::clear()
     engine = 0;
 }
 
-QQmlPropertyCache *QQmlPropertyCache::copy(int reserve)
+/*!
+Returns a new cache deriving from this one.  The new cache is shared if \a engine
+is null, which is only allowed if this cache is shared as well.
+*/
+QQmlPropertyCache *QQmlPropertyCache::copy(QQmlEngine *engine, int reserve)
 {
-    QQmlPropertyCache *cache = new QQmlPropertyCache(engine);
+    Q_ASSERT(engine || _shared);
+    QQmlPropertyCache *cache = engine ? new QQmlPropertyCache(engine) : new QQmlPropertyCache;
     cache->_parent = this;
     cache->_parent->addref();
     cache->propertyIndexCacheStart = propertyIndexCache.count() + propertyIndexCacheStart;
@@ -316,15 +382,15 @@ QQmlPropertyCache *QQmlPropertyCache::copy(int reserve)
     return cache;
 }
 
-QQmlPropertyCache *QQmlPropertyCache::copy()
+QQmlPropertyCache *QQmlPropertyCache::copy(QQmlEngine *engine)
 {
-    return copy(0);
+    return copy(engine, 0);
 }
 
-QQmlPropertyCache *QQmlPropertyCache::copyAndReserve(QQmlEngine *, int propertyCount, int methodCount,
+QQmlPropertyCache *QQmlPropertyCache::copyAndReserve(QQmlEngine *engine, int propertyCount, int methodCount,
                                                      int signalCount)
 {
-    QQmlPropertyCache *rv = copy(propertyCount + methodCount + signalCount);
+    QQmlPropertyCache *rv = copy(engine, propertyCount + methodCount + signalCount);
     rv->propertyIndexCache.reserve(propertyCount);
     rv->methodIndexCache.reserve(methodCount);
     rv->signalHandlerIndexCache.reserve(signalCount);
@@ -546,6 +612,39 @@ void QQmlPropertyCache::setParent(QQmlPropertyCache *newParent)
     _parent = newParent;
 }
 
+// Meta objects created by moc live as long as the process, and don't change
+static bool isStaticMetaObject(const QMetaObject *metaObject)
+{
+    for (; metaObject; metaObject = metaObject->superClass()) {
+        if (!metaObject->d.static_metacall || QQmlPropertyCache::isDynamicMetaObject(metaObject))
+            return false;
+    }
+    return true;
+}
+
+/*!
+Returns the process wide cache of \a metaObject, or null if \a metaObject is not
+a static C++ meta object.  Shared caches are immutable, apart from the lazy resolution
+of their entries, and must not be modified.  Use copy() to derive from them.
+
+The returned cache is not referenced, so if it is to be stored, call addref().
+*/
+QQmlPropertyCache *QQmlPropertyCache::sharedCache(const QMetaObject *metaObject)
+{
+    Q_ASSERT(metaObject);
+
+    if (disableSharedPropertyCaches() || !isStaticMetaObject(metaObject))
+        return 0;
+
+    QQmlSharedPropertyCaches *shared = sharedPropertyCaches();
+    if (!shared)
+        return 0;
+
+    QMutexLocker locker(&shared->mutex);
+    QML_MEMORY_SCOPE_STRING("QQmlPropertyCache");
+    return shared->cache(metaObject);
+}
+
 // Returns the first C++ type's QMetaObject - that is, the first QMetaObject not created by
 // QML
 const QMetaObject *QQmlPropertyCache::firstCppMetaObject() const
@@ -576,7 +675,7 @@ QQmlPropertyCache::copyAndAppend(QQmlEngine *engine, const QMetaObject *metaObje
     // Reserve enough space in the name hash for all the methods (including signals), all the
     // signal handlers and all the properties.  This assumes no name clashes, but this is the
     // common case.
-    QQmlPropertyCache *rv = copy(QMetaObjectPrivate::get(metaObject)->methodCount +
+    QQmlPropertyCache *rv = copy(engine, QMetaObjectPrivate::get(metaObject)->methodCount +
                                          QMetaObjectPrivate::get(metaObject)->signalCount +
                                          QMetaObjectPrivate::get(metaObject)->propertyCount);
 
@@ -801,14 +900,33 @@ QQmlPropertyData *QQmlPropertyCache::ensureResolved(QQmlPropertyData *p) const
 
 void QQmlPropertyCache::resolve(QQmlPropertyData *data) const
 {
-    Q_ASSERT(data->notFullyResolved());
+    // Entries found by name may belong to a parent cache, possibly a shared one
+    const QQmlPropertyCache *cache = this;
+    while (cache->_parent && !cache->ownsEntry(data))
+        cache = cache->_parent;
 
-    data->propType = QMetaType::type(data->propTypeName);
+    QMutexLocker locker(sharedCacheMutex(cache));
+    if (!data->notFullyResolved())
+        return; // Resolved by another thread in the meantime
 
+    const int propType = QMetaType::type(data->propTypeName);
+    QQmlPropertyData::Flags flags = data->getFlags() & ~QQmlPropertyData::NotFullyResolved;
     if (!data->isFunction())
-        data->flags |= flagsForPropertyType(data->propType, engine);
+        flags |= flagsForPropertyType(propType, cache->engine);
 
-    data->flags &= ~QQmlPropertyData::NotFullyResolved;
+    data->propType = propType;
+    data->publishResolvedFlags(flags);
+}
+
+bool QQmlPropertyCache::ownsEntry(const QQmlPropertyData *data) const
+{
+    const IndexCache *caches[] = { &propertyIndexCache, &methodIndexCache, &signalHandlerIndexCache };
+    for (int ii = 0; ii < 3; ++ii) {
+        const QQmlPropertyData *begin = caches[ii]->constData();
+        if (data >= begin && data < begin + caches[ii]->count())
+            return true;
+    }
+    return false;
 }
 
 void QQmlPropertyCache::updateRecur(QQmlEngine *engine, const QMetaObject *metaObject)
@@ -823,7 +941,7 @@ void QQmlPropertyCache::updateRecur(QQmlEngine *engine, const QMetaObject *metaO
 
 void QQmlPropertyCache::update(QQmlEngine *engine, const QMetaObject *metaObject)
 {
-    Q_ASSERT(engine);
+    Q_ASSERT(engine || _shared);
     Q_ASSERT(metaObject);
     Q_ASSERT(stringCache.isEmpty());
 
@@ -850,6 +968,8 @@ void QQmlPropertyCache::update(QQmlEngine *engine, const QMetaObject *metaObject
 */
 void QQmlPropertyCache::invalidate(QQmlEngine *engine, const QMetaObject *metaObject)
 {
+    Q_ASSERT(!_shared);
+
     stringCache.clear();
     propertyIndexCache.clear();
     methodIndexCache.clear();
@@ -1094,13 +1214,15 @@ QQmlPropertyCacheMethodArguments *QQmlPropertyCache::createArgumentsObject(int a
     \a index MUST be in the signal index range (see QObjectPrivate::signalIndex()).
     This is different from QMetaMethod::methodIndex().
 */
-QString QQmlPropertyCache::signalParameterStringForJS(int index, QString *errorString)
+QString QQmlPropertyCache::signalParameterStringForJS(QQmlEngine *engine, int index, QString *errorString)
 {
     QQmlPropertyCache *c = 0;
     QQmlPropertyData *signalData = signal(index, &c);
     if (!signalData)
         return QString();
 
+    QMutexLocker locker(sharedCacheMutex(c));
+
     typedef QQmlPropertyCacheMethodArguments A;
 
     if (signalData->arguments) {
@@ -1186,6 +1308,9 @@ int *QQmlPropertyCache::methodParameterTypes(QObject *object, int index,
 
         QQmlPropertyData *rv = const_cast<QQmlPropertyData *>(&c->methodIndexCache.at(index - c->methodIndexCacheStart));
 
+        // The arguments of shared caches may be filled in by another thread,
+        // so they are only read with the lock held
+        QMutexLocker locker(sharedCacheMutex(c));
         if (rv->arguments && static_cast<A *>(rv->arguments)->argumentsValid)
             return static_cast<A *>(rv->arguments)->arguments;
 
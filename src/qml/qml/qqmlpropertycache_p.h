@@ -59,6 +59,7 @@
 #include "qqmlnotifier_p.h"
 
 #include <private/qhashedstring_p.h>
+#include <QtCore/qatomic.h>
 #include <QtCore/qvarlengtharray.h>
 #include <QtCore/qvector.h>
 
@@ -237,7 +238,13 @@ private:
     friend class QQmlPropertyCache;
     void lazyLoad(const QMetaProperty &, QQmlEngine *engine = 0);
     void lazyLoad(const QMetaMethod &);
-    bool notFullyResolved() const { return flags & NotFullyResolved; }
+    // Entries of shared caches are resolved by whichever thread needs them first.
+    // The resolved flags are stored last with release semantics, and read with
+    // acquire semantics, so that an entry seen as resolved is seen with its type.
+    bool notFullyResolved() const
+    { return reinterpret_cast<const QBasicAtomicInt *>(&flags)->loadAcquire() & NotFullyResolved; }
+    void publishResolvedFlags(Flags f)
+    { reinterpret_cast<QBasicAtomicInt *>(&flags)->storeRelease(int(f)); }
 };
 
 class QQmlPropertyCacheMethodArguments;
@@ -251,7 +258,7 @@ public:
     void update(QQmlEngine *, const QMetaObject *);
     void invalidate(QQmlEngine *, const QMetaObject *);
 
-    QQmlPropertyCache *copy();
+    QQmlPropertyCache *copy(QQmlEngine *);
 
     QQmlPropertyCache *copyAndAppend(QQmlEngine *, const QMetaObject *,
                 QQmlPropertyData::Flag propertyFlags = QQmlPropertyData::NoFlags,
@@ -281,6 +288,9 @@ public:
     const QMetaObject *createMetaObject();
     const QMetaObject *firstCppMetaObject() const;
 
+    static QQmlPropertyCache *sharedCache(const QMetaObject *);
+    inline bool isShared() const;
+
     template<typename K>
     QQmlPropertyData *property(const K &key, QObject *object, QQmlContextData *context) const
     {
@@ -317,7 +327,7 @@ public:
     static int originalClone(QObject *, int index);
 
     QList<QByteArray> signalParameterNames(int index) const;
-    QString signalParameterStringForJS(int index, QString *errorString = 0);
+    QString signalParameterStringForJS(QQmlEngine *engine, int index, QString *errorString = 0);
     static QString signalParameterStringForJS(QQmlEngine *engine, const QList<QByteArray> &parameterNameList, QString *errorString = 0);
 
     const char *className() const;
@@ -342,8 +352,11 @@ private:
     friend class QQmlCompiler;
     friend class QQmlPropertyCacheCreator;
     friend class QQmlComponentAndAliasResolver;
+    friend struct QQmlSharedPropertyCaches;
+
+    QQmlPropertyCache();
 
-    inline QQmlPropertyCache *copy(int reserve);
+    inline QQmlPropertyCache *copy(QQmlEngine *, int reserve);
 
     void append(QQmlEngine *, const QMetaObject *, int revision,
                 QQmlPropertyData::Flag propertyFlags = QQmlPropertyData::NoFlags,
@@ -364,6 +377,7 @@ private:
     QQmlPropertyData *ensureResolved(QQmlPropertyData*) const;
 
     void resolve(QQmlPropertyData *) const;
+    bool ownsEntry(const QQmlPropertyData *) const;
     void updateRecur(QQmlEngine *, const QMetaObject *);
 
     template<typename K>
@@ -395,6 +409,7 @@ private:
 
     bool _hasPropertyOverrides : 1;
     bool _ownMetaObject : 1;
+    bool _shared : 1;
     const QMetaObject *_metaObject;
     QByteArray _dynamicClassName;
     QByteArray _dynamicStringData;
@@ -498,6 +513,12 @@ QQmlEngine *QQmlPropertyCache::qmlEngine() const
     return engine;
 }
 
+// Shared caches belong to no engine, see sharedCache()
+bool QQmlPropertyCache::isShared() const
+{
+    return _shared;
+}
+
 int QQmlPropertyCache::propertyCount() const
 {
     return propertyIndexCacheStart + propertyIndexCache.count();
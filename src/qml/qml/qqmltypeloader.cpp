@@ -52,12 +52,14 @@
 #include <private/qqmlprofilerservice_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
 #include <private/qqmlcodegenerator_p.h>
+#include <private/qv4diskcache_p.h>
 
 #include <QtCore/qdir.h>
 #include <QtCore/qfile.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qthread.h>
+#include <QtCore/qrunnable.h>
 #include <QtQml/qqmlfile.h>
 #include <QtCore/qdiriterator.h>
 #include <QtQml/qqmlcomponent.h>
@@ -198,6 +200,76 @@ void QQmlDataLoaderNetworkReplyProxy::manualFinished(QNetworkReply *reply)
 }
 
 
+// Reads a local blob's data and calls QQmlDataBlob::prepareData() in a worker thread.
+// The loader thread collects the result with waitForFinished(), which runs the job
+// inline if no worker has picked it up yet.
+class QQmlDataLoaderPrepareJob : public QQmlRefCount
+{
+public:
+    QQmlDataLoaderPrepareJob(QQmlDataBlob *blob, const QString &fileName)
+    : blob(blob), fileName(fileName), finalUrl(blob->finalUrl()),
+      finalUrlString(blob->finalUrlString()), ok(false), state(Queued) {}
+
+    void run();
+    void waitForFinished();
+
+    QQmlDataBlob *blob;
+    QString fileName;
+    QUrl finalUrl;
+    QString finalUrlString;
+    QByteArray data;
+    QString errorString;
+    bool ok;
+
+private:
+    enum State { Queued, Running, Finished };
+    QAtomicInt state;
+    QMutex mutex;
+    QWaitCondition finished;
+};
+
+class QQmlDataLoaderPrepareRunnable : public QRunnable
+{
+public:
+    QQmlDataLoaderPrepareRunnable(QQmlDataLoaderPrepareJob *job)
+    : job(job) { job->addref(); }
+    ~QQmlDataLoaderPrepareRunnable() { job->release(); }
+
+    virtual void run() { job->run(); }
+
+private:
+    QQmlDataLoaderPrepareJob *job;
+};
+
+void QQmlDataLoaderPrepareJob::run()
+{
+    if (!state.testAndSetOrdered(Queued, Running))
+        return;
+
+    QFile file(fileName);
+    if (file.open(QFile::ReadOnly)) {
+        data = file.readAll();
+        ok = true;
+        blob->prepareData(data, finalUrl, finalUrlString);
+    } else {
+        errorString = file.errorString();
+    }
+
+    QMutexLocker locker(&mutex);
+    state.store(Finished);
+    finished.wakeAll();
+}
+
+void QQmlDataLoaderPrepareJob::waitForFinished()
+{
+    // Steal the job if no worker has started it yet
+    run();
+
+    QMutexLocker locker(&mutex);
+    while (state.load() != Finished)
+        finished.wait(&mutex);
+}
+
 /*!
 \class QQmlDataBlob
 \brief The QQmlDataBlob encapsulates a data request that can be issued to a QQmlDataLoader.
@@ -480,6 +552,22 @@ The default implementation does nothing.
 XXX Rename processData() or some such to avoid confusion between done() (processing thread)
 and completed() (main thread)
 */
+/*!
+Invoked with the raw \a data of a local file in a worker thread of the QQmlDataLoader, before
+dataReceived() is called with the same data in the loader thread.  \a finalUrl and
+\a finalUrlString are the values of finalUrl() and finalUrlString(), which may not be called
+from the worker thread.
+
+Derived classes can override this to move work that does not touch the engine, such as
+parsing, out of the loader thread.  The implementation must not call any other method of
+the blob or the loader.  The default implementation does nothing.
+
+\sa QQmlDataLoader::setWorkerThreadCount()
+*/
+void QQmlDataBlob::prepareData(const QByteArray &, const QUrl &, const QString &)
+{
+}
+
 void QQmlDataBlob::done()
 {
 }
@@ -877,8 +965,15 @@ Thus QQmlDataBlob::done() will always eventually be called, even if the blob has
 Create a new QQmlDataLoader for \a engine.
 */
 QQmlDataLoader::QQmlDataLoader(QQmlEngine *engine)
-: m_engine(engine), m_thread(new QQmlDataLoaderThread(this))
+: m_engine(engine), m_thread(new QQmlDataLoaderThread(this)), m_setDataDepth(0),
+  m_workerThreadCount(QThread::idealThreadCount())
 {
+    if (qEnvironmentVariableIsSet("QML_LOADER_WORKER_THREADS"))
+        m_workerThreadCount = qgetenv("QML_LOADER_WORKER_THREADS").toInt();
+    if (m_workerThreadCount < 0)
+        m_workerThreadCount = 0;
+    if (m_workerThreadCount > 0)
+        m_workerPool.setMaxThreadCount(m_workerThreadCount);
 }
 
 /*! \internal */
@@ -889,6 +984,8 @@ QQmlDataLoader::~QQmlDataLoader()
 
     shutdownThread();
     delete m_thread;
+
+    m_workerPool.waitForDone();
 }
 
 void QQmlDataLoader::lock()
@@ -916,7 +1013,8 @@ void QQmlDataLoader::load(QQmlDataBlob *blob, Mode mode)
 
     if (m_thread->isThisThread()) {
         unlock();
-        loadThread(blob);
+        if (!loadConcurrently(blob))
+            loadThread(blob);
         lock();
     } else if (mode == PreferSynchronous) {
         unlock();
@@ -1048,6 +1146,76 @@ void QQmlDataLoader::loadThread(QQmlDataBlob *blob)
     }
 }
 
+/*
+Blobs requested while another blob is inside its setData() callback are dependencies of that
+blob.  Instead of loading them recursively one after the other, local QML and JavaScript files
+are read and prepared by the worker pool, and delivered by loadPreparedBlobs() in request order
+once the outermost setData() returns.  The blobs are still done() by the time the synchronous
+load that triggered them returns.
+
+Returns false if \a blob must be loaded by loadThread() instead.
+*/
+bool QQmlDataLoader::loadConcurrently(QQmlDataBlob *blob)
+{
+    ASSERT_LOADTHREAD();
+
+    if (m_setDataDepth == 0 || m_workerThreadCount == 0 || m_thread->isShutdown())
+        return false;
+
+    if (blob->type() != QQmlDataBlob::QmlFile && blob->type() != QQmlDataBlob::JavaScriptFile)
+        return false;
+
+    const QString fileName = QQmlFile::urlToLocalFileOrQrc(blob->m_url);
+    if (fileName.isEmpty())
+        return false;
+
+    if (!QQmlEnginePrivate::get(m_engine)->debugChangesCache().isEmpty())
+        return false;
+
+    blob->addref();
+
+    PreparedBlob prepared;
+    prepared.blob = blob;
+    prepared.job = new QQmlDataLoaderPrepareJob(blob, fileName);
+    m_preparedBlobs.append(prepared);
+
+    m_workerPool.start(new QQmlDataLoaderPrepareRunnable(prepared.job));
+    return true;
+}
+
+void QQmlDataLoader::loadPreparedBlobs()
+{
+    ASSERT_LOADTHREAD();
+
+    // Blobs loaded here may defer further dependencies, which are appended to the list
+    while (!m_preparedBlobs.isEmpty()) {
+        PreparedBlob prepared = m_preparedBlobs.takeFirst();
+        QQmlDataBlob *blob = prepared.blob;
+        QQmlDataLoaderPrepareJob *job = prepared.job;
+
+        job->waitForFinished();
+
+        QML_MEMORY_SCOPE_URL(blob->m_url);
+        if (m_thread->isShutdown()) {
+            QQmlError error;
+            error.setDescription(QLatin1String("Interrupted by shutdown"));
+            blob->setError(error);
+        } else if (job->ok) {
+            blob->m_data.setProgress(0xFF);
+            if (blob->m_data.isAsync())
+                m_thread->callDownloadProgressChanged(blob, 1.);
+
+            setData(blob, job->data);
+        } else {
+            // Let loadThread() report the error the usual way
+            loadThread(blob);
+        }
+
+        job->release();
+        blob->release();
+    }
+}
+
 #define DATALOADER_MAXIMUM_REDIRECT_RECURSION 16
 
 void QQmlDataLoader::networkReplyFinished(QNetworkReply *reply)
@@ -1131,6 +1299,29 @@ void QQmlDataLoader::initializeEngine(QQmlExtensionInterface *iface,
     }
 }
 
+/*!
+Returns the number of worker threads used to read and parse local QML and JavaScript
+files concurrently.
+
+The default is QThread::idealThreadCount(), and can be overridden with the
+QML_LOADER_WORKER_THREADS environment variable.
+*/
+int QQmlDataLoader::workerThreadCount() const
+{
+    return m_workerThreadCount;
+}
+
+/*!
+Sets the number of worker threads to \a count.  A count of 0 loads all blobs in the
+loader thread.
+*/
+void QQmlDataLoader::setWorkerThreadCount(int count)
+{
+    m_workerThreadCount = qMax(0, count);
+    if (m_workerThreadCount > 0)
+        m_workerPool.setMaxThreadCount(m_workerThreadCount);
+}
+
 
 void QQmlDataLoader::setData(QQmlDataBlob *blob, const QByteArray &data)
 {
@@ -1151,6 +1342,7 @@ void QQmlDataLoader::setData(QQmlDataBlob *blob, QQmlFile *file)
 void QQmlDataLoader::setData(QQmlDataBlob *blob, const QQmlDataBlob::Data &d)
 {
     QML_MEMORY_SCOPE_URL(blob->url());
+    ++m_setDataDepth;
     blob->m_inCallback = true;
 
     blob->dataReceived(d);
@@ -1164,6 +1356,10 @@ void QQmlDataLoader::setData(QQmlDataBlob *blob, const QQmlDataBlob::Data &d)
     blob->m_inCallback = false;
 
     blob->tryDone();
+
+    if (m_setDataDepth == 1)
+        loadPreparedBlobs();
+    --m_setDataDepth;
 }
 
 void QQmlDataLoader::shutdownThread()
@@ -1647,7 +1843,7 @@ void QQmlTypeLoader::addBundle(const QString &identifier, const QString &fileNam
 void QQmlTypeLoader::addBundleNoLock(const QString &identifier, const QString &fileName)
 {
     QQmlBundleData *data = new QQmlBundleData(fileName);
-    if (data->open()) {
+    if (data->open(QIODevice::ReadOnly)) {
 
         m_bundleCache.insert(identifier, data);
 
@@ -1964,7 +2160,8 @@ QQmlTypeData::TypeDataCallback::~TypeDataCallback()
 
 QQmlTypeData::QQmlTypeData(const QUrl &url, QQmlTypeLoader *manager)
 : QQmlTypeLoader::Blob(url, QmlFile, manager),
-   m_typesResolved(false), m_compiledData(0), m_implicitImport(0), m_implicitImportLoaded(false)
+   m_typesResolved(false), m_compiledData(0), m_implicitImport(0), m_implicitImportLoaded(false),
+   m_parsed(false)
 {
     m_useNewCompiler = QQmlEnginePrivate::get(manager->engine())->useNewCompiler;
 }
@@ -2147,25 +2344,40 @@ bool QQmlTypeData::loadImplicitImport()
     return true;
 }
 
-void QQmlTypeData::dataReceived(const Data &data)
+void QQmlTypeData::parse(const QString &code, const QByteArray &preparseData, const QUrl &url, const QString &urlString)
 {
-    QString code = QString::fromUtf8(data.data(), data.size());
-    QByteArray preparseData;
-
-    if (data.isFile()) preparseData = data.asFile()->metaData(QLatin1String("qml:preparse"));
+    m_parsed = true;
 
     if (m_useNewCompiler) {
         parsedQML.reset(new QtQml::ParsedQML(QV8Engine::getV4(typeLoader()->engine())->debugger != 0));
         QQmlCodeGenerator compiler;
-        if (!compiler.generateFromQml(code, finalUrl(), finalUrlString(), parsedQML.data())) {
-            setError(compiler.errors);
-            return;
-        }
+        if (!compiler.generateFromQml(code, url, urlString, parsedQML.data()))
+            m_parseErrors = compiler.errors;
     } else {
-        if (!scriptParser.parse(code, preparseData, finalUrl(), finalUrlString())) {
-            setError(scriptParser.errors());
-            return;
-        }
+        if (!scriptParser.parse(code, preparseData, url, urlString))
+            m_parseErrors = scriptParser.errors();
+    }
+}
+
+void QQmlTypeData::prepareData(const QByteArray &data, const QUrl &finalUrl, const QString &finalUrlString)
+{
+    parse(QString::fromUtf8(data), QByteArray(), finalUrl, finalUrlString);
+}
+
+void QQmlTypeData::dataReceived(const Data &data)
+{
+    if (!m_parsed) {
+        QString code = QString::fromUtf8(data.data(), data.size());
+        QByteArray preparseData;
+
+        if (data.isFile()) preparseData = data.asFile()->metaData(QLatin1String("qml:preparse"));
+
+        parse(code, preparseData, finalUrl(), finalUrlString());
+    }
+
+    if (!m_parseErrors.isEmpty()) {
+        setError(m_parseErrors);
+        return;
     }
 
     m_imports.setBaseUrl(finalUrl(), finalUrlString());
@@ -2841,12 +3053,16 @@ void QQmlScriptData::clear()
 }
 
 QQmlScriptBlob::QQmlScriptBlob(const QUrl &url, QQmlTypeLoader *loader)
-: QQmlTypeLoader::Blob(url, JavaScriptFile, loader), m_scriptData(0)
+: QQmlTypeLoader::Blob(url, JavaScriptFile, loader), m_metaDataExtracted(false), m_compiled(false),
+  m_compiledUnit(0), m_scriptData(0)
 {
 }
 
 QQmlScriptBlob::~QQmlScriptBlob()
 {
+    if (m_compiledUnit)
+        m_compiledUnit->deref();
+
     if (m_scriptData) {
         m_scriptData->release();
         m_scriptData = 0;
@@ -2863,19 +3079,52 @@ QQmlScriptData *QQmlScriptBlob::scriptData() const
     return m_scriptData;
 }
 
+void QQmlScriptBlob::extractMetaData(const QByteArray &data, const QUrl &url)
+{
+    m_metaDataExtracted = true;
+
+    m_source = QString::fromUtf8(data);
+    m_metadata = QQmlScript::Parser::extractMetaData(m_source, &m_metaDataError);
+    if (m_metaDataError.isValid())
+        m_metaDataError.setUrl(url);
+}
+
+// Compiles m_source, which extractMetaData() has stripped of the .pragma and .import lines.
+// Only uses the engine's compiler, so it can run in a worker thread.
+void QQmlScriptBlob::compile(const QUrl &url)
+{
+    m_compiled = true;
+
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(m_typeLoader->engine());
+    m_compiledUnit = QV4::DiskCache::load(v4, url, m_source);
+    if (!m_compiledUnit) {
+        m_compiledUnit = QV4::Script::precompile(v4, url, m_source, &m_compileErrors);
+        if (m_compiledUnit)
+            QV4::DiskCache::save(v4, url, m_source, m_compiledUnit);
+    }
+    if (m_compiledUnit)
+        m_compiledUnit->ref();
+    m_source.clear();
+}
+
+void QQmlScriptBlob::prepareData(const QByteArray &data, const QUrl &finalUrl, const QString &)
+{
+    extractMetaData(data, finalUrl);
+    if (!m_metaDataError.isValid())
+        compile(finalUrl);
+}
+
 void QQmlScriptBlob::dataReceived(const Data &data)
 {
-    m_source = QString::fromUtf8(data.data(), data.size());
+    if (!m_metaDataExtracted)
+        extractMetaData(QByteArray::fromRawData(data.data(), data.size()), finalUrl());
 
     m_scriptData = new QQmlScriptData();
     m_scriptData->url = finalUrl();
     m_scriptData->urlString = finalUrlString();
 
-    QQmlError metaDataError;
-    m_metadata = QQmlScript::Parser::extractMetaData(m_source, &metaDataError);
-    if (metaDataError.isValid()) {
-        metaDataError.setUrl(finalUrl());
-        setError(metaDataError);
+    if (m_metaDataError.isValid()) {
+        setError(m_metaDataError);
         return;
     }
 
@@ -2940,14 +3189,14 @@ void QQmlScriptBlob::done()
 
     m_scriptData->pragmas = m_metadata.pragmas;
 
-    QList<QQmlError> errors;
-    QV4::ExecutionEngine *v4 = QV8Engine::getV4(m_typeLoader->engine());
-    m_scriptData->m_precompiledScript = QV4::Script::precompile(v4, m_scriptData->url, m_source, &errors);
-    if (m_scriptData->m_precompiledScript)
-        m_scriptData->m_precompiledScript->ref();
-    m_source.clear();
-    if (!errors.isEmpty()) {
-        setError(errors);
+    if (!m_compiled)
+        compile(m_scriptData->url);
+
+    // Hand the reference taken by compile() over to the script data
+    m_scriptData->m_precompiledScript = m_compiledUnit;
+    m_compiledUnit = 0;
+    if (!m_compileErrors.isEmpty()) {
+        setError(m_compileErrors);
         return;
     }
 }
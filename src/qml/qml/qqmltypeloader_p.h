@@ -55,6 +55,7 @@
 
 #include <QtCore/qobject.h>
 #include <QtCore/qatomic.h>
+#include <QtCore/qthreadpool.h>
 #include <QtNetwork/qnetworkreply.h>
 #include <QtQml/qqmlerror.h>
 #include <QtQml/qqmlengine.h>
@@ -153,6 +154,9 @@ protected:
     void setError(const QList<QQmlError> &errors);
     void addDependency(QQmlDataBlob *);
 
+    // Callback made in a worker thread of the loader
+    virtual void prepareData(const QByteArray &, const QUrl &, const QString &);
+
     // Callbacks made in load thread
     virtual void dataReceived(const Data &) = 0;
     virtual void done();
@@ -167,6 +171,7 @@ protected:
 private:
     friend class QQmlDataLoader;
     friend class QQmlDataLoaderThread;
+    friend class QQmlDataLoaderPrepareJob;
 
     void tryDone();
     void cancelAllWaitingFor();
@@ -213,6 +218,7 @@ private:
 };
 
 class QQmlDataLoaderThread;
+class QQmlDataLoaderPrepareJob;
 class QQmlDataLoader
 {
 public:
@@ -232,6 +238,9 @@ public:
     QQmlEngine *engine() const;
     void initializeEngine(QQmlExtensionInterface *, const char *);
 
+    int workerThreadCount() const;
+    void setWorkerThreadCount(int);
+
 protected:
     void shutdownThread();
 
@@ -241,6 +250,8 @@ private:
     friend class QQmlDataLoaderNetworkReplyProxy;
 
     void loadThread(QQmlDataBlob *);
+    bool loadConcurrently(QQmlDataBlob *);
+    void loadPreparedBlobs();
     void loadWithStaticDataThread(QQmlDataBlob *, const QByteArray &);
     void networkReplyFinished(QNetworkReply *);
     void networkReplyProgress(QNetworkReply *, qint64, qint64);
@@ -251,9 +262,21 @@ private:
     void setData(QQmlDataBlob *, QQmlFile *);
     void setData(QQmlDataBlob *, const QQmlDataBlob::Data &);
 
+    struct PreparedBlob {
+        QQmlDataBlob *blob;
+        QQmlDataLoaderPrepareJob *job;
+    };
+
     QQmlEngine *m_engine;
     QQmlDataLoaderThread *m_thread;
     NetworkReplies m_networkReplies;
+
+    // Blobs whose data is read and prepared by m_workerPool, delivered in order once the
+    // outermost setData() callback returns
+    QList<PreparedBlob> m_preparedBlobs;
+    int m_setDataDepth;
+    int m_workerThreadCount;
+    QThreadPool m_workerPool;
 };
 
 class QQmlBundleData : public QQmlBundle,
@@ -444,11 +467,13 @@ public:
 protected:
     virtual void done();
     virtual void completed();
+    virtual void prepareData(const QByteArray &, const QUrl &, const QString &);
     virtual void dataReceived(const Data &);
     virtual void allDependenciesDone();
     virtual void downloadProgressChanged(qreal);
 
 private:
+    void parse(const QString &code, const QByteArray &preparseData, const QUrl &url, const QString &urlString);
     void resolveTypes();
     void compile();
     bool resolveType(const QQmlScript::TypeReference *parserRef, int &majorVersion, int &minorVersion, TypeReference &ref);
@@ -484,6 +509,10 @@ private:
     QQmlScript::Import *m_implicitImport;
     bool m_implicitImportLoaded;
     bool loadImplicitImport();
+
+    // Set by parse(), which may run in a worker thread before dataReceived()
+    bool m_parsed;
+    QList<QQmlError> m_parseErrors;
 };
 
 // QQmlScriptData instances are created, uninitialized, by the loader in the 
@@ -551,14 +580,26 @@ public:
     QQmlScriptData *scriptData() const;
 
 protected:
+    virtual void prepareData(const QByteArray &, const QUrl &, const QString &);
     virtual void dataReceived(const Data &);
     virtual void done();
 
 private:
     virtual void scriptImported(QQmlScriptBlob *blob, const QQmlScript::Location &location, const QString &qualifier, const QString &nameSpace);
 
+    void extractMetaData(const QByteArray &data, const QUrl &url);
+    void compile(const QUrl &url);
+
     QString m_source;
     QQmlScript::Parser::JavaScriptMetaData m_metadata;
+    QQmlError m_metaDataError;
+
+    // Set by extractMetaData() and compile(), which may run in a worker thread before
+    // dataReceived()
+    bool m_metaDataExtracted;
+    bool m_compiled;
+    QV4::CompiledData::CompilationUnit *m_compiledUnit;
+    QList<QQmlError> m_compileErrors;
 
     QList<ScriptReference> m_scripts;
     QQmlScriptData *m_scriptData;
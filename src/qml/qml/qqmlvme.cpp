@@ -64,6 +64,7 @@
 #include "qqmlscriptstring_p.h"
 #include "qqmlpropertyvalueinterceptor_p.h"
 #include "qqmlvaluetypeproxybinding_p.h"
+#include "qqmlnativebinding_p.h"
 #include "qqmlexpression_p.h"
 #include "qqmlcontextwrapper_p.h"
 
@@ -862,6 +863,8 @@ QObject *QQmlVME::run(QList<QQmlError> *errors,
             tmpValue = QV4::FunctionObject::creatScriptFunction(qmlContext, runtimeFunction);
 
             QQmlBinding *bind = new QQmlBinding(tmpValue, context, CTXT, COMP->name, instr.line, instr.column);
+            if (runtimeFunction->compiledFunction->flags & QV4::CompiledData::Function::HasStaticQmlDependencies)
+                bind->setHasStaticDependencies(true);
             bindValues.push(bind);
             bind->m_mePtr = &bindValues.top();
             bind->setTarget(target, instr.property, CTXT);
@@ -890,6 +893,32 @@ QObject *QQmlVME::run(QList<QQmlError> *errors,
             }
         QML_END_INSTR(StoreBinding)
 
+        QML_BEGIN_INSTR(StoreNativeBinding)
+            QObject *target = objects.top();
+            QObject *scope =
+                objects.at(objects.count() - 1 - instr.context);
+
+            if (instr.isRoot && BINDINGSKIPLIST.testBit(instr.property.coreIndex))
+                QML_NEXT_INSTR(StoreNativeBinding);
+
+            QQmlNativeBinding *bind =
+                new QQmlNativeBinding(target, instr.property, scope, CTXT,
+                                      QQmlNativeBinding::SourceKind(instr.sourceKind), instr.idIndex,
+                                      instr.source, QQmlNativeBinding::Conversion(instr.conversion),
+                                      PRIMITIVES.at(instr.expression), COMP->name, instr.line, instr.column);
+            bindValues.push(bind);
+            bind->m_mePtr = &bindValues.top();
+
+            typedef QQmlPropertyPrivate QDPP;
+            CLEAN_PROPERTY(target, QDPP::bindingIndex(instr.property));
+
+            bind->addToObject();
+
+            QQmlData *data = QQmlData::get(target);
+            Q_ASSERT(data);
+            data->setPendingBindingBit(target, instr.property.coreIndex);
+        QML_END_INSTR(StoreNativeBinding)
+
         QML_BEGIN_INSTR(StoreValueSource)
             QObject *obj = objects.pop();
             QQmlPropertyValueSource *vs = reinterpret_cast<QQmlPropertyValueSource *>(reinterpret_cast<char *>(obj) + instr.castValue);
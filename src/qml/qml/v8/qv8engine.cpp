@@ -75,6 +75,7 @@
 #include <private/qv4objectproto_p.h>
 #include <private/qv4globalobject_p.h>
 #include <private/qv4regexpobject_p.h>
+#include <private/qv4arraybuffer_p.h>
 #include <private/qv4variantobject_p.h>
 #include <private/qv4script_p.h>
 #include <private/qv4include_p.h>
@@ -150,6 +151,8 @@ QVariant QV8Engine::toVariant(const QV4::ValueRef value, int typeHint)
             return qVariantFromValue<QObject *>(wrapper->object());
         } else if (object->as<QV4::QmlContextWrapper>()) {
             return QVariant();
+        } else if (QV4::ArrayBuffer *ab = object->as<QV4::ArrayBuffer>()) {
+            return ab->asByteArray();
         } else if (QV4::QmlTypeWrapper *w = object->as<QV4::QmlTypeWrapper>()) {
             return w->toVariant();
         } else if (QV4::QmlValueTypeWrapper *v = object->as<QV4::QmlValueTypeWrapper>()) {
@@ -196,8 +199,11 @@ static QV4::ReturnedValue arrayFromStringList(QV8Engine *engine, const QStringLi
     QV4::Scoped<QV4::ArrayObject> a(scope, e->newArrayObject());
     int len = list.count();
     a->arrayReserve(len);
+    QV4::ScopedValue v(scope);
     for (int ii = 0; ii < len; ++ii) {
-        a->arrayData[ii].value = QV4::Encode(e->newString(list.at(ii)));
+        v = e->newString(list.at(ii));
+        a->writeBarrier();
+        a->arrayData[ii].value = v.asReturnedValue();
         a->arrayDataLen = ii + 1;
     }
     a->setArrayLengthUnchecked(len);
@@ -211,8 +217,11 @@ static QV4::ReturnedValue arrayFromVariantList(QV8Engine *engine, const QVariant
     QV4::Scoped<QV4::ArrayObject> a(scope, e->newArrayObject());
     int len = list.count();
     a->arrayReserve(len);
+    QV4::ScopedValue v(scope);
     for (int ii = 0; ii < len; ++ii) {
-        a->arrayData[ii].value = engine->fromVariant(list.at(ii));
+        v = engine->fromVariant(list.at(ii));
+        a->writeBarrier();
+        a->arrayData[ii].value = v.asReturnedValue();
         a->arrayDataLen = ii + 1;
     }
     a->setArrayLengthUnchecked(len);
@@ -325,8 +334,11 @@ QV4::ReturnedValue QV8Engine::fromVariant(const QVariant &variant)
             const QList<QObject *> &list = *(QList<QObject *>*)ptr;
             QV4::Scoped<QV4::ArrayObject> a(scope, m_v4Engine->newArrayObject());
             a->arrayReserve(list.count());
+            QV4::ScopedValue v(scope);
             for (int ii = 0; ii < list.count(); ++ii) {
-                a->arrayData[ii].value = QV4::QObjectWrapper::wrap(m_v4Engine, list.at(ii));
+                v = QV4::QObjectWrapper::wrap(m_v4Engine, list.at(ii));
+                a->writeBarrier();
+                a->arrayData[ii].value = v.asReturnedValue();
                 a->arrayDataLen = ii + 1;
             }
             a->setArrayLengthUnchecked(list.count());
@@ -379,6 +391,7 @@ QQmlContextData *QV8Engine::callingContext()
 // Array -> QVariantList(...)
 // Date -> QVariant(QDateTime)
 // RegExp -> QVariant(QRegExp)
+// ArrayBuffer -> QVariant(QByteArray)
 // [Any other object] -> QVariantMap(...)
 QVariant QV8Engine::toBasicVariant(const QV4::ValueRef value)
 {
@@ -402,6 +415,8 @@ QVariant QV8Engine::toBasicVariant(const QV4::ValueRef value)
 
     if (QV4::RegExpObject *re = o->as<QV4::RegExpObject>())
         return re->toQRegExp();
+    if (QV4::ArrayBuffer *ab = o->as<QV4::ArrayBuffer>())
+        return ab->asByteArray();
     if (o->asArrayObject()) {
         QV4::ScopedArrayObject a(scope, o);
         QV4::ScopedValue v(scope);
@@ -541,8 +556,11 @@ QV4::ReturnedValue QV8Engine::variantListToJS(const QVariantList &lst)
     QV4::Scope scope(m_v4Engine);
     QV4::Scoped<QV4::ArrayObject> a(scope, m_v4Engine->newArrayObject());
     a->arrayReserve(lst.size());
+    QV4::ScopedValue v(scope);
     for (int i = 0; i < lst.size(); i++) {
-        a->arrayData[i].value = variantToJS(lst.at(i));
+        v = variantToJS(lst.at(i));
+        a->writeBarrier();
+        a->arrayData[i].value = v.asReturnedValue();
         a->arrayDataLen = i + 1;
     }
     a->setArrayLengthUnchecked(lst.size());
@@ -752,6 +770,11 @@ bool QV8Engine::metaTypeFromJS(const QV4::ValueRef value, int type, void *data)
         else
             *reinterpret_cast<QString*>(data) = value->toString(m_v4Engine->currentContext())->toQString();
         return true;
+    case QMetaType::QByteArray:
+        if (QV4::ArrayBuffer *ab = value->as<QV4::ArrayBuffer>()) {
+            *reinterpret_cast<QByteArray*>(data) = ab->asByteArray();
+            return true;
+        } break;
     case QMetaType::Float:
         *reinterpret_cast<float*>(data) = value->toNumber();
         return true;
@@ -958,6 +981,8 @@ QVariant QV8Engine::variantFromJS(const QV4::ValueRef value,
         return re->toQRegExp();
     if (QV4::VariantObject *v = value->as<QV4::VariantObject>())
         return v->data;
+    if (QV4::ArrayBuffer *ab = value->as<QV4::ArrayBuffer>())
+        return ab->asByteArray();
     if (value->as<QV4::QObjectWrapper>())
         return qVariantFromValue(qtObjectFromJS(value));
     if (QV4::QmlValueTypeWrapper *v = value->as<QV4::QmlValueTypeWrapper>())
@@ -53,6 +53,7 @@
 #include <QtCore/qmutex.h>
 #include <QtCore/qwaitcondition.h>
 #include <QtCore/qfile.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qdatetime.h>
 #include <QtNetwork/qnetworkaccessmanager.h>
 #include <QtQml/qqmlinfo.h>
@@ -74,15 +75,16 @@ class WorkerDataEvent : public QEvent
 public:
     enum Type { WorkerData = QEvent::User };
 
-    WorkerDataEvent(int workerId, const QByteArray &data);
+    WorkerDataEvent(int workerId, const QV4::Serialize::Data &data);
     virtual ~WorkerDataEvent();
 
     int workerId() const;
-    QByteArray data() const;
+    // the receiver takes the contents, see Serialize::Deserializer
+    QV4::Serialize::Data &data();
 
 private:
     int m_id;
-    QByteArray m_data;
+    QV4::Serialize::Data m_data;
 };
 
 class WorkerLoadEvent : public QEvent
@@ -126,6 +128,13 @@ private:
     QQmlError m_error;
 };
 
+// Posted to a QQuickWorkerScript to continue deserializing received messages
+enum { WorkerDeserializeEvent = WorkerErrorEvent::WorkerError + 1 };
+
+// How long a QQuickWorkerScript may block its thread deserializing messages
+// before it yields to the event loop, in milliseconds
+static const int deserializeBudget = 5;
+
 class QQuickWorkerScriptEnginePrivate : public QObject
 {
     Q_OBJECT
@@ -190,7 +199,7 @@ protected:
     virtual bool event(QEvent *);
 
 private:
-    void processMessage(int, const QByteArray &);
+    void processMessage(int, QV4::Serialize::Data &);
     void processLoad(int, const QUrl &);
     void reportScriptException(WorkerScript *, const QQmlError &error);
 };
@@ -222,8 +231,8 @@ void QQuickWorkerScriptEnginePrivate::WorkerEngine::init()
 #define SEND_MESSAGE_CREATE_SCRIPT \
     "(function(method, engine) { "\
         "return (function(id) { "\
-            "return (function(message) { "\
-                "if (arguments.length) method(engine, id, message); "\
+            "return (function(message, transfer) { "\
+                "if (arguments.length) method(engine, id, message, transfer); "\
             "}); "\
         "}); "\
     "})"
@@ -289,7 +298,8 @@ QV4::ReturnedValue QQuickWorkerScriptEnginePrivate::method_sendMessage(QV4::Call
 
     QV4::Scope scope(ctx);
     QV4::ScopedValue v(scope, ctx->callData->argument(2));
-    QByteArray data = QV4::Serialize::serialize(v, engine);
+    QV4::ScopedValue transfer(scope, ctx->callData->argument(3));
+    QV4::Serialize::Data data = QV4::Serialize::serialize(v, engine, transfer);
 
     QMutexLocker locker(&engine->p->m_lock);
     WorkerScript *script = engine->p->workers.value(id);
@@ -347,7 +357,7 @@ bool QQuickWorkerScriptEnginePrivate::event(QEvent *event)
     }
 }
 
-void QQuickWorkerScriptEnginePrivate::processMessage(int id, const QByteArray &data)
+void QQuickWorkerScriptEnginePrivate::processMessage(int id, QV4::Serialize::Data &data)
 {
     WorkerScript *script = workers.value(id);
     if (!script)
@@ -421,7 +431,7 @@ void QQuickWorkerScriptEnginePrivate::reportScriptException(WorkerScript *script
         QCoreApplication::postEvent(script->owner, new WorkerErrorEvent(error));
 }
 
-WorkerDataEvent::WorkerDataEvent(int workerId, const QByteArray &data)
+WorkerDataEvent::WorkerDataEvent(int workerId, const QV4::Serialize::Data &data)
 : QEvent((QEvent::Type)WorkerData), m_id(workerId), m_data(data)
 {
 }
@@ -435,7 +445,7 @@ int WorkerDataEvent::workerId() const
     return m_id;
 }
 
-QByteArray WorkerDataEvent::data() const
+QV4::Serialize::Data &WorkerDataEvent::data()
 {
     return m_data;
 }
@@ -543,7 +553,7 @@ void QQuickWorkerScriptEngine::executeUrl(int id, const QUrl &url)
     QCoreApplication::postEvent(d, new WorkerLoadEvent(id, url));
 }
 
-void QQuickWorkerScriptEngine::sendMessage(int id, const QByteArray &data)
+void QQuickWorkerScriptEngine::sendMessage(int id, const QV4::Serialize::Data &data)
 {
     QCoreApplication::postEvent(d, new WorkerDataEvent(id, data));
 }
@@ -622,6 +632,7 @@ QQuickWorkerScript::QQuickWorkerScript(QObject *parent)
 QQuickWorkerScript::~QQuickWorkerScript()
 {
     if (m_scriptId != -1) m_engine->removeWorkerScript(m_scriptId);
+    qDeleteAll(m_incoming);
 }
 
 /*!
@@ -649,7 +660,7 @@ void QQuickWorkerScript::setSource(const QUrl &source)
 }
 
 /*!
-    \qmlmethod WorkerScript::sendMessage(jsobject message)
+    \qmlmethod WorkerScript::sendMessage(jsobject message, list transfer)
 
     Sends the given \a message to a worker script handler in another
     thread. The other worker script handler can receive this message
@@ -662,11 +673,23 @@ void QQuickWorkerScript::setSource(const QUrl &source)
     \li boolean, number, string
     \li JavaScript objects and arrays
     \li ListModel objects (any other type of QObject* is not allowed)
+    \li ArrayBuffer, typed array and DataView objects
     \endlist
 
     All objects and arrays are copied to the \c message. With the exception
     of ListModel objects, any modifications by the other thread to an object
     passed in \c message will not be reflected in the original object.
+
+    The contents of long strings and of ArrayBuffers are shared with the
+    other thread until one of the sides modifies them. ArrayBuffers listed
+    in the optional \a transfer array are handed over to the other thread
+    and become empty in the sending one, so that neither side ever needs
+    to copy them. The same applies to the \c WorkerScript.sendMessage()
+    function available to the worker script.
+
+    Large messages are delivered to the onMessage() handler in the main
+    thread after being deserialized in several steps, in order to keep the
+    user interface responsive.
 */
 void QQuickWorkerScript::sendMessage(QQmlV4Function *args)
 {
@@ -679,8 +702,11 @@ void QQuickWorkerScript::sendMessage(QQmlV4Function *args)
     QV4::ScopedValue argument(scope, QV4::Primitive::undefinedValue());
     if (args->length() != 0)
         argument = (*args)[0];
+    QV4::ScopedValue transfer(scope, QV4::Primitive::undefinedValue());
+    if (args->length() > 1)
+        transfer = (*args)[1];
 
-    m_engine->sendMessage(m_scriptId, QV4::Serialize::serialize(argument, args->engine()));
+    m_engine->sendMessage(m_scriptId, QV4::Serialize::serialize(argument, args->engine(), transfer));
 }
 
 void QQuickWorkerScript::classBegin()
@@ -729,11 +755,16 @@ bool QQuickWorkerScript::event(QEvent *event)
         if (engine) {
             WorkerDataEvent *workerEvent = static_cast<WorkerDataEvent *>(event);
             QV8Engine *v8engine = QQmlEnginePrivate::get(engine)->v8engine();
-            QV4::Scope scope(QV8Engine::getV4(v8engine));
-            QV4::ScopedValue value(scope, QV4::Serialize::deserialize(workerEvent->data(), v8engine));
-            emit message(QQmlV4Handle(value));
+            bool idle = m_incoming.isEmpty();
+            m_incoming.enqueue(new QV4::Serialize::Deserializer(workerEvent->data(), v8engine));
+            // otherwise a WorkerDeserializeEvent is already pending
+            if (idle)
+                processMessages();
         }
         return true;
+    } else if (event->type() == (QEvent::Type)WorkerDeserializeEvent) {
+        processMessages();
+        return true;
     } else if (event->type() == (QEvent::Type)WorkerErrorEvent::WorkerError) {
         WorkerErrorEvent *workerEvent = static_cast<WorkerErrorEvent *>(event);
         QQmlEnginePrivate::warning(qmlEngine(this), workerEvent->error());
@@ -743,6 +774,29 @@ bool QQuickWorkerScript::event(QEvent *event)
     }
 }
 
+void QQuickWorkerScript::processMessages()
+{
+    QQmlEngine *engine = qmlEngine(this);
+    if (!engine)
+        return;
+    QV4::Scope scope(QV8Engine::getV4(QQmlEnginePrivate::get(engine)->v8engine()));
+    QV4::ScopedValue value(scope);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_incoming.isEmpty()) {
+        int remaining = deserializeBudget - timer.elapsed();
+        if (remaining <= 0 || !m_incoming.head()->run(remaining)) {
+            QCoreApplication::postEvent(this, new QEvent((QEvent::Type)WorkerDeserializeEvent));
+            return;
+        }
+        QV4::Serialize::Deserializer *deserializer = m_incoming.dequeue();
+        value = deserializer->result();
+        delete deserializer;
+        emit message(QQmlV4Handle(value));
+    }
+}
+
 QT_END_NAMESPACE
 
 #include <qquickworkerscript.moc>
@@ -59,6 +59,8 @@
 #include <QtCore/qthread.h>
 #include <QtQml/qjsvalue.h>
 #include <QtCore/qurl.h>
+#include <QtCore/qqueue.h>
+#include <private/qv4serialize_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -75,7 +77,7 @@ public:
     int registerWorkerScript(QQuickWorkerScript *);
     void removeWorkerScript(int);
     void executeUrl(int, const QUrl &);
-    void sendMessage(int, const QByteArray &);
+    void sendMessage(int, const QV4::Serialize::Data &);
 
 protected:
     virtual void run();
@@ -113,10 +115,13 @@ protected:
 
 private:
     QQuickWorkerScriptEngine *engine();
+    void processMessages();
     QQuickWorkerScriptEngine *m_engine;
     int m_scriptId;
     QUrl m_source;
     bool m_componentComplete;
+    // received messages that are not completely deserialized yet
+    QQueue<QV4::Serialize::Deserializer *> m_incoming;
 };
 
 QT_END_NAMESPACE
@@ -64,12 +64,16 @@
 #include <QtGui/qstylehints.h>
 #include <QtCore/qvarlengtharray.h>
 #include <QtCore/qabstractanimation.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtQml/qqmlincubator.h>
 
 #include <QtQuick/private/qquickpixmapcache_p.h>
 
 #include <private/qqmlprofilerservice_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
+#include <private/qqmlbindingqueue_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4mm_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -98,8 +102,9 @@ public:
     QQuickWindowIncubationController(QSGRenderLoop *loop)
         : m_renderLoop(loop), m_timer(0)
     {
+        m_frame_time = qMax(1, qRound(1000 / QGuiApplication::primaryScreen()->refreshRate()));
         // Allow incubation for 1/3 of a frame.
-        m_incubation_time = qMax(1, int(1000 / QGuiApplication::primaryScreen()->refreshRate()) / 3);
+        m_incubation_time = qMax(1, m_frame_time / 3);
 
         m_animation_driver = m_renderLoop->animationDriver();
         if (m_animation_driver) {
@@ -126,14 +131,26 @@ protected:
 
 public slots:
     void incubate() {
+        // Use what is left of the current frame
+        const int budget = m_renderLoop->interleaveIncubation()
+                ? m_renderLoop->incubationBudget(m_frame_time)
+                : m_incubation_time * 2;
+        QElapsedTimer timer;
+        timer.start();
+
         if (incubatingObjectCount()) {
-            if (m_renderLoop->interleaveIncubation()) {
-                incubateFor(m_incubation_time);
-            } else {
-                incubateFor(m_incubation_time * 2);
-                if (incubatingObjectCount())
-                    incubateAgain();
-            }
+            incubateFor(budget);
+            if (!m_renderLoop->interleaveIncubation() && incubatingObjectCount())
+                incubateAgain();
+        }
+
+        // Give an ongoing incremental garbage collection what incubation left over,
+        // at most one regular step
+        QQmlEngine *e = engine();
+        const qint64 remaining = qint64(budget) * 1000 - timer.nsecsElapsed() / 1000;
+        if (e && remaining > 0) {
+            QV4::MemoryManager *mm = QV8Engine::getV4(e)->memoryManager;
+            mm->incrementalGCStep(int(qMin(remaining, qint64(mm->incrementalGCBudget()))));
         }
     }
 
@@ -148,6 +165,7 @@ protected:
 
 private:
     QSGRenderLoop *m_renderLoop;
+    int m_frame_time;
     int m_incubation_time;
     QAnimationDriver *m_animation_driver;
     int m_timer;
@@ -258,6 +276,10 @@ void QQuickWindowPrivate::polishItems()
 {
     int maxPolishCycles = 100000;
 
+    // Batched bindings have to be up to date before polishing, and
+    // polishing may dirty bindings again.
+    QQmlBindingQueue::flushAll();
+
     while (!itemsToPolish.isEmpty() && --maxPolishCycles > 0) {
         QSet<QQuickItem *> itms = itemsToPolish;
         itemsToPolish.clear();
@@ -267,6 +289,8 @@ void QQuickWindowPrivate::polishItems()
             QQuickItemPrivate::get(item)->polishScheduled = false;
             item->updatePolish();
         }
+
+        QQmlBindingQueue::flushAll();
     }
 
     if (maxPolishCycles == 0)
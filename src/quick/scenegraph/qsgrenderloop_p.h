@@ -90,6 +90,9 @@ public:
     static bool useConsistentTiming();
 
     virtual bool interleaveIncubation() const { return false; }
+    // Milliseconds the GUI thread can spend incubating after timeToIncubate()
+    // was emitted, for frames lasting frameTime milliseconds.
+    virtual int incubationBudget(int frameTime) const { return qMax(1, frameTime / 3); }
 
     static void cleanup();
 
@@ -757,6 +757,21 @@ bool QSGThreadedRenderLoop::interleaveIncubation() const
     return m_animation_driver->isRunning() && anyoneShowing();
 }
 
+/*!
+    The GUI thread needs to be done with incubation before the next frame is
+    polished and synchronized, so the budget is what remains of the current
+    frame, minus a quarter of it for event processing.  This is the deadline
+    incubation must meet, no matter how long polishing and syncing took.
+ */
+int QSGThreadedRenderLoop::incubationBudget(int frameTime) const
+{
+    if (!m_frameTimer.isValid())
+        return QSGRenderLoop::incubationBudget(frameTime);
+
+    int remaining = frameTime - frameTime / 4 - int(m_frameTimer.elapsed());
+    return qBound(1, remaining, qMax(1, frameTime / 2));
+}
+
 void QSGThreadedRenderLoop::animationStarted()
 {
     QSG_GUI_DEBUG((void *) 0, "animationStarted()");
@@ -1090,6 +1105,8 @@ void QSGThreadedRenderLoop::polishAndSync(Window *w)
         return;
     }
 
+    m_frameTimer.start();
+
 
 #ifndef QSG_NO_RENDER_TIMING
     QElapsedTimer timer;
@@ -1196,6 +1213,7 @@ bool QSGThreadedRenderLoop::event(QEvent *e)
         QTimerEvent *te = static_cast<QTimerEvent *>(e);
         if (te->timerId() == m_animation_timer) {
             QSG_GUI_DEBUG((void *) 0, "QEvent::Timer -> non-visual animation");
+            m_frameTimer.start();
             m_animation_driver->advance();
             emit timeToIncubate();
         } else {
@@ -43,6 +43,7 @@
 #define QSGTHREADEDRENDERLOOP_P_H
 
 #include <QtCore/QThread>
+#include <QtCore/QElapsedTimer>
 #include <QtGui/QOpenGLContext>
 #include <private/qsgcontext_p.h>
 
@@ -78,6 +79,7 @@ public:
     bool event(QEvent *);
 
     bool interleaveIncubation() const;
+    int incubationBudget(int frameTime) const;
 
 public Q_SLOTS:
     void animationStarted();
@@ -117,6 +119,8 @@ private:
     int m_animation_timer;
     int m_exhaust_delay;
 
+    QElapsedTimer m_frameTimer;
+
     bool m_locked;
 };
 
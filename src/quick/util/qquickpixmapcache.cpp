@@ -379,6 +379,21 @@ static bool readImage(const QUrl& url, QIODevice *dev, QImage *image, QString *e
     }
 }
 
+// Images inside a bundle are decoded straight from the bundle's memory mapping
+static bool readBundleImage(QQmlEngine *engine, const QUrl& url, QImage *image, QString *errorString,
+                            QSize *impsize, const QSize &requestSize, bool *opened)
+{
+    QQmlFile file(engine, url);
+    *opened = !file.isError();
+    if (!*opened)
+        return false;
+
+    QByteArray data = QByteArray::fromRawData(file.data(), file.size());
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return readImage(url, &buffer, image, errorString, impsize, requestSize);
+}
+
 QQuickPixmapReader::QQuickPixmapReader(QQmlEngine *eng)
 : QThread(eng), engine(eng), threadObject(0), accessManager(0)
 {
@@ -598,6 +613,22 @@ void QQuickPixmapReader::processJob(QQuickPixmapReply *runningJob, const QUrl &u
 
         }
 
+    } else if (QQmlFile::isBundle(url)) {
+        QSystraceEvent trace("graphics", "QQuickPixmapCache::bundleRead");
+        QImage image;
+        QQuickPixmapReply::ReadError errorCode = QQuickPixmapReply::NoError;
+        QString errorStr;
+        QSize readSize;
+        bool opened = false;
+        if (!readBundleImage(engine, url, &image, &errorStr, &readSize, requestSize, &opened)) {
+            if (!opened)
+                errorStr = QQuickPixmap::tr("Cannot open: %1").arg(url.toString());
+            errorCode = QQuickPixmapReply::Loading;
+        }
+        mutex.lock();
+        if (!cancelled.contains(runningJob))
+            runningJob->postReply(errorCode, errorStr, readSize, textureFactoryForImage(image));
+        mutex.unlock();
     } else {
         QString lf = QQmlFile::urlToLocalFileOrQrc(url);
         if (!lf.isEmpty()) {
@@ -1037,6 +1068,22 @@ static QQuickPixmapData* createPixmapDataSync(QQuickPixmap *declarativePixmap, Q
             QQuickPixmap::tr("Failed to get image from provider: %1").arg(url.toString()));
     }
 
+    if (QQmlFile::isBundle(url)) {
+        QImage image;
+        QSize readSize;
+        QString errorString;
+        bool opened = false;
+        if (readBundleImage(engine, url, &image, &errorString, &readSize, requestSize, &opened)) {
+            *ok = true;
+            return new QQuickPixmapData(declarativePixmap, url, textureFactoryForImage(image), readSize, requestSize);
+        }
+        if (opened)
+            errorString = QQuickPixmap::tr("Invalid image data: %1").arg(url.toString());
+        else
+            errorString = QQuickPixmap::tr("Cannot open: %1").arg(url.toString());
+        return new QQuickPixmapData(declarativePixmap, url, requestSize, errorString);
+    }
+
     QString localFile = QQmlFile::urlToLocalFileOrQrc(url);
     if (localFile.isEmpty()) 
         return 0;
@@ -100,6 +100,7 @@ public:
         Creating,
         Binding,            //running a binding
         HandlingSignal,     //running a signal handler
+        Incubating,         //an incubation slice, since version 2 of the service
 
         MaximumRangeType
     };
@@ -341,6 +342,8 @@ void tst_QQmlProfilerService::blockingConnectWithTraceEnabled()
     connect(true, "test.qml");
     QVERIFY(m_client);
     QTRY_COMPARE(m_client->state(), QQmlDebugClient::Enabled);
+    // Version 2 added the Incubating range type
+    QCOMPARE(m_client->serviceVersion(), 2.0f);
 
     m_client->setTraceState(true);
     m_client->setTraceState(false);
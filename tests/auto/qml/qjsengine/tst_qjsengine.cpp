@@ -48,6 +48,11 @@
 #include <qstandarditemmodel.h>
 #include <QtCore/qnumeric.h>
 #include <qqmlengine.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4mm_p.h>
+#include <private/qv4lookup_p.h>
+#include <private/qv4isel_moth_p.h>
 #include <stdlib.h>
 
 #ifdef Q_CC_MSVC
@@ -107,6 +112,13 @@ private slots:
     void castWithMultipleInheritance();
     void collectGarbage();
     void gcWithNestedDataStructure();
+    void generationalGC();
+    void writeBarrierAfterAllocation();
+    void incrementalGC();
+    void lazySweep();
+    void trimMemory();
+    void exactStackRoots();
+    void polymorphicLookups();
     void stacktrace();
     void numberParsing_data();
     void numberParsing();
@@ -137,6 +149,8 @@ private slots:
     void reentrancy_objectCreation();
     void jsIncDecNonObjectProperty();
     void JSONparse();
+    void JSONparseRecords();
+    void JSONstringify();
 
     void qRegExpInport_data();
     void qRegExpInport();
@@ -150,6 +164,12 @@ private slots:
     void functionDeclarationsInConditionals();
 
     void arrayPop_QTBUG_35979();
+    void arrayDenseFastPaths();
+    void sparseArrays();
+    void typedArrays();
+    void arrayBufferToByteArray();
+    void byteArrayProperty();
+    void arrayBufferMemoryUsage();
 
     void regexpLastMatch();
 
@@ -157,6 +177,11 @@ private slots:
 
     void scopeOfEvaluate();
 
+    void conditionalJumps_data();
+    void conditionalJumps();
+    void conditionalJumpThrows();
+    void arithmeticOverflow();
+
 signals:
     void testSignal();
 };
@@ -1305,6 +1330,313 @@ void tst_QJSEngine::gcWithNestedDataStructure()
     }
 }
 
+void tst_QJSEngine::generationalGC()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    mm->setGenerationalGC(true);
+    QVERIFY(mm->isGenerationalGC());
+
+    // holder and the closure context are old after the first collection, and
+    // only reach the objects created afterwards through the write barrier
+    QJSValue ret = eng.evaluate(
+        "var holder = { list: [] };"
+        "function counter() { var value = { n: 0 }; return function() { value = { n: value.n + 1 }; return value.n; } }"
+        "var next = counter();"
+        "var slots = [];"
+        "for (var i = 0; i < 1000; ++i) slots.push(null);");
+    QVERIFY(!ret.isError());
+    eng.collectGarbage();
+
+    // slots is old as well, and gets young elements stored through indexed writes
+    ret = eng.evaluate(
+        "for (var i = 0; i < 100000; ++i) {"
+        "  holder.list.push({ index: i });"
+        "  holder['p' + (i % 16)] = { index: i };"
+        "  slots[i % 1000] = { index: i };"
+        "  var garbage = [ i, String(i), { x: i } ];"
+        "  next();"
+        "}");
+    QVERIFY(!ret.isError());
+    QVERIFY(mm->statistics().minorCollections > 0);
+
+    ret = eng.evaluate(
+        "var garbage;"
+        "for (var i = 0; i < 100000; ++i) garbage = [ i, String(i), { x: i } ];"
+        "slots.every(function(o, i) { return o.index === 99000 + i; })");
+    QCOMPARE(ret.toBool(), true);
+
+    eng.collectGarbage();
+    ret = eng.evaluate(
+        "holder.list.length == 100000 &&"
+        "holder.list.every(function(o, i) { return o.index === i; }) &&"
+        "holder.p15.index === 99999 &&"
+        "slots.every(function(o, i) { return o.index === 99000 + i; }) &&"
+        "next() === 100001");
+    QCOMPARE(ret.toBool(), true);
+
+    mm->setGenerationalGC(false);
+    eng.collectGarbage();
+    QCOMPARE(eng.evaluate("holder.list[500].index").toInt(), 500);
+}
+
+class MinorCollector : public QObject
+{
+    Q_OBJECT
+public:
+    MinorCollector(QV4::MemoryManager *mm)
+        : mm(mm)
+    {}
+
+public slots:
+    void collect()
+    {
+        mm->runGC(/*minor*/true);
+    }
+
+private:
+    QV4::MemoryManager *mm;
+};
+
+void tst_QJSEngine::writeBarrierAfterAllocation()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    mm->setGenerationalGC(true);
+    eng.globalObject().setProperty("collector", eng.newQObject(new MinorCollector(mm)));
+
+    // The getters run a minor collection, which promotes the array being filled,
+    // before they create the young element that gets stored into it.
+    QJSValue ret = eng.evaluate(
+        "function element(i) { return { get: function() { collector.collect(); return { index: i }; } }; }"
+        "var source = { length: 20 };"
+        "var accessors = [];"
+        "for (var i = 0; i < 20; ++i) {"
+        "  Object.defineProperty(source, i, element(i));"
+        "  Object.defineProperty(accessors, i, element(i));"
+        "}"
+        "var spliced = Array.prototype.splice.call(source, 0, 20);"
+        "var concatenated = [].concat(accessors);"
+        "collector.collect();"
+        "collector.collect();"
+        "var garbage;"
+        "for (var i = 0; i < 10000; ++i) garbage = { x: i };"
+        "spliced.length === 20 && spliced.every(function(o, i) { return o.index === i; }) &&"
+        "concatenated.length === 20 && concatenated.every(function(o, i) { return o.index === i; })");
+    QVERIFY(!ret.isError());
+    QCOMPARE(ret.toBool(), true);
+    QVERIFY(mm->statistics().minorCollections >= 40);
+}
+
+void tst_QJSEngine::incrementalGC()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    mm->setIncrementalGC(true);
+    mm->setIncrementalGCBudget(100);
+    QVERIFY(mm->isIncrementalGC());
+
+    // objects scanned by earlier marking steps are written to in between steps
+    QJSValue ret = eng.evaluate(
+        "var holder = { list: [] };"
+        "function counter() { var value = { n: 0 }; return function() { value = { n: value.n + 1 }; return value.n; } }"
+        "var next = counter();"
+        "var slots = [];"
+        "for (var i = 0; i < 1000; ++i) slots.push(null);"
+        "for (var i = 0; i < 100000; ++i) {"
+        "  holder.list.push({ index: i });"
+        "  holder['p' + (i % 16)] = { index: i };"
+        "  slots[i % 1000] = { index: i };"
+        "  var garbage = [ i, String(i), { x: i } ];"
+        "  next();"
+        "}");
+    QVERIFY(!ret.isError());
+    // the allocations alone drive collections to completion
+    QVERIFY(mm->statistics().incrementalSlices > 0);
+    QVERIFY(mm->statistics().fullCollections > 0);
+    while (!mm->incrementalGCStep())
+        ;
+
+    ret = eng.evaluate(
+        "holder.list.length == 100000 &&"
+        "holder.list.every(function(o, i) { return o.index === i; }) &&"
+        "holder.p15.index === 99999 &&"
+        "slots.every(function(o, i) { return o.index === 99000 + i; }) &&"
+        "next() === 100001");
+    QCOMPARE(ret.toBool(), true);
+}
+
+void tst_QJSEngine::lazySweep()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    mm->setLazySweep(true);
+    QVERIFY(mm->isLazySweep());
+
+    // chunks are swept while allocating in between collections
+    QJSValue ret = eng.evaluate(
+        "var holder = { list: [] };"
+        "for (var i = 0; i < 100000; ++i) {"
+        "  holder.list.push({ index: i });"
+        "  var garbage = [ i, String(i), { x: i } ];"
+        "}");
+    QVERIFY(!ret.isError());
+    QVERIFY(mm->statistics().lazySweeps > 0);
+
+    // JavaScript owned objects, collected while more garbage is produced
+    QPointer<QObject> object = new QObject();
+    {
+        QJSValue v = eng.newQObject(object);
+    }
+    ret = eng.evaluate(
+        "for (var i = 0; i < 100000; ++i) {"
+        "  var garbage = { x: i };"
+        "}"
+        "holder.list.length == 100000 &&"
+        "holder.list.every(function(o, i) { return o.index === i; })");
+    QCOMPARE(ret.toBool(), true);
+
+    // explicit collections sweep everything
+    eng.collectGarbage();
+    if (object)
+        QGuiApplication::sendPostedEvents(object, QEvent::DeferredDelete);
+    QVERIFY(object == 0);
+}
+
+void tst_QJSEngine::trimMemory()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+
+    QJSValue ret = eng.evaluate(
+        "var spike = [];"
+        "for (var i = 0; i < 200000; ++i)"
+        "  spike.push({ index: i });"
+        "var survivor = { index: -1 };");
+    QVERIFY(!ret.isError());
+    const std::size_t peak = mm->heapSize();
+
+    eng.evaluate("spike = null;");
+    eng.trimMemory();
+    QVERIFY(mm->heapSize() < peak);
+    QVERIFY(mm->statistics().releasedChunks > 0);
+
+    // the heap grows again as needed
+    ret = eng.evaluate(
+        "var list = [];"
+        "for (var i = 0; i < 200000; ++i)"
+        "  list.push({ index: i });"
+        "list.length == 200000 && list[199999].index === 199999 && survivor.index === -1");
+    QCOMPARE(ret.toBool(), true);
+}
+
+// gc() is only available in QML engines
+class GarbageCollector : public QObject
+{
+    Q_OBJECT
+public:
+    GarbageCollector(QJSEngine *engine)
+        : engine(engine)
+    {}
+
+public slots:
+    void collect()
+    {
+        engine->collectGarbage();
+    }
+
+private:
+    QJSEngine *engine;
+};
+
+void tst_QJSEngine::exactStackRoots()
+{
+    QJSEngine eng;
+    QPointer<QObject> object = new QObject();
+    eng.globalObject().setProperty("object", eng.newQObject(object));
+    eng.globalObject().setProperty("collector", eng.newQObject(new GarbageCollector(&eng)));
+
+    // the frames of deep() reuse the stack slots that held the wrapper before
+    QJSValue ret = eng.evaluate(
+        "function use(o) { var a = o; var b = { x: o, y: [ o, a ] }; return b.y.length; }"
+        "function deep(n) { var t = n * 2; if (n) return deep(n - 1) + t; collector.collect(); return t; }"
+        "use(object);"
+        "object = null;"
+        "deep(20);");
+    QCOMPARE(ret.toInt(), 420);
+    if (object)
+        QGuiApplication::sendPostedEvents(object, QEvent::DeferredDelete);
+    QVERIFY(object == 0);
+}
+
+void tst_QJSEngine::polymorphicLookups()
+{
+    QJSEngine eng;
+
+    // objects of 20 different shapes go through the same get and set sites
+    QJSValue ret = eng.evaluate(
+        "function makeShape(n) { var o = {}; for (var i = 0; i < n; ++i) o['p' + i] = i; o.value = n; return o; }"
+        "function get(o) { return o.value; }"
+        "function set(o, v) { o.value = v; }"
+        "var shapes = [];"
+        "for (var i = 0; i < 20; ++i) shapes.push(makeShape(i));"
+        "var proto = { value: -1 };"
+        "var inherited = Object.create(proto);"
+        "var ok = true;"
+        "for (var round = 0; round < 10; ++round) {"
+        "  for (var i = 0; i < 20; ++i) {"
+        "    if (get(shapes[i]) !== i + round) ok = false;"
+        "    set(shapes[i], i + round + 1);"
+        "  }"
+        "  if (get(inherited) !== round - 1) ok = false;"
+        "  proto.value = round;"
+        "}"
+        "ok");
+    QCOMPARE(ret.toBool(), true);
+
+    bool getterFound = false;
+    bool setterFound = false;
+    const QVector<QV4::LookupStatistics> stats = QV4::Lookup::statistics(QV8Engine::getV4(&eng));
+    foreach (const QV4::LookupStatistics &s, stats) {
+        if (s.name != QLatin1String("value") || !s.megamorphic)
+            continue;
+        QVERIFY(s.hits > 0);
+        QVERIFY(s.misses > 0);
+        if (s.classes == QV4::Lookup::PolymorphicSize) {
+            if (getterFound)
+                setterFound = true;
+            getterFound = true;
+        }
+    }
+    QVERIFY(getterFound);
+    QVERIFY(setterFound);
+
+    // the prototype holding the property keeps changing its shape, which updates
+    // the entry of the receiver class instead of adding new ones
+    ret = eng.evaluate(
+        "function getInherited(o) { return o.inherited; }"
+        "var a = Object.create({ inherited: 1 });"
+        "var b = { inherited: 2 };"
+        "var holder = Object.getPrototypeOf(a);"
+        "var ok = true;"
+        "for (var i = 0; i < 20; ++i) {"
+        "  holder['q' + i] = i;"
+        "  if (getInherited(a) !== 1 || getInherited(b) !== 2) ok = false;"
+        "}"
+        "ok");
+    QCOMPARE(ret.toBool(), true);
+
+    bool inheritedFound = false;
+    foreach (const QV4::LookupStatistics &s, QV4::Lookup::statistics(QV8Engine::getV4(&eng))) {
+        if (s.name != QLatin1String("inherited"))
+            continue;
+        QVERIFY(!s.megamorphic);
+        QCOMPARE(s.classes, 2);
+        inheritedFound = true;
+    }
+    QVERIFY(inheritedFound);
+}
+
 void tst_QJSEngine::stacktrace()
 {
     QString script = QString::fromLatin1(
@@ -2540,6 +2872,44 @@ void tst_QJSEngine::JSONparse()
     QVERIFY(ret.isObject());
 }
 
+void tst_QJSEngine::JSONparseRecords()
+{
+    QJSEngine eng;
+    // objects with the same keys share their class, others must not be affected by that
+    QJSValue ret = eng.evaluate("var r = JSON.parse('[{\"a\":1,\"b\":\"x\"},{\"a\":2,\"b\":\"y\"},{\"a\":3},{\"b\":4,\"a\":5},"
+                                "{\"a\":6,\"b\":7,\"c\":8},{\"a\":1,\"a\":2},{\"a\\\\u0062\":9},{\"0\":1,\"a\":2}]');"
+                                "[r[0].a, Object.keys(r[1]), r[1].b, r[2].a, 'b' in r[2], Object.keys(r[3]), Object.keys(r[4]),"
+                                " r[5].a, Object.keys(r[6]), r[7][0], Object.keys(r[7])].join('|')");
+    QCOMPARE(ret.toString(), QString("1|a,b|y|3|false|b,a|a,b,c|2|ab|1|0,a"));
+
+    ret = eng.evaluate("JSON.parse('\"0123456789abcdefghij\"').length + ':' + JSON.parse('\"abc\\\\ndef\\\\u00e9\\\\\"q\"')");
+    QCOMPARE(ret.toString(), QString::fromUtf8("20:abc\ndef\xc3\xa9\"q"));
+    ret = eng.evaluate("try { JSON.parse('\"a\\tb\"'); false } catch (e) { e instanceof SyntaxError }");
+    QVERIFY(ret.toBool());
+
+    ret = eng.evaluate("JSON.parse('[0, -12, 123456789, 1234567890, 12345678901, 1.5, -2e3, 33554432]').join()");
+    QCOMPARE(ret.toString(), QString("0,-12,123456789,1234567890,12345678901,1.5,-2000,33554432"));
+    ret = eng.evaluate("try { JSON.parse('[-]'); false } catch (e) { e instanceof SyntaxError }");
+    QVERIFY(ret.toBool());
+}
+
+void tst_QJSEngine::JSONstringify()
+{
+    QJSEngine eng;
+    QCOMPARE(eng.evaluate("JSON.stringify({a: [1, 'x\"y\\n', null, undefined, function() {}], b: undefined, c: 1.5, d: NaN, e: {}, f: []})").toString(),
+             QString("{\"a\":[1,\"x\\\"y\\n\",null,null,null],\"c\":1.5,\"d\":null,\"e\":{},\"f\":[]}"));
+    QCOMPARE(eng.evaluate("JSON.stringify({a: 1, b: [2, {}], c: undefined}, null, 2)").toString(),
+             QString("{\n  \"a\": 1,\n  \"b\": [\n    2,\n    {}\n  ]\n}"));
+    QCOMPARE(eng.evaluate("JSON.stringify('\\u0001\\t')").toString(), QString("\"\\u0001\\t\""));
+
+    QCOMPARE(eng.evaluate("JSON.stringify([{toJSON: function(k) { return 'k' + k }}])").toString(), QString("[\"k0\"]"));
+    QCOMPARE(eng.evaluate("JSON.stringify({a: 1, b: 'x'}, function(k, v) { return typeof v === 'number' ? v * 2 : v })").toString(),
+             QString("{\"a\":2,\"b\":\"x\"}"));
+    QCOMPARE(eng.evaluate("JSON.stringify({a: 1, b: 2, c: 3}, ['c', 'a'])").toString(), QString("{\"c\":3,\"a\":1}"));
+    QVERIFY(eng.evaluate("JSON.stringify(undefined) === undefined").toBool());
+    QVERIFY(eng.evaluate("var o = {}; o.o = o; try { JSON.stringify(o); false } catch (e) { e instanceof TypeError }").toBool());
+}
+
 static QRegExp minimal(QRegExp r) { r.setMinimal(true); return r; }
 
 void tst_QJSEngine::qRegExpInport_data()
@@ -2735,6 +3105,177 @@ void tst_QJSEngine::arrayPop_QTBUG_35979()
     QCOMPARE(result.toString(), QString("1,3"));
 }
 
+void tst_QJSEngine::arrayDenseFastPaths()
+{
+    QJSEngine eng;
+    QCOMPARE(eng.evaluate("[10, 9, 1, undefined, 'b', , true, 'a', 2.5].sort().toString()").toString(),
+             QString("1,10,2.5,9,a,b,true,,"));
+    QCOMPARE(eng.evaluate("var x = [3, , undefined, 1]; x.sort(); x.length + ':' + (2 in x) + ':' + (3 in x)").toString(),
+             QString("4:true:false"));
+    QCOMPARE(eng.evaluate("[{ toString: function() { return 'b' } }, 'a'].sort().toString()").toString(),
+             QString("a,b"));
+
+    QCOMPARE(eng.evaluate("[1, NaN, 2].indexOf(NaN)").toInt(), -1);
+    QCOMPARE(eng.evaluate("[1, -0, 2].indexOf(0)").toInt(), 1);
+    QCOMPARE(eng.evaluate("[1, '2', 2].indexOf(2)").toInt(), 2);
+    QCOMPARE(eng.evaluate("[1, , 2].indexOf(undefined)").toInt(), -1);
+
+    // holes are looked up on the prototype chain
+    QJSValue result = eng.evaluate("Array.prototype[1] = 'p'; var r = []; [0, , 2].forEach(function(v) { r.push(v) });"
+                                   "delete Array.prototype[1]; r.toString()");
+    QCOMPARE(result.toString(), QString("0,p,2"));
+}
+
+void tst_QJSEngine::sparseArrays()
+{
+    QJSEngine eng;
+    // enough entries to need several chunks, inserted out of order
+    QCOMPARE(eng.evaluate("var a = []; for (var i = 0; i < 1000; ++i) a[((i * 7919) % 1000) * 16 + 100000] = i;"
+                          "var keys = []; for (var k in a) keys.push(k); var sorted = true;"
+                          "for (var i = 1; i < keys.length; ++i) sorted = sorted && (+keys[i - 1] < +keys[i]);"
+                          "keys.length + ':' + sorted + ':' + keys[0] + ':' + a[100016]").toString(),
+             QString("1000:true:100000:679"));
+    QCOMPARE(eng.evaluate("a.length = 108000; var n = 0; for (var k in a) ++n; n + ':' + a.length + ':' + a[107984] + ':' + a[108000]").toString(),
+             QString("500:108000:821:undefined"));
+    QCOMPARE(eng.evaluate("for (var i = 0; i < 300; ++i) delete a[100000 + i * 16]; a.indexOf(821) + ':' + a.lastIndexOf(679)").toString(),
+             QString("107984:-1"));
+
+    // shift and unshift renumber all entries, also when index 0 is a hole
+    QCOMPARE(eng.evaluate("var s = []; s[1] = 'a'; s[300000] = 'b'; s.shift(); s[0] + ':' + s.length + ':' + s[299999]").toString(),
+             QString("a:300000:b"));
+    QCOMPARE(eng.evaluate("for (var i = 0; i < 500; ++i) s.unshift(i); s.shift() + ':' + s[499] + ':' + s[300498] + ':' + s.length").toString(),
+             QString("499:a:b:300499"));
+
+    // entries added or removed during for-in
+    QCOMPARE(eng.evaluate("var f = []; f[5] = 5; f[100000] = 6; f[200000] = 7; var r = [];"
+                          "for (var k in f) { r.push(k); if (k == 5) { delete f[100000]; f[150000] = 8; } } r.toString()").toString(),
+             QString("5,150000,200000"));
+}
+
+void tst_QJSEngine::typedArrays()
+{
+    QJSEngine eng;
+    QCOMPARE(eng.evaluate("var a = new Uint8Array(4); a[0] = 257; a[1] = -1; a[5] = 1; a.length + ':' + a[0] + ':' + a[1] + ':' + a[5]").toString(),
+             QString("4:1:255:undefined"));
+    QCOMPARE(eng.evaluate("var c = new Uint8ClampedArray([300, -5, 1.5, 2.5, NaN]); Array.prototype.join.call(c)").toString(),
+             QString("255,0,2,2,0"));
+    QCOMPARE(eng.evaluate("var f = new Float32Array([0.5, 1.1]); f[0] + ':' + (f[1] == 1.1)").toString(),
+             QString("0.5:false"));
+    QCOMPARE(eng.evaluate("Object.prototype.toString.call(new Int16Array(1))").toString(),
+             QString("[object Int16Array]"));
+
+    // views share the buffer
+    QCOMPARE(eng.evaluate("var b = new ArrayBuffer(8); var i32 = new Int32Array(b); var u8 = new Uint8Array(b, 4);"
+                          "for (var i = 0; i < 4; ++i) u8[i] = 1; i32[1] + ':' + b.byteLength + ':' + u8.byteOffset").toString(),
+             QString("16843009:8:4"));
+    QCOMPARE(eng.evaluate("var s = i32.subarray(1); s[0] = -1; u8[1] + ':' + s.length").toString(), QString("255:1"));
+    QCOMPARE(eng.evaluate("var t = new Int8Array([1, 2, 3, 4]); t.set(t.subarray(0, 2), 1); Array.prototype.join.call(t)").toString(),
+             QString("1,1,2,4"));
+    QCOMPARE(eng.evaluate("var k = []; for (var p in new Int8Array(3)) k.push(p); k.join()").toString(),
+             QString("0,1,2"));
+    QCOMPARE(eng.evaluate("new Int8Array(new ArrayBuffer(4)).buffer.slice(1, -1).byteLength").toInt(), 2);
+
+    QVERIFY(eng.evaluate("new Int32Array(new ArrayBuffer(6))").isError());
+    QVERIFY(eng.evaluate("new Int32Array(new ArrayBuffer(8), 2)").isError());
+    QVERIFY(eng.evaluate("Uint8Array(1)").isError());
+
+    QCOMPARE(eng.evaluate("var d = new DataView(new ArrayBuffer(8)); d.setInt16(0, -2); d.setFloat32(4, 1.5, true);"
+                          "d.getUint8(0) + ':' + d.getUint8(1) + ':' + d.getInt16(0) + ':' + d.getFloat32(4, true)").toString(),
+             QString("255:254:-2:1.5"));
+    QVERIFY(eng.evaluate("d.getInt32(6)").isError());
+}
+
+void tst_QJSEngine::arrayBufferToByteArray()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    QByteArray data("\x01\x02\x03", 3);
+    eng.globalObject().setProperty("data", eng.toScriptValue(data));
+    QJSValue buffer = eng.evaluate("new ArrayBuffer(data)");
+    QCOMPARE(buffer.property("byteLength").toInt(), 3);
+    eng.globalObject().setProperty("buffer", buffer);
+
+    // the contents are shared, and only accounted once a view takes them over
+    const std::size_t shared = mm->unmanagedHeapSize();
+    QCOMPARE(eng.evaluate("new Uint8Array(buffer)[2]").toInt(), 3);
+    QCOMPARE(mm->unmanagedHeapSize(), shared + 3);
+
+    // writing from script does not change the array the buffer was created from
+    eng.evaluate("new Uint8Array(buffer)[0] = 42");
+    QCOMPARE(data.at(0), char(1));
+
+    QByteArray result = eng.fromScriptValue<QByteArray>(buffer);
+    QCOMPARE(result, QByteArray("\x2a\x02\x03", 3));
+    QCOMPARE(buffer.toVariant().toByteArray(), result);
+
+    // nor does writing from script change the arrays handed out before
+    eng.evaluate("new Uint8Array(buffer)[1] = 43");
+    QCOMPARE(result.at(1), char(2));
+}
+
+class ByteArrayHolder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QByteArray bytes READ bytes WRITE setBytes)
+public:
+    QByteArray bytes() const { return m_bytes; }
+    void setBytes(const QByteArray &bytes) { m_bytes = bytes; }
+
+public slots:
+    QByteArray reversed(const QByteArray &bytes)
+    {
+        QByteArray rv;
+        for (int ii = bytes.size() - 1; ii >= 0; --ii)
+            rv += bytes.at(ii);
+        return rv;
+    }
+
+private:
+    QByteArray m_bytes;
+};
+
+void tst_QJSEngine::byteArrayProperty()
+{
+    QJSEngine eng;
+    ByteArrayHolder holder;
+    holder.setBytes("abc");
+    eng.globalObject().setProperty("holder", eng.newQObject(&holder));
+
+    // QByteArray values stay variants that convert to their contents as a string
+    QVERIFY(!eng.evaluate("holder.bytes instanceof ArrayBuffer").toBool());
+    QCOMPARE(eng.evaluate("String(holder.bytes)").toString(), QString("abc"));
+    QCOMPARE(eng.evaluate("String.fromCharCode.apply(null, new Uint8Array(new ArrayBuffer(holder.bytes)))").toString(), QString("abc"));
+
+    QVERIFY(!eng.evaluate("holder.bytes = new Uint8Array([100, 101]).buffer").isError());
+    QCOMPARE(holder.bytes(), QByteArray("de"));
+
+    QCOMPARE(eng.evaluate("Array.prototype.join.call(new Uint8Array(new ArrayBuffer(holder.reversed(new Uint8Array([1, 2]).buffer))))").toString(),
+             QString("2,1"));
+
+    QVERIFY(!eng.toScriptValue(QVariant(QByteArray("xyz"))).property("byteLength").isNumber());
+}
+
+void tst_QJSEngine::arrayBufferMemoryUsage()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+    const std::size_t initial = mm->unmanagedHeapSize();
+
+    QJSValue kept = eng.evaluate("new ArrayBuffer(1000)");
+    QCOMPARE(mm->unmanagedHeapSize(), initial + 1000);
+
+    // Buffers hardly take any heap space, but their contents still trigger collections
+    const uint collections = mm->statistics().fullCollections + mm->statistics().incrementalSlices;
+    QVERIFY(!eng.evaluate("for (var i = 0; i < 256; ++i) new ArrayBuffer(1024 * 1024)").isError());
+    QVERIFY(mm->statistics().fullCollections + mm->statistics().incrementalSlices > collections);
+    QVERIFY(mm->unmanagedHeapSize() < 64 * 1024 * 1024);
+
+    eng.collectGarbage();
+    QVERIFY(mm->unmanagedHeapSize() >= initial + 1000);
+    QVERIFY(mm->unmanagedHeapSize() < 8 * 1024 * 1024);
+    QCOMPARE(kept.property("byteLength").toInt(), 1000);
+}
+
 void tst_QJSEngine::regexpLastMatch()
 {
     QJSEngine eng;
@@ -2897,6 +3438,88 @@ void tst_QJSEngine::scopeOfEvaluate()
     QCOMPARE(result.toInt(), 42);
 }
 
+void tst_QJSEngine::conditionalJumps_data()
+{
+    QTest::addColumn<QString>("lhs");
+    QTest::addColumn<QString>("op");
+    QTest::addColumn<QString>("rhs");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("int <") << "1" << "<" << "2" << true;
+    QTest::newRow("double >=") << "1.5" << ">=" << "1.25" << true;
+    QTest::newRow("NaN <") << "NaN" << "<" << "1" << false;
+    QTest::newRow("NaN ==") << "NaN" << "==" << "NaN" << false;
+    QTest::newRow("NaN !=") << "NaN" << "!=" << "NaN" << true;
+    QTest::newRow("null == 0") << "null" << "==" << "0" << false;
+    QTest::newRow("null >= 0") << "null" << ">=" << "0" << true;
+    QTest::newRow("true === 1") << "true" << "===" << "1" << false;
+    QTest::newRow("true == 1") << "true" << "==" << "1" << true;
+    QTest::newRow("int == double") << "2" << "==" << "2.0" << true;
+    QTest::newRow("int !== double") << "2" << "!==" << "2.5" << true;
+    QTest::newRow("string <") << "'a'" << "<" << "'b'" << true;
+    QTest::newRow("string == int") << "'1'" << "==" << "1" << true;
+    QTest::newRow("undefined == null") << "undefined" << "==" << "null" << true;
+}
+
+// Engines use the JIT by default where it is available. Creates one that runs
+// the interpreter, for the tests of its instructions.
+static QJSEngine *createEngine(bool interpreter)
+{
+    if (!interpreter)
+        return new QJSEngine;
+    QV4::ExecutionEngine::setForceInterpreter(true);
+    QJSEngine *engine = new QJSEngine;
+    QV4::ExecutionEngine::setForceInterpreter(false);
+    return engine;
+}
+
+// Comparisons directly feeding a conditional jump are compiled as a single instruction
+void tst_QJSEngine::conditionalJumps()
+{
+    QFETCH(QString, lhs);
+    QFETCH(QString, op);
+    QFETCH(QString, rhs);
+    QFETCH(bool, expected);
+
+    for (int interpreter = 0; interpreter < 2; ++interpreter) {
+        QScopedPointer<QJSEngine> eng(createEngine(interpreter));
+        if (interpreter)
+            QVERIFY(dynamic_cast<QQmlJS::Moth::ISelFactory *>(QV8Engine::getV4(eng.data())->iselFactory.data()));
+        QJSValue function = eng->evaluate(QString::fromLatin1(
+                "(function(x, y) { var r = 0; if (x %1 y) r += 1; else r += 2;"
+                " while (x %1 y) { r += 4; break; } return r; })").arg(op));
+        QVERIFY(function.isCallable());
+        QJSValue result = function.call(QJSValueList() << eng->evaluate(lhs) << eng->evaluate(rhs));
+        QCOMPARE(result.toInt(), expected ? 5 : 2);
+    }
+}
+
+void tst_QJSEngine::conditionalJumpThrows()
+{
+    for (int interpreter = 0; interpreter < 2; ++interpreter) {
+        QScopedPointer<QJSEngine> eng(createEngine(interpreter));
+        QJSValue thrown = eng->evaluate("(function() { var o = { valueOf: function() { throw 42; } };"
+                                        " try { if (o < 1) return 1; return 2; } catch (e) { return e; } })()");
+        QCOMPARE(thrown.toInt(), 42);
+    }
+}
+
+void tst_QJSEngine::arithmeticOverflow()
+{
+    for (int interpreter = 0; interpreter < 2; ++interpreter) {
+        QScopedPointer<QJSEngine> eng(createEngine(interpreter));
+        QJSValue function = eng->evaluate("(function(i, j, x, y) { i++; j--;"
+                                          " return [i, j, i * 2, x + 2, y - 2]; })");
+        QVERIFY(function.isCallable());
+        QJSValue overflow = function.call(QJSValueList() << 2147483647 << int(-2147483647 - 1) << 1.5 << 0.5);
+        QCOMPARE(overflow.property(0).toNumber(), 2147483648.);
+        QCOMPARE(overflow.property(1).toNumber(), -2147483649.);
+        QCOMPARE(overflow.property(2).toNumber(), 4294967296.);
+        QCOMPARE(overflow.property(3).toNumber(), 3.5);
+        QCOMPARE(overflow.property(4).toNumber(), -1.5);
+    }
+}
+
 QTEST_MAIN(tst_QJSEngine)
 
 #include "tst_qjsengine.moc"
@@ -59,6 +59,7 @@ PRIVATETESTS += \
     qqmlinstantiator \
     qv4debugger \
     qqmlenginecleanup \
+    qrecyclepool \
     v4misc
 
 qtHaveModule(widgets) {
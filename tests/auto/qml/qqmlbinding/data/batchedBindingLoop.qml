@@ -0,0 +1,7 @@
+import QtQml 2.0
+
+QtObject {
+    property int y: 0
+    property int x: y + 1
+    onXChanged: if (x > 10) y = x
+}
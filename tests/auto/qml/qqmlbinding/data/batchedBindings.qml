@@ -0,0 +1,8 @@
+import QtQml 2.0
+
+QtObject {
+    property int a: 1
+    property int b: 2
+    property int sum: a + b
+    property int result: sum * 2 + a
+}
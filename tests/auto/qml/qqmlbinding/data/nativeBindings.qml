@@ -0,0 +1,16 @@
+import QtQuick 2.0
+
+Item {
+    property int value: 10
+    property bool flag: true
+    property string label: "a"
+
+    Item { id: child; objectName: "child"; width: 100 }
+
+    property int copy: value
+    property double converted: value
+    property bool negated: !flag
+    property string text: label
+    property real childWidth: child.width
+    property int script: value + 1
+}
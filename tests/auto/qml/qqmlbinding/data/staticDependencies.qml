@@ -0,0 +1,15 @@
+import QtQuick 2.0
+
+Item {
+    property int margin: 2
+    property bool useA: true
+    property int a: 10
+    property int b: 20
+
+    Item { id: child; objectName: "child"; width: 100; height: 4 }
+    property var holder: ({ valueOf: function() { return child.height } })
+
+    property int simple: child.width - 2 * margin
+    property int conditional: useA ? a : b
+    property int converted: holder * 2
+}
@@ -42,6 +42,10 @@
 #include <QtQml/qqmlengine.h>
 #include <QtQml/qqmlcomponent.h>
 #include <private/qqmlbind_p.h>
+#include <private/qqmlengine_p.h>
+#include <private/qqmlbinding_p.h>
+#include <private/qqmlnativebinding_p.h>
+#include <private/qqmlproperty_p.h>
 #include <QtQuick/private/qquickrectangle_p.h>
 #include "../../shared/util.h"
 
@@ -58,6 +62,10 @@ private slots:
     void restoreBindingWithLoop();
     void restoreBindingWithoutCrash();
     void deletedObject();
+    void batchedUpdates();
+    void batchedBindingLoop();
+    void staticDependencies();
+    void nativeBindings();
 
 private:
     QQmlEngine engine;
@@ -232,6 +240,158 @@ void tst_qqmlbinding::deletedObject()
     delete rect;
 }
 
+void tst_qqmlbinding::batchedUpdates()
+{
+    QQmlEngine engine;
+    QQmlBindingQueue &queue = QQmlEnginePrivate::get(&engine)->bindingQueue;
+    queue.setEnabled(true);
+
+    QQmlComponent c(&engine, testFileUrl("batchedBindings.qml"));
+    QScopedPointer<QObject> o(c.create());
+    QVERIFY(o != 0);
+    queue.flush();
+    QCOMPARE(o->property("sum").toInt(), 3);
+    QCOMPARE(o->property("result").toInt(), 7);
+
+    // The first change teaches the queue that result depends on sum
+    o->setProperty("a", 2);
+    queue.flush();
+    QCOMPARE(o->property("sum").toInt(), 4);
+    QCOMPARE(o->property("result").toInt(), 10);
+    QVERIFY(queue.isEmpty());
+
+    queue.resetStatistics();
+    o->setProperty("a", 10);
+    o->setProperty("b", 20);
+    QVERIFY(!queue.isEmpty());
+    QCOMPARE(o->property("sum").toInt(), 4);
+
+    queue.flush();
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(o->property("sum").toInt(), 30);
+    QCOMPARE(o->property("result").toInt(), 70);
+    QCOMPARE(queue.statistics().evaluations, quint64(2));
+    QVERIFY(queue.statistics().avoidedEvaluations >= 2);
+    QCOMPARE(queue.statistics().maxLevel, 1u);
+
+    // Without an explicit flush the queue is flushed from the event loop
+    o->setProperty("b", 5);
+    QTRY_COMPARE(o->property("result").toInt(), 40);
+
+    queue.setEnabled(false);
+    o->setProperty("a", 1);
+    QCOMPARE(o->property("result").toInt(), 13);
+}
+
+void tst_qqmlbinding::batchedBindingLoop()
+{
+    QQmlEngine engine;
+    QQmlBindingQueue &queue = QQmlEnginePrivate::get(&engine)->bindingQueue;
+    queue.setEnabled(true);
+
+    QQmlComponent c(&engine, testFileUrl("batchedBindingLoop.qml"));
+    QScopedPointer<QObject> o(c.create());
+    QVERIFY(o != 0);
+    queue.flush();
+    QCOMPARE(o->property("x").toInt(), 1);
+
+    QString warning = c.url().toString() + QLatin1String(":3:1: QML QtObject: Binding loop detected for property \"x\"");
+    QTest::ignoreMessage(QtWarningMsg, qPrintable(warning));
+    o->setProperty("y", 20);
+    queue.flush();
+    QCOMPARE(o->property("x").toInt(), 21);
+    QVERIFY(queue.isEmpty());
+}
+
+static QQmlBinding *bindingOn(QObject *object, const char *property)
+{
+    QQmlAbstractBinding *binding = QQmlPropertyPrivate::binding(QQmlProperty(object, QLatin1String(property)));
+    if (!binding || binding->bindingType() != QQmlAbstractBinding::Binding)
+        return 0;
+    return static_cast<QQmlBinding *>(binding);
+}
+
+void tst_qqmlbinding::staticDependencies()
+{
+    QQmlEngine engine;
+    QQmlComponent c(&engine, testFileUrl("staticDependencies.qml"));
+    QScopedPointer<QObject> o(c.create());
+    QVERIFY(o != 0);
+    QObject *child = o->findChild<QObject *>("child");
+    QVERIFY(child != 0);
+
+    QQmlBinding *simple = bindingOn(o.data(), "simple");
+    QVERIFY(simple != 0);
+    QVERIFY(simple->hasStaticDependencies());
+    QQmlBinding *conditional = bindingOn(o.data(), "conditional");
+    QVERIFY(conditional != 0);
+    QVERIFY(!conditional->hasStaticDependencies());
+    // Multiplying an object calls its valueOf(), which can read anything
+    QQmlBinding *converted = bindingOn(o.data(), "converted");
+    QVERIFY(converted != 0);
+    QVERIFY(!converted->hasStaticDependencies());
+
+    // Later evaluations rely on the dependencies captured by the first one
+    QCOMPARE(o->property("simple").toInt(), 96);
+    child->setProperty("width", 50);
+    QCOMPARE(o->property("simple").toInt(), 46);
+    o->setProperty("margin", 5);
+    QCOMPARE(o->property("simple").toInt(), 40);
+    child->setProperty("width", 60);
+    QCOMPARE(o->property("simple").toInt(), 50);
+
+    QCOMPARE(o->property("conditional").toInt(), 10);
+    o->setProperty("useA", false);
+    QCOMPARE(o->property("conditional").toInt(), 20);
+    o->setProperty("b", 30);
+    QCOMPARE(o->property("conditional").toInt(), 30);
+
+    QCOMPARE(o->property("converted").toInt(), 8);
+    child->setProperty("height", 7);
+    QCOMPARE(o->property("converted").toInt(), 14);
+}
+
+void tst_qqmlbinding::nativeBindings()
+{
+    QQmlEngine engine;
+    QQmlComponent c(&engine, testFileUrl("nativeBindings.qml"));
+    QScopedPointer<QObject> o(c.create());
+    QVERIFY(o != 0);
+    QObject *child = o->findChild<QObject *>("child");
+    QVERIFY(child != 0);
+
+    const char *native[] = { "copy", "converted", "negated", "text", "childWidth" };
+    for (int ii = 0; ii < int(sizeof(native) / sizeof(native[0])); ++ii) {
+        QQmlAbstractBinding *binding = QQmlPropertyPrivate::binding(QQmlProperty(o.data(), QLatin1String(native[ii])));
+        QVERIFY(binding != 0);
+        QCOMPARE(binding->bindingType(), QQmlAbstractBinding::Native);
+    }
+    QVERIFY(bindingOn(o.data(), "script") != 0);
+
+    QCOMPARE(o->property("copy").toInt(), 10);
+    QCOMPARE(o->property("converted").toDouble(), 10.0);
+    QCOMPARE(o->property("negated").toBool(), false);
+    QCOMPARE(o->property("text").toString(), QLatin1String("a"));
+    QCOMPARE(o->property("childWidth").toReal(), qreal(100));
+
+    o->setProperty("value", 20);
+    o->setProperty("flag", false);
+    o->setProperty("label", QLatin1String("b"));
+    child->setProperty("width", 50);
+    QCOMPARE(o->property("copy").toInt(), 20);
+    QCOMPARE(o->property("converted").toDouble(), 20.0);
+    QCOMPARE(o->property("negated").toBool(), true);
+    QCOMPARE(o->property("text").toString(), QLatin1String("b"));
+    QCOMPARE(o->property("childWidth").toReal(), qreal(50));
+    QCOMPARE(o->property("script").toInt(), 21);
+
+    // Assigning a value removes the binding
+    QQmlProperty::write(o.data(), QLatin1String("copy"), 5);
+    o->setProperty("value", 30);
+    QCOMPARE(o->property("copy").toInt(), 5);
+    QVERIFY(!QQmlPropertyPrivate::binding(QQmlProperty(o.data(), QLatin1String("copy"))));
+}
+
 QTEST_MAIN(tst_qqmlbinding)
 
 #include "tst_qqmlbinding.moc"
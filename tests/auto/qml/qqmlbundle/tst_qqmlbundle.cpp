@@ -65,6 +65,10 @@ private slots:
 
     void import();
 
+    void readOnlyLookup();
+    void currentFormat();
+    void corruptLinks();
+
 private:
     QStringList findFiles(const QDir &d);
     bool makeBundle(const QString &path, const QString &name);
@@ -211,6 +215,113 @@ void tst_qqmlbundle::import()
     delete o;
 }
 
+// Test that files are found through the index of a read-only bundle
+void tst_qqmlbundle::readOnlyLookup()
+{
+    QVERIFY(makeBundle(testFile("relativeResolution.2"), "my.bundle"));
+
+    QQmlBundle bundle(testFile("relativeResolution.2/my.bundle"));
+    QVERIFY(bundle.open(QFile::ReadOnly));
+
+    QList<const QQmlBundle::FileEntry *> files = bundle.files();
+    QVERIFY(!files.isEmpty());
+    foreach (const QQmlBundle::FileEntry *entry, files)
+        QCOMPARE(bundle.find(entry->fileName()), entry);
+
+    const QQmlBundle::FileEntry *entry = bundle.find(QLatin1String("subdir/test.qml"));
+    QVERIFY(entry != 0);
+
+    QFile source(testFile("relativeResolution.2/bundledata/subdir/test.qml"));
+    QVERIFY(source.open(QFile::ReadOnly));
+    QCOMPARE(QByteArray(entry->contents(), entry->fileSize()), source.readAll());
+
+    QVERIFY(bundle.find(QLatin1String("subdir/missing.qml")) == 0);
+    QVERIFY(!bundle.add(testFile("import.qml")));
+}
+
+// Test that new bundles are written in the current format, with file entries that
+// version 1 readers can still find
+void tst_qqmlbundle::currentFormat()
+{
+    QVERIFY(makeBundle(testFile("relativeResolution.2"), "my.bundle"));
+
+    QQmlBundle bundle(testFile("relativeResolution.2/my.bundle"));
+    QVERIFY(bundle.open(QFile::ReadOnly));
+    QCOMPARE(bundle.version(), 2);
+
+    QList<const QQmlBundle::FileEntry *> files = bundle.files();
+    QVERIFY(!files.isEmpty());
+    foreach (const QQmlBundle::FileEntry *entry, files) {
+        QCOMPARE(entry->fileNameLength, int(entry->fileName().length() * sizeof(QChar)));
+        QCOMPARE(bundle.find(entry->fileName()), entry);
+
+        QFile source(testFile("relativeResolution.2/bundledata/") + entry->fileName());
+        QVERIFY(source.open(QFile::ReadOnly));
+        QCOMPARE(QByteArray(entry->contents(), entry->fileSize()), source.readAll());
+    }
+}
+
+// Test that links with offsets outside the bundle or going in circles are ignored
+void tst_qqmlbundle::corruptLinks()
+{
+    QVERIFY(makeBundle(testFile("relativeResolution.2"), "my.bundle"));
+    const QString fileName = testFile("relativeResolution.2/my.bundle");
+    const QString entryName = QLatin1String("subdir/test.qml");
+
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadWrite));
+    QVERIFY(bundle.addMetaLink(entryName, QLatin1String("meta"), QByteArray("data")));
+    }
+
+    quint32 linkOffset = 0;
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadOnly));
+    const QQmlBundle::FileEntry *entry = bundle.find(entryName);
+    QVERIFY(entry != 0);
+    const QQmlBundle::FileEntry *meta = bundle.link(entry, QLatin1String("meta"));
+    QVERIFY(meta != 0);
+    QCOMPARE(QByteArray(meta->contents(), meta->fileSize()), QByteArray("data"));
+    linkOffset = entry->link;
+    }
+
+    // A link pointing to itself
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadWrite));
+    const QQmlBundle::FileEntry *entry = bundle.find(entryName);
+    QVERIFY(entry != 0);
+    const QQmlBundle::FileEntry *meta = bundle.link(entry, QLatin1String("meta"));
+    QVERIFY(meta != 0);
+    const_cast<QQmlBundle::FileEntry *>(meta)->link = linkOffset;
+    }
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadOnly));
+    const QQmlBundle::FileEntry *entry = bundle.find(entryName);
+    QVERIFY(entry != 0);
+    QVERIFY(bundle.link(entry, QLatin1String("meta")) != 0);
+    QVERIFY(bundle.link(entry, QLatin1String("missing")) == 0);
+    }
+
+    // A link past the end of the bundle
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadWrite));
+    const QQmlBundle::FileEntry *entry = bundle.find(entryName);
+    QVERIFY(entry != 0);
+    const_cast<QQmlBundle::FileEntry *>(entry)->link = QFileInfo(fileName).size() + 16;
+    }
+    {
+    QQmlBundle bundle(fileName);
+    QVERIFY(bundle.open(QFile::ReadOnly));
+    const QQmlBundle::FileEntry *entry = bundle.find(entryName);
+    QVERIFY(entry != 0);
+    QVERIFY(bundle.link(entry, QLatin1String("meta")) == 0);
+    }
+}
+
 // Transform the data available under <path>/bundledata to a bundle named <path>/<name>
 bool tst_qqmlbundle::makeBundle(const QString &path, const QString &name)
 {
@@ -0,0 +1,5 @@
+import QtQml 2.0
+
+QtObject {
+    property int sum: _source.evaluate(_source.value + _first.value)
+}
@@ -0,0 +1,7 @@
+import QtQml 2.0
+
+QtObject {
+    property QtObject victim
+    property int value: _source.value
+    onValueChanged: if (victim) _source.destroyObject(victim)
+}
@@ -150,6 +150,31 @@ signals:
     void unusedSignal();
 };
 
+class NotifierSource : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged)
+public:
+    NotifierSource() : m_value(0), evaluations(0) {}
+
+    int value() const { return m_value; }
+    void setValue(int v) { m_value = v; emit valueChanged(); }
+
+    int valueReceivers() { return receivers(SIGNAL(valueChanged())); }
+    bool valueConnected() { return isSignalConnected(QMetaMethod::fromSignal(&NotifierSource::valueChanged)); }
+
+    Q_INVOKABLE void destroyObject(QObject *o) { delete o; }
+    Q_INVOKABLE int evaluate(int v) { ++evaluations; return v; }
+
+    int evaluations;
+
+signals:
+    void valueChanged();
+
+private:
+    int m_value;
+};
+
 class tst_qqmlnotifier : public QQmlDataTest
 {
     Q_OBJECT
@@ -173,6 +198,8 @@ private slots:
     void readProperty();
     void propertyChange();
     void disconnectOnDestroy();
+    void manyEndpoints();
+    void cancelledEndpoint();
 
 private:
     void createObjects();
@@ -320,6 +347,102 @@ void tst_qqmlnotifier::disconnectOnDestroy()
     exportedObject->verifyReceiverCount();
 }
 
+void tst_qqmlnotifier::manyEndpoints()
+{
+    NotifierSource source;
+    engine.rootContext()->setContextProperty("_source", &source);
+
+    QQmlComponent component(&engine, testFileUrl("manyEndpoints.qml"));
+    QList<QObject *> objects;
+    for (int ii = 0; ii < 32; ++ii) {
+        QObject *o = component.create();
+        QVERIFY(o != 0);
+        objects << o;
+    }
+    QCOMPARE(source.valueReceivers(), 32);
+
+    // The first emission moves the endpoints into contiguous storage
+    source.setValue(1);
+    foreach (QObject *o, objects)
+        QCOMPARE(o->property("value").toInt(), 1);
+    QCOMPARE(source.valueReceivers(), 32);
+
+    // Objects deleted while the signal is being emitted are skipped
+    QList<QObject *> survivors;
+    for (int ii = 0; ii < objects.count(); ii += 2) {
+        objects.at(ii)->setProperty("victim", QVariant::fromValue(objects.at(ii + 1)));
+        survivors << objects.at(ii);
+    }
+    source.setValue(2);
+    foreach (QObject *o, survivors)
+        QCOMPARE(o->property("value").toInt(), 2);
+    QCOMPARE(source.valueReceivers(), 16);
+
+    // Endpoints connected later are appended to the storage
+    for (int ii = 0; ii < 4; ++ii) {
+        QObject *o = component.create();
+        QVERIFY(o != 0);
+        survivors << o;
+    }
+    QCOMPARE(source.valueReceivers(), 20);
+    source.setValue(3);
+    foreach (QObject *o, survivors)
+        QCOMPARE(o->property("value").toInt(), 3);
+
+    QVERIFY(source.valueConnected());
+    qDeleteAll(survivors);
+    QCOMPARE(source.valueReceivers(), 0);
+    // Emptying the storage frees it and lets QObject skip the signal again
+    QVERIFY(!source.valueConnected());
+
+    QObject *o = component.create();
+    QVERIFY(o != 0);
+    QCOMPARE(source.valueReceivers(), 1);
+    QVERIFY(source.valueConnected());
+    source.setValue(4);
+    QCOMPARE(o->property("value").toInt(), 4);
+    delete o;
+    QCOMPARE(source.valueReceivers(), 0);
+
+    engine.rootContext()->setContextProperty("_source", 0);
+}
+
+void tst_qqmlnotifier::cancelledEndpoint()
+{
+    NotifierSource source;
+    engine.rootContext()->setContextProperty("_source", &source);
+
+    QQmlComponent component(&engine, testFileUrl("manyEndpoints.qml"));
+    QList<QObject *> objects;
+    for (int ii = 0; ii < 16; ++ii) {
+        QObject *o = component.create();
+        QVERIFY(o != 0);
+        objects << o;
+    }
+    engine.rootContext()->setContextProperty("_first", objects.first());
+
+    // The binding depends on the signal twice, directly and through the binding of the
+    // first object, which is connected earlier and re-evaluates it first.  Its own
+    // pending notification is then cancelled, in array mode as well.
+    QQmlComponent dependent(&engine, testFileUrl("cancelledEndpoint.qml"));
+    QObject *o = dependent.create();
+    QVERIFY(o != 0);
+    QCOMPARE(source.valueReceivers(), 17);
+    QCOMPARE(source.evaluations, 1);
+
+    for (int ii = 1; ii <= 3; ++ii) {
+        source.setValue(ii);
+        QCOMPARE(o->property("sum").toInt(), 2 * ii);
+        QCOMPARE(source.evaluations, 1 + ii);
+    }
+
+    delete o;
+    qDeleteAll(objects);
+    QCOMPARE(source.valueReceivers(), 0);
+    engine.rootContext()->setContextProperty("_first", 0);
+    engine.rootContext()->setContextProperty("_source", 0);
+}
+
 QTEST_MAIN(tst_qqmlnotifier)
 
 #include "tst_qqmlnotifier.moc"
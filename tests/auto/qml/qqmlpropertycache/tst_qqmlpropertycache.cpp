@@ -41,6 +41,8 @@
 
 #include <qtest.h>
 #include <private/qqmlpropertycache_p.h>
+#include <private/qqmlengine_p.h>
+#include <private/qmetaobjectbuilder_p.h>
 #include <QtQml/qqmlengine.h>
 #include "../../shared/util.h"
 
@@ -57,6 +59,8 @@ private slots:
     void methodsDerived();
     void signalHandlers();
     void signalHandlersDerived();
+    void sharedCaches();
+    void sharedCacheLateType();
 
 private:
     QQmlEngine engine;
@@ -102,6 +106,21 @@ Q_SIGNALS:
     void signalB();
 };
 
+class LateObject : public QObject
+{
+    Q_OBJECT
+};
+
+class LateTypeObject : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(LateObject *late READ late CONSTANT)
+public:
+    LateTypeObject(QObject *parent = 0) : QObject(parent) {}
+
+    LateObject *late() const { return 0; }
+};
+
 QQmlPropertyData *cacheProperty(QQmlPropertyCache *cache, const char *name)
 {
     return cache->property(QLatin1String(name), 0, 0);
@@ -278,6 +297,70 @@ void tst_qqmlpropertycache::signalHandlersDerived()
     QCOMPARE(data->coreIndex, metaObject->indexOfMethod("propertyDChanged()"));
 }
 
+void tst_qqmlpropertycache::sharedCaches()
+{
+    QQmlEngine engine1;
+    QQmlEngine engine2;
+    DerivedObject object;
+    const QMetaObject *metaObject = object.metaObject();
+
+    // C++ meta objects use the same cache in all engines
+    QQmlPropertyCache *cache = QQmlEnginePrivate::get(&engine1)->cache(&object);
+    QVERIFY(cache);
+    QVERIFY(cache->isShared());
+    QVERIFY(!cache->qmlEngine());
+    QCOMPARE(QQmlEnginePrivate::get(&engine2)->cache(&object), cache);
+    QCOMPARE(QQmlPropertyCache::sharedCache(metaObject), cache);
+    QCOMPARE(cache->parent(), QQmlPropertyCache::sharedCache(&BaseObject::staticMetaObject));
+
+    QQmlPropertyData *data;
+    QVERIFY(data = cacheProperty(cache, "propertyA"));
+    QCOMPARE(data->coreIndex, metaObject->indexOfProperty("propertyA"));
+    QVERIFY(data = cacheProperty(cache, "propertyD"));
+    QCOMPARE(data->coreIndex, metaObject->indexOfProperty("propertyD"));
+    QCOMPARE(data->propType, int(QMetaType::QString));
+
+    // Caches derived for an engine are not shared
+    QQmlRefPointer<QQmlPropertyCache> copy;
+    copy.take(cache->copy(&engine1));
+    QVERIFY(!copy->isShared());
+    QCOMPARE(copy->qmlEngine(), &engine1);
+    QCOMPARE(copy->parent(), cache);
+    QVERIFY(data = cacheProperty(copy, "propertyC"));
+    QCOMPARE(data->coreIndex, metaObject->indexOfProperty("propertyC"));
+
+    // Meta objects not created by moc may not live as long as the process
+    QMetaObjectBuilder builder;
+    builder.setClassName("DynamicObject");
+    builder.setSuperClass(&QObject::staticMetaObject);
+    QMetaObject *dynamicMetaObject = builder.toMetaObject();
+    QVERIFY(!QQmlPropertyCache::sharedCache(dynamicMetaObject));
+    free(dynamicMetaObject);
+}
+
+void tst_qqmlpropertycache::sharedCacheLateType()
+{
+    LateTypeObject object;
+    QQmlPropertyCache *cache = 0;
+    {
+        QQmlEngine engine;
+        cache = QQmlEnginePrivate::get(&engine)->cache(&object);
+        QVERIFY(cache);
+        QVERIFY(cache->isShared());
+    }
+
+    // The property type is registered after the first engine built the shared cache
+    QCOMPARE(QMetaType::type("LateObject*"), int(QMetaType::UnknownType));
+    qRegisterMetaType<LateObject *>();
+
+    QQmlEngine engine;
+    QCOMPARE(QQmlEnginePrivate::get(&engine)->cache(&object), cache);
+    QQmlPropertyData *data = cacheProperty(cache, "late");
+    QVERIFY(data);
+    QCOMPARE(data->propType, qMetaTypeId<LateObject *>());
+    QVERIFY(data->isQObject());
+}
+
 QTEST_MAIN(tst_qqmlpropertycache)
 
 #include "tst_qqmlpropertycache.moc"
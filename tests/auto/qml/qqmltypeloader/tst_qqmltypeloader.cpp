@@ -43,6 +43,11 @@
 #include <QtQml/qqmlengine.h>
 #include <QtQuick/qquickview.h>
 #include <QtQuick/qquickitem.h>
+#include <private/qqmlengine_p.h>
+#include <private/qv4compileddata_p.h>
+#include <private/qv4diskcache_p.h>
+#include <private/qv4script_p.h>
+#include <private/qv8engine_p.h>
 #include "../../shared/util.h"
 
 class tst_QQMLTypeLoader : public QQmlDataTest
@@ -51,6 +56,13 @@ class tst_QQMLTypeLoader : public QQmlDataTest
 
 private slots:
     void testLoadComplete();
+    void diskCache();
+    void precompiledUnit();
+    void concurrentLoad_data();
+    void concurrentLoad();
+    void importCache();
+    void importCacheFile();
+    void importCacheFileChild();
 };
 
 void tst_QQMLTypeLoader::testLoadComplete()
@@ -70,6 +82,284 @@ void tst_QQMLTypeLoader::testLoadComplete()
     delete window;
 }
 
+static void writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(contents);
+}
+
+static int evaluateAnswer(const QUrl &url)
+{
+    QQmlEngine engine;
+    QQmlComponent component(&engine, url);
+    QScopedPointer<QObject> object(component.create());
+    return object ? object->property("answer").toInt() : -1;
+}
+
+void tst_QQMLTypeLoader::diskCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString cachePath = dir.path() + QLatin1String("/cache");
+    qputenv("QML_DISK_CACHE_PATH", cachePath.toLocal8Bit());
+
+    {
+        QQmlEngine engine;
+        if (!QV4::DiskCache::isSupported(QV8Engine::getV4(&engine))) {
+            qunsetenv("QML_DISK_CACHE_PATH");
+            QSKIP("The execution engine's backend does not support caching compiled code");
+        }
+    }
+
+    const QString qmlFile = dir.path() + QLatin1String("/main.qml");
+    const QString jsFile = dir.path() + QLatin1String("/script.js");
+    writeFile(qmlFile, "import QtQml 2.0\nimport \"script.js\" as Script\nQtObject { property int answer: Script.answer() }\n");
+    writeFile(jsFile, "function answer() { var values = [20, 22]; return values[0] + values[1]; }\n");
+
+    const QUrl url = QUrl::fromLocalFile(qmlFile);
+    const QString cacheFile = QV4::DiskCache::cacheFilePath(QUrl::fromLocalFile(jsFile));
+
+    // The first load compiles the script and writes the cache file, the second one uses it.
+    QCOMPARE(evaluateAnswer(url), 42);
+    QVERIFY(QFile::exists(cacheFile));
+    QCOMPARE(evaluateAnswer(url), 42);
+
+    // Changing the source invalidates the cached unit.
+    writeFile(jsFile, "function answer() { return 43; }\n");
+    QCOMPARE(evaluateAnswer(url), 43);
+    QCOMPARE(evaluateAnswer(url), 43);
+
+    // A corrupt cache file is ignored and replaced.
+    writeFile(cacheFile, "qv4cache garbage");
+    QCOMPARE(evaluateAnswer(url), 43);
+    QVERIFY(QFileInfo(cacheFile).size() > 16);
+
+    // So is a file with a valid header whose unit points outside of itself.
+    QFile file(cacheFile);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray contents = file.readAll();
+    file.close();
+    const int unitOffset = contents.indexOf(QV4::CompiledData::magic_str);
+    QVERIFY(unitOffset > 0);
+    QV4::CompiledData::Unit *unit = reinterpret_cast<QV4::CompiledData::Unit *>(contents.data() + unitOffset);
+    unit->offsetToStringTable = 0xfffffff0;
+    writeFile(cacheFile, contents);
+    QCOMPARE(evaluateAnswer(url), 43);
+    QFile rewritten(cacheFile);
+    QVERIFY(rewritten.open(QIODevice::ReadOnly));
+    QVERIFY(rewritten.readAll() != contents);
+
+    qunsetenv("QML_DISK_CACHE_PATH");
+}
+
+void tst_QQMLTypeLoader::precompiledUnit()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString qmlFile = dir.path() + QLatin1String("/main.qml");
+    const QString jsFile = dir.path() + QLatin1String("/script.js");
+    const QByteArray source("function answer() { return 42; }\n");
+    writeFile(qmlFile, "import QtQml 2.0\nimport \"script.js\" as Script\nQtObject { property int answer: Script.answer() }\n");
+    writeFile(jsFile, source);
+    const QUrl url = QUrl::fromLocalFile(qmlFile);
+    const QUrl jsUrl = QUrl::fromLocalFile(jsFile);
+
+    {
+        QQmlEngine engine;
+        QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+        if (!QV4::DiskCache::isSupported(v4))
+            QSKIP("The execution engine's backend does not support caching compiled code");
+
+        // Store a different unit under the hash of the real source, to tell whether it gets used.
+        QV4::CompiledData::CompilationUnit *unit = QV4::Script::precompile(v4, jsUrl, QStringLiteral("function answer() { return 7; }"), 0);
+        QVERIFY(unit);
+        unit->ref();
+        QVERIFY(QV4::DiskCache::saveUnit(QV4::DiskCache::precompiledFilePath(jsUrl), QString::fromUtf8(source), unit));
+        unit->deref();
+    }
+    QCOMPARE(QV4::DiskCache::precompiledFilePath(jsUrl), jsFile + QLatin1Char('c'));
+    QCOMPARE(evaluateAnswer(url), 7);
+
+    // Changing the source invalidates the precompiled unit.
+    writeFile(jsFile, "function answer() { return 43; }\n");
+    QCOMPARE(evaluateAnswer(url), 43);
+}
+
+void tst_QQMLTypeLoader::concurrentLoad_data()
+{
+    QTest::addColumn<int>("workerThreads");
+
+    QTest::newRow("serial") << 0;
+    QTest::newRow("concurrent") << 4;
+}
+
+void tst_QQMLTypeLoader::concurrentLoad()
+{
+    QFETCH(int, workerThreads);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Nested components and scripts, so that prepared blobs defer further dependencies
+    const int count = 10;
+    const QString path = dir.path() + QLatin1Char('/');
+    QByteArray root("import QtQml 2.0\nQtObject {\n");
+    for (int ii = 0; ii < count; ++ii) {
+        const QByteArray n = QByteArray::number(ii);
+        root += "    property QtObject c" + n + ": Outer" + n + " {}\n";
+        writeFile(path + QLatin1String("Outer") + n + QLatin1String(".qml"),
+                  "import QtQml 2.0\nimport \"outer" + n + ".js\" as Script\n"
+                  "QtObject { property QtObject inner: Inner" + n + " {}\n"
+                  "           property int value: Script.value() + inner.value }\n");
+        writeFile(path + QLatin1String("outer") + n + QLatin1String(".js"),
+                  ".import \"inner" + n + ".js\" as Inner\nfunction value() { return Inner.value(); }\n");
+        writeFile(path + QLatin1String("Inner") + n + QLatin1String(".qml"),
+                  "import QtQml 2.0\nQtObject { property int value: " + n + " }\n");
+        writeFile(path + QLatin1String("inner") + n + QLatin1String(".js"),
+                  "function value() { return 1; }\n");
+    }
+    root += "    property int answer: c0.value";
+    for (int ii = 1; ii < count; ++ii)
+        root += " + c" + QByteArray::number(ii) + ".value";
+    root += "\n}\n";
+    writeFile(path + QLatin1String("main.qml"), root);
+
+    const QUrl url = QUrl::fromLocalFile(path + QLatin1String("main.qml"));
+
+    {
+        QQmlEngine engine;
+        QQmlEnginePrivate::get(&engine)->typeLoader.setWorkerThreadCount(workerThreads);
+        QQmlComponent component(&engine, url);
+        QVERIFY2(component.isReady(), qPrintable(component.errorString()));
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY(object);
+        // sum of 0..9 plus one per inner script
+        QCOMPARE(object->property("answer").toInt(), 45 + count);
+    }
+
+    // Errors in a prepared dependency are reported synchronously
+    writeFile(path + QLatin1String("inner5.js"), "function value() { return 1 +; }\n");
+    writeFile(path + QLatin1String("Inner7.qml"), "import QtQml 2.0\nQtObject { property int value: }\n");
+    {
+        QQmlEngine engine;
+        QQmlEnginePrivate::get(&engine)->typeLoader.setWorkerThreadCount(workerThreads);
+        QQmlComponent component(&engine, url);
+        QVERIFY(component.isError());
+        QVERIFY(!component.errors().isEmpty());
+    }
+}
+
+static int evaluateImport(const QString &importPath, const QUrl &url)
+{
+    QQmlEngine engine;
+    engine.addImportPath(importPath);
+    QQmlComponent component(&engine, url);
+    QScopedPointer<QObject> object(component.create());
+    return object ? object->property("answer").toInt() : -1;
+}
+
+static void writeModule(const QString &path, int answer)
+{
+    QVERIFY(QDir().mkpath(path));
+    writeFile(path + QLatin1String("/qmldir"), "Thing 1.0 Thing.qml\n");
+    writeFile(path + QLatin1String("/Thing.qml"),
+              "import QtQml 2.0\nQtObject { property int answer: " + QByteArray::number(answer) + " }\n");
+}
+
+void tst_QQMLTypeLoader::importCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString importPath = dir.path() + QLatin1String("/imports");
+    const QString modulePath = importPath + QLatin1String("/CacheModule");
+    QVERIFY(QDir().mkpath(importPath));
+    writeFile(dir.path() + QLatin1String("/main.qml"), "import CacheModule 1.0\nThing {}\n");
+    const QUrl url = QUrl::fromLocalFile(dir.path() + QLatin1String("/main.qml"));
+
+    // A miss is shared with the next engine, until the module is created
+    QTest::ignoreMessage(QtWarningMsg, "QQmlComponent: Component is not ready");
+    QCOMPARE(evaluateImport(importPath, url), -1);
+    writeModule(modulePath, 1);
+    QCOMPARE(evaluateImport(importPath, url), 1);
+    QCOMPARE(evaluateImport(importPath, url), 1);
+
+    // A versioned module added later takes precedence
+    writeModule(importPath + QLatin1String("/CacheModule.1"), 2);
+    QCOMPARE(evaluateImport(importPath, url), 2);
+
+    // A hit is dropped once its qmldir is removed
+    QVERIFY(QFile::remove(importPath + QLatin1String("/CacheModule.1/qmldir")));
+    QCOMPARE(evaluateImport(importPath, url), 1);
+    QVERIFY(QFile::remove(modulePath + QLatin1String("/qmldir")));
+    QTest::ignoreMessage(QtWarningMsg, "QQmlComponent: Component is not ready");
+    QCOMPARE(evaluateImport(importPath, url), -1);
+}
+
+static bool runImportCacheChild(const QString &cacheFile, const QString &importPath, const QUrl &url, int answer)
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QLatin1String("QML_IMPORT_CACHE_FILE"), cacheFile);
+    environment.insert(QLatin1String("TST_IMPORT_CACHE_PATH"), importPath);
+    environment.insert(QLatin1String("TST_IMPORT_CACHE_URL"), url.toString());
+    environment.insert(QLatin1String("TST_IMPORT_CACHE_ANSWER"), QString::number(answer));
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.start(QCoreApplication::applicationFilePath(), QStringList() << QLatin1String("importCacheFileChild"));
+    return process.waitForFinished() && process.exitStatus() == QProcess::NormalExit
+            && process.exitCode() == 0;
+}
+
+void tst_QQMLTypeLoader::importCacheFile()
+{
+#ifdef QT_NO_PROCESS
+    QSKIP("Needs QProcess to load the cache file in a new process");
+#else
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString cacheFile = dir.path() + QLatin1String("/importcache");
+    const QString importPath = dir.path() + QLatin1String("/imports");
+    writeModule(importPath + QLatin1String("/CacheModule"), 1);
+    writeFile(dir.path() + QLatin1String("/main.qml"), "import CacheModule 1.0\nThing {}\n");
+    const QUrl url = QUrl::fromLocalFile(dir.path() + QLatin1String("/main.qml"));
+
+    // The cache is written when the engine is destroyed
+    qputenv("QML_IMPORT_CACHE_FILE", cacheFile.toLocal8Bit());
+    QCOMPARE(evaluateImport(importPath, url), 1);
+    qunsetenv("QML_IMPORT_CACHE_FILE");
+    QVERIFY(QFileInfo(cacheFile).size() > 0);
+
+    // A new process reads it back
+    QVERIFY(runImportCacheChild(cacheFile, importPath, url, 1));
+
+    // and notices a module added since then
+    writeModule(importPath + QLatin1String("/CacheModule.1"), 2);
+    QVERIFY(runImportCacheChild(cacheFile, importPath, url, 2));
+    QVERIFY(QFile::remove(importPath + QLatin1String("/CacheModule.1/qmldir")));
+    QVERIFY(runImportCacheChild(cacheFile, importPath, url, 1));
+
+    // A corrupt cache file is ignored and replaced
+    writeFile(cacheFile, "garbage");
+    QVERIFY(runImportCacheChild(cacheFile, importPath, url, 1));
+    QVERIFY(QFileInfo(cacheFile).size() > 7);
+#endif
+}
+
+// Runs in the processes started by importCacheFile()
+void tst_QQMLTypeLoader::importCacheFileChild()
+{
+    const QString importPath = QString::fromLocal8Bit(qgetenv("TST_IMPORT_CACHE_PATH"));
+    if (importPath.isEmpty())
+        QSKIP("Only run by importCacheFile()");
+
+    const QUrl url(QString::fromLocal8Bit(qgetenv("TST_IMPORT_CACHE_URL")));
+    QCOMPARE(evaluateImport(importPath, url), qgetenv("TST_IMPORT_CACHE_ANSWER").toInt());
+}
+
 QTEST_MAIN(tst_QQMLTypeLoader)
 
 #include "tst_qqmltypeloader.moc"
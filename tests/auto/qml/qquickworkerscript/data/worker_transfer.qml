@@ -0,0 +1,86 @@
+import QtQuick 2.0
+
+WorkerScript {
+    id: worker
+    source: "script.js"
+
+    // unlike a variant property this keeps the JS types of the message
+    property var response
+
+    property var received: []
+    property int recordCount: 0
+
+    signal done()
+
+    onMessage: {
+        if (messageObject.sequence === undefined) {
+            worker.response = messageObject
+            worker.done()
+            return
+        }
+        worker.received = worker.received.concat([messageObject.sequence])
+        if (messageObject.records)
+            worker.recordCount = messageObject.records.length
+        if (messageObject.sequence === 5)
+            worker.done()
+    }
+
+    property string longString: new Array(1001).join("abc")
+
+    function makeMessage() {
+        var numbers = [];
+        for (var i = 0; i < 10000; ++i)
+            numbers.push(i % 3 ? i : i / 2);
+        var records = [];
+        for (var i = 0; i < 1000; ++i)
+            records.push({ id: i, name: "record" + i, tags: [i, null, true] });
+        return { text: longString, numbers: numbers, records: records };
+    }
+
+    function testTransfer() {
+        var message = makeMessage();
+        var buffer = new ArrayBuffer(16);
+        var bytes = new Uint8Array(buffer);
+        for (var i = 0; i < bytes.length; ++i)
+            bytes[i] = i;
+        message.buffer = buffer;
+        message.view = new Uint8Array(buffer, 4, 8);
+        message.data = new DataView(buffer, 2);
+        worker.sendMessage(message, [buffer]);
+        return buffer.byteLength === 0 && message.view.length === 0;
+    }
+
+    // The first message takes several deserialization slices on the way back,
+    // the ones after it have to wait for it
+    function sendSequence() {
+        var records = [];
+        for (var i = 0; i < 100000; ++i)
+            records.push({ id: i, name: "record" + i });
+        worker.sendMessage({ sequence: 0, records: records });
+        for (var i = 1; i <= 5; ++i)
+            worker.sendMessage({ sequence: i });
+    }
+
+    function checkSequence() {
+        return received.join() === "0,1,2,3,4,5" && recordCount === 100000;
+    }
+
+    function checkResponse() {
+        var expected = makeMessage();
+        var r = response;
+        if (r.text !== longString || r.numbers.length !== expected.numbers.length
+                || r.records.length !== expected.records.length)
+            return false;
+        for (var i = 0; i < expected.numbers.length; ++i) {
+            if (r.numbers[i] !== expected.numbers[i])
+                return false;
+        }
+        if (JSON.stringify(r.records) !== JSON.stringify(expected.records))
+            return false;
+        if (r.buffer.byteLength !== 16 || r.view.buffer !== r.buffer || r.data.buffer !== r.buffer)
+            return false;
+        if (r.view.length !== 8 || r.view[0] !== 4 || r.data.getUint8(0) !== 2)
+            return false;
+        return true;
+    }
+}
@@ -64,6 +64,8 @@ private slots:
     void messaging_sendQObjectList();
     void messaging_sendJsObject();
     void messaging_sendExternalObject();
+    void messaging_transfer();
+    void messaging_order();
     void script_with_pragma();
     void script_included();
     void scriptError_onLoad();
@@ -208,6 +210,45 @@ void tst_QQuickWorkerScript::messaging_sendExternalObject()
     delete obj;
 }
 
+void tst_QQuickWorkerScript::messaging_transfer()
+{
+    QQmlComponent component(&m_engine, testFileUrl("worker_transfer.qml"));
+    QQuickWorkerScript *worker = qobject_cast<QQuickWorkerScript*>(component.create());
+    QVERIFY(worker != 0);
+
+    QVariant result = qVariantFromValue(false);
+    QVERIFY(QMetaObject::invokeMethod(worker, "testTransfer", Qt::DirectConnection,
+            Q_RETURN_ARG(QVariant, result)));
+    QVERIFY(result.toBool());
+    waitForEchoMessage(worker);
+
+    result = qVariantFromValue(false);
+    QVERIFY(QMetaObject::invokeMethod(worker, "checkResponse", Qt::DirectConnection,
+            Q_RETURN_ARG(QVariant, result)));
+    QVERIFY(result.toBool());
+
+    qApp->processEvents();
+    delete worker;
+}
+
+void tst_QQuickWorkerScript::messaging_order()
+{
+    QQmlComponent component(&m_engine, testFileUrl("worker_transfer.qml"));
+    QQuickWorkerScript *worker = qobject_cast<QQuickWorkerScript*>(component.create());
+    QVERIFY(worker != 0);
+
+    QVERIFY(QMetaObject::invokeMethod(worker, "sendSequence", Qt::DirectConnection));
+    waitForEchoMessage(worker);
+
+    QVariant result = qVariantFromValue(false);
+    QVERIFY(QMetaObject::invokeMethod(worker, "checkSequence", Qt::DirectConnection,
+            Q_RETURN_ARG(QVariant, result)));
+    QVERIFY(result.toBool());
+
+    qApp->processEvents();
+    delete worker;
+}
+
 void tst_QQuickWorkerScript::script_with_pragma()
 {
     QVariant value(100);
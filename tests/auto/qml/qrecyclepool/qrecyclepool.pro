@@ -0,0 +1,10 @@
+CONFIG += testcase
+TARGET = tst_qrecyclepool
+macx:CONFIG -= app_bundle
+
+SOURCES += tst_qrecyclepool.cpp
+
+CONFIG += parallel_test
+
+QT += core-private qml-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
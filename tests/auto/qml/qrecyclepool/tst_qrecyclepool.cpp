@@ -0,0 +1,156 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include <qtest.h>
+#include <QtCore/qthread.h>
+#include <private/qrecyclepool_p.h>
+
+struct PoolItem
+{
+    PoolItem() : value(0) {}
+    PoolItem(int v) : value(v) {}
+    int value;
+};
+
+typedef QRecyclePool<PoolItem, 4> SmallPool;
+
+class AllocatingThread : public QThread
+{
+public:
+    AllocatingThread(QThreadStorage<SmallPool *> *pools) : pools(pools), item(0) {}
+
+    void run()
+    {
+        item = new (qAllocateFromThreadRecyclePool(pools)) PoolItem(42);
+        // Items may be returned while the thread is running
+        void *other = qAllocateFromThreadRecyclePool(pools);
+        SmallPool::Deallocate(other);
+    }
+
+    QThreadStorage<SmallPool *> *pools;
+    PoolItem *item;
+};
+
+class tst_qrecyclepool : public QObject
+{
+    Q_OBJECT
+private slots:
+    void reuse();
+    void releaseEmptyPages();
+    void threadPool();
+};
+
+void tst_qrecyclepool::reuse()
+{
+    SmallPool pool;
+    PoolItem *a = pool.New(1);
+    PoolItem *b = pool.New(2);
+    QCOMPARE(a->value, 1);
+    QCOMPARE(b->value, 2);
+
+    SmallPool::Delete(a);
+    PoolItem *c = pool.New(3);
+    QCOMPARE(c, a);
+    QCOMPARE(c->value, 3);
+
+    SmallPool::Delete(b);
+    SmallPool::Delete(c);
+    QCOMPARE(pool.pageCount(), 1);
+}
+
+void tst_qrecyclepool::releaseEmptyPages()
+{
+    SmallPool pool;
+    QList<PoolItem *> items;
+    for (int ii = 0; ii < 12; ++ii)
+        items << pool.New(ii);
+    QCOMPARE(pool.pageCount(), 3);
+
+    // Returning all items of an older page releases it
+    for (int ii = 0; ii < 4; ++ii)
+        SmallPool::Delete(items.at(ii));
+    QCOMPARE(pool.pageCount(), 2);
+
+    // A partially used page is reused before a new page is created
+    SmallPool::Delete(items.at(4));
+    PoolItem *reused = pool.New(100);
+    QCOMPARE(reused, items.at(4));
+    QCOMPARE(pool.pageCount(), 2);
+    items[4] = reused;
+
+    // The current page is kept, even when it is empty
+    for (int ii = 4; ii < 12; ++ii)
+        SmallPool::Delete(items.at(ii));
+    QCOMPARE(pool.pageCount(), 1);
+
+    // Pages are created again as needed
+    items.clear();
+    for (int ii = 0; ii < 8; ++ii)
+        items << pool.New(ii);
+    QCOMPARE(pool.pageCount(), 2);
+    for (int ii = 0; ii < 8; ++ii)
+        QCOMPARE(items.at(ii)->value, ii);
+    foreach (PoolItem *item, items)
+        SmallPool::Delete(item);
+}
+
+void tst_qrecyclepool::threadPool()
+{
+    QThreadStorage<SmallPool *> pools;
+
+    // A pool outlives its thread while items from it are outstanding
+    AllocatingThread thread(&pools);
+    thread.start();
+    QVERIFY(thread.wait());
+    QVERIFY(thread.item != 0);
+    QCOMPARE(thread.item->value, 42);
+    SmallPool::Deallocate(thread.item);
+
+    // Every thread has its own pool
+    void *mainItem = qAllocateFromThreadRecyclePool(&pools);
+    QVERIFY(pools.hasLocalData());
+    QCOMPARE(pools.localData()->pageCount(), 1);
+    SmallPool::Deallocate(mainItem);
+    pools.setLocalData(0);
+}
+
+QTEST_MAIN(tst_qrecyclepool)
+
+#include "tst_qrecyclepool.moc"
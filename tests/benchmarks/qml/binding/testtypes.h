@@ -49,11 +49,13 @@ class MyQmlObject : public QObject
     Q_OBJECT
     Q_PROPERTY(int result READ result WRITE setResult)
     Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(bool flag READ flag WRITE setFlag NOTIFY flagChanged)
+    Q_PROPERTY(bool flagResult READ flagResult WRITE setFlagResult)
     Q_PROPERTY(MyQmlObject *object READ object WRITE setObject NOTIFY objectChanged)
     Q_PROPERTY(QQmlListProperty<QObject> data READ data)
     Q_CLASSINFO("DefaultProperty", "data")
 public:
-    MyQmlObject() : m_result(0), m_value(0), m_object(0) {}
+    MyQmlObject() : m_result(0), m_value(0), m_flag(false), m_flagResult(false), m_object(0) {}
 
     int result() const { return m_result; }
     void setResult(int r) { m_result = r; }
@@ -61,6 +63,12 @@ public:
     int value() const { return m_value; }
     void setValue(int v) { m_value = v; emit valueChanged(); }
 
+    bool flag() const { return m_flag; }
+    void setFlag(bool f) { m_flag = f; emit flagChanged(); }
+
+    bool flagResult() const { return m_flagResult; }
+    void setFlagResult(bool r) { m_flagResult = r; }
+
     QQmlListProperty<QObject> data() { return QQmlListProperty<QObject>(this, m_data); }
 
     MyQmlObject *object() const { return m_object; }
@@ -68,12 +76,15 @@ public:
 
 signals:
     void valueChanged();
+    void flagChanged();
     void objectChanged();
 
 private:
     QList<QObject *> m_data;
     int m_result;
     int m_value;
+    bool m_flag;
+    bool m_flagResult;
     MyQmlObject *m_object;
 };
 QML_DECLARE_TYPE(MyQmlObject);
@@ -64,8 +64,12 @@ private slots:
     void objectproperty();
     void basicproperty_data();
     void basicproperty();
+    void negation_data();
+    void negation();
     void creation_data();
     void creation();
+    void fanout_data();
+    void fanout();
 
 private:
     QQmlEngine engine;
@@ -142,6 +146,10 @@ void tst_binding::basicproperty_data()
     QTest::newRow("myObject.value") << SRCDIR "/data/idproperty.txt" << "myObject.value";
     QTest::newRow("myObject.value + 10") << SRCDIR "/data/idproperty.txt" << "myObject.value + 10";
     QTest::newRow("myObject.value + myObject.value + 10") << SRCDIR "/data/idproperty.txt" << "myObject.value + myObject.value + 10";
+
+    // Same results as "value" and "myObject.value", but not simple enough for a native binding
+    QTest::newRow("value | 0") << SRCDIR "/data/localproperty.txt" << "value | 0";
+    QTest::newRow("myObject.value | 0") << SRCDIR "/data/idproperty.txt" << "myObject.value | 0";
 }
 
 void tst_binding::basicproperty()
@@ -160,6 +168,31 @@ void tst_binding::basicproperty()
     }
 }
 
+void tst_binding::negation_data()
+{
+    QTest::addColumn<QString>("file");
+    QTest::addColumn<QString>("binding");
+
+    QTest::newRow("!myObject.flag") << SRCDIR "/data/negation.txt" << "!myObject.flag";
+    QTest::newRow("myObject.flag ? false : true") << SRCDIR "/data/negation.txt" << "myObject.flag ? false : true";
+}
+
+void tst_binding::negation()
+{
+    QFETCH(QString, file);
+    QFETCH(QString, binding);
+
+    COMPONENT(file, binding);
+
+    MyQmlObject *object = qobject_cast<MyQmlObject *>(c.create());
+    QVERIFY(object != 0);
+
+    QBENCHMARK {
+        object->setFlag(true);
+        object->setFlag(false);
+    }
+}
+
 void tst_binding::creation_data()
 {
     QTest::addColumn<QString>("file");
@@ -167,6 +200,7 @@ void tst_binding::creation_data()
 
     QTest::newRow("constant") << SRCDIR "/data/creation.txt" << "10";
     QTest::newRow("ownProperty") << SRCDIR "/data/creation.txt" << "myObject.value";
+    QTest::newRow("ownPropertyScript") << SRCDIR "/data/creation.txt" << "myObject.value | 0";
     QTest::newRow("declaredProperty") << SRCDIR "/data/creation.txt" << "myObject.myValue";
     QTest::newRow("contextProperty") << SRCDIR "/data/creation.txt" << "tstObject.value";
 }
@@ -184,5 +218,39 @@ void tst_binding::creation()
     }
 }
 
+void tst_binding::fanout_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+// Many bindings depending on a single notifier
+void tst_binding::fanout()
+{
+    QFETCH(int, count);
+
+    QString file = SRCDIR "/data/localproperty.txt";
+    QString binding = "tstObject.value";
+    COMPONENT(file, binding);
+
+    QList<QObject *> objects;
+    for (int ii = 0; ii < count; ++ii) {
+        QObject *o = c.create();
+        QVERIFY(o != 0);
+        objects << o;
+    }
+
+    QBENCHMARK {
+        tstObject.setValue(1);
+        tstObject.setValue(2);
+    }
+
+    qDeleteAll(objects);
+}
+
 QTEST_MAIN(tst_binding)
 #include "tst_binding.moc"
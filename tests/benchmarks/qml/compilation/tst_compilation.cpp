@@ -48,10 +48,13 @@
 #include <QtQml/private/qqmljsparser_p.h>
 #include <QtQml/private/qqmljslexer_p.h>
 #include <QtQml/private/qqmlscript_p.h>
+#include <QtQml/private/qqmlengine_p.h>
 
 #include <QFile>
 #include <QDebug>
 #include <QTextStream>
+#include <QTemporaryDir>
+#include <QThread>
 
 class tst_compilation : public QObject
 {
@@ -68,7 +71,12 @@ private slots:
     void scriptparser_data();
     void scriptparser();
 
+    void typeloader_data();
+    void typeloader();
+
 private:
+    bool writeTypeLoaderFiles(const QString &path, int componentCount);
+
     QQmlEngine engine;
 };
 
@@ -157,6 +165,71 @@ void tst_compilation::scriptparser()
     }
 }
 
+// Writes a main.qml instantiating componentCount distinct components, each of which
+// imports its own JavaScript library
+bool tst_compilation::writeTypeLoaderFiles(const QString &path, int componentCount)
+{
+    QFile main(path + QLatin1String("/main.qml"));
+    if (!main.open(QIODevice::WriteOnly))
+        return false;
+    QTextStream mainStream(&main);
+    mainStream << "import QtQml 2.0\nQtObject {\n    property list<QtObject> children: [\n";
+
+    for (int ii = 0; ii < componentCount; ++ii) {
+        QFile component(path + QString::fromLatin1("/Component%1.qml").arg(ii));
+        QFile script(path + QString::fromLatin1("/script%1.js").arg(ii));
+        if (!component.open(QIODevice::WriteOnly) || !script.open(QIODevice::WriteOnly))
+            return false;
+
+        QTextStream componentStream(&component);
+        componentStream << "import QtQml 2.0\nimport \"script" << ii << ".js\" as Script\n"
+                        << "QtObject {\n";
+        for (int jj = 0; jj < 20; ++jj)
+            componentStream << "    property int p" << jj << ": Script.value(" << jj << ") + " << jj << "\n";
+        componentStream << "}\n";
+
+        QTextStream scriptStream(&script);
+        scriptStream << ".pragma library\n";
+        for (int jj = 0; jj < 20; ++jj)
+            scriptStream << "function f" << jj << "(x) { var r = 0; for (var i = 0; i < x; ++i) r += i * " << jj << "; return r; }\n";
+        scriptStream << "function value(x) { return f" << ii % 20 << "(x); }\n";
+
+        mainStream << "        Component" << ii << " {}" << (ii + 1 < componentCount ? "," : "") << "\n";
+    }
+
+    mainStream << "    ]\n}\n";
+    return true;
+}
+
+void tst_compilation::typeloader_data()
+{
+    QTest::addColumn<int>("workerThreads");
+
+    QTest::newRow("serial") << 0;
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("ideal") << QThread::idealThreadCount();
+}
+
+void tst_compilation::typeloader()
+{
+    QFETCH(int, workerThreads);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTypeLoaderFiles(dir.path(), 100));
+    const QUrl url = QUrl::fromLocalFile(dir.path() + QLatin1String("/main.qml"));
+
+    // Every iteration needs a fresh engine, otherwise the types are served from its cache
+    QBENCHMARK {
+        QQmlEngine engine;
+        QQmlEnginePrivate::get(&engine)->typeLoader.setWorkerThreadCount(workerThreads);
+        QQmlComponent c(&engine, url);
+        QVERIFY2(c.isReady(), qPrintable(c.errorString()));
+    }
+}
+
 QTEST_MAIN(tst_compilation)
 
 #include "tst_compilation.moc"
@@ -0,0 +1,20 @@
+// Benchmarks the Array builtins on dense arrays of numbers.
+
+import QtQuick 2.0
+
+QtObject {
+    function runtest() {
+        var a = [];
+        for (var ii = 0; ii < 1000; ++ii)
+            a.push((ii * 7919) % 1000);
+
+        var sum = 0;
+        for (var jj = 0; jj < 100; ++jj) {
+            a.forEach(function(v) { sum += v });
+            sum += a.map(function(v) { return v + 1 }).filter(function(v) { return v & 1 }).length;
+            sum += a.reduce(function(s, v) { return s + v }, 0);
+            sum += a.indexOf(999) + a.lastIndexOf(0);
+            a.slice(0).sort();
+        }
+    }
+}
@@ -0,0 +1,21 @@
+// Benchmarks JSON.parse and JSON.stringify on a payload of records, as
+// received from a web service.
+
+import QtQuick 2.0
+
+QtObject {
+    function runtest() {
+        var records = [];
+        for (var ii = 0; ii < 2000; ++ii) {
+            records.push({ id: ii, name: "item number " + ii, price: ii * 1.25, tags: ["a", "b\n"],
+                           available: (ii & 1) == 0, owner: { first: "Jane", last: "Doe" } });
+        }
+        var text = JSON.stringify(records);
+
+        for (var jj = 0; jj < 10; ++jj) {
+            var parsed = JSON.parse(text);
+            JSON.stringify(parsed);
+            JSON.stringify(parsed, null, 2);
+        }
+    }
+}
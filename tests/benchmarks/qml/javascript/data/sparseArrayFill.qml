@@ -0,0 +1,24 @@
+// Benchmarks filling arrays that are stored sparsely, in ascending,
+// descending and scattered order.
+
+import QtQuick 2.0
+
+QtObject {
+    function runtest() {
+        for (var ii = 0; ii < 10; ++ii) {
+            var a = [];
+            for (var jj = 0; jj < 20000; ++jj)
+                a[jj * 16 + 100000] = jj;
+
+            var b = [];
+            for (var jj = 20000; jj > 0; --jj)
+                b[jj * 16 + 100000] = jj;
+
+            var c = [];
+            for (var jj = 0; jj < 20000; ++jj)
+                c[((jj * 7919) % 20000) * 16 + 100000] = jj;
+
+            a.length = 100000;
+        }
+    }
+}
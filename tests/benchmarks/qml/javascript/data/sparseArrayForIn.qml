@@ -0,0 +1,17 @@
+// Benchmarks for-in enumeration of a sparse array.
+
+import QtQuick 2.0
+
+QtObject {
+    function runtest() {
+        var a = [];
+        for (var ii = 0; ii < 5000; ++ii)
+            a[ii * 64 + 100000] = ii;
+
+        var sum = 0;
+        for (var jj = 0; jj < 100; ++jj) {
+            for (var k in a)
+                sum += a[k];
+        }
+    }
+}
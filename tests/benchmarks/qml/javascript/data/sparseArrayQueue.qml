@@ -0,0 +1,19 @@
+// Benchmarks using a sparse array as a queue with shift() and unshift().
+
+import QtQuick 2.0
+
+QtObject {
+    function runtest() {
+        var a = [];
+        a[200000] = 0;
+        for (var ii = 0; ii < 1000; ++ii)
+            a[ii] = ii;
+
+        for (var ii = 0; ii < 20000; ++ii) {
+            a.unshift(ii);
+            a.unshift(ii, ii + 1);
+            a.shift();
+            a.shift();
+        }
+    }
+}
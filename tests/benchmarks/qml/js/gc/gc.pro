@@ -0,0 +1,9 @@
+CONFIG += testcase
+TEMPLATE = app
+TARGET = tst_bench_gc
+macx:CONFIG -= app_bundle
+CONFIG += release
+
+SOURCES += tst_gc.cpp
+
+QT += qml-private testlib
@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+#include <QElapsedTimer>
+#include <private/qv8engine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4mm_p.h>
+
+#include <algorithm>
+
+// Runs a script that allocates in "frames" and reports the distribution of frame
+// times, which is dominated by garbage collection pauses.
+class tst_gc : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_gc() {}
+
+private slots:
+    void framePauses_data();
+    void framePauses();
+};
+
+enum GCMode {
+    EagerSweep = 0x0,
+    LazySweep = 0x1,
+    Incremental = 0x2,
+    Generational = 0x4
+};
+
+void tst_gc::framePauses_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("eager sweep") << int(EagerSweep);
+    QTest::newRow("lazy sweep") << int(LazySweep);
+    QTest::newRow("incremental, eager sweep") << int(Incremental);
+    QTest::newRow("incremental, lazy sweep") << int(Incremental | LazySweep);
+    QTest::newRow("generational, eager sweep") << int(Generational);
+    QTest::newRow("generational, lazy sweep") << int(Generational | LazySweep);
+}
+
+static qint64 percentile(const QVector<qint64> &sorted, int p)
+{
+    return sorted.at(qMin(sorted.size() - 1, sorted.size() * p / 100));
+}
+
+void tst_gc::framePauses()
+{
+    QFETCH(int, mode);
+
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    mm->setLazySweep(mode & LazySweep);
+    mm->setIncrementalGC(mode & Incremental);
+    mm->setGenerationalGC(mode & Generational);
+
+    // keeps a window of live objects around while producing lots of garbage
+    QJSValue frame = engine.evaluate(
+        "(function() {"
+        "  var live = [];"
+        "  var next = 0;"
+        "  return function() {"
+        "    for (var i = 0; i < 2000; ++i) {"
+        "      var o = { index: i, name: 'item' + i, data: [ i, i + 1, i + 2 ] };"
+        "      if (!(i % 10))"
+        "        live[next++ % 20000] = o;"
+        "    }"
+        "  };"
+        "})()");
+    QVERIFY(frame.isCallable());
+
+    const int frames = 500;
+    QVector<qint64> times;
+    times.reserve(frames);
+
+    QBENCHMARK {
+        times.clear();
+        for (int i = 0; i < frames; ++i) {
+            QElapsedTimer t;
+            t.start();
+            frame.call();
+            // what the render loop does once per frame
+            mm->incrementalGCStep();
+            times.append(t.nsecsElapsed() / 1000);
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    const QV4::MemoryManager::GCStatistics &stats = mm->statistics();
+    qDebug("frame times (us): median %lld, 90%% %lld, 99%% %lld, max %lld",
+           percentile(times, 50), percentile(times, 90), percentile(times, 99), times.last());
+    qDebug("collections: %u full (max pause %lldus), %u minor (max pause %lldus), "
+           "%u marking steps (max %lldus), %u lazy sweeps (max %lldus)",
+           stats.fullCollections, stats.maxFullPause, stats.minorCollections, stats.maxMinorPause,
+           stats.incrementalSlices, stats.maxSlicePause, stats.lazySweeps, stats.maxLazySweepTime);
+}
+
+QTEST_MAIN(tst_gc)
+
+#include "tst_gc.moc"
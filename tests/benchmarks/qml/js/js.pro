@@ -3,6 +3,7 @@ SUBDIRS = \
         qjsengine \
         qjsvalue \
         qjsvalueiterator \
+        gc \
 
 TRUSTED_BENCHMARKS += \
     qjsvalue \
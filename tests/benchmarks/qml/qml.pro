@@ -2,6 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
            binding \
+           compilation \
            creation \
            javascript \
            holistic \
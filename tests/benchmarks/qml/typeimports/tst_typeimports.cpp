@@ -54,6 +54,9 @@ private slots:
     void cpp();
     void qml();
 
+    void cpp_newEngine();
+    void qml_newEngine();
+
 private:
     QQmlEngine engine;
 };
@@ -130,6 +133,25 @@ void tst_typeimports::qml()
     }
 }
 
+// Import resolution is repeated for every engine, these show how much of it is shared
+void tst_typeimports::cpp_newEngine()
+{
+    QBENCHMARK {
+        QQmlEngine newEngine;
+        QQmlComponent component(&newEngine, TEST_FILE("cpp.qml"));
+        QVERIFY(component.isReady());
+    }
+}
+
+void tst_typeimports::qml_newEngine()
+{
+    QBENCHMARK {
+        QQmlEngine newEngine;
+        QQmlComponent component(&newEngine, TEST_FILE("qml.qml"));
+        QVERIFY(component.isReady());
+    }
+}
+
 QTEST_MAIN(tst_typeimports)
 
 #include "tst_typeimports.moc"
@@ -0,0 +1,381 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qqmlcodegenerator_p.h>
+#include <private/qqmlscript_p.h>
+#include <private/qv4diskcache_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4isel_moth_p.h>
+#include <private/qv4script_p.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QUrl>
+#include <QtQml/QQmlError>
+
+#include <iostream>
+
+QT_USE_NAMESPACE
+
+// Compiles the JavaScript files of an application ahead of time. Every file "foo.js" reachable
+// from the given sources is compiled for the interpreter and written to "foo.jsc", which the
+// engine loads instead of parsing and compiling the script. QML documents are checked for
+// errors and followed for their imports.
+//
+// The compiled units contain interpreter bytecode. They are only used by engines that run
+// the interpreter, i.e. on platforms without the JIT or with QV4_FORCE_INTERPRETER set;
+// engines that use the JIT ignore them and compile the sources as usual. Units carry the
+// engine stamp of the disk cache, so they load into any build of the same Qt version with
+// the same instruction set, and need to be regenerated when either changes.
+class CacheGenerator
+{
+public:
+    CacheGenerator()
+        : engine(new QQmlJS::Moth::ISelFactory)
+        , checkOnly(false)
+        , verbose(false)
+        , errorCount(0)
+    {}
+
+    void addPath(const QString &path);
+    void run();
+    bool writeResourceFile(const QString &fileName) const;
+
+    QV4::ExecutionEngine engine;
+    QDir rootDir;
+    QString outputPath;
+    QUrl urlBase;
+    QStringList importPaths;
+    bool checkOnly;
+    bool verbose;
+    int errorCount;
+
+private:
+    void addImport(const QString &directory, int type, const QString &uri, int majorVersion, int minorVersion);
+    void compileQml(const QString &fileName);
+    void compileScript(const QString &fileName);
+    bool readSource(const QString &fileName, QString *source);
+    void reportErrors(const QList<QQmlError> &errors);
+    bool isInsideRoot(const QString &fileName) const;
+    QUrl urlForFile(const QString &fileName) const;
+    QString outputFileName(const QString &fileName) const;
+
+    QStringList pending;
+    QSet<QString> seen;
+    QStringList written;
+};
+
+void CacheGenerator::addPath(const QString &path)
+{
+    const QFileInfo info(path);
+    const QString canonicalPath = info.canonicalFilePath();
+    if (canonicalPath.isEmpty() || seen.contains(canonicalPath))
+        return;
+    seen.insert(canonicalPath);
+
+    if (info.isDir()) {
+        QDirIterator it(canonicalPath, QStringList() << QLatin1String("*.qml") << QLatin1String("*.js"), QDir::Files);
+        while (it.hasNext())
+            addPath(it.next());
+    } else if (canonicalPath.endsWith(QLatin1String(".qml")) || canonicalPath.endsWith(QLatin1String(".js"))) {
+        pending.append(canonicalPath);
+    }
+}
+
+void CacheGenerator::addImport(const QString &directory, int type, const QString &uri, int majorVersion, int minorVersion)
+{
+    if (type != QQmlScript::Import::Library) {
+        addPath(QDir(directory).filePath(uri));
+        return;
+    }
+
+    // Modules are looked up like the engine does, preferring the most specific version.
+    QString modulePath = uri;
+    modulePath.replace(QLatin1Char('.'), QLatin1Char('/'));
+    QStringList candidates;
+    if (majorVersion >= 0) {
+        if (minorVersion >= 0)
+            candidates << modulePath + QString::fromLatin1(".%1.%2").arg(majorVersion).arg(minorVersion);
+        candidates << modulePath + QString::fromLatin1(".%1").arg(majorVersion);
+    }
+    candidates << modulePath;
+
+    foreach (const QString &importPath, importPaths) {
+        foreach (const QString &candidate, candidates) {
+            const QString path = QDir(importPath).filePath(candidate);
+            if (QFileInfo(path).isDir()) {
+                addPath(path);
+                return;
+            }
+        }
+    }
+}
+
+void CacheGenerator::run()
+{
+    while (!pending.isEmpty()) {
+        const QString fileName = pending.takeFirst();
+        if (fileName.endsWith(QLatin1String(".js")))
+            compileScript(fileName);
+        else
+            compileQml(fileName);
+    }
+}
+
+void CacheGenerator::compileQml(const QString &fileName)
+{
+    QString source;
+    if (!readSource(fileName, &source))
+        return;
+
+    const QUrl url = urlForFile(fileName);
+    QtQml::QQmlCodeGenerator codeGenerator;
+    QtQml::ParsedQML parsed(/*debugMode*/false);
+    if (!codeGenerator.generateFromQml(source, url, url.toString(), &parsed)) {
+        reportErrors(codeGenerator.errors);
+        return;
+    }
+
+    // Types of the same directory are imported implicitly.
+    const QString directory = QFileInfo(fileName).path();
+    addPath(directory);
+    foreach (const QV4::CompiledData::Import *import, parsed.imports) {
+        int type = QQmlScript::Import::Library;
+        if (import->type == QV4::CompiledData::Import::ImportFile)
+            type = QQmlScript::Import::File;
+        else if (import->type == QV4::CompiledData::Import::ImportScript)
+            type = QQmlScript::Import::Script;
+        addImport(directory, type, parsed.stringAt(import->uriIndex), import->majorVersion, import->minorVersion);
+    }
+}
+
+void CacheGenerator::compileScript(const QString &fileName)
+{
+    QString source;
+    if (!readSource(fileName, &source))
+        return;
+
+    // Same preprocessing as QQmlScriptBlob, which blanks out the .pragma and .import lines.
+    QQmlError metaDataError;
+    const QQmlScript::Parser::JavaScriptMetaData metaData = QQmlScript::Parser::extractMetaData(source, &metaDataError);
+    if (metaDataError.isValid()) {
+        metaDataError.setUrl(urlForFile(fileName));
+        reportErrors(QList<QQmlError>() << metaDataError);
+        return;
+    }
+
+    const QString directory = QFileInfo(fileName).path();
+    foreach (const QQmlScript::Import &import, metaData.imports)
+        addImport(directory, import.type, import.uri, import.majorVersion, import.minorVersion);
+
+    QList<QQmlError> errors;
+    QV4::CompiledData::CompilationUnit *unit = QV4::Script::precompile(&engine, urlForFile(fileName), source, &errors);
+    if (!errors.isEmpty()) {
+        reportErrors(errors);
+        return;
+    }
+    if (!unit || checkOnly)
+        return;
+
+    unit->ref();
+    const QString output = outputFileName(fileName);
+    if (output.isEmpty()) {
+        if (verbose)
+            std::cerr << "skipping " << qPrintable(fileName) << ", outside of the root path" << std::endl;
+    } else if (!QDir().mkpath(QFileInfo(output).path()) || !QV4::DiskCache::saveUnit(output, source, unit)) {
+        std::cerr << "cannot write " << qPrintable(output) << std::endl;
+        ++errorCount;
+    } else {
+        written.append(output);
+        if (verbose)
+            std::cerr << "wrote " << qPrintable(output) << std::endl;
+    }
+    unit->deref();
+}
+
+bool CacheGenerator::readSource(const QString &fileName, QString *source)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "cannot open " << qPrintable(fileName) << std::endl;
+        ++errorCount;
+        return false;
+    }
+    *source = QString::fromUtf8(file.readAll());
+    return true;
+}
+
+void CacheGenerator::reportErrors(const QList<QQmlError> &errors)
+{
+    foreach (const QQmlError &error, errors)
+        std::cerr << qPrintable(error.toString()) << std::endl;
+    errorCount += errors.count();
+}
+
+bool CacheGenerator::isInsideRoot(const QString &fileName) const
+{
+    const QString relativePath = rootDir.relativeFilePath(fileName);
+    return !relativePath.startsWith(QLatin1String("../")) && !QDir::isAbsolutePath(relativePath);
+}
+
+QUrl CacheGenerator::urlForFile(const QString &fileName) const
+{
+    if (urlBase.isEmpty() || !isInsideRoot(fileName))
+        return QUrl::fromLocalFile(fileName);
+    return urlBase.resolved(QUrl(rootDir.relativeFilePath(fileName)));
+}
+
+QString CacheGenerator::outputFileName(const QString &fileName) const
+{
+    if (!isInsideRoot(fileName))
+        return QString();
+    if (outputPath.isEmpty())
+        return fileName + QLatin1Char('c');
+    return QDir(outputPath).filePath(rootDir.relativeFilePath(fileName) + QLatin1Char('c'));
+}
+
+// Lists the compiled units under the same names as their sources, so that the resource
+// file can be added next to the one holding the application's QML files.
+bool CacheGenerator::writeResourceFile(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    const QDir resourceDir = QFileInfo(fileName).absoluteDir();
+    QString prefix = QLatin1String("/");
+    if (urlBase.scheme() == QLatin1String("qrc") && !urlBase.path().isEmpty())
+        prefix = urlBase.path();
+
+    QTextStream stream(&file);
+    stream << "<RCC>\n    <qresource prefix=\"" << prefix << "\">\n";
+    foreach (const QString &output, written) {
+        const QString alias = outputPath.isEmpty() ? rootDir.relativeFilePath(output)
+                                                   : QDir(outputPath).relativeFilePath(output);
+        stream << "        <file alias=\"" << alias << "\">" << resourceDir.relativeFilePath(output) << "</file>\n";
+    }
+    stream << "    </qresource>\n</RCC>\n";
+    return stream.status() == QTextStream::Ok;
+}
+
+static void printUsage(const QString &appName)
+{
+    std::cerr << qPrintable(QString::fromLatin1(
+                                 "Usage: %1 [options] file-or-directory...\n"
+                                 "Compiles the JavaScript files of a QML application ahead of time and\n"
+                                 "reports errors in its QML and JavaScript files. Imports are followed.\n"
+                                 "The compiled units are only used when the interpreter runs, i.e. without\n"
+                                 "the JIT or with QV4_FORCE_INTERPRETER set, and by the same Qt version.\n\n"
+                                 "Options:\n"
+                                 "  -rootPath <path>    Only files below <path> are written (default: current directory)\n"
+                                 "  -importPath <path>  Look up module imports in <path>, may be given several times\n"
+                                 "  -outputPath <path>  Write compiled units below <path> instead of next to the sources\n"
+                                 "  -urlBase <url>      URL the root path is deployed to, for example qrc:/\n"
+                                 "  -qrc <file>         Write a resource file listing the compiled units\n"
+                                 "  -check              Only report errors, don't write compiled units\n"
+                                 "  -verbose            Print the names of the written files\n"
+                                 "Example: %1 -rootPath . -urlBase qrc:/ -qrc compiled.qrc main.qml\n").arg(
+                                 appName));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    const QString appName = QFileInfo(args.takeFirst()).baseName();
+
+    CacheGenerator generator;
+    generator.rootDir = QDir::current();
+    QString resourceFile;
+    QStringList inputs;
+
+    while (!args.isEmpty()) {
+        const QString arg = args.takeFirst();
+        const bool hasValue = !args.isEmpty();
+        if (arg == QLatin1String("-rootPath") && hasValue) {
+            generator.rootDir = QDir(QFileInfo(args.takeFirst()).canonicalFilePath());
+        } else if (arg == QLatin1String("-importPath") && hasValue) {
+            generator.importPaths.append(args.takeFirst());
+        } else if (arg == QLatin1String("-outputPath") && hasValue) {
+            generator.outputPath = args.takeFirst();
+        } else if (arg == QLatin1String("-urlBase") && hasValue) {
+            generator.urlBase = QUrl(args.takeFirst());
+        } else if (arg == QLatin1String("-qrc") && hasValue) {
+            resourceFile = args.takeFirst();
+        } else if (arg == QLatin1String("-check")) {
+            generator.checkOnly = true;
+        } else if (arg == QLatin1String("-verbose")) {
+            generator.verbose = true;
+        } else if (arg.startsWith(QLatin1Char('-'))) {
+            printUsage(appName);
+            return EXIT_FAILURE;
+        } else {
+            inputs.append(arg);
+        }
+    }
+
+    if (inputs.isEmpty()) {
+        printUsage(appName);
+        return EXIT_FAILURE;
+    }
+
+    foreach (const QString &input, inputs) {
+        if (!QFileInfo(input).exists()) {
+            std::cerr << "cannot open " << qPrintable(input) << std::endl;
+            return EXIT_FAILURE;
+        }
+        generator.addPath(input);
+    }
+    generator.run();
+
+    if (!resourceFile.isEmpty() && !generator.checkOnly && !generator.writeResourceFile(resourceFile)) {
+        std::cerr << "cannot write " << qPrintable(resourceFile) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return generator.errorCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
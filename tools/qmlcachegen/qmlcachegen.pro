@@ -0,0 +1,6 @@
+QT = qml-private core-private
+CONFIG += no_import_scan
+
+SOURCES += main.cpp
+
+load(qt_tool)
@@ -55,6 +55,7 @@ namespace Constants {
     const char TYPE_CREATING_STR[] = "Creating";
     const char TYPE_BINDING_STR[] = "Binding";
     const char TYPE_HANDLINGSIGNAL_STR[] = "HandlingSignal";
+    const char TYPE_INCUBATING_STR[] = "Incubating";
     const char PROFILER_FILE_VERSION[] = "1.02";
 }
 
@@ -199,6 +200,9 @@ QString QmlProfilerData::qmlRangeTypeAsString(QQmlProfilerService::RangeType typ
     case QQmlProfilerService::HandlingSignal:
         return QLatin1String(Constants::TYPE_HANDLINGSIGNAL_STR);
         break;
+    case QQmlProfilerService::Incubating:
+        return QLatin1String(Constants::TYPE_INCUBATING_STR);
+        break;
     default:
         return QString::number((int)typeEnum);
     }
@@ -10,7 +10,8 @@ qmlimportscanner.CONFIG = host_build
     SUBDIRS += \
         qml \
         qmlprofiler \
-        qmlbundle
+        qmlbundle \
+        qmlcachegen
     qtHaveModule(quick) {
         SUBDIRS += qmlscene qmlplugindump
         qtHaveModule(widgets): SUBDIRS += qmleasing
@@ -23,6 +24,7 @@ qml.depends = qmlimportscanner
 qmleasing.depends = qmlimportscanner
 
 # qmlmin, qmlimportscanner & qmlbundle are build tools.
+# qmlcachegen is not, the units it writes are only valid for the QtQml library it runs against.
 # qmlscene is needed by the autotests.
 # qmltestrunner may be useful for manual testing.
 # qmlplugindump cannot be a build tool, because it loads target plugins.